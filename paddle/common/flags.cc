@@ -462,8 +462,8 @@ PHI_DEFINE_EXPORTED_double(
  * Allocator related FLAG
  * Name: FLAGS_allocator_strategy
  * Since Version: 1.2
- * Value Range: string, {naive_best_fit, auto_growth, thread_local},
- * default=auto_growth
+ * Value Range: string, {naive_best_fit, auto_growth, thread_local,
+ * thread_cache}, default=auto_growth
  * Example:
  * Note: For selecting allocator policy of PaddlePaddle.
  */
@@ -481,7 +481,56 @@ PHI_DEFINE_EXPORTED_string(
     "size of models may be larger). auto_growth strategy would allocate "
     "GPU memory on demand, which allows users to start several Paddle jobs "
     "on the same GPU card but may lead to more memory fragmentation "
-    "(i.e., maximum batch size of models may be smaller).");
+    "(i.e., maximum batch size of models may be smaller). "
+    "thread_cache caches the CPU memory per thread by size class, which "
+    "suits multi-threaded CPU inference, and uses the auto_growth "
+    "allocators for the other devices.");
+
+/**
+ * Memory related FLAG
+ * Name: FLAGS_thread_cache_allocator_max_size_in_kb
+ * Since Version: 3.0.0
+ * Value Range: uint64, default=256 (KB)
+ * Example:
+ * Note: The largest CPU allocation cached by the thread_cache allocator
+ *       strategy, larger ones are allocated from the system.
+ */
+PHI_DEFINE_EXPORTED_uint64(
+    thread_cache_allocator_max_size_in_kb,
+    256ul,
+    "The largest CPU allocation cached by the thread_cache allocator "
+    "strategy, larger ones are allocated from the system. The unit is KB.");
+
+/**
+ * Memory related FLAG
+ * Name: FLAGS_thread_cache_allocator_cache_size_in_mb
+ * Since Version: 3.0.0
+ * Value Range: uint64, default=4 (MB)
+ * Example:
+ * Note: The CPU memory a thread caches in the thread_cache allocator
+ *       strategy before moving it to the lists shared by all threads.
+ */
+PHI_DEFINE_EXPORTED_uint64(
+    thread_cache_allocator_cache_size_in_mb,
+    4ul,
+    "The CPU memory a thread caches in the thread_cache allocator strategy "
+    "before moving it to the lists shared by all threads. The unit is MB.");
+
+/**
+ * Memory related FLAG
+ * Name: FLAGS_thread_cache_allocator_trim_interval_ms
+ * Since Version: 3.0.0
+ * Value Range: int64, default=1000 (ms)
+ * Example:
+ * Note: The interval at which the thread_cache allocator strategy frees the
+ *       shared cached CPU memory that was not used since the last trim.
+ */
+PHI_DEFINE_EXPORTED_int64(
+    thread_cache_allocator_trim_interval_ms,
+    1000,
+    "The interval at which the thread_cache allocator strategy frees the "
+    "shared cached CPU memory that was not used since the last trim. The "
+    "unit is ms.");
 
 /**
  * Memory related FLAG
@@ -928,6 +977,35 @@ PHI_DEFINE_EXPORTED_bool(
     false,
     "It controls get all neighbor id when running sub part graph.");
 
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_graph_alias_sampler_min_degree
+ * Since Version: 3.0.0
+ * Value Range: int32, default=64
+ * Example:
+ * Note: Nodes with at least this many neighbors use the alias method for
+ *       weighted neighbor sampling. A value <= 0 disables it.
+ */
+PHI_DEFINE_EXPORTED_int32(
+    graph_alias_sampler_min_degree,
+    64,
+    "Nodes with at least this many neighbors use the alias method for "
+    "weighted neighbor sampling, <= 0 disables it.");
+
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_graph_load_with_mmap
+ * Since Version: 3.0.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: Load graph node and edge files with mmap, splitting every file into
+ *       chunks parsed on all load threads. Files need not be sharded.
+ */
+PHI_DEFINE_EXPORTED_bool(graph_load_with_mmap,
+                         false,
+                         "It controls whether load graph node and edge files "
+                         "with mmap, parsing chunks of the files in parallel.");
+
 /**
  * Distributed related FLAG
  * Name: enable_exit_when_partial_worker
@@ -1177,6 +1255,14 @@ PD_DEFINE_bool(enable_slotrecord_reset_shrink,  // NOLINT
 PD_DEFINE_bool(enable_ins_parser_file,  // NOLINT
                false,
                "enable parser ins file, default false");
+PD_DEFINE_bool(enable_lock_free_data_feed_queue,  // NOLINT
+               false,
+               "use a lock-free channel as the instance queue of "
+               "PrivateQueueDataFeed, default false");
+PD_DEFINE_int32(data_feed_prefetch_files,  // NOLINT
+                0,
+                "number of files each SlotRecord loading thread reads ahead, "
+                "0 reads one file at a time, default 0");
 PHI_DEFINE_EXPORTED_bool(
     gpugraph_enable_hbm_table_collision_stat,
     false,
@@ -1570,6 +1656,50 @@ PHI_DEFINE_EXPORTED_bool(
     false,
     "whether PirInterpreter::RecordStreamForGC use cache strategy.");
 
+PHI_DEFINE_EXPORTED_bool(
+    pir_interpreter_static_memory_plan,
+    false,
+    "whether PirInterpreter places the intermediate DenseTensors of a "
+    "trace run program in one arena planned from their live ranges.");
+
+PHI_DEFINE_EXPORTED_bool(
+    pir_interpreter_critical_path_schedule,
+    false,
+    "whether the multi-thread PirInterpreter runs the ready instructions "
+    "with the longest critical path first, using the instruction costs "
+    "profiled in its first run. It also moves the inference "
+    "PirInterpreter, which runs in trace mode by default, to the "
+    "multi-thread scheduler when no input or output hook is registered.");
+
+PHI_DEFINE_EXPORTED_double(
+    pir_interpreter_inline_op_cost_us,
+    20.0,
+    "with pir_interpreter_critical_path_schedule, the cpu instructions "
+    "costing less microseconds than this run on the thread that made them "
+    "ready instead of being dispatched to the workqueue.");
+
+PHI_DEFINE_EXPORTED_bool(
+    pir_interpreter_batch_cpu_instructions,
+    false,
+    "whether a trace run PirInterpreter runs the consecutive cpu kernel "
+    "instructions of its execution order as one batch, without the per "
+    "instruction event, hook and profiling bookkeeping.");
+
+PHI_DEFINE_EXPORTED_bool(
+    pir_interpreter_log_dispatch_overhead,
+    false,
+    "whether a trace run PirInterpreter logs, after each run, the time "
+    "spent outside of the kernels of its instructions.");
+
+PHI_DEFINE_EXPORTED_string(
+    pir_interpreter_build_cache_dir,
+    "",
+    "the directory where PirInterpreter saves the dependencies, stream "
+    "events, gc plan and trace order it analysed, keyed by a hash of its "
+    "instructions and place, and loads them to skip the analysis when the "
+    "same program is built again, e.g. by another process. Empty means no "
+    "cache.");
+
 /**
  * Using PIR API in Python
  * Name: enable_pir_api
@@ -26,7 +26,8 @@ namespace paddle {
 namespace distributed {
 
 static bool IsStreamSafeAllocator() {
-  return (FLAGS_allocator_strategy == "auto_growth" &&
+  return ((FLAGS_allocator_strategy == "auto_growth" ||
+           FLAGS_allocator_strategy == "thread_cache") &&
           FLAGS_use_stream_safe_cuda_allocator);
 }
 
@@ -107,5 +107,89 @@ class ChunkAllocator {
   }
 };
 
+// Like ChunkAllocator, but hands out raw blocks whose size is only known at
+// run time. All blocks of one block size are interchangeable, so a block may
+// be released to any FixedSizeChunkAllocator with the same block size.
+// Chunks are only returned to the system when the allocator is destroyed.
+class FixedSizeChunkAllocator {
+ public:
+  explicit FixedSizeChunkAllocator(size_t block_size, size_t chunk_size = 1024)
+      : _block_size(block_size), _chunk_size(chunk_size) {
+    PADDLE_ENFORCE_EQ(
+        block_size >= sizeof(void*) && block_size % alignof(void*) == 0,
+        true,
+        common::errors::InvalidArgument(
+            "The block size of FixedSizeChunkAllocator must be a multiple of "
+            "%u and not less than it, but received %u.",
+            alignof(void*),
+            block_size));
+    _chunks = NULL;
+    _free_nodes = NULL;
+    _chunk_num = 0;
+  }
+  FixedSizeChunkAllocator(const FixedSizeChunkAllocator&) = delete;
+  ~FixedSizeChunkAllocator() {
+    while (_chunks != NULL) {
+      Chunk* x = _chunks;
+      _chunks = _chunks->next;
+      free(x);
+    }
+  }
+  void* acquire() {
+    if (_free_nodes == NULL) {
+      create_new_chunk();
+    }
+    Node* x = _free_nodes;
+    _free_nodes = _free_nodes->next;
+    return x;
+  }
+  void release(void* x) {
+    Node* node = reinterpret_cast<Node*>(x);
+    node->next = _free_nodes;
+    _free_nodes = node;
+  }
+  size_t block_size() const { return _block_size; }
+  // bytes taken from the system, including blocks not handed out yet
+  size_t reserved_bytes() const {
+    return _chunk_num * (kChunkHeaderSize + _block_size * _chunk_size);
+  }
+
+ private:
+  struct Node {
+    Node* next;
+  };
+  struct Chunk {
+    Chunk* next;
+  };
+  static constexpr size_t kChunkHeaderSize = 64;
+
+  size_t _block_size;  // bytes of one block
+  size_t _chunk_size;  // how many blocks in one chunk
+  Chunk* _chunks;      // a list
+  Node* _free_nodes;   // a list
+  size_t _chunk_num;   // how many chunks are allocated
+
+  void create_new_chunk() {
+    Chunk* chunk;
+    size_t alloc_size = kChunkHeaderSize + _block_size * _chunk_size;
+    int error = posix_memalign(
+        reinterpret_cast<void**>(&chunk), kChunkHeaderSize, alloc_size);
+    PADDLE_ENFORCE_EQ(error,
+                      0,
+                      common::errors::ResourceExhausted(
+                          "Fail to alloc memory of %ld size, error code is %d.",
+                          alloc_size,
+                          error));
+    chunk->next = _chunks;
+    _chunks = chunk;
+    ++_chunk_num;
+
+    char* blocks = reinterpret_cast<char*>(chunk) + kChunkHeaderSize;
+    for (size_t i = 0; i < _chunk_size; i++) {
+      release(blocks + i * _block_size);
+    }
+  }
+};
+
 }  // namespace distributed
 }  // namespace paddle
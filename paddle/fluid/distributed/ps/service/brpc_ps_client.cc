@@ -345,6 +345,19 @@ int32_t BrpcPsClient::Initialize() {
     }
   }
 
+  const auto &server_param = _config.server_param().downpour_server_param();
+  for (int i = 0; i < server_param.downpour_table_param_size(); ++i) {
+    const auto &table_param = server_param.downpour_table_param(i);
+    if (table_param.has_wire_codec()) {
+      // checks the value type once, the codecs are built per request
+      SparseWireCodec codec(table_param.wire_codec(), 0);
+      if (!codec.IsRaw()) {
+        _sparse_wire_codec_map[table_param.table_id()] =
+            table_param.wire_codec();
+      }
+    }
+  }
+
   auto &profiler = CostProfiler::instance();
   profiler.register_profiler("pserver_client_pull_dense");
   profiler.register_profiler("pserver_client_pull_sparse");
@@ -1167,11 +1180,21 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
   auto *accessor = GetTableAccessor(table_id);
 
   size_t value_size = accessor->GetAccessorInfo().select_size;
+  size_t value_dim = accessor->GetAccessorInfo().select_dim;
+  SparseWireCodec codec;
+  auto codec_itr = _sparse_wire_codec_map.find(table_id);
+  if (codec_itr != _sparse_wire_codec_map.end()) {
+    codec = SparseWireCodec(codec_itr->second,
+                            codec_itr->second.pull_exact_dim());
+  }
 
   DownpourBrpcClosure *closure = new DownpourBrpcClosure(
-      request_call_num, [shard_sorted_kvs, value_size](void *done) {
+      request_call_num,
+      [shard_sorted_kvs, value_size, value_dim, codec](void *done) {
         int ret = 0;
         auto *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
+        size_t encoded_size = codec.ValueBytes(value_dim);
+        std::vector<char> encoded_value(encoded_size);
         for (size_t i = 0; i < shard_sorted_kvs->size(); ++i) {
           if (closure->check_response(i, PS_PULL_SPARSE_TABLE) != 0) {
             ret = -1;
@@ -1192,12 +1215,23 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
             } else {
               last_key = kv_pair.first;
               last_value_data = kv_pair.second;
-              if (value_size !=
-                  io_buffer_itr.copy_and_forward(
-                      reinterpret_cast<void *>(last_value_data), value_size)) {
-                LOG(WARNING) << "res data is lack or not in format";
-                ret = -1;
-                break;
+              if (codec.value_type() == SparseWireCodec::kRaw) {
+                if (value_size != io_buffer_itr.copy_and_forward(
+                                      reinterpret_cast<void *>(last_value_data),
+                                      value_size)) {
+                  LOG(WARNING) << "res data is lack or not in format";
+                  ret = -1;
+                  break;
+                }
+              } else {
+                if (encoded_size != io_buffer_itr.copy_and_forward(
+                                        encoded_value.data(), encoded_size)) {
+                  LOG(WARNING) << "res data is lack or not in format";
+                  ret = -1;
+                  break;
+                }
+                codec.DecodeValue(
+                    encoded_value.data(), value_dim, last_value_data);
               }
             }
           }
@@ -1224,6 +1258,8 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
     auto &request_buffer = closure->cntl(i)->request_attachment();
 
     request_buffer.append(reinterpret_cast<void *>(&is_training), sizeof(bool));
+    std::vector<uint64_t> request_keys;
+    request_keys.reserve(sorted_kv_size);
     std::vector<uint32_t> keys_counter;
     keys_counter.reserve(sorted_kv_size);
 
@@ -1231,8 +1267,7 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
       ++kv_request_count;
       uint32_t keys = 1;
       last_key = sorted_kvs[kv_idx].first;
-      request_buffer.append(reinterpret_cast<void *>(&last_key),
-                            sizeof(uint64_t));
+      request_keys.push_back(last_key);
       while (kv_idx < sorted_kv_size - 1 &&
              last_key == sorted_kvs[kv_idx + 1].first) {
         ++kv_idx;
@@ -1241,8 +1276,13 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
       keys_counter.push_back(keys);
     }
 
-    request_buffer.append(reinterpret_cast<void *>(keys_counter.data()),
-                          sizeof(uint32_t) * keys_counter.size());
+    // the raw codec writes the keys and counters as they are
+    std::string encoded_request;
+    codec.EncodeKeys(
+        request_keys.data(), request_keys.size(), &encoded_request);
+    codec.EncodeCounts(
+        keys_counter.data(), keys_counter.size(), &encoded_request);
+    request_buffer.append(encoded_request);
 
     if (kv_request_count == 0) {
       closure->Run();
@@ -1252,6 +1292,9 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
       closure->request(i)->set_client_id(_client_id);
       closure->request(i)->add_params((char *)&kv_request_count,  // NOLINT
                                       sizeof(uint32_t));
+      if (!codec.IsRaw()) {
+        closure->request(i)->add_params(codec.Serialize());
+      }
       PsService_Stub rpc_stub(GetCmdChannel(i));
       closure->cntl(i)->set_log_id(butil::gettimeofday_ms());
       rpc_stub.service(
@@ -1858,19 +1901,40 @@ int BrpcPsClient::PushSparseAsyncShardPush(
                            sizeof(uint32_t));  // NOLINT
   auto *push_data = push_request->mutable_data();
   int update_size = accessor->GetAccessorInfo().update_size;
-  push_data->resize(merged_kv_count * (sizeof(uint64_t) + update_size));
-  char *push_data_ptr = const_cast<char *>(push_data->data());
-  memcpy(push_data_ptr,
-         merged_key_list.data(),
-         merged_kv_count * sizeof(uint64_t));
-  push_data_ptr += merged_kv_count * sizeof(uint64_t);
-  for (size_t i = 0; i < merged_kv_count; ++i) {
-    const char *task_data_ptr = merged_value_list[i].data();
-
+  auto codec_itr = _sparse_wire_codec_map.find(table_id);
+  if (codec_itr != _sparse_wire_codec_map.end()) {
+    SparseWireCodec codec(codec_itr->second,
+                          codec_itr->second.push_exact_dim());
+    size_t update_dim = accessor->GetAccessorInfo().update_dim;
+    size_t encoded_size = codec.ValueBytes(update_dim);
+    push_request->add_params(codec.Serialize());
+    push_data->clear();
+    codec.EncodeKeys(merged_key_list.data(), merged_kv_count, push_data);
+    size_t keys_size = push_data->size();
+    push_data->resize(keys_size + merged_kv_count * encoded_size);
+    char *push_data_ptr = const_cast<char *>(push_data->data()) + keys_size;
+    for (size_t i = 0; i < merged_kv_count; ++i) {
+      codec.EncodeValue(
+          reinterpret_cast<const float *>(merged_value_list[i].data()),
+          update_dim,
+          push_data_ptr);
+      push_data_ptr += encoded_size;
+    }
+  } else {
+    push_data->resize(merged_kv_count * (sizeof(uint64_t) + update_size));
+    char *push_data_ptr = const_cast<char *>(push_data->data());
     memcpy(push_data_ptr,
-           (float *)(task_data_ptr),  // NOLINT
-           update_size);
-    push_data_ptr += update_size;
+           merged_key_list.data(),
+           merged_kv_count * sizeof(uint64_t));
+    push_data_ptr += merged_kv_count * sizeof(uint64_t);
+    for (size_t i = 0; i < merged_kv_count; ++i) {
+      const char *task_data_ptr = merged_value_list[i].data();
+
+      memcpy(push_data_ptr,
+             (float *)(task_data_ptr),  // NOLINT
+             update_size);
+      push_data_ptr += update_size;
+    }
   }
   PsService_Stub rpc_stub(GetSparseChannel(shard_idx));
   closure->cntl(shard_idx)->set_request_compress_type(
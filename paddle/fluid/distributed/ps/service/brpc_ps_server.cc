@@ -18,6 +18,7 @@
 
 #include "butil/object_pool.h"
 #include "paddle/fluid/distributed/common/cost_timer.h"
+#include "paddle/fluid/distributed/ps/service/sparse_wire_codec.h"
 #include "paddle/fluid/distributed/ps/table/depends/sparse_utils.h"
 #include "paddle/fluid/distributed/ps/table/table.h"
 #include "paddle/fluid/framework/archive.h"
@@ -522,6 +523,12 @@ int32_t BrpcPsService::PullSparse(Table *table,
     return 0;
   }
 
+  SparseWireCodec codec;
+  if (request.params_size() > 1 && codec.Deserialize(request.params(1)) != 0) {
+    set_response_code(response, -1, "PullSparse wire codec is invalid");
+    return 0;
+  }
+
   CostTimer timer("pserver_server_pull_sparse");
   const uint32_t num =
       *(reinterpret_cast<const uint32_t *>(request.params(0).c_str()));
@@ -535,7 +542,30 @@ int32_t BrpcPsService::PullSparse(Table *table,
 
   auto value = PullSparseValue(num, dim);
 
-  value.DeserializeFromBytes(const_cast<void *>(data));
+  if (codec.IsRaw()) {
+    value.DeserializeFromBytes(const_cast<void *>(data));
+  } else {
+    thread_local std::vector<uint64_t> req_keys;
+    thread_local std::vector<uint32_t> req_frequencies;
+    req_keys.resize(num);
+    req_frequencies.resize(num);
+    const char *begin = reinterpret_cast<const char *>(data);
+    size_t keys_size = codec.DecodeKeys(begin + sizeof(bool),
+                                        req_buffer_size - sizeof(bool),
+                                        num,
+                                        req_keys.data());
+    if (keys_size == 0 ||
+        codec.DecodeCounts(begin + sizeof(bool) + keys_size,
+                           req_buffer_size - sizeof(bool) - keys_size,
+                           num,
+                           req_frequencies.data()) == 0) {
+      set_response_code(response, -1, "PullSparse request is not in format");
+      return 0;
+    }
+    value.is_training_ = reinterpret_cast<const bool *>(begin)[0];
+    value.feasigns_ = req_keys.data();
+    value.frequencies_ = req_frequencies.data();
+  }
 
   auto res_data = butil::get_object<std::vector<float>>();
   res_data->resize(num * dim);
@@ -546,8 +576,20 @@ int32_t BrpcPsService::PullSparse(Table *table,
   table->Pull(table_context);
   // table->PullSparse(res_data->data(), value);
 
-  cntl->response_attachment().append(reinterpret_cast<char *>(res_data->data()),
-                                     res_data->size() * sizeof(float));
+  if (codec.value_type() == SparseWireCodec::kRaw) {
+    cntl->response_attachment().append(
+        reinterpret_cast<char *>(res_data->data()),
+        res_data->size() * sizeof(float));
+  } else {
+    thread_local std::string res_buffer;
+    size_t encoded_size = codec.ValueBytes(dim);
+    res_buffer.resize(num * encoded_size);
+    for (size_t i = 0; i < num; ++i) {
+      codec.EncodeValue(
+          res_data->data() + i * dim, dim, &res_buffer[i * encoded_size]);
+    }
+    cntl->response_attachment().append(res_buffer);
+  }
   butil::return_object(res_data);
   return 0;
 }
@@ -571,6 +613,11 @@ int32_t BrpcPsService::PushSparse(Table *table,
                       "least 1 for num of sparse_key");
     return 0;
   }
+  SparseWireCodec codec;
+  if (request.params_size() > 1 && codec.Deserialize(request.params(1)) != 0) {
+    set_response_code(response, -1, "PushSparse wire codec is invalid");
+    return 0;
+  }
   CostTimer timer("pserver_server_push_sparse");
   const uint32_t num =
       *(reinterpret_cast<const uint32_t *>(request.params(0).c_str()));
@@ -581,9 +628,33 @@ int32_t BrpcPsService::PushSparse(Table *table,
   */
   TableContext table_context;
   table_context.value_type = Sparse;
-  table_context.push_context.keys = (const uint64_t *)push_data.data();
-  table_context.push_context.values =
-      (const float *)(push_data.data() + sizeof(uint64_t) * num);
+  if (codec.IsRaw()) {
+    table_context.push_context.keys = (const uint64_t *)push_data.data();
+    table_context.push_context.values =
+        (const float *)(push_data.data() + sizeof(uint64_t) * num);
+  } else {
+    // keys and values encoded by the codec of the client
+    thread_local std::vector<uint64_t> push_keys;
+    thread_local std::vector<float> push_values;
+    size_t dim = table->GetValueAccessor()->GetAccessorInfo().update_dim;
+    size_t encoded_size = codec.ValueBytes(dim);
+    push_keys.resize(num);
+    push_values.resize(num * dim);
+    size_t keys_size = codec.DecodeKeys(
+        push_data.data(), push_data.size(), num, push_keys.data());
+    if (keys_size == 0 ||
+        push_data.size() - keys_size < num * encoded_size) {
+      set_response_code(response, -1, "PushSparse request is not in format");
+      return 0;
+    }
+    const char *value_data = push_data.data() + keys_size;
+    for (size_t i = 0; i < num; ++i) {
+      codec.DecodeValue(
+          value_data + i * encoded_size, dim, push_values.data() + i * dim);
+    }
+    table_context.push_context.keys = push_keys.data();
+    table_context.push_context.values = push_values.data();
+  }
   table_context.num = num;
   // const uint64_t *keys = (const uint64_t *)push_data.data();
   // const float *values = (const float *)(push_data.data() + sizeof(uint64_t) *
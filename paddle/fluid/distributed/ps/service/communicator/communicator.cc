@@ -292,7 +292,6 @@ void Communicator::RpcSendSparse(const std::string &var_name,
                                  const Scope &scope) {
   phi::RecordEvent record_event(
       "Communicator->RpcSendSparse", phi::TracerEventType::Communication, 1);
-  size_t request_call_num = _worker_ptr->GetServerNums();
   std::vector<uint64_t> sparse_push_keys;
   std::vector<float *> push_g_vec;
 
@@ -320,6 +319,49 @@ void Communicator::RpcSendSparse(const std::string &var_name,
   }
   */
 
+  PushSparseRawGradient(table_id,
+                        sparse_push_keys.data(),
+                        (const float **)push_g_vec.data(),
+                        sparse_push_keys.size());
+}
+
+void Communicator::RpcSendMergedSparse(
+    const std::vector<std::shared_ptr<Variable>> &vars,
+    int table_id,
+    SparseKeyMerger *merger) {
+  phi::RecordEvent record_event("Communicator->RpcSendMergedSparse",
+                                phi::TracerEventType::Communication,
+                                1);
+  auto &slr0 = vars[0]->Get<phi::SelectedRows>();
+  merger->Reset(slr0.value().dims()[1]);
+  for (auto &var : vars) {
+    auto &slr = var->Get<phi::SelectedRows>();
+    PADDLE_ENFORCE_EQ(
+        static_cast<size_t>(slr.value().dims()[1]),
+        merger->dim(),
+        common::errors::InvalidArgument("vars should have the same dims."));
+    const float *data = slr.value().data<float>();
+    for (size_t i = 0; i < slr.rows().size(); ++i) {
+      merger->Append(static_cast<uint64_t>(slr.rows()[i]),
+                     data + i * merger->dim());
+    }
+  }
+  merger->Merge();
+  sparse_merge_stat_.Add(merger->input_num(), merger->size());
+  VLOG(3) << "merge sparse grads of table " << table_id << " from "
+          << vars.size() << " vars, " << merger->input_num() << " keys -> "
+          << merger->size() << " keys, total "
+          << sparse_merge_stat_.ToString();
+
+  PushSparseRawGradient(
+      table_id, merger->keys(), merger->values(), merger->size());
+}
+
+void Communicator::PushSparseRawGradient(int table_id,
+                                         const uint64_t *keys,
+                                         const float **values,
+                                         size_t num) {
+  size_t request_call_num = _worker_ptr->GetServerNums();
   ++_async_call_num;
   DownpourBrpcClosure *closure = new DownpourBrpcClosure(
       request_call_num, [this, request_call_num](void *done) {
@@ -334,12 +376,8 @@ void Communicator::RpcSendSparse(const std::string &var_name,
         closure->set_promise_value(ret);
         --_async_call_num;
       });
-  auto status =
-      _worker_ptr->PushSparseRawGradient(table_id,
-                                         sparse_push_keys.data(),
-                                         (const float **)push_g_vec.data(),
-                                         sparse_push_keys.size(),
-                                         closure);
+  auto status = _worker_ptr->PushSparseRawGradient(
+      table_id, keys, values, num, closure);
   status.wait();
   return;
 }
@@ -534,7 +572,10 @@ void AsyncCommunicator::SendByCommunicator() {
       }
       if (merged_var_num == 0) return;
 
-      for (size_t i = 0; i < var_nums; i++) {
+      // sparse grads of all queued batches are deduplicated by the merger at
+      // once, instead of being merged into a SelectedRows of send_scope_
+      bool send_merged_sparse = ctx.is_sparse && !ctx.is_tensor_table;
+      for (size_t i = 0; i < var_nums && !send_merged_sparse; i++) {
         auto &var_name = varnames[i];
         if (var_name == STEP_COUNTER) {
           MergeVars<int64_t>(var_name, vars[i], send_scope_.get(), 1);
@@ -551,7 +592,8 @@ void AsyncCommunicator::SendByCommunicator() {
             1,
             common::errors::InvalidArgument(
                 "sparse variables can only be merged by one variables"));
-        RpcSendSparse(varnames[0], table_id, *send_scope_);
+        RpcSendMergedSparse(
+            vars[0], table_id, send_varname_to_merger_.at(varnames[0]).get());
       } else {
         RpcSendDense(ctx, *send_scope_);
         if (!independent_recv_ &&
@@ -716,12 +758,11 @@ void AsyncCommunicator::PushSparseFromTensorAsync(
           "outputs is %d, the size of inputs is %d",
           outputs->size(),
           inputs->size()));
-  std::vector<uint64_t> push_keys;
-  push_keys.reserve(MAX_FEASIGN_NUM / 100);
-  std::vector<std::vector<float>> push_values;
-  push_values.reserve(MAX_FEASIGN_NUM / 100);
+  // duplicated keys of the batch are merged before the push, the buffers of
+  // the merger are reused by the following calls of the thread
+  thread_local SparseKeyMerger merger;
+  merger.Reset(fea_dim);
   size_t output_len = 0;
-  size_t input_idx = 0;
 
   VLOG(2) << "fleet.cc::emb_dim: " << fea_dim << " batch_size: " << batch_size
           << " batch_size_consist: " << batch_size_consist;
@@ -756,21 +797,7 @@ void AsyncCommunicator::PushSparseFromTensorAsync(
           if (real_id == padding_id) {
             continue;
           }
-          push_keys.emplace_back(real_id);
-          push_values.emplace_back(fea_dim + 1);
-          // slot show clk grad... consistent with CtrCommonPushValue defined in
-          // ctr_accessor.h
-          push_values.back()[0] = 2;  // TODO(zhaocaibei123): slot
-          // push_values.back()[1] =
-          //    (i >= show_size ? 1 : static_cast<float>(show_tensor[i]));
-          // push_values.back()[2] =
-          //    (i >= clk_size ? 0 : static_cast<float>(clk_tensor[i]));
-
-          float *data = push_values.back().data() + 1;  // hard code here
-
-          memcpy(data, g + output_len, sizeof(float) * fea_dim);
-
-          ++input_idx;
+          merger.Append(real_id, g + output_len);
         }
       }
     } else {
@@ -779,21 +806,7 @@ void AsyncCommunicator::PushSparseFromTensorAsync(
         if (real_id == padding_id) {
           continue;
         }
-        push_keys.emplace_back(real_id);
-        push_values.emplace_back(fea_dim + 1);
-        // slot show clk grad... consistent with CtrCommonPushValue defined in
-        // ctr_accessor.h
-        push_values.back()[0] = 2;  // TODO(zhaocaibei123): slot
-        // push_values.back()[1] =
-        //    (i >= show_size ? 1 : static_cast<float>(show_tensor[i]));
-        // push_values.back()[2] =
-        //    (i >= clk_size ? 0 : static_cast<float>(clk_tensor[i]));
-
-        float *data = push_values.back().data() + 1;
-
-        memcpy(data, g + output_len, sizeof(float) * fea_dim);
-
-        ++input_idx;
+        merger.Append(real_id, g + output_len);
       }
     }
     PADDLE_ENFORCE_EQ(
@@ -805,21 +818,29 @@ void AsyncCommunicator::PushSparseFromTensorAsync(
             static_cast<int64_t>(output_len)));
   }
 
-  std::vector<float *> push_g_vec(input_idx, nullptr);
-
-  for (auto i = 0u; i < push_keys.size(); ++i) {
-    push_g_vec[i] = push_values.at(i).data();
-  }
+  // slot show clk grad... consistent with CtrCommonPushValue defined in
+  // ctr_accessor.h, show clk and grads of a key are summed like
+  // CtrCommonAccessor::Merge does
+  merger.Merge(
+      fea_dim + 1,
+      [fea_dim](float *dst, const float *src) {
+        dst[0] = 2;  // TODO(zhaocaibei123): slot
+        memcpy(dst + 1, src, sizeof(float) * fea_dim);
+      },
+      [fea_dim](float *dst, const float *src) {
+        for (int i = 0; i < fea_dim; ++i) {
+          dst[i + 1] += src[i];
+        }
+      });
+  sparse_merge_stat_.Add(merger.input_num(), merger.size());
 
   PADDLE_ENFORCE_EQ(
       this->Check(table_id),
       true,
       common::errors::InvalidArgument(
           "can not find table: %s, please check your config", table_id));
-  auto status = _worker_ptr->PushSparse(table_id,
-                                        push_keys.data(),
-                                        (const float **)push_g_vec.data(),
-                                        push_keys.size());
+  auto status = _worker_ptr->PushSparse(
+      table_id, merger.keys(), merger.values(), merger.size());
 }
 
 void HalfAsyncCommunicator::MainThread() {
@@ -856,6 +877,10 @@ void AsyncCommunicator::InitImpl(const RpcCtxMap &send_varname_to_ctx,
           std::make_shared<BlockingQueue<std::shared_ptr<Variable>>>(
               send_queue_size_);
     }
+    if (ctx.is_sparse) {
+      send_varname_to_merger_[varnames[0]] =
+          std::make_unique<SparseKeyMerger>();
+    }
   }
   send_threadpool_ = std::make_unique<::ThreadPool>(thread_pool_size_);
 }
@@ -1023,7 +1048,9 @@ void HalfAsyncCommunicator::SendByCommunicator() {
         auto &var_name = varnames[i];
         auto &var_queue = send_varname_to_queue_[var_name];
         for (int j = 0; j < batches; j++) vars[i].push_back(var_queue->Pop());
-        MergeVars<float>(var_name, vars[i], send_scope_.get(), 1);
+        if (!ctx.is_sparse) {
+          MergeVars<float>(var_name, vars[i], send_scope_.get(), 1);
+        }
       }
 
       if (ctx.is_sparse) {
@@ -1032,7 +1059,8 @@ void HalfAsyncCommunicator::SendByCommunicator() {
             1,
             common::errors::InvalidArgument(
                 "sparse variables can only be merged by one variables"));
-        RpcSendSparse(varnames[0], table_id, *send_scope_);
+        RpcSendMergedSparse(
+            vars[0], table_id, send_varname_to_merger_.at(varnames[0]).get());
       } else {
         RpcSendDense(ctx, *send_scope_);
       }
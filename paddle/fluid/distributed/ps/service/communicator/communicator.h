@@ -31,6 +31,7 @@ limitations under the License. */
 
 #include "paddle/common/flags.h"
 #include "paddle/fluid/distributed/ps/service/communicator/communicator_common.h"
+#include "paddle/fluid/distributed/ps/service/communicator/sparse_key_merger.h"
 #include "paddle/fluid/distributed/ps/service/coordinator_client.h"
 #include "paddle/fluid/distributed/ps/service/ps_client.h"
 #include "paddle/fluid/framework/channel.h"
@@ -268,6 +269,11 @@ class Communicator {
   virtual void RpcSendSparse(const std::string &var_name,
                              int table_id,
                              const Scope &scope);
+  // 4.1 send the sparse grads of a whole send window, duplicated keys of all
+  // vars are merged by merger before the push
+  void RpcSendMergedSparse(const std::vector<std::shared_ptr<Variable>> &vars,
+                           int table_id,
+                           SparseKeyMerger *merger);
   // 5. send sparse param
   virtual void RpcSendSparseParam(const std::string &varname,
                                   int table_id,
@@ -420,6 +426,13 @@ class Communicator {
   Scope *recv_scope_;  // should be global scope
   std::unique_ptr<Scope> xpu_temp_scope_;
   std::atomic<uint32_t> _async_call_num{0};
+  SparseMergeStat sparse_merge_stat_;
+
+ private:
+  void PushSparseRawGradient(int table_id,
+                             const uint64_t *keys,
+                             const float **values,
+                             size_t num);
 };
 
 class AsyncCommunicator : public Communicator {
@@ -499,6 +512,9 @@ class AsyncCommunicator : public Communicator {
   std::unordered_map<std::string,
                      std::shared_ptr<BlockingQueue<std::shared_ptr<Variable>>>>
       send_varname_to_queue_;
+  // one per sparse var, only used by the send task of the var
+  std::unordered_map<std::string, std::unique_ptr<SparseKeyMerger>>
+      send_varname_to_merger_;
   std::unique_ptr<::ThreadPool> send_threadpool_{nullptr};
 
   int min_send_grad_num_before_recv_;
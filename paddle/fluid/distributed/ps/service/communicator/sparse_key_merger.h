@@ -0,0 +1,182 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "paddle/utils/string/string_helper.h"
+
+namespace paddle {
+namespace distributed {
+
+// Number of sparse keys before and after merging, summed over all pushes.
+struct SparseMergeStat {
+  std::atomic<uint64_t> input_num{0};
+  std::atomic<uint64_t> output_num{0};
+
+  void Add(size_t input, size_t output) {
+    input_num.fetch_add(input, std::memory_order_relaxed);
+    output_num.fetch_add(output, std::memory_order_relaxed);
+  }
+
+  std::string ToString() const {
+    uint64_t input = input_num.load();
+    uint64_t output = output_num.load();
+    return ::paddle::string::format_string(
+        "input_keys:%lu merged_keys:%lu compression_ratio:%.4f",
+        input,
+        output,
+        output == 0 ? 1.0 : static_cast<double>(input) / output);
+  }
+};
+
+// Merges the sparse gradients of equal keys before they are pushed.
+//
+// The caller appends (key, value) pairs of one send window, e.g. all queued
+// batches of a variable, then calls Merge once. Keys are radix sorted
+// together with their position, so the values of a key are merged in the
+// order they were appended and the result does not depend on hashing. The
+// inputs are only referenced until Merge returns; the merged values live in
+// an arena owned by the merger. All buffers are kept across Reset, so once
+// they have grown to the size of a window merging does not allocate. It is
+// not thread safe.
+class SparseKeyMerger {
+ public:
+  // starts a new window of values with dim floats each
+  void Reset(size_t dim) {
+    _dim = dim;
+    _entries.clear();
+    _inputs.clear();
+    _keys.clear();
+    _values.clear();
+    _value_ptrs.clear();
+  }
+
+  void Append(uint64_t key, const float* value) {
+    _entries.push_back({key, static_cast<uint32_t>(_inputs.size())});
+    _inputs.push_back(value);
+  }
+
+  // Merges the values of equal keys into merged_dim floats per key.
+  // first(dst, src) initializes dst from the first value of a key, and
+  // add(dst, src) folds each later value of the key into it.
+  template <class FIRST, class ADD>
+  void Merge(size_t merged_dim, FIRST&& first, ADD&& add) {
+    SortEntries();
+    size_t key_num = 0;
+    for (size_t i = 0; i < _entries.size(); ++i) {
+      key_num += i == 0 || _entries[i].key != _entries[i - 1].key;
+    }
+    _keys.resize(key_num);
+    _values.resize(key_num * merged_dim);
+    _value_ptrs.resize(key_num);
+    float* dst = nullptr;
+    size_t key_idx = 0;
+    for (size_t i = 0; i < _entries.size(); ++i) {
+      const float* src = _inputs[_entries[i].index];
+      if (i == 0 || _entries[i].key != _entries[i - 1].key) {
+        dst = _values.data() + key_idx * merged_dim;
+        _keys[key_idx] = _entries[i].key;
+        _value_ptrs[key_idx] = dst;
+        ++key_idx;
+        first(dst, src);
+      } else {
+        add(dst, src);
+      }
+    }
+  }
+
+  // sums the values of equal keys
+  void Merge() {
+    size_t dim = _dim;
+    Merge(
+        dim,
+        [dim](float* dst, const float* src) {
+          memcpy(dst, src, dim * sizeof(float));
+        },
+        [dim](float* dst, const float* src) {
+          for (size_t i = 0; i < dim; ++i) {
+            dst[i] += src[i];
+          }
+        });
+  }
+
+  size_t dim() const { return _dim; }
+  // number of appended values
+  size_t input_num() const { return _inputs.size(); }
+  // number of distinct keys, valid after Merge
+  size_t size() const { return _keys.size(); }
+  const uint64_t* keys() const { return _keys.data(); }
+  const float** values() {
+    return const_cast<const float**>(_value_ptrs.data());
+  }
+
+ private:
+  struct Entry {
+    uint64_t key;
+    uint32_t index;
+  };
+
+  static const size_t kRadixSortMinNum = 256;
+
+  // stable LSD radix sort by key, bytes equal in all keys are skipped
+  void SortEntries() {
+    size_t num = _entries.size();
+    if (num < kRadixSortMinNum) {
+      std::stable_sort(
+          _entries.begin(),
+          _entries.end(),
+          [](const Entry& a, const Entry& b) { return a.key < b.key; });
+      return;
+    }
+    uint64_t diff = 0;
+    for (auto& entry : _entries) {
+      diff |= entry.key ^ _entries[0].key;
+    }
+    _sort_buffer.resize(num);
+    for (int shift = 0; shift < 64; shift += 8) {
+      if (((diff >> shift) & 0xff) == 0) {
+        continue;
+      }
+      size_t offsets[257] = {0};
+      for (auto& entry : _entries) {
+        ++offsets[((entry.key >> shift) & 0xff) + 1];
+      }
+      for (int i = 1; i < 257; ++i) {
+        offsets[i] += offsets[i - 1];
+      }
+      for (auto& entry : _entries) {
+        _sort_buffer[offsets[(entry.key >> shift) & 0xff]++] = entry;
+      }
+      _entries.swap(_sort_buffer);
+    }
+  }
+
+  size_t _dim = 0;
+  std::vector<Entry> _entries;
+  std::vector<Entry> _sort_buffer;
+  std::vector<const float*> _inputs;
+  std::vector<uint64_t> _keys;
+  std::vector<float> _values;
+  std::vector<float*> _value_ptrs;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -67,6 +67,26 @@ int32_t PSClient::Configure(  // called in FleetWrapper::InitWorker
   return Initialize();
 }
 
+std::future<int32_t> PSClient::PushSparseSplit(size_t table_id,
+                                               const uint64_t *keys,
+                                               const float **headers,
+                                               size_t header_dim,
+                                               const float **grads,
+                                               size_t num) {
+  size_t update_dim = GetTableAccessor(table_id)->GetAccessorInfo().update_dim;
+  std::vector<float> update_values(num * update_dim);
+  std::vector<const float *> update_value_ptrs(num);
+  for (size_t i = 0; i < num; ++i) {
+    float *update_value = update_values.data() + i * update_dim;
+    memcpy(update_value, headers[i], header_dim * sizeof(float));
+    memcpy(update_value + header_dim,
+           grads[i],
+           (update_dim - header_dim) * sizeof(float));
+    update_value_ptrs[i] = update_value;
+  }
+  return PushSparse(table_id, keys, update_value_ptrs.data(), num);
+}
+
 PSClient *PSClientFactory::Create(const PSParameter &ps_config) {
   const auto &config = ps_config.server_param();
   if (!config.has_downpour_server_param()) {
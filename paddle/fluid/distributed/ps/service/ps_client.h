@@ -291,6 +291,15 @@ class PSClient {
                                           const uint64_t *keys,
                                           const float **update_values,
                                           size_t num) = 0;
+  // Like PushSparse, but the first header_dim fields of update value i are
+  // headers[i] and the rest grads[i]. Clients that send the values join
+  // them, the local client hands both parts to the table as they are.
+  virtual std::future<int32_t> PushSparseSplit(size_t table_id,
+                                               const uint64_t *keys,
+                                               const float **headers,
+                                               size_t header_dim,
+                                               const float **grads,
+                                               size_t num);
 
   // for save cache
   virtual std::future<int32_t> CacheShuffle(uint32_t table_id UNUSED,
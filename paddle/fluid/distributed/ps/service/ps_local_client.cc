@@ -224,6 +224,28 @@ int32_t PsLocalClient::Initialize() {
   return done();
 }
 
+::std::future<int32_t> PsLocalClient::PullSparse(float** select_values,
+                                                 size_t table_id,
+                                                 const uint64_t* keys,
+                                                 size_t num,
+                                                 bool is_training) {
+  auto* table_ptr = GetTable(table_id);
+  auto* accessor = GetTableAccessor(table_id);
+
+  PullSparseValue pull_value(num, accessor->GetAccessorInfo().select_dim);
+  pull_value.is_training_ = is_training;
+  pull_value.feasigns_ = const_cast<uint64_t*>(keys);
+
+  TableContext table_context;
+  table_context.value_type = Sparse;
+  table_context.pull_context.pull_value = pull_value;
+  table_context.pull_context.select_values = select_values;
+  table_context.num = num;
+  table_ptr->Pull(table_context);
+
+  return done();
+}
+
 ::std::future<int32_t> PsLocalClient::PullSparsePtr(
     int shard_id,
     char** select_values,
@@ -251,9 +273,11 @@ int32_t PsLocalClient::Initialize() {
   table_context.pass_id = pass_id;
 
   //  table_ptr->PullSparsePtr(select_values, keys, num);
-  table_ptr->Pull(table_context);
+  int32_t ret = table_ptr->Pull(table_context);
 
-  return done();
+  std::promise<int32_t> prom;
+  prom.set_value(ret);
+  return prom.get_future();
 }
 
 ::std::future<int32_t> PsLocalClient::PrintTableStat(uint32_t table_id,
@@ -325,6 +349,27 @@ int32_t PsLocalClient::Initialize() {
   return done();
 }
 
+::std::future<int32_t> PsLocalClient::PushSparseSplit(size_t table_id,
+                                                      const uint64_t* keys,
+                                                      const float** headers,
+                                                      size_t header_dim,
+                                                      const float** grads,
+                                                      size_t num) {
+  auto* table_ptr = GetTable(table_id);
+
+  TableContext table_context;
+  table_context.value_type = Sparse;
+  table_context.push_context.keys = keys;
+  table_context.push_context.ptr_values = grads;
+  table_context.push_context.ptr_headers = headers;
+  table_context.push_context.header_dim = header_dim;
+  table_context.num = num;
+  table_context.use_ptr = true;
+
+  table_ptr->Push(table_context);
+  return done();
+}
+
 ::std::future<int32_t> PsLocalClient::SetDayId(size_t table_id, int day_id) {
   auto* table_ptr = GetTable(table_id);
   table_ptr->SetDayId(day_id);
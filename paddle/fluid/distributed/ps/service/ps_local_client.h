@@ -65,18 +65,16 @@ class PsLocalClient : public PSClient {
                                                 size_t region_num,
                                                 size_t table_id);
 
-  virtual ::std::future<int32_t> PullSparse(float** select_values UNUSED,
-                                            size_t table_id UNUSED,
-                                            const uint64_t* keys UNUSED,
-                                            size_t num UNUSED,
-                                            bool is_training UNUSED) {
-    std::promise<int32_t> prom;
-    std::future<int32_t> fut = prom.get_future();
-    prom.set_value(0);
-
-    return fut;
-  }
+  // the table selects each value straight into select_values[i]
+  virtual ::std::future<int32_t> PullSparse(float** select_values,
+                                            size_t table_id,
+                                            const uint64_t* keys,
+                                            size_t num,
+                                            bool is_training);
 
+  // returns pointers to the values inside the table, they stay valid for
+  // the pass (see the PullSparsePtr of each table). The future holds the
+  // table's status, e.g. -1 when an SSD table can not pin the pass.
   virtual ::std::future<int32_t> PullSparsePtr(
       const int shard_id,
       char** select_values,
@@ -100,6 +98,14 @@ class PsLocalClient : public PSClient {
                                             const float** update_values,
                                             size_t num);
 
+  // the table reads the headers and the gradients in place
+  virtual ::std::future<int32_t> PushSparseSplit(size_t table_id,
+                                                 const uint64_t* keys,
+                                                 const float** headers,
+                                                 size_t header_dim,
+                                                 const float** grads,
+                                                 size_t num);
+
   virtual ::std::future<int32_t> Flush();
   // server profiler
   virtual std::future<int32_t> StartProfiler() {
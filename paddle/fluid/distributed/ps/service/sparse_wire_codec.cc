@@ -0,0 +1,275 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/service/sparse_wire_codec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "paddle/common/enforce.h"
+#include "paddle/phi/common/bfloat16.h"
+#include "paddle/phi/common/float16.h"
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+const size_t kHeaderSize = 8;
+const char kHeaderMagic[2] = {'S', 'W'};
+
+inline void AppendVarint(uint64_t value, std::string* out) {
+  char buffer[10];
+  int len = 0;
+  while (value >= 0x80) {
+    buffer[len++] = static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  buffer[len++] = static_cast<char>(value);
+  out->append(buffer, len);
+}
+
+// returns the number of bytes read, 0 if data ends inside the varint
+inline size_t ReadVarint(const char* data, size_t size, uint64_t* value) {
+  uint64_t result = 0;
+  for (size_t i = 0; i < size && i < 10; ++i) {
+    uint64_t byte = static_cast<uint8_t>(data[i]);
+    result |= (byte & 0x7f) << (7 * i);
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+SparseWireCodec::SparseWireCodec(const SparseWireCodecParameter& param,
+                                 uint32_t exact_dim)
+    : _delta_keys(param.delta_keys()), _exact_dim(exact_dim) {
+  PADDLE_ENFORCE_EQ(
+      ParseValueType(param.value_type(), &_value_type),
+      0,
+      common::errors::InvalidArgument(
+          "Unsupported sparse wire codec value_type %s, expected raw, fp16, "
+          "bf16 or int8.",
+          param.value_type()));
+}
+
+int SparseWireCodec::ParseValueType(const std::string& name,
+                                    ValueType* value_type) {
+  if (name == "raw") {
+    *value_type = kRaw;
+  } else if (name == "fp16") {
+    *value_type = kFp16;
+  } else if (name == "bf16") {
+    *value_type = kBf16;
+  } else if (name == "int8") {
+    *value_type = kInt8;
+  } else {
+    return -1;
+  }
+  return 0;
+}
+
+std::string SparseWireCodec::Serialize() const {
+  /*
+  |--magic--|--valueType--|--deltaKeys--|--exactDim--|
+  |---2B----|-----1B------|-----1B------|-----4B-----|
+  */
+  std::string header(kHeaderSize, '\0');
+  memcpy(&header[0], kHeaderMagic, sizeof(kHeaderMagic));
+  header[2] = static_cast<char>(_value_type);
+  header[3] = static_cast<char>(_delta_keys);
+  memcpy(&header[4], &_exact_dim, sizeof(uint32_t));
+  return header;
+}
+
+int SparseWireCodec::Deserialize(const std::string& header) {
+  if (header.size() != kHeaderSize ||
+      memcmp(header.data(), kHeaderMagic, sizeof(kHeaderMagic)) != 0 ||
+      static_cast<uint8_t>(header[2]) > kInt8) {
+    return -1;
+  }
+  _value_type = static_cast<ValueType>(header[2]);
+  _delta_keys = header[3] != 0;
+  memcpy(&_exact_dim, &header[4], sizeof(uint32_t));
+  return 0;
+}
+
+void SparseWireCodec::EncodeKeys(const uint64_t* keys,
+                                 size_t num,
+                                 std::string* out) const {
+  if (!_delta_keys) {
+    out->append(reinterpret_cast<const char*>(keys), num * sizeof(uint64_t));
+    return;
+  }
+  uint64_t last_key = 0;
+  for (size_t i = 0; i < num; ++i) {
+    // wraps around for unsorted keys, DecodeKeys wraps back
+    AppendVarint(keys[i] - last_key, out);
+    last_key = keys[i];
+  }
+}
+
+size_t SparseWireCodec::DecodeKeys(const char* data,
+                                   size_t size,
+                                   size_t num,
+                                   uint64_t* keys) const {
+  if (!_delta_keys) {
+    if (size < num * sizeof(uint64_t)) {
+      return 0;
+    }
+    memcpy(keys, data, num * sizeof(uint64_t));
+    return num * sizeof(uint64_t);
+  }
+  size_t pos = 0;
+  uint64_t last_key = 0;
+  for (size_t i = 0; i < num; ++i) {
+    uint64_t delta = 0;
+    size_t len = ReadVarint(data + pos, size - pos, &delta);
+    if (len == 0) {
+      return 0;
+    }
+    pos += len;
+    last_key += delta;
+    keys[i] = last_key;
+  }
+  return pos;
+}
+
+void SparseWireCodec::EncodeCounts(const uint32_t* counts,
+                                   size_t num,
+                                   std::string* out) const {
+  if (!_delta_keys) {
+    out->append(reinterpret_cast<const char*>(counts), num * sizeof(uint32_t));
+    return;
+  }
+  for (size_t i = 0; i < num; ++i) {
+    AppendVarint(counts[i], out);
+  }
+}
+
+size_t SparseWireCodec::DecodeCounts(const char* data,
+                                     size_t size,
+                                     size_t num,
+                                     uint32_t* counts) const {
+  if (!_delta_keys) {
+    if (size < num * sizeof(uint32_t)) {
+      return 0;
+    }
+    memcpy(counts, data, num * sizeof(uint32_t));
+    return num * sizeof(uint32_t);
+  }
+  size_t pos = 0;
+  for (size_t i = 0; i < num; ++i) {
+    uint64_t count = 0;
+    size_t len = ReadVarint(data + pos, size - pos, &count);
+    if (len == 0 || count > UINT32_MAX) {
+      return 0;
+    }
+    pos += len;
+    counts[i] = static_cast<uint32_t>(count);
+  }
+  return pos;
+}
+
+size_t SparseWireCodec::ValueBytes(size_t dim) const {
+  size_t exact_dim = std::min<size_t>(_exact_dim, dim);
+  size_t quant_dim = dim - exact_dim;
+  switch (_value_type) {
+    case kFp16:
+    case kBf16:
+      return exact_dim * sizeof(float) + quant_dim * sizeof(uint16_t);
+    case kInt8:
+      return exact_dim * sizeof(float) +
+             (quant_dim > 0 ? sizeof(float) + quant_dim : 0);
+    default:
+      return dim * sizeof(float);
+  }
+}
+
+void SparseWireCodec::EncodeValue(const float* value,
+                                  size_t dim,
+                                  char* out) const {
+  size_t exact_dim =
+      _value_type == kRaw ? dim : std::min<size_t>(_exact_dim, dim);
+  memcpy(out, value, exact_dim * sizeof(float));
+  out += exact_dim * sizeof(float);
+  if (exact_dim == dim) {
+    return;
+  }
+  if (_value_type == kFp16 || _value_type == kBf16) {
+    for (size_t i = exact_dim; i < dim; ++i) {
+      uint16_t bits = _value_type == kFp16 ? phi::dtype::float16(value[i]).x
+                                           : phi::dtype::bfloat16(value[i]).x;
+      memcpy(out, &bits, sizeof(uint16_t));
+      out += sizeof(uint16_t);
+    }
+    return;
+  }
+  // int8, symmetric with one scale per value
+  float max_abs = 0;
+  for (size_t i = exact_dim; i < dim; ++i) {
+    max_abs = std::max(max_abs, std::fabs(value[i]));
+  }
+  float scale = max_abs / 127.0f;
+  memcpy(out, &scale, sizeof(float));
+  out += sizeof(float);
+  for (size_t i = exact_dim; i < dim; ++i) {
+    float q = scale > 0 ? std::round(value[i] / scale) : 0.0f;
+    *out++ = static_cast<char>(
+        static_cast<int8_t>(std::min(std::max(q, -127.0f), 127.0f)));
+  }
+}
+
+void SparseWireCodec::DecodeValue(const char* data,
+                                  size_t dim,
+                                  float* value) const {
+  size_t exact_dim =
+      _value_type == kRaw ? dim : std::min<size_t>(_exact_dim, dim);
+  memcpy(value, data, exact_dim * sizeof(float));
+  data += exact_dim * sizeof(float);
+  if (exact_dim == dim) {
+    return;
+  }
+  if (_value_type == kFp16 || _value_type == kBf16) {
+    phi::dtype::float16 fp16;
+    phi::dtype::bfloat16 bf16;
+    for (size_t i = exact_dim; i < dim; ++i) {
+      uint16_t bits = 0;
+      memcpy(&bits, data, sizeof(uint16_t));
+      data += sizeof(uint16_t);
+      if (_value_type == kFp16) {
+        fp16.x = bits;
+        value[i] = static_cast<float>(fp16);
+      } else {
+        bf16.x = bits;
+        value[i] = static_cast<float>(bf16);
+      }
+    }
+    return;
+  }
+  float scale = 0;
+  memcpy(&scale, data, sizeof(float));
+  data += sizeof(float);
+  for (size_t i = exact_dim; i < dim; ++i) {
+    value[i] = static_cast<int8_t>(*data++) * scale;
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
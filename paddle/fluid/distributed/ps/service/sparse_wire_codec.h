@@ -0,0 +1,89 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+
+namespace paddle {
+namespace distributed {
+
+// Wire format of the keys and values of sparse push/pull requests between
+// BrpcPsClient and BrpcPsService.
+//
+// Keys are delta encoded against the previous key and written as varints,
+// which is compact for the sorted keys of a request (any order still decodes
+// correctly). Every value is written with a fixed number of bytes: its first
+// exact_dim floats (e.g. slot, show and click) stay fp32, the others are
+// quantized to fp16, bf16, or int8 with a fp32 scale per value.
+//
+// The client puts the serialized codec into the request params, and the
+// server decodes the request and encodes the response with it; requests
+// without it use the raw format.
+class SparseWireCodec {
+ public:
+  enum ValueType : uint8_t { kRaw = 0, kFp16 = 1, kBf16 = 2, kInt8 = 3 };
+
+  SparseWireCodec() = default;
+  SparseWireCodec(ValueType value_type, bool delta_keys, uint32_t exact_dim)
+      : _value_type(value_type),
+        _delta_keys(delta_keys),
+        _exact_dim(exact_dim) {}
+  SparseWireCodec(const SparseWireCodecParameter& param, uint32_t exact_dim);
+
+  static int ParseValueType(const std::string& name, ValueType* value_type);
+
+  bool IsRaw() const { return _value_type == kRaw && !_delta_keys; }
+  ValueType value_type() const { return _value_type; }
+  bool delta_keys() const { return _delta_keys; }
+  uint32_t exact_dim() const { return _exact_dim; }
+
+  // fixed size header shipped in the request params
+  std::string Serialize() const;
+  // returns 0 on success, -1 if the header is malformed
+  int Deserialize(const std::string& header);
+
+  // appends num keys to out
+  void EncodeKeys(const uint64_t* keys, size_t num, std::string* out) const;
+  // Decodes num keys from data of size bytes into keys. Returns the number of
+  // bytes read, or 0 if data is malformed.
+  size_t DecodeKeys(const char* data,
+                    size_t size,
+                    size_t num,
+                    uint64_t* keys) const;
+  // the same for uint32 counters, e.g. the key frequencies of a pull
+  void EncodeCounts(const uint32_t* counts, size_t num, std::string* out) const;
+  size_t DecodeCounts(const char* data,
+                      size_t size,
+                      size_t num,
+                      uint32_t* counts) const;
+
+  // bytes of one encoded value of dim floats
+  size_t ValueBytes(size_t dim) const;
+  // writes ValueBytes(dim) bytes to out
+  void EncodeValue(const float* value, size_t dim, char* out) const;
+  void DecodeValue(const char* data, size_t dim, float* value) const;
+
+ private:
+  ValueType _value_type = kRaw;
+  bool _delta_keys = false;
+  uint32_t _exact_dim = 0;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -15,6 +15,7 @@
 #pragma once
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <unordered_map>
 #include <vector>
@@ -150,6 +151,33 @@ class ValueAccessor {
   virtual int32_t Update(float** values,
                          const float** update_values,
                          size_t num) = 0;
+  // Like Update, but update value i is split in two: its first header_dim
+  // fields are in push_headers[i] and the rest in push_grads[i], so a
+  // trainer can push gradients from its own memory behind a small header.
+  // The default joins every pair in a scratch buffer and calls Update.
+  virtual int32_t SplitUpdate(float** values,
+                              const float** push_headers,
+                              size_t header_dim,
+                              const float** push_grads,
+                              size_t num) {
+    std::vector<float> update_value(_accessor_info.update_dim);
+    const float* update_value_ptr = update_value.data();
+    for (size_t i = 0; i < num; ++i) {
+      JoinSplitValue(
+          push_headers[i], header_dim, push_grads[i], update_value.data());
+      Update(values + i, &update_value_ptr, 1);
+    }
+    return 0;
+  }
+  // CreateValue for an update value split like in SplitUpdate
+  bool SplitCreateValue(int type,
+                        const float* push_header,
+                        size_t header_dim,
+                        const float* push_grad) {
+    std::vector<float> update_value(_accessor_info.update_dim);
+    JoinSplitValue(push_header, header_dim, push_grad, update_value.data());
+    return CreateValue(type, update_value.data());
+  }
 
   // used to save model, will filter feature
   virtual std::string ParseToString(const float* value, int param) = 0;
@@ -195,6 +223,16 @@ class ValueAccessor {
   virtual int get_##field##_index() { return class ::field##_index(); }
 
  protected:
+  void JoinSplitValue(const float* push_header,
+                      size_t header_dim,
+                      const float* push_grad,
+                      float* update_value) const {
+    memcpy(update_value, push_header, header_dim * sizeof(float));
+    memcpy(update_value + header_dim,
+           push_grad,
+           (_accessor_info.update_dim - header_dim) * sizeof(float));
+  }
+
   size_t _value_size;
   size_t _select_value_size;
   size_t _update_value_size;
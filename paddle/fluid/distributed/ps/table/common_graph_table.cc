@@ -24,6 +24,7 @@
 
 #include "paddle/common/flags.h"
 #include "paddle/fluid/distributed/common/utils.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_file_reader.h"
 #include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
 #include "paddle/fluid/framework/fleet/heter_ps/graph_gpu_wrapper.h"
@@ -33,10 +34,12 @@
 #include "paddle/fluid/framework/io/fs.h"
 #include "paddle/phi/core/generator.h"
 #include "paddle/phi/core/platform/timer.h"
+#include "paddle/utils/string/parse_digits.h"
 #include "paddle/utils/string/printf.h"
 #include "paddle/utils/string/string_helper.h"
 
 COMMON_DECLARE_bool(graph_load_in_parallel);
+COMMON_DECLARE_bool(graph_load_with_mmap);
 COMMON_DECLARE_bool(graph_get_neighbor_id);
 COMMON_DECLARE_int32(gpugraph_storage_mode);
 COMMON_DECLARE_uint64(gpugraph_slot_feasign_max_num);
@@ -1777,10 +1780,32 @@ void GraphShard::clear() {
   }
   bucket.clear();
   node_location.clear();
+  csr_blocks.clear();
 }
 
 GraphShard::~GraphShard() { clear(); }
 
+size_t GraphShard::finalize_edges() {
+  size_t edge_num = 0;
+  bool with_weight = false;
+  for (auto &node : bucket) {
+    edge_num += node->get_neighbor_size();
+    with_weight = with_weight || node->has_neighbor_weight();
+  }
+  auto block = std::make_unique<GraphCsrEdges>();
+  block->ids.reserve(edge_num);
+  if (with_weight) {
+    block->weights.reserve(edge_num);
+  }
+  for (auto &node : bucket) {
+    node->freeze_edges(block.get(), with_weight);
+  }
+  // the nodes no longer reference the older blocks
+  csr_blocks.clear();
+  csr_blocks.push_back(std::move(block));
+  return edge_num;
+}
+
 void GraphShard::delete_node(uint64_t id) {
   auto iter = node_location.find(id);
   if (iter == node_location.end()) return;
@@ -2448,17 +2473,23 @@ int32_t GraphTable::load_nodes(const std::string &path,
     if (node_type.empty()) {
       VLOG(0) << "Begin GraphTable::load_nodes(), will load all node_type once";
     }
-    std::vector<std::future<std::pair<uint64_t, uint64_t>>> tasks;
-    for (size_t i = 0; i < paths.size(); i++) {
-      tasks.push_back(load_node_edge_task_pool->enqueue(
-          [&, i, this]() -> std::pair<uint64_t, uint64_t> {
-            return parse_node_file_parallel(paths[i], load_slot);
-          }));
-    }
-    for (size_t i = 0; i < tasks.size(); i++) {
-      auto res = tasks[i].get();
-      count += res.first;
-      valid_count += res.second;
+    if (FLAGS_graph_load_with_mmap) {
+      auto res = load_nodes_mmap(paths, node_type, idx, load_slot);
+      count = res.first;
+      valid_count = res.second;
+    } else {
+      std::vector<std::future<std::pair<uint64_t, uint64_t>>> tasks;
+      for (size_t i = 0; i < paths.size(); i++) {
+        tasks.push_back(load_node_edge_task_pool->enqueue(
+            [&, i, this]() -> std::pair<uint64_t, uint64_t> {
+              return parse_node_file_parallel(paths[i], load_slot);
+            }));
+      }
+      for (size_t i = 0; i < tasks.size(); i++) {
+        auto res = tasks[i].get();
+        count += res.first;
+        valid_count += res.second;
+      }
     }
   } else {
     VLOG(0) << "Begin GraphTable::load_nodes() node_type[" << node_type << "]";
@@ -2474,11 +2505,17 @@ int32_t GraphTable::load_nodes(const std::string &path,
       }
       idx = node_type_str_to_node_types_idx[node_type];
     }
-    for (auto path : paths) {
-      VLOG(2) << "Begin GraphTable::load_nodes(), path[" << path << "]";
-      auto res = parse_node_file(path, node_type, idx, load_slot);
-      count += res.first;
-      valid_count += res.second;
+    if (FLAGS_graph_load_with_mmap) {
+      auto res = load_nodes_mmap(paths, node_type, idx, load_slot);
+      count = res.first;
+      valid_count = res.second;
+    } else {
+      for (auto path : paths) {
+        VLOG(2) << "Begin GraphTable::load_nodes(), path[" << path << "]";
+        auto res = parse_node_file(path, node_type, idx, load_slot);
+        count += res.first;
+        valid_count += res.second;
+      }
     }
   }
   if (is_parse_node_fail_) {
@@ -2502,6 +2539,22 @@ int32_t GraphTable::build_sampler(int idx, std::string sample_type) {
   return 0;
 }
 
+int32_t GraphTable::finalize_edges(int idx) {
+  std::vector<std::future<size_t>> tasks;
+  auto &shards = edge_shards[idx];
+  for (size_t i = 0; i < shards.size(); ++i) {
+    tasks.push_back(_shards_task_pool[i % task_pool_size_]->enqueue(
+        [&, i]() -> size_t { return shards[i]->finalize_edges(); }));
+  }
+  size_t edge_num = 0;
+  for (auto &task : tasks) {
+    edge_num += task.get();
+  }
+  VLOG(0) << "finalize " << edge_num << " edges of edge_type["
+          << id_to_edge[idx] << "] into csr arrays";
+  return 0;
+}
+
 std::pair<uint64_t, uint64_t> GraphTable::parse_edge_file(
     const std::string &path, int idx, bool reverse, bool use_weight) {
   is_weighted_ = use_weight;
@@ -2583,6 +2636,351 @@ std::pair<uint64_t, uint64_t> GraphTable::parse_edge_file(
   return {local_count, local_valid_count};
 }
 
+namespace {
+
+const size_t kMinGraphFileChunkSize = 1 << 20;
+const size_t kMaxGraphFileChunkSize = 64 << 20;
+
+// Maps the files, splits them into chunks of whole lines and loads them in
+// waves of thread_num chunks: parse_chunk(slot, file, begin, end) runs on the
+// chunks of a wave in parallel and buckets their records by shard, then
+// insert_shard(index, wave_size) runs once per shard index in parallel, so
+// that every shard is written by one thread at a time without locks.
+template <typename ParseChunk, typename InsertShard>
+void load_text_files(const std::vector<std::string> &paths,
+                     ::ThreadPool *pool,
+                     size_t thread_num,
+                     size_t shard_count,
+                     ParseChunk parse_chunk,
+                     InsertShard insert_shard) {
+  struct Chunk {
+    size_t file;
+    size_t begin;
+    size_t end;
+  };
+  std::vector<std::unique_ptr<MmapTextFile>> files(paths.size());
+  size_t total_size = 0;
+  for (size_t i = 0; i < paths.size(); ++i) {
+    files[i] = std::make_unique<MmapTextFile>();
+    if (files[i]->open(paths[i]) != 0) {
+      VLOG(0) << "fail to open graph file " << paths[i];
+      continue;
+    }
+    total_size += files[i]->size();
+  }
+  size_t chunk_size = std::min(
+      std::max(total_size / thread_num, kMinGraphFileChunkSize),
+      kMaxGraphFileChunkSize);
+  std::vector<Chunk> chunks;
+  std::vector<size_t> last_chunk(paths.size(), 0);
+  for (size_t i = 0; i < files.size(); ++i) {
+    for (auto &range :
+         split_text_chunks(files[i]->data(), files[i]->size(), chunk_size)) {
+      chunks.push_back({i, range.first, range.second});
+    }
+    last_chunk[i] = chunks.size();
+  }
+
+  for (size_t start = 0; start < chunks.size(); start += thread_num) {
+    size_t wave_size = std::min(thread_num, chunks.size() - start);
+    std::vector<std::future<int>> tasks;
+    for (size_t slot = 0; slot < wave_size; ++slot) {
+      tasks.push_back(pool->enqueue([&, slot]() -> int {
+        const Chunk &chunk = chunks[start + slot];
+        const char *data = files[chunk.file]->data();
+        parse_chunk(slot, chunk.file, data + chunk.begin, data + chunk.end);
+        return 0;
+      }));
+    }
+    for (auto &task : tasks) {
+      task.get();
+    }
+    tasks.clear();
+    for (size_t index = 0; index < shard_count; ++index) {
+      tasks.push_back(pool->enqueue([&, index]() -> int {
+        insert_shard(index, wave_size);
+        return 0;
+      }));
+    }
+    for (auto &task : tasks) {
+      task.get();
+    }
+    // unmap the files whose chunks are all loaded
+    for (size_t i = 0; i < files.size(); ++i) {
+      if (last_chunk[i] <= start + wave_size) {
+        files[i]->close();
+      }
+    }
+  }
+}
+
+inline const char *next_line(const char *p, const char *end) {
+  const void *newline = memchr(p, '\n', end - p);
+  return newline == nullptr ? end : static_cast<const char *>(newline);
+}
+
+}  // namespace
+
+std::pair<uint64_t, uint64_t> GraphTable::load_edges_mmap(
+    const std::vector<std::string> &paths,
+    int idx,
+    bool reverse,
+    bool use_weight) {
+  is_weighted_ = use_weight;
+  struct EdgeRecord {
+    uint64_t src_id;
+    uint64_t dst_id;
+    float weight;
+  };
+  size_t thread_num = load_thread_num_;
+  size_t shard_count = shard_end - shard_start;
+  // records of each chunk of a wave, by shard index
+  std::vector<std::vector<std::vector<EdgeRecord>>> buckets(
+      thread_num, std::vector<std::vector<EdgeRecord>>(shard_count));
+  std::vector<uint64_t> part_nums(paths.size(), 0);
+  if (FLAGS_graph_load_in_parallel) {
+    for (size_t i = 0; i < paths.size(); ++i) {
+      auto path_split =
+          ::paddle::string::split_string<std::string>(paths[i], "/");
+      auto part_name_split = ::paddle::string::split_string<std::string>(
+          path_split[path_split.size() - 1], "-");
+      part_nums[i] = std::stoull(part_name_split[part_name_split.size() - 1]);
+    }
+  }
+  bool hard_split = FLAGS_graph_edges_split_mode == "hard" ||
+                    FLAGS_graph_edges_split_mode == "HARD";
+  std::atomic<uint64_t> count(0);
+  std::atomic<uint64_t> valid_count(0);
+
+  auto parse_chunk =
+      [&](size_t slot, size_t file, const char *p, const char *end) {
+        auto &shard_edges = buckets[slot];
+        uint64_t local_count = 0;
+        while (p < end) {
+          const char *line = p;
+          const char *line_end = next_line(p, end);
+          p = line_end == end ? end : line_end + 1;
+          uint64_t src_id = 0;
+          uint64_t dst_id = 0;
+          // ids that overflow 64 bits parse as empty and skip the line
+          const char *pos =
+              paddle::string::ParseUint64Digits(line, line_end, &src_id);
+          if (pos == line || pos == line_end || *pos != '\t') continue;
+          const char *dst = pos + 1;
+          pos = paddle::string::ParseUint64Digits(dst, line_end, &dst_id);
+          if (pos == dst) continue;
+          local_count++;
+          if (reverse) {
+            std::swap(src_id, dst_id);
+          }
+          size_t src_shard_id = src_id % shard_num;
+          if (FLAGS_graph_load_in_parallel &&
+              src_shard_id != (part_nums[file] % shard_num)) {
+            continue;
+          }
+          if (src_shard_id >= shard_end || src_shard_id < shard_start) {
+            VLOG(4) << "will not load " << src_id << " from " << paths[file]
+                    << ", please check id distribution";
+            continue;
+          }
+          if (hard_split) {
+            // only keep hash(src_id) = hash(dst_id) = node_id edges
+            if (!is_key_for_self_rank(src_id)) {
+              continue;
+            }
+            if (!FLAGS_graph_edges_split_only_by_src_id &&
+                !is_key_for_self_rank(dst_id)) {
+              continue;
+            }
+          }
+          // the weight is the last field if there are more than two
+          float weight = 1;
+          const char *last = line_end;
+          while (last > pos && *(last - 1) != '\t') --last;
+          if (last > pos) {
+            // the last line of a mapped file is not null terminated
+            char buffer[64];
+            size_t len = std::min<size_t>(line_end - last, sizeof(buffer) - 1);
+            memcpy(buffer, last, len);
+            buffer[len] = '\0';
+            weight = std::strtof(buffer, nullptr);
+          }
+          shard_edges[src_shard_id - shard_start].push_back(
+              {src_id, dst_id, weight});
+        }
+        count += local_count;
+      };
+
+  auto insert_shard = [&](size_t index, size_t wave_size) {
+    auto &shard = edge_shards[idx][index];
+    uint64_t local_valid_count = 0;
+    for (size_t slot = 0; slot < wave_size; ++slot) {
+      auto &edges = buckets[slot][index];
+      GraphNode *node = nullptr;
+      for (auto &edge : edges) {
+        // edges of a node are mostly adjacent in the file
+        if (node == nullptr || node->get_id() != edge.src_id) {
+          node = shard->add_graph_node(edge.src_id);
+          if (node == nullptr) continue;
+          node->build_edges(is_weighted_);
+        }
+        node->add_edge(edge.dst_id, edge.weight);
+        local_valid_count++;
+      }
+      std::vector<EdgeRecord>().swap(edges);
+    }
+    valid_count += local_valid_count;
+  };
+
+  load_text_files(paths,
+                  load_node_edge_task_pool.get(),
+                  thread_num,
+                  shard_count,
+                  parse_chunk,
+                  insert_shard);
+  return {count, valid_count};
+}
+
+std::pair<uint64_t, uint64_t> GraphTable::load_nodes_mmap(
+    const std::vector<std::string> &paths,
+    const std::string &node_type,
+    int idx,
+    bool load_slot) {
+  struct NodeRecord {
+    int idx;
+    uint64_t id;
+    // the tab separated features of the line
+    const char *features;
+    size_t len;
+  };
+  size_t thread_num = load_thread_num_;
+  size_t shard_count = shard_end - shard_start;
+  std::vector<std::vector<std::vector<NodeRecord>>> buckets(
+      thread_num, std::vector<std::vector<NodeRecord>>(shard_count));
+  // lines start with their node type when loading all types at once
+  bool type_in_line = FLAGS_graph_load_in_parallel;
+  bool hard_split = FLAGS_graph_edges_split_mode == "hard" ||
+                    FLAGS_graph_edges_split_mode == "HARD";
+  size_t n = node_type.length();
+  std::atomic<uint64_t> count(0);
+  std::atomic<uint64_t> valid_count(0);
+
+  auto parse_chunk = [&](size_t slot,
+                         size_t file,
+                         const char *p,
+                         const char *end) {
+    auto &shard_nodes = buckets[slot];
+    uint64_t local_count = 0;
+    std::string last_type;
+    int type_idx = idx;
+    while (p < end) {
+      const char *line = p;
+      const char *line_end = next_line(p, end);
+      p = line_end == end ? end : line_end + 1;
+      const char *fields = line;
+      if (type_in_line) {
+        const char *tab = static_cast<const char *>(
+            memchr(line, '\t', line_end - line));
+        if (tab == nullptr) continue;
+        if (last_type.empty() ||
+            last_type.compare(0, std::string::npos, line, tab - line) != 0) {
+          auto it = node_type_str_to_node_types_idx.find(
+              std::string(line, tab - line));
+          if (it == node_type_str_to_node_types_idx.end()) {
+            VLOG(1) << std::string(line, tab - line)
+                    << " type error, please check, file[" << paths[file]
+                    << "]";
+            last_type.clear();
+            continue;
+          }
+          last_type.assign(line, tab - line);
+          type_idx = it->second;
+        }
+        fields = tab + 1;
+      } else {
+        if (static_cast<size_t>(line_end - line) < n ||
+            strncmp(line, node_type.c_str(), n) != 0) {
+          continue;
+        }
+        fields = line + n;
+        if (fields < line_end && *fields == '\t') ++fields;
+      }
+      uint64_t id = 0;
+      const char *pos =
+          paddle::string::ParseUint64Digits(fields, line_end, &id);
+      if (pos == fields) continue;
+      size_t shard_id = id % shard_num;
+      if (shard_id >= shard_end || shard_id < shard_start) {
+        VLOG(4) << "will not load " << id << " from " << paths[file]
+                << ", please check id distribution";
+        continue;
+      }
+      local_count++;
+      if (hard_split && !is_key_for_self_rank(id)) {
+        continue;
+      }
+      if (pos < line_end && *pos == '\t') ++pos;
+      shard_nodes[shard_id - shard_start].push_back(
+          {type_idx, id, pos, static_cast<size_t>(line_end - pos)});
+    }
+    count += local_count;
+  };
+
+  auto insert_shard = [&](size_t index, size_t wave_size) {
+    uint64_t local_valid_count = 0;
+    std::vector<::paddle::string::str_ptr> vals;
+    bool failed = false;
+    for (size_t slot = 0; slot < wave_size; ++slot) {
+      auto &nodes = buckets[slot][index];
+      for (auto &record : nodes) {
+        if (failed) break;
+        int float_fea_num = 0;
+        if (float_feat_id_map.size() > 0) {
+          float_fea_num = float_feat_id_map[record.idx].size();
+        }
+        if (!load_slot) {
+          node_shards[record.idx][index]->add_feature_node(
+              record.id, false, float_fea_num);
+          local_valid_count++;
+          continue;
+        }
+        auto node = feature_shards[record.idx][index]->add_feature_node(
+            record.id, false, float_fea_num);
+        if (node != NULL) {
+          int slot_fea_num = 0;
+          if (feat_name.size() > 0) slot_fea_num = feat_name[record.idx].size();
+          if (slot_fea_num > 0) node->set_feature_size(slot_fea_num);
+          if (float_fea_num > 0) node->set_float_feature_size(float_fea_num);
+          vals.clear();
+          ::paddle::string::split_string_ptr(
+              record.features, record.len, '\t', &vals);
+          for (auto &v : vals) {
+            if (parse_feature(record.idx, v.ptr, v.len, node) != 0) {
+              VLOG(0) << "Fail to parse feature, node_id[" << record.id
+                      << "] shard_idx[" << index << "] fea_type_id["
+                      << record.idx << "]";
+              is_parse_node_fail_ = true;
+              failed = true;
+              break;
+            }
+          }
+        }
+        local_valid_count++;
+      }
+      std::vector<NodeRecord>().swap(nodes);
+    }
+    valid_count += local_valid_count;
+  };
+
+  load_text_files(paths,
+                  load_node_edge_task_pool.get(),
+                  thread_num,
+                  shard_count,
+                  parse_chunk,
+                  insert_shard);
+  return {count, valid_count};
+}
+
 std::pair<uint64_t, uint64_t> GraphTable::load_edges(
     const std::string &path,
     bool reverse_edge,
@@ -2609,7 +3007,11 @@ std::pair<uint64_t, uint64_t> GraphTable::load_edges(
   uint64_t valid_count = 0;
 
   VLOG(0) << "Begin GraphTable::load_edges() edge_type[" << edge_type << "]";
-  if (FLAGS_graph_load_in_parallel) {
+  if (FLAGS_graph_load_with_mmap) {
+    auto res = load_edges_mmap(paths, idx, reverse_edge, use_weight);
+    count = res.first;
+    valid_count = res.second;
+  } else if (FLAGS_graph_load_in_parallel) {
     std::vector<std::future<std::pair<uint64_t, uint64_t>>> tasks;
     for (size_t i = 0; i < paths.size(); i++) {
       tasks.push_back(load_node_edge_task_pool->enqueue(
@@ -2661,6 +3063,9 @@ std::pair<uint64_t, uint64_t> GraphTable::load_edges(
       }
     }
   }
+  if (finalize_edges_on_load) {
+    finalize_edges(idx);
+  }
 
   return {count, valid_count};
 }
@@ -2818,10 +3223,8 @@ int32_t GraphTable::random_sample_neighbors(
     tasks.push_back(_shards_task_pool[i]->enqueue([&, i, this]() -> int {
       uint64_t node_id;
       std::vector<std::pair<SampleKey, SampleResult>> r;
-      LRUResponse response = LRUResponse::blocked;
       if (use_cache) {
-        response =
-            scaled_lru->query(i, id_list[i].data(), id_list[i].size(), r);
+        sample_cache->query(id_list[i].data(), id_list[i].size(), &r);
       }
       size_t index = 0;
       std::vector<SampleResult> sample_res;
@@ -2864,8 +3267,13 @@ int32_t GraphTable::random_sample_neighbors(
           int offset = 0;
           uint64_t id;
           float weight;
+          // frozen nodes are read from their csr arrays directly
+          const int64_t *neighbor_ids = node->get_neighbor_ids();
+#if defined(PADDLE_WITH_HETERPS) && defined(PADDLE_WITH_PSCORE)
+          const float *neighbor_weights = node->get_neighbor_weights();
+#endif
           char *buffer_addr = new char[actual_size];
-          if (response == LRUResponse::ok) {
+          if (use_cache) {
             sample_keys.emplace_back(idx, node_id, sample_size, need_weight);
             sample_res.emplace_back(actual_size, buffer_addr);
             buffer = sample_res.back().buffer;
@@ -2873,12 +3281,15 @@ int32_t GraphTable::random_sample_neighbors(
             buffer.reset(buffer_addr, char_del);
           }
           for (int &x : res) {
-            id = node->get_neighbor_id(x);
+            id = neighbor_ids != nullptr ? neighbor_ids[x]
+                                         : node->get_neighbor_id(x);
             memcpy(buffer_addr + offset, &id, Node::id_size);
             offset += Node::id_size;
             if (need_weight) {
 #if defined(PADDLE_WITH_HETERPS) && defined(PADDLE_WITH_PSCORE)
-              weight = node->get_neighbor_weight(x);
+              weight = neighbor_weights != nullptr
+                           ? neighbor_weights[x]
+                           : node->get_neighbor_weight(x);
 #else
               weight = 1.0;
 #endif
@@ -2889,8 +3300,65 @@ int32_t GraphTable::random_sample_neighbors(
         }
       }
       if (!sample_res.empty()) {
-        scaled_lru->insert(
-            i, sample_keys.data(), sample_res.data(), sample_keys.size());
+        sample_cache->insert(
+            sample_keys.data(), sample_res.data(), sample_keys.size());
+      }
+      return 0;
+    }));
+  }
+  for (auto &t : tasks) {
+    t.get();
+  }
+  return 0;
+}
+
+std::pair<int64_t, int64_t> GraphTable::PrintTableStat() {
+  SampleCacheStat stat = get_sample_cache_stat();
+  VLOG(0) << "GraphTable " << stat.to_string();
+  return {stat.hit, stat.miss};
+}
+
+int32_t GraphTable::sample_neighbors_batch(int idx,
+                                           const uint64_t *node_ids,
+                                           size_t num,
+                                           int sample_size,
+                                           uint64_t *neighbor_ids,
+                                           float *weights,
+                                           int *actual_sizes) {
+  std::vector<std::vector<size_t>> seq_id(task_pool_size_);
+  for (size_t i = 0; i < num; ++i) {
+    seq_id[get_thread_pool_index(node_ids[i])].push_back(i);
+  }
+  std::vector<std::future<int>> tasks;
+  for (size_t i = 0; i < seq_id.size(); i++) {
+    if (seq_id[i].empty()) continue;
+    tasks.push_back(_shards_task_pool[i]->enqueue([&, i, this]() -> int {
+      auto &rng = _shards_task_rng_pool[i];
+      std::vector<int> res(sample_size);
+      for (size_t pos : seq_id[i]) {
+        Node *node = find_node(GraphTableType::EDGE_TABLE, idx, node_ids[pos]);
+        if (node == nullptr) {
+          actual_sizes[pos] = 0;
+          continue;
+        }
+        int size = node->sample_k_to(sample_size, rng, res.data());
+        const int64_t *ids = node->get_neighbor_ids();
+        uint64_t *ids_out = neighbor_ids + pos * sample_size;
+        for (int j = 0; j < size; ++j) {
+          ids_out[j] = ids != nullptr ? ids[res[j]]
+                                      : node->get_neighbor_id(res[j]);
+        }
+        if (weights != nullptr) {
+          const float *node_weights = node->get_neighbor_weights();
+          float *weights_out = weights + pos * sample_size;
+          for (int j = 0; j < size; ++j) {
+            weights_out[j] =
+                node_weights != nullptr
+                    ? node_weights[res[j]]
+                    : static_cast<float>(node->get_neighbor_weight(res[j]));
+          }
+        }
+        actual_sizes[pos] = size;
       }
       return 0;
     }));
@@ -3444,6 +3912,7 @@ void GraphTable::load_node_weight(int type_id, int idx, std::string path) {
 int32_t GraphTable::Initialize(const GraphParameter &graph) {
   task_pool_size_ = graph.task_pool_size();
   build_sampler_on_cpu = graph.build_sampler_on_cpu();
+  finalize_edges_on_load = graph.finalize_edges_on_load();
 
 #ifdef PADDLE_WITH_HETERPS
   _db = NULL;
@@ -3471,7 +3940,8 @@ int32_t GraphTable::Initialize(const GraphParameter &graph) {
   if (use_cache) {
     cache_size_limit = graph.cache_size_limit();
     cache_ttl = graph.cache_ttl();
-    make_neighbor_sample_cache(cache_size_limit, cache_ttl);
+    make_neighbor_sample_cache(
+        cache_size_limit, cache_ttl, graph.cache_bytes_limit());
   }
   _shards_task_pool.resize(task_pool_size_);
   for (size_t i = 0; i < _shards_task_pool.size(); ++i) {
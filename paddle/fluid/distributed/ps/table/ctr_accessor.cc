@@ -14,6 +14,8 @@
 
 #include "paddle/fluid/distributed/ps/table/ctr_accessor.h"
 
+#include <algorithm>
+
 #include "glog/logging.h"
 #include "paddle/common/flags.h"
 #include "paddle/fluid/platform/enforce.h"
@@ -246,35 +248,80 @@ int32_t CtrCommonAccessor::Merge(float** update_values,
 int32_t CtrCommonAccessor::Update(float** update_values,
                                   const float** push_values,
                                   size_t num) {
-  for (size_t value_item = 0; value_item < num; ++value_item) {
-    float* update_value = update_values[value_item];
-    const float* push_value = push_values[value_item];
-    float push_show = push_value[CtrCommonPushValue::ShowIndex()];
-    float push_click = push_value[CtrCommonPushValue::ClickIndex()];
-    float slot = push_value[CtrCommonPushValue::SlotIndex()];
-    update_value[common_feature_value.ShowIndex()] += push_show;
-    update_value[common_feature_value.ClickIndex()] += push_click;
-    update_value[common_feature_value.SlotIndex()] = slot;
-    update_value[common_feature_value.DeltaScoreIndex()] +=
-        (push_show - push_click) * _config.ctr_accessor_param().nonclk_coeff() +
-        push_click * _config.ctr_accessor_param().click_coeff();
-    update_value[common_feature_value.UnseenDaysIndex()] = 0;
-    // TODO(zhaocaibei123): add configure show_scale
-    if (!_show_scale) {
-      push_show = 1;
+  return UpdateFromParts(update_values, nullptr, 0, push_values, num);
+}
+
+int32_t CtrCommonAccessor::SplitUpdate(float** update_values,
+                                       const float** push_headers,
+                                       size_t header_dim,
+                                       const float** push_grads,
+                                       size_t num) {
+  PADDLE_ENFORCE_LE(
+      header_dim,
+      static_cast<size_t>(CtrCommonPushValue::EmbedxGIndex()),
+      common::errors::InvalidArgument(
+          "The push header of CtrCommonAccessor holds at most the fields "
+          "before embedx_g (%d), but got %d.",
+          CtrCommonPushValue::EmbedxGIndex(),
+          header_dim));
+  return UpdateFromParts(
+      update_values, push_headers, header_dim, push_grads, num);
+}
+
+int32_t CtrCommonAccessor::UpdateFromParts(float** update_values,
+                                           const float** push_headers,
+                                           size_t header_dim,
+                                           const float** push_grads,
+                                           size_t num) {
+  // the sgd rules update the weights of a batch of values per call
+  constexpr size_t kBatchSize = 64;
+  float* embed_w[kBatchSize];
+  float* embed_g2sum[kBatchSize];
+  const float* embed_g[kBatchSize];
+  float* embedx_w[kBatchSize];
+  float* embedx_g2sum[kBatchSize];
+  const float* embedx_g[kBatchSize];
+  float scale[kBatchSize];
+  for (size_t begin = 0; begin < num; begin += kBatchSize) {
+    size_t batch_num = std::min(kBatchSize, num - begin);
+    for (size_t i = 0; i < batch_num; ++i) {
+      float* update_value = update_values[begin + i];
+      const float* push_header =
+          header_dim > 0 ? push_headers[begin + i] : nullptr;
+      const float* push_grad = push_grads[begin + i];
+      auto push_field = [=](size_t index) {
+        return index < header_dim ? push_header + index
+                                  : push_grad + (index - header_dim);
+      };
+      float push_show = *push_field(CtrCommonPushValue::ShowIndex());
+      float push_click = *push_field(CtrCommonPushValue::ClickIndex());
+      float slot = *push_field(CtrCommonPushValue::SlotIndex());
+      update_value[common_feature_value.ShowIndex()] += push_show;
+      update_value[common_feature_value.ClickIndex()] += push_click;
+      update_value[common_feature_value.SlotIndex()] = slot;
+      update_value[common_feature_value.DeltaScoreIndex()] +=
+          (push_show - push_click) *
+              _config.ctr_accessor_param().nonclk_coeff() +
+          push_click * _config.ctr_accessor_param().click_coeff();
+      update_value[common_feature_value.UnseenDaysIndex()] = 0;
+      // TODO(zhaocaibei123): add configure show_scale
+      if (!_show_scale) {
+        push_show = 1;
+      }
+      VLOG(3) << "accessor show scale:" << _show_scale
+              << ", push_show:" << push_show;
+      embed_w[i] = update_value + common_feature_value.EmbedWIndex();
+      embed_g2sum[i] = update_value + common_feature_value.EmbedG2SumIndex();
+      embed_g[i] = push_field(CtrCommonPushValue::EmbedGIndex());
+      embedx_w[i] = update_value + common_feature_value.EmbedxWIndex();
+      embedx_g2sum[i] = update_value + common_feature_value.EmbedxG2SumIndex();
+      embedx_g[i] = push_field(CtrCommonPushValue::EmbedxGIndex());
+      scale[i] = push_show;
     }
-    VLOG(3) << "accessor show scale:" << _show_scale
-            << ", push_show:" << push_show;
-    _embed_sgd_rule->UpdateValue(
-        update_value + common_feature_value.EmbedWIndex(),
-        update_value + common_feature_value.EmbedG2SumIndex(),
-        push_value + CtrCommonPushValue::EmbedGIndex(),
-        push_show);
-    _embedx_sgd_rule->UpdateValue(
-        update_value + common_feature_value.EmbedxWIndex(),
-        update_value + common_feature_value.EmbedxG2SumIndex(),
-        push_value + CtrCommonPushValue::EmbedxGIndex(),
-        push_show);
+    _embed_sgd_rule->BatchUpdateValue(
+        embed_w, embed_g2sum, embed_g, scale, batch_num);
+    _embedx_sgd_rule->BatchUpdateValue(
+        embedx_w, embedx_g2sum, embedx_g, scale, batch_num);
   }
   return 0;
 }
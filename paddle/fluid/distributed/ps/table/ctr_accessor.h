@@ -173,6 +173,12 @@ class CtrCommonAccessor : public ValueAccessor {
   virtual int32_t Update(float** values,
                          const float** update_values,
                          size_t num);
+  // reads the slot/show/click header and the gradients where they are
+  int32_t SplitUpdate(float** values,
+                      const float** push_headers,
+                      size_t header_dim,
+                      const float** push_grads,
+                      size_t num) override;
 
   std::string ParseToString(const float* value, int param) override;
   int32_t ParseFromString(const std::string& str, float* v) override;
@@ -189,6 +195,13 @@ class CtrCommonAccessor : public ValueAccessor {
 
  private:
   // float ShowClickScore(float show, float click);
+  // field index of update value i is push_headers[i][index] below
+  // header_dim and push_grads[i][index - header_dim] from there on
+  int32_t UpdateFromParts(float** values,
+                          const float** push_headers,
+                          size_t header_dim,
+                          const float** push_grads,
+                          size_t num);
 
   // SparseValueSGDRule* _embed_sgd_rule;
   // SparseValueSGDRule* _embedx_sgd_rule;
@@ -0,0 +1,198 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <utility>
+
+#include <mct/hash-map.hpp>
+
+#include "paddle/fluid/distributed/common/chunk_allocator.h"
+#include "paddle/phi/core/memory/allocation/spin_lock.h"
+
+namespace paddle {
+namespace distributed {
+
+static const int CONCURRENT_SPARSE_SHARD_BUCKET_NUM_BITS = 10;
+static const size_t CONCURRENT_SPARSE_SHARD_BUCKET_NUM =
+    static_cast<size_t>(1) << CONCURRENT_SPARSE_SHARD_BUCKET_NUM_BITS;
+
+// A sparse shard that can be read and written by many threads at once.
+//
+// Unlike SparseTableShard, which must be driven by a single thread, every
+// bucket here owns its own open-addressing map, value allocator and spin
+// lock, so operations on keys that hash to different buckets never contend.
+// Values are meant to be touched from the callbacks passed to the *_apply and
+// for_each helpers, which run with the bucket lock held.
+template <class KEY, class VALUE>
+class ConcurrentSparseTableShard {
+ public:
+  typedef typename mct::closed_hash_map<KEY, mct::Pointer, std::hash<KEY>>
+      map_type;
+
+  ConcurrentSparseTableShard() {}
+  ConcurrentSparseTableShard(const ConcurrentSparseTableShard&) = delete;
+  ~ConcurrentSparseTableShard() { clear(); }
+
+  size_t size() const {
+    size_t total = 0;
+    for (size_t bucket = 0; bucket < CONCURRENT_SPARSE_SHARD_BUCKET_NUM;
+         bucket++) {
+      total += _buckets[bucket].size.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+  bool empty() const { return size() == 0; }
+  size_t bucket_count() const { return CONCURRENT_SPARSE_SHARD_BUCKET_NUM; }
+  void set_max_load_factor(float x) {
+    for (size_t bucket = 0; bucket < CONCURRENT_SPARSE_SHARD_BUCKET_NUM;
+         bucket++) {
+      std::lock_guard<memory::SpinLock> guard(_buckets[bucket].lock);
+      _buckets[bucket].map.max_load_factor(x);
+    }
+  }
+
+  // Calls func(VALUE&) under the bucket lock if key exists.
+  template <class FUNC>
+  bool find_and_apply(const KEY& key, FUNC&& func) {
+    size_t hash = _hasher(key);
+    Bucket& bucket = _buckets[compute_bucket(hash)];
+    std::lock_guard<memory::SpinLock> guard(bucket.lock);
+    auto it = bucket.map.find_with_hash(key, hash);
+    if (it == bucket.map.end()) {
+      return false;
+    }
+    func(*(VALUE*)(void*)it->second);  // NOLINT
+    return true;
+  }
+
+  // Calls func(VALUE&, bool created) under the bucket lock, creating a
+  // default value first if key does not exist. Returns whether it was created.
+  template <class FUNC>
+  bool emplace_and_apply(const KEY& key, FUNC&& func) {
+    size_t hash = _hasher(key);
+    Bucket& bucket = _buckets[compute_bucket(hash)];
+    std::lock_guard<memory::SpinLock> guard(bucket.lock);
+    auto res = bucket.map.insert_with_hash({key, NULL}, hash);
+    if (res.second) {
+      res.first->second = bucket.alloc.acquire();
+      bucket.size.fetch_add(1, std::memory_order_relaxed);
+    }
+    func(*(VALUE*)(void*)res.first->second, res.second);  // NOLINT
+    return res.second;
+  }
+
+  // Returns the address of the value of key, or NULL. The address stays valid
+  // until the key is erased, but reading through it is not synchronized with
+  // writers; callers must order such reads against pushes themselves.
+  VALUE* find_ptr(const KEY& key) {
+    size_t hash = _hasher(key);
+    Bucket& bucket = _buckets[compute_bucket(hash)];
+    std::lock_guard<memory::SpinLock> guard(bucket.lock);
+    auto it = bucket.map.find_with_hash(key, hash);
+    if (it == bucket.map.end()) {
+      return NULL;
+    }
+    return (VALUE*)(void*)it->second;  // NOLINT
+  }
+
+  size_t erase(const KEY& key) {
+    size_t hash = _hasher(key);
+    Bucket& bucket = _buckets[compute_bucket(hash)];
+    std::lock_guard<memory::SpinLock> guard(bucket.lock);
+    auto it = bucket.map.find_with_hash(key, hash);
+    if (it == bucket.map.end()) {
+      return 0;
+    }
+    bucket.alloc.release((VALUE*)(void*)it->second);  // NOLINT
+    bucket.map.quick_erase(it);
+    bucket.size.fetch_sub(1, std::memory_order_relaxed);
+    return 1;
+  }
+
+  // Calls func(const KEY&, VALUE&) for every value of one bucket while the
+  // bucket is locked.
+  template <class FUNC>
+  void for_each(size_t bucket_idx, FUNC&& func) {
+    Bucket& bucket = _buckets[bucket_idx];
+    std::lock_guard<memory::SpinLock> guard(bucket.lock);
+    for (auto it = bucket.map.begin(); it != bucket.map.end(); ++it) {
+      func(it->first, *(VALUE*)(void*)it->second);  // NOLINT
+    }
+  }
+  template <class FUNC>
+  void for_each(FUNC&& func) {
+    for (size_t bucket = 0; bucket < CONCURRENT_SPARSE_SHARD_BUCKET_NUM;
+         bucket++) {
+      for_each(bucket, func);
+    }
+  }
+
+  // Erases every value of one bucket for which pred(const KEY&, VALUE&)
+  // returns true, and returns how many were erased.
+  template <class PRED>
+  size_t erase_if(size_t bucket_idx, PRED&& pred) {
+    Bucket& bucket = _buckets[bucket_idx];
+    std::lock_guard<memory::SpinLock> guard(bucket.lock);
+    size_t erased = 0;
+    for (auto it = bucket.map.begin(); it != bucket.map.end();) {
+      if (pred(it->first, *(VALUE*)(void*)it->second)) {  // NOLINT
+        bucket.alloc.release((VALUE*)(void*)it->second);  // NOLINT
+        it = bucket.map.erase(it);
+        ++erased;
+      } else {
+        ++it;
+      }
+    }
+    bucket.size.fetch_sub(erased, std::memory_order_relaxed);
+    return erased;
+  }
+
+  void clear() {
+    for (size_t bucket_idx = 0; bucket_idx < CONCURRENT_SPARSE_SHARD_BUCKET_NUM;
+         bucket_idx++) {
+      Bucket& bucket = _buckets[bucket_idx];
+      std::lock_guard<memory::SpinLock> guard(bucket.lock);
+      for (auto it = bucket.map.begin(); it != bucket.map.end(); ++it) {
+        bucket.alloc.release((VALUE*)(void*)it->second);  // NOLINT
+      }
+      bucket.map.clear();
+      bucket.size.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  // std::hash of an integer is the identity and keys routed to one shard
+  // share their low bits, so mix the hash before taking the high bits.
+  size_t compute_bucket(size_t hash) const {
+    return (static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL) >>
+           (64 - CONCURRENT_SPARSE_SHARD_BUCKET_NUM_BITS);
+  }
+
+ private:
+  struct alignas(64) Bucket {
+    memory::SpinLock lock;
+    std::atomic<size_t> size{0};
+    map_type map;
+    ChunkAllocator<VALUE> alloc;
+  };
+
+  Bucket _buckets[CONCURRENT_SPARSE_SHARD_BUCKET_NUM];
+  std::hash<KEY> _hasher;
+};
+
+}  // namespace distributed
+}  // namespace paddle
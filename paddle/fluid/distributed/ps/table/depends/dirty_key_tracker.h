@@ -0,0 +1,72 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+#include "paddle/fluid/distributed/ps/thirdparty/round_robin.h"
+
+namespace paddle {
+namespace distributed {
+
+// save/load param of incremental checkpoints, see MemorySparseTable::SaveDelta
+static const int SPARSE_DELTA_SAVE_PARAM = 8;
+
+// Records which keys of one sparse shard changed since the last checkpoint.
+//
+// Like the shard itself it is not thread safe, and must only be touched by
+// the thread that owns the shard. Operations that rewrite every value of the
+// shard (e.g. the show/click decay of Shrink) call MarkAllDirty instead of
+// marking keys one by one; the next delta then holds the whole shard.
+class DirtyKeyTracker {
+ public:
+  void MarkDirty(uint64_t key) {
+    if (!_all_dirty) {
+      _dirty_keys.insert(key);
+    }
+  }
+  void MarkErased(uint64_t key) {
+    _dirty_keys.erase(key);
+    _erased_keys.insert(key);
+  }
+  void MarkAllDirty() {
+    _all_dirty = true;
+    _dirty_keys.clear();
+  }
+  // called once the current values are persisted
+  void Reset() {
+    _all_dirty = false;
+    _dirty_keys.clear();
+    _erased_keys.clear();
+  }
+
+  bool all_dirty() const { return _all_dirty; }
+  const robin_hood::unordered_set<uint64_t>& dirty_keys() const {
+    return _dirty_keys;
+  }
+  // keys erased since the last checkpoint, some may have been created again
+  const robin_hood::unordered_set<uint64_t>& erased_keys() const {
+    return _erased_keys;
+  }
+
+ private:
+  bool _all_dirty = false;
+  robin_hood::unordered_set<uint64_t> _dirty_keys;
+  robin_hood::unordered_set<uint64_t> _erased_keys;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -14,12 +14,21 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <mct/hash-map.hpp>
 
 #include "paddle/common/flags.h"
 #include "paddle/fluid/distributed/common/chunk_allocator.h"
+#include "paddle/phi/core/memory/allocation/spin_lock.h"
 
 namespace paddle {
 namespace distributed {
@@ -28,17 +37,200 @@ static const int CTR_SPARSE_SHARD_BUCKET_NUM_BITS = 6;
 static const size_t CTR_SPARSE_SHARD_BUCKET_NUM =
     static_cast<size_t>(1) << CTR_SPARSE_SHARD_BUCKET_NUM_BITS;
 
+// Size-class slabs backing FixedFeatureValue.
+//
+// Holding every value in its own std::vector costs one malloc'ed block plus
+// its allocator overhead per feature. Instead, values whose capacity is the
+// same number of floats are packed back to back into the chunks of one
+// FixedSizeChunkAllocator. Push threads of different shards resize values at
+// the same time, so every size class is split into stripes and a thread
+// always acquires from and releases to its own stripe.
+//
+// Freed values go back to the free list of their stripe and are reused by
+// later values of the same size class, the chunks are never returned to the
+// system: the resident memory does not drop after a Shrink, it only stops
+// growing until the table grows past its former size again. StatString
+// reports the used and reserved bytes of each size class.
+class FeatureValueSlab {
+ public:
+  // larger values fall back to malloc
+  static constexpr size_t kMaxSlabFloats = 2048;
+  static constexpr size_t kStripeNum = 16;
+
+  struct SizeClassStat {
+    size_t capacity;        // floats of one value
+    int64_t value_num;      // values currently held
+    size_t reserved_bytes;  // bytes taken from the system
+  };
+
+  static FeatureValueSlab& Instance() {
+    // never destroyed, values of static tables may outlive it otherwise
+    static FeatureValueSlab* slab = new FeatureValueSlab();
+    return *slab;
+  }
+
+  // Capacity, in floats, of the size class holding a value of size floats.
+  static size_t CapacityOf(size_t size) {
+    return (size + 1) & ~static_cast<size_t>(1);
+  }
+
+  float* Acquire(size_t capacity) {
+    if (capacity > kMaxSlabFloats) {
+      return reinterpret_cast<float*>(malloc(capacity * sizeof(float)));
+    }
+    SizeClass* size_class = GetSizeClass(capacity);
+    Stripe& stripe = size_class->stripes[StripeId()];
+    size_class->value_num.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<memory::SpinLock> guard(stripe.lock);
+    return reinterpret_cast<float*>(stripe.alloc->acquire());
+  }
+
+  void Release(float* data, size_t capacity) {
+    if (capacity > kMaxSlabFloats) {
+      free(data);
+      return;
+    }
+    SizeClass* size_class = GetSizeClass(capacity);
+    Stripe& stripe = size_class->stripes[StripeId()];
+    size_class->value_num.fetch_sub(1, std::memory_order_relaxed);
+    std::lock_guard<memory::SpinLock> guard(stripe.lock);
+    stripe.alloc->release(data);
+  }
+
+  std::vector<SizeClassStat> GetStats() {
+    std::vector<SizeClassStat> stats;
+    for (size_t i = 0; i < kSizeClassNum; ++i) {
+      SizeClass* size_class = _size_classes[i].load(std::memory_order_acquire);
+      if (size_class == NULL) {
+        continue;
+      }
+      SizeClassStat stat = {i * 2, size_class->value_num.load(), 0};
+      for (auto& stripe : size_class->stripes) {
+        std::lock_guard<memory::SpinLock> guard(stripe.lock);
+        stat.reserved_bytes += stripe.alloc->reserved_bytes();
+      }
+      stats.push_back(stat);
+    }
+    return stats;
+  }
+
+  std::string StatString() {
+    std::stringstream ss;
+    size_t total_reserved_bytes = 0;
+    size_t total_used_bytes = 0;
+    for (auto& stat : GetStats()) {
+      size_t used_bytes = stat.value_num * stat.capacity * sizeof(float);
+      total_reserved_bytes += stat.reserved_bytes;
+      total_used_bytes += used_bytes;
+      ss << "[dim:" << stat.capacity << " values:" << stat.value_num
+         << " used:" << used_bytes << " reserved:" << stat.reserved_bytes
+         << "] ";
+    }
+    ss << "total used:" << total_used_bytes
+       << " reserved:" << total_reserved_bytes;
+    return ss.str();
+  }
+
+ private:
+  static constexpr size_t kSizeClassNum = kMaxSlabFloats / 2 + 1;
+  struct alignas(64) Stripe {
+    memory::SpinLock lock;
+    std::unique_ptr<FixedSizeChunkAllocator> alloc;
+  };
+  struct SizeClass {
+    explicit SizeClass(size_t capacity) {
+      for (auto& stripe : stripes) {
+        stripe.alloc.reset(
+            new FixedSizeChunkAllocator(capacity * sizeof(float)));
+      }
+    }
+    Stripe stripes[kStripeNum];
+    std::atomic<int64_t> value_num{0};
+  };
+
+  FeatureValueSlab() {
+    for (auto& size_class : _size_classes) {
+      size_class.store(NULL, std::memory_order_relaxed);
+    }
+  }
+
+  SizeClass* GetSizeClass(size_t capacity) {
+    auto& slot = _size_classes[capacity / 2];
+    SizeClass* size_class = slot.load(std::memory_order_acquire);
+    if (size_class != NULL) {
+      return size_class;
+    }
+    SizeClass* created = new SizeClass(capacity);
+    if (!slot.compare_exchange_strong(size_class, created)) {
+      delete created;  // size_class now holds the winner
+      return size_class;
+    }
+    return created;
+  }
+
+  static size_t StripeId() {
+    static std::atomic<size_t> next_stripe{0};
+    thread_local size_t stripe_id = next_stripe++ % kStripeNum;
+    return stripe_id;
+  }
+
+  std::atomic<SizeClass*> _size_classes[kSizeClassNum];
+};
+
 class FixedFeatureValue {
  public:
   FixedFeatureValue() {}
-  ~FixedFeatureValue() {}
-  float* data() { return _data.data(); }
-  size_t size() { return _data.size(); }
-  void resize(size_t size) { _data.resize(size); }
-  void shrink_to_fit() { _data.shrink_to_fit(); }
+  FixedFeatureValue(const FixedFeatureValue& other) { *this = other; }
+  FixedFeatureValue(FixedFeatureValue&& other) { swap(other); }
+  FixedFeatureValue& operator=(const FixedFeatureValue& other) {
+    if (this != &other) {
+      resize(other._size);
+      if (_size > 0) {
+        memcpy(_data, other._data, _size * sizeof(float));
+      }
+    }
+    return *this;
+  }
+  ~FixedFeatureValue() { resize(0); }
+  float* data() { return _data; }
+  size_t size() { return _size; }
+  // Resizing within the capacity of the current size class happens in place,
+  // otherwise the value moves to the slab of its new size class. Like
+  // std::vector, new floats are zero filled.
+  void resize(size_t size) {
+    size_t capacity = FeatureValueSlab::CapacityOf(size);
+    if (capacity != _capacity) {
+      float* data = NULL;
+      if (capacity > 0) {
+        data = FeatureValueSlab::Instance().Acquire(capacity);
+        if (_size > 0 && size > 0) {
+          memcpy(data, _data, std::min<size_t>(_size, size) * sizeof(float));
+        }
+      }
+      if (_capacity > 0) {
+        FeatureValueSlab::Instance().Release(_data, _capacity);
+      }
+      _data = data;
+      _capacity = capacity;
+    }
+    if (size > _size) {
+      memset(_data + _size, 0, (size - _size) * sizeof(float));
+    }
+    _size = size;
+  }
+  // values never hold more than their size class, nothing to give back
+  void shrink_to_fit() {}
 
  private:
-  std::vector<float> _data;
+  void swap(FixedFeatureValue& other) {
+    std::swap(_data, other._data);
+    std::swap(_size, other._size);
+    std::swap(_capacity, other._capacity);
+  }
+
+  float* _data = NULL;
+  uint32_t _size = 0;
+  uint32_t _capacity = 0;
 };
 
 template <class KEY, class VALUE>
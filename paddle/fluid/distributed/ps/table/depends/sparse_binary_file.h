@@ -0,0 +1,426 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/fluid/distributed/common/afs_warpper.h"
+#include "paddle/fluid/distributed/ps/table/accessor.h"
+#include "paddle/fluid/framework/io/fs.h"
+#include "paddle/utils/string/string_helper.h"
+
+namespace paddle {
+namespace distributed {
+
+// Binary checkpoint file of a sparse table shard.
+//
+//   file   := SparseBinaryFileHeader block*
+//   block  := SparseBinaryBlockHeader
+//             uint64_t keys[record_num]
+//             uint32_t sizes[record_num]    (padded to 8 bytes)
+//             float    values[value_num]    (padded to 8 bytes)
+//
+// Values of one block are stored back to back in key order, sizes[i] floats
+// for keys[i]. Every column starts 8-byte aligned, so a local file can be
+// mmap'ed and read in place without copying.
+
+// "\0PDSPBIN" when read as little endian bytes
+static const uint64_t SPARSE_BINARY_FILE_MAGIC = 0x4e49425053445000;
+static const uint32_t SPARSE_BINARY_FILE_VERSION = 1;
+static const char SPARSE_BINARY_FILE_SUFFIX[] = ".bin";
+// The writer flushes a block once its values reach
+// SPARSE_BINARY_BLOCK_VALUE_BYTES. A reader rejects any block over
+// SPARSE_BINARY_MAX_BLOCK_BYTES before allocating for it, so a corrupted
+// header can not make it allocate without bound.
+static const size_t SPARSE_BINARY_BLOCK_VALUE_BYTES = 64UL << 20;
+static const size_t SPARSE_BINARY_MAX_BLOCK_RECORDS = 1UL << 20;
+static const size_t SPARSE_BINARY_MAX_BLOCK_BYTES = 256UL << 20;
+
+struct SparseBinaryFileHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t value_dim;  // floats of a fully extended value
+  uint64_t reserved[2];
+};
+
+struct SparseBinaryBlockHeader {
+  uint32_t record_num;
+  uint32_t reserved;
+  uint64_t value_num;
+};
+
+struct SparseBinaryBlock {
+  size_t record_num = 0;
+  const uint64_t* keys = nullptr;
+  const uint32_t* sizes = nullptr;
+  const float* values = nullptr;
+};
+
+inline size_t SparseBinaryAlign8(size_t size) { return (size + 7) & ~7UL; }
+
+inline bool IsSparseBinaryFile(const std::string& path) {
+  return ::paddle::string::ends_with(path, SPARSE_BINARY_FILE_SUFFIX);
+}
+
+class SparseBinaryFileWriter {
+ public:
+  SparseBinaryFileWriter(std::shared_ptr<FsWriteChannel> channel,
+                         uint32_t value_dim,
+                         size_t block_record_num = 64 * 1024)
+      : _channel(channel),
+        _block_record_num(
+            std::min(block_record_num, SPARSE_BINARY_MAX_BLOCK_RECORDS)) {
+    SparseBinaryFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = SPARSE_BINARY_FILE_MAGIC;
+    header.version = SPARSE_BINARY_FILE_VERSION;
+    header.value_dim = value_dim;
+    _failed = _channel->write(reinterpret_cast<const char*>(&header),
+                              sizeof(header)) != 0;
+    _keys.reserve(_block_record_num);
+    _sizes.reserve(_block_record_num);
+  }
+
+  // Returns 0 on success.
+  int Append(uint64_t key, const float* value, uint32_t size) {
+    _keys.push_back(key);
+    _sizes.push_back(size);
+    _values.insert(_values.end(), value, value + size);
+    if (_keys.size() >= _block_record_num ||
+        _values.size() * sizeof(float) >= SPARSE_BINARY_BLOCK_VALUE_BYTES) {
+      FlushBlock();
+    }
+    return _failed ? -1 : 0;
+  }
+
+  // Writes the pending block. Returns 0 if every write succeeded.
+  int Close() {
+    FlushBlock();
+    return _failed ? -1 : 0;
+  }
+
+ private:
+  void FlushBlock() {
+    if (_keys.empty() || _failed) {
+      _keys.clear();
+      _sizes.clear();
+      _values.clear();
+      return;
+    }
+    SparseBinaryBlockHeader header;
+    header.record_num = _keys.size();
+    header.reserved = 0;
+    header.value_num = _values.size();
+    static const char padding[8] = {0};
+    size_t sizes_bytes = _sizes.size() * sizeof(uint32_t);
+    size_t values_bytes = _values.size() * sizeof(float);
+    _failed = _channel->write(reinterpret_cast<const char*>(&header),
+                              sizeof(header)) != 0 ||
+              _channel->write(reinterpret_cast<const char*>(_keys.data()),
+                              _keys.size() * sizeof(uint64_t)) != 0 ||
+              _channel->write(reinterpret_cast<const char*>(_sizes.data()),
+                              sizes_bytes) != 0 ||
+              _channel->write(padding,
+                              SparseBinaryAlign8(sizes_bytes) - sizes_bytes) !=
+                  0 ||
+              _channel->write(reinterpret_cast<const char*>(_values.data()),
+                              values_bytes) != 0 ||
+              _channel->write(padding,
+                              SparseBinaryAlign8(values_bytes) -
+                                  values_bytes) != 0;
+    _keys.clear();
+    _sizes.clear();
+    _values.clear();
+  }
+
+  std::shared_ptr<FsWriteChannel> _channel;
+  size_t _block_record_num;
+  bool _failed = false;
+  std::vector<uint64_t> _keys;
+  std::vector<uint32_t> _sizes;
+  std::vector<float> _values;
+};
+
+// Reads a binary shard block by block. Local files without a deconverter
+// are mmap'ed and handed out in place; other files are streamed through an
+// FsReadChannel into reused buffers.
+class SparseBinaryFileReader {
+ public:
+  SparseBinaryFileReader() {}
+  SparseBinaryFileReader(const SparseBinaryFileReader&) = delete;
+  ~SparseBinaryFileReader() { Close(); }
+
+  // Returns 0 on success.
+  int Open(AfsClient* afs_client, const FsChannelConfig& config) {
+    Close();
+    SparseBinaryFileHeader header;
+    if (::paddle::framework::fs_select_internal(config.path) == 0 &&
+        config.deconverter.empty()) {
+      int fd = ::open(config.path.c_str(), O_RDONLY);
+      struct stat st;
+      if (fd < 0 || fstat(fd, &st) != 0 ||
+          static_cast<size_t>(st.st_size) < sizeof(header)) {
+        LOG(ERROR) << "SparseBinaryFileReader open failed, path:"
+                   << config.path;
+        if (fd >= 0) ::close(fd);
+        return -1;
+      }
+      void* addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      ::close(fd);
+      if (addr == MAP_FAILED) {
+        LOG(ERROR) << "SparseBinaryFileReader mmap failed, path:"
+                   << config.path;
+        return -1;
+      }
+      madvise(addr, st.st_size, MADV_SEQUENTIAL);
+      _mmap_addr = reinterpret_cast<char*>(addr);
+      _mmap_size = st.st_size;
+      memcpy(&header, _mmap_addr, sizeof(header));
+      _mmap_offset = sizeof(header);
+    } else {
+      int err_no = 0;
+      _channel = afs_client->open_r(config, 0, &err_no);
+      if (err_no != 0 ||
+          _channel->read(reinterpret_cast<char*>(&header), sizeof(header)) !=
+              static_cast<int>(sizeof(header))) {
+        LOG(ERROR) << "SparseBinaryFileReader open failed, path:"
+                   << config.path;
+        return -1;
+      }
+    }
+    if (header.magic != SPARSE_BINARY_FILE_MAGIC ||
+        header.version > SPARSE_BINARY_FILE_VERSION) {
+      LOG(ERROR) << "SparseBinaryFileReader bad header, path:" << config.path
+                 << " version:" << header.version;
+      return -1;
+    }
+    _value_dim = header.value_dim;
+    return 0;
+  }
+
+  // Returns 1 with the next block, 0 at end of file and -1 on error. The
+  // block stays valid until the next call. Every size of a returned block is
+  // at most value_dim and the sizes add up to the values of the block.
+  int NextBlock(SparseBinaryBlock* block) {
+    SparseBinaryBlockHeader header;
+    if (!ReadBytes(sizeof(header), reinterpret_cast<char*>(&header), nullptr)) {
+      return _error ? -1 : 0;
+    }
+    // checked before the sizes below are computed, they can not overflow
+    if (header.record_num > SPARSE_BINARY_MAX_BLOCK_RECORDS ||
+        header.value_num >
+            static_cast<uint64_t>(header.record_num) * _value_dim ||
+        header.value_num > SPARSE_BINARY_MAX_BLOCK_BYTES / sizeof(float)) {
+      LOG(ERROR) << "SparseBinaryFileReader bad block, record_num:"
+                 << header.record_num << " value_num:" << header.value_num;
+      _error = true;
+      return -1;
+    }
+    size_t keys_bytes = header.record_num * sizeof(uint64_t);
+    size_t sizes_bytes =
+        SparseBinaryAlign8(header.record_num * sizeof(uint32_t));
+    size_t values_bytes = SparseBinaryAlign8(header.value_num * sizeof(float));
+    size_t block_bytes = keys_bytes + sizes_bytes + values_bytes;
+    size_t max_block_bytes = _mmap_addr != nullptr
+                                 ? _mmap_size - _mmap_offset
+                                 : SPARSE_BINARY_MAX_BLOCK_BYTES;
+    if (block_bytes > max_block_bytes) {
+      LOG(ERROR) << "SparseBinaryFileReader bad block of " << block_bytes
+                 << " bytes, at most " << max_block_bytes << " are left";
+      _error = true;
+      return -1;
+    }
+    if (_mmap_addr == nullptr) {
+      _buffer.resize(block_bytes);
+    }
+    const char* data = nullptr;
+    if (!ReadBytes(block_bytes, _buffer.data(), &data)) {
+      _error = true;
+      return -1;
+    }
+    const uint32_t* sizes =
+        reinterpret_cast<const uint32_t*>(data + keys_bytes);
+    uint64_t value_num = 0;
+    for (size_t i = 0; i < header.record_num; ++i) {
+      if (sizes[i] > _value_dim) {
+        LOG(ERROR) << "SparseBinaryFileReader bad value size:" << sizes[i]
+                   << " value_dim:" << _value_dim;
+        _error = true;
+        return -1;
+      }
+      value_num += sizes[i];
+    }
+    if (value_num != header.value_num) {
+      LOG(ERROR) << "SparseBinaryFileReader bad block, value_num:"
+                 << header.value_num << " sum of sizes:" << value_num;
+      _error = true;
+      return -1;
+    }
+    block->record_num = header.record_num;
+    block->keys = reinterpret_cast<const uint64_t*>(data);
+    block->sizes = sizes;
+    block->values =
+        reinterpret_cast<const float*>(data + keys_bytes + sizes_bytes);
+    return 1;
+  }
+
+  uint32_t value_dim() const { return _value_dim; }
+
+  void Close() {
+    if (_mmap_addr != nullptr) {
+      munmap(_mmap_addr, _mmap_size);
+      _mmap_addr = nullptr;
+    }
+    if (_channel != nullptr) {
+      _channel->close();
+      _channel = nullptr;
+    }
+    _error = false;
+  }
+
+ private:
+  // Reads size bytes. A mmap'ed file points *data into the mapping and leaves
+  // buf untouched, otherwise the bytes land in buf. A header read (data is
+  // null) always copies. Returns false at end of file or on error.
+  bool ReadBytes(size_t size, char* buf, const char** data) {
+    if (_mmap_addr != nullptr) {
+      if (_mmap_offset == _mmap_size) {
+        return false;
+      }
+      if (_mmap_offset + size > _mmap_size) {
+        _error = true;
+        return false;
+      }
+      if (data != nullptr) {
+        *data = _mmap_addr + _mmap_offset;
+      } else {
+        memcpy(buf, _mmap_addr + _mmap_offset, size);
+      }
+      _mmap_offset += size;
+      return true;
+    }
+    size_t read_size = static_cast<size_t>(_channel->read(buf, size));
+    if (read_size != size) {
+      _error = read_size != 0;
+      return false;
+    }
+    if (data != nullptr) {
+      *data = buf;
+    }
+    return true;
+  }
+
+  uint32_t _value_dim = 0;
+  bool _error = false;
+  char* _mmap_addr = nullptr;
+  size_t _mmap_size = 0;
+  size_t _mmap_offset = 0;
+  std::shared_ptr<FsReadChannel> _channel;
+  std::vector<char> _buffer;
+};
+
+// Rewrites a binary shard file as the "key value..." text lines Save writes
+// through ValueAccessor::ParseToString. Returns the number of records, or -1.
+inline int64_t ConvertSparseBinaryToText(ValueAccessor* accessor,
+                                         AfsClient* afs_client,
+                                         const std::string& binary_path,
+                                         const std::string& text_path) {
+  SparseBinaryFileReader reader;
+  FsChannelConfig read_config;
+  read_config.path = binary_path;
+  if (reader.Open(afs_client, read_config) != 0) {
+    return -1;
+  }
+  if (reader.value_dim() !=
+      accessor->GetAccessorInfo().size / sizeof(float)) {
+    LOG(ERROR) << "SparseBinaryFileReader value dim " << reader.value_dim()
+               << " not equal to accessor value dim, path:" << binary_path;
+    return -1;
+  }
+  FsChannelConfig write_config;
+  write_config.path = text_path;
+  int err_no = 0;
+  auto write_channel =
+      afs_client->open_w(write_config, 1024 * 1024 * 40, &err_no);
+  int64_t record_num = 0;
+  SparseBinaryBlock block;
+  int ret = 0;
+  while ((ret = reader.NextBlock(&block)) > 0) {
+    const float* value = block.values;
+    for (size_t i = 0; i < block.record_num; ++i) {
+      std::string format_value = accessor->ParseToString(value, block.sizes[i]);
+      if (0 != write_channel->write_line(::paddle::string::format_string(
+                   "%lu %s", block.keys[i], format_value.c_str()))) {
+        ret = -1;
+        break;
+      }
+      value += block.sizes[i];
+      ++record_num;
+    }
+    if (ret < 0) break;
+  }
+  write_channel->close();
+  return ret < 0 || err_no == -1 ? -1 : record_num;
+}
+
+// Parses text lines written by Save into a binary shard file. Returns the
+// number of records, or -1.
+inline int64_t ConvertSparseTextToBinary(ValueAccessor* accessor,
+                                         AfsClient* afs_client,
+                                         const std::string& text_path,
+                                         const std::string& binary_path) {
+  size_t value_dim = accessor->GetAccessorInfo().size / sizeof(float);
+  FsChannelConfig read_config;
+  read_config.path = text_path;
+  int err_no = 0;
+  auto read_channel = afs_client->open_r(read_config, 0, &err_no);
+  FsChannelConfig write_config;
+  write_config.path = binary_path;
+  auto write_channel =
+      afs_client->open_w(write_config, 1024 * 1024 * 40, &err_no);
+  SparseBinaryFileWriter writer(write_channel, value_dim);
+  std::vector<float> value(value_dim);
+  std::string line_data;
+  char* end = nullptr;
+  int64_t record_num = 0;
+  int ret = 0;
+  while (read_channel->read_line(line_data) == 0 && line_data.size() > 1) {
+    uint64_t key = std::strtoul(line_data.data(), &end, 10);
+    int parse_size = accessor->ParseFromString(++end, value.data());
+    if ((ret = writer.Append(key, value.data(), parse_size)) != 0) {
+      break;
+    }
+    ++record_num;
+  }
+  read_channel->close();
+  if (ret == 0) {
+    ret = writer.Close();
+  }
+  write_channel->close();
+  return ret != 0 || err_no == -1 ? -1 : record_num;
+}
+
+}  // namespace distributed
+}  // namespace paddle
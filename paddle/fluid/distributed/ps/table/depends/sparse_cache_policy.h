@@ -0,0 +1,228 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "paddle/utils/string/string_helper.h"
+
+namespace paddle {
+namespace distributed {
+
+// Count-min sketch of 4-bit counters estimating how often keys were accessed
+// recently. Every counter is halved once sample_size accesses were recorded,
+// so the popularity of keys that are no longer read fades away (TinyLFU).
+class FrequencySketch {
+ public:
+  explicit FrequencySketch(size_t capacity) {
+    size_t width = 64;
+    while (width < capacity) {
+      width <<= 1;
+    }
+    _table.assign(width, 0);
+    _mask = width - 1;
+    _sample_size = 10 * width;
+  }
+
+  void Increment(uint64_t key) {
+    bool added = false;
+    for (int i = 0; i < kDepth; ++i) {
+      uint64_t hash = Hash(key, i);
+      uint64_t& word = _table[hash & _mask];
+      int offset = static_cast<int>((hash >> 32) & 15) << 2;
+      if (((word >> offset) & 0xfULL) != 0xfULL) {
+        word += 1ULL << offset;
+        added = true;
+      }
+    }
+    if (added && ++_size >= _sample_size) {
+      Reset();
+    }
+  }
+
+  uint32_t Estimate(uint64_t key) const {
+    uint32_t frequency = 15;
+    for (int i = 0; i < kDepth; ++i) {
+      uint64_t hash = Hash(key, i);
+      int offset = static_cast<int>((hash >> 32) & 15) << 2;
+      frequency = std::min(
+          frequency,
+          static_cast<uint32_t>((_table[hash & _mask] >> offset) & 0xfULL));
+    }
+    return frequency;
+  }
+
+ private:
+  static const int kDepth = 4;
+
+  static uint64_t Hash(uint64_t key, int row) {
+    // splitmix64 with a different seed per row
+    uint64_t x = key + 0x9E3779B97F4A7C15ULL * (row + 1);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+  }
+
+  void Reset() {
+    for (auto& word : _table) {
+      word = (word >> 1) & 0x7777777777777777ULL;
+    }
+    _size /= 2;
+  }
+
+  std::vector<uint64_t> _table;
+  uint64_t _mask;
+  size_t _sample_size;
+  size_t _size = 0;
+};
+
+// Hit and movement counters of a memory tier in front of rocksdb.
+struct SparseCacheStat {
+  std::atomic<uint64_t> mem_hit_num{0};
+  std::atomic<uint64_t> ssd_hit_num{0};
+  std::atomic<uint64_t> miss_num{0};
+  std::atomic<uint64_t> admit_num{0};
+  std::atomic<uint64_t> reject_num{0};
+  std::atomic<uint64_t> evict_num{0};
+
+  std::string ToString() const {
+    uint64_t mem_hit = mem_hit_num.load();
+    uint64_t ssd_hit = ssd_hit_num.load();
+    uint64_t miss = miss_num.load();
+    uint64_t total = mem_hit + ssd_hit + miss;
+    return ::paddle::string::format_string(
+        "mem_hit:%lu ssd_hit:%lu miss:%lu mem_hit_rate:%.4f admit:%lu "
+        "reject:%lu evict:%lu",
+        mem_hit,
+        ssd_hit,
+        miss,
+        total == 0 ? 0.0 : static_cast<double>(mem_hit) / total,
+        admit_num.load(),
+        reject_num.load(),
+        evict_num.load());
+  }
+};
+
+// Decides which values of one sparse shard stay in memory when the shard is
+// backed by a slower tier.
+//
+// A value read from the slower tier is only admitted into memory once its key
+// was accessed admit_threshold times recently, so one-off keys of a scan do
+// not push hot ones out. When the shard holds more than capacity values, a
+// hand sweeps it and evicts the coldest of the next kSampleNum values, where
+// the sketch frequency decides and the caller's heat (e.g. the accessor's
+// show) breaks ties; if they are all hot the hand goes on for up to
+// kMaxScanNum values. Like the shard it must only be used by its thread.
+class SparseCachePolicy {
+ public:
+  SparseCachePolicy(size_t capacity, uint32_t admit_threshold)
+      : _sketch(std::max<size_t>(capacity, 1024)),
+        _capacity(capacity),
+        _admit_threshold(admit_threshold) {}
+
+  // call for every access of key, whichever tier serves it
+  void RecordAccess(uint64_t key) { _sketch.Increment(key); }
+  bool Admit(uint64_t key) const {
+    return _admit_threshold <= 1 || _sketch.Estimate(key) >= _admit_threshold;
+  }
+  uint32_t Frequency(uint64_t key) const { return _sketch.Estimate(key); }
+  bool NeedEvict(size_t size) const {
+    return _capacity > 0 && size > _capacity;
+  }
+
+  // Evicts values of shard until at most capacity are left. heat(value)
+  // returns a non-negative score, evict(key, value) is called right before a
+  // value is erased. Returns the number of evicted values.
+  template <class SHARD, class HEAT, class EVICT>
+  size_t Evict(SHARD* shard, HEAT&& heat, EVICT&& evict) {
+    return Evict(shard, heat, evict, [](uint64_t key) { return true; });
+  }
+
+  // Like above, but values for which can_evict(key) is false stay in memory.
+  // Eviction stops early when the hand meets none it may evict.
+  template <class SHARD, class HEAT, class EVICT, class CAN_EVICT>
+  size_t Evict(SHARD* shard,
+               HEAT&& heat,
+               EVICT&& evict,
+               CAN_EVICT&& can_evict) {
+    size_t evicted = 0;
+    while (NeedEvict(shard->size())) {
+      auto it = _hand_valid ? shard->find(_hand_key) : shard->end();
+      if (it == shard->end()) {
+        it = shard->begin();
+      }
+      auto victim = shard->end();
+      double victim_score = std::numeric_limits<double>::max();
+      // like CLOCK, hot values met by the hand are skipped for a while
+      for (int i = 0; i < kSampleNum ||
+                      (i < kMaxScanNum && victim_score >= HotFrequency());
+           ++i) {
+        if (it == shard->end()) {
+          it = shard->begin();
+        }
+        if (!can_evict(it.key())) {
+          ++it;
+          continue;
+        }
+        double value_heat =
+            std::max(static_cast<double>(heat(it.value())), 0.0);
+        double score =
+            _sketch.Estimate(it.key()) + value_heat / (value_heat + 1.0);
+        if (score < victim_score) {
+          victim = it;
+          victim_score = score;
+        }
+        ++it;
+      }
+      if (victim == shard->end()) {
+        _hand_valid = it != shard->end();
+        if (_hand_valid) {
+          _hand_key = it.key();
+        }
+        break;
+      }
+      _hand_valid = it != shard->end() && it.key() != victim.key();
+      if (_hand_valid) {
+        _hand_key = it.key();
+      }
+      evict(victim.key(), victim.value());
+      shard->erase(victim);
+      ++evicted;
+    }
+    return evicted;
+  }
+
+ private:
+  static const int kSampleNum = 8;
+  static const int kMaxScanNum = 64;
+
+  double HotFrequency() const {
+    return std::max<uint32_t>(_admit_threshold, 2);
+  }
+
+  FrequencySketch _sketch;
+  size_t _capacity;
+  uint32_t _admit_threshold;
+  uint64_t _hand_key = 0;
+  bool _hand_valid = false;
+};
+
+}  // namespace distributed
+}  // namespace paddle
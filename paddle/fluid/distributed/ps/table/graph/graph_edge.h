@@ -36,6 +36,7 @@ class GraphEdgeBlob {
   virtual float get_weight(int idx UNUSED) { return 1.0; }
 #endif
   std::vector<int64_t>& export_id_array() { return id_arr; }
+  virtual bool has_weight() { return false; }
 
  protected:
   std::vector<int64_t> id_arr;
@@ -51,6 +52,7 @@ class WeightedGraphEdgeBlob : public GraphEdgeBlob {
 #else
   virtual float get_weight(int idx) { return weight_arr[idx]; }
 #endif
+  virtual bool has_weight() { return !weight_arr.empty(); }
 
  protected:
 #ifdef PADDLE_WITH_CUDA
@@ -59,5 +61,13 @@ class WeightedGraphEdgeBlob : public GraphEdgeBlob {
   std::vector<float> weight_arr;
 #endif
 };
+
+// The edges of many nodes packed into contiguous arrays (CSR), built when a
+// GraphShard is finalized. A node owns the range [begin, begin + size) of
+// ids, and of weights if the shard has weighted edges.
+struct GraphCsrEdges {
+  std::vector<int64_t> ids;
+  std::vector<float> weights;
+};
 }  // namespace distributed
 }  // namespace paddle
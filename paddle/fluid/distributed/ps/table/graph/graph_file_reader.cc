@@ -0,0 +1,98 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_file_reader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace paddle {
+namespace distributed {
+
+int MmapTextFile::open(const std::string &path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return -1;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+    size_ = st.st_size;
+    if (size_ == 0) {
+      ::close(fd);
+      return 0;
+    }
+    void *addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      madvise(addr, size_, MADV_SEQUENTIAL);
+      ::close(fd);
+      data_ = static_cast<const char *>(addr);
+      mapped_ = true;
+      return 0;
+    }
+  }
+  ::close(fd);
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return -1;
+  }
+  std::stringstream stream;
+  stream << file.rdbuf();
+  buffer_ = stream.str();
+  data_ = buffer_.data();
+  size_ = buffer_.size();
+  return 0;
+}
+
+void MmapTextFile::close() {
+  if (mapped_) {
+    munmap(const_cast<char *>(data_), size_);
+    mapped_ = false;
+  }
+  buffer_.clear();
+  buffer_.shrink_to_fit();
+  data_ = nullptr;
+  size_ = 0;
+}
+
+std::vector<std::pair<size_t, size_t>> split_text_chunks(const char *data,
+                                                         size_t size,
+                                                         size_t chunk_size) {
+  std::vector<std::pair<size_t, size_t>> chunks;
+  chunk_size = std::max<size_t>(chunk_size, 1);
+  size_t begin = 0;
+  while (begin < size) {
+    size_t end = size;
+    if (size - begin > chunk_size) {
+      size_t pos = begin + chunk_size - 1;
+      const void *newline = memchr(data + pos, '\n', size - pos);
+      if (newline != nullptr) {
+        end = static_cast<const char *>(newline) - data + 1;
+      }
+    }
+    chunks.emplace_back(begin, end);
+    begin = end;
+  }
+  return chunks;
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,55 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+// Read-only view of a local text file, mapped with mmap. Files that can not
+// be mapped (e.g. pipes) are read into memory instead.
+class MmapTextFile {
+ public:
+  MmapTextFile() {}
+  ~MmapTextFile() { close(); }
+  MmapTextFile(const MmapTextFile &) = delete;
+  MmapTextFile &operator=(const MmapTextFile &) = delete;
+
+  // returns 0 on success, -1 if the file can not be read
+  int open(const std::string &path);
+  void close();
+  const char *data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+  std::string buffer_;
+};
+
+// Splits data into [begin, end) ranges of about chunk_size bytes. Every range
+// but the first starts after a '\n' and every range but the last ends after
+// one, so no line is split.
+std::vector<std::pair<size_t, size_t>> split_text_chunks(const char *data,
+                                                         size_t size,
+                                                         size_t chunk_size);
+
+}  // namespace distributed
+}  // namespace paddle
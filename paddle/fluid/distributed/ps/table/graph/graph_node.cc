@@ -15,6 +15,11 @@
 #include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
 
 #include <cstring>
+
+#include "paddle/common/flags.h"
+
+COMMON_DECLARE_int32(graph_alias_sampler_min_degree);
+
 namespace paddle::distributed {
 
 GraphNode::~GraphNode() {
@@ -56,6 +61,9 @@ int FeatureNode::get_size(bool need_feature) {
 }
 
 void GraphNode::build_edges(bool is_weighted) {
+  if (edges == nullptr && csr_edges != nullptr) {
+    thaw_edges();
+  }
   if (edges == nullptr) {
     if (is_weighted == true) {
       edges = new WeightedGraphEdgeBlob();
@@ -64,14 +72,34 @@ void GraphNode::build_edges(bool is_weighted) {
     }
   }
 }
+bool GraphNode::use_alias_sampler(size_t size) {
+  return FLAGS_graph_alias_sampler_min_degree > 0 &&
+         size >= static_cast<size_t>(FLAGS_graph_alias_sampler_min_degree);
+}
 void GraphNode::build_sampler(std::string sample_type) {
   if (sampler != nullptr) {
     return;
   }
+  if (csr_edges != nullptr) {
+    // frozen edges are sampled from the csr arrays directly
+    csr_sampler =
+        sample_type == "weighted" ? kWeightedCsrSampler : kRandomCsrSampler;
+    if (csr_sampler == kWeightedCsrSampler && !csr_edges->weights.empty() &&
+        use_alias_sampler(csr_size)) {
+      auto alias_sampler = new AliasSampler();
+      alias_sampler->build(csr_edges, csr_begin, csr_size);
+      sampler = alias_sampler;
+    }
+    return;
+  }
   if (sample_type == "random") {
     sampler = new RandomSampler();
   } else if (sample_type == "weighted") {
-    sampler = new WeightedSampler();
+    if (use_alias_sampler(edges->size())) {
+      sampler = new AliasSampler();
+    } else {
+      sampler = new WeightedSampler();
+    }
   }
   if (sampler != nullptr) {
     sampler->build(edges);
@@ -80,6 +108,70 @@ void GraphNode::build_sampler(std::string sample_type) {
                              sample_type);
   }
 }
+void GraphNode::freeze_edges(GraphCsrEdges* csr, bool with_weight) {
+  if (edges == nullptr && csr_edges == nullptr) {
+    return;
+  }
+  size_t size = get_neighbor_size();
+  uint64_t begin = csr->ids.size();
+  for (size_t i = 0; i < size; ++i) {
+    csr->ids.push_back(get_neighbor_id(i));
+  }
+  if (with_weight) {
+    for (size_t i = 0; i < size; ++i) {
+      csr->weights.push_back(has_neighbor_weight()
+                                 ? static_cast<float>(get_neighbor_weight(i))
+                                 : 1.0f);
+    }
+  }
+  if (edges != nullptr) {
+    csr_weighted_blob = dynamic_cast<WeightedGraphEdgeBlob*>(edges) != nullptr;
+    delete edges;
+    edges = nullptr;
+  }
+  if (sampler != nullptr) {
+    csr_sampler = dynamic_cast<RandomSampler*>(sampler) != nullptr
+                      ? kRandomCsrSampler
+                      : kWeightedCsrSampler;
+    delete sampler;
+    sampler = nullptr;
+  }
+  csr_edges = csr;
+  csr_begin = begin;
+  csr_size = size;
+  if (csr_sampler == kWeightedCsrSampler && with_weight &&
+      use_alias_sampler(size)) {
+    // the table is built from the csr weights by the first sample_k
+    auto alias_sampler = new AliasSampler();
+    alias_sampler->build(csr, begin, size);
+    sampler = alias_sampler;
+  }
+}
+void GraphNode::thaw_edges() {
+  if (csr_weighted_blob) {
+    edges = new WeightedGraphEdgeBlob();
+  } else {
+    edges = new GraphEdgeBlob();
+  }
+  for (uint32_t i = 0; i < csr_size; ++i) {
+    edges->add_edge(csr_edges->ids[csr_begin + i],
+                    csr_edges->weights.empty()
+                        ? 1.0f
+                        : csr_edges->weights[csr_begin + i]);
+  }
+  if (sampler != nullptr) {
+    delete sampler;
+    sampler = nullptr;
+  }
+  CsrSampler sampler_type = csr_sampler;
+  csr_edges = nullptr;
+  csr_begin = 0;
+  csr_size = 0;
+  csr_sampler = kNoCsrSampler;
+  if (sampler_type != kNoCsrSampler) {
+    build_sampler(sampler_type == kWeightedCsrSampler ? "weighted" : "random");
+  }
+}
 void FeatureNode::to_buffer(char* buffer, bool need_feature) {
   memcpy(buffer, &id, id_size);
   buffer += id_size;
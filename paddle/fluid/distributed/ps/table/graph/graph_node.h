@@ -16,6 +16,7 @@
 #ifdef PADDLE_WITH_CUDA
 #include <cuda_fp16.h>
 #endif
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <memory>
@@ -48,6 +49,14 @@ class Node {
       int k UNUSED, const std::shared_ptr<std::mt19937_64> rng UNUSED) {
     return std::vector<int>();
   }
+  // writes the sampled neighbor indices to res, returns their number
+  virtual int sample_k_to(int k,
+                          const std::shared_ptr<std::mt19937_64> rng,
+                          int *res) {
+    std::vector<int> sample_result = sample_k(k, rng);
+    std::copy(sample_result.begin(), sample_result.end(), res);
+    return sample_result.size();
+  }
   virtual uint64_t get_neighbor_id(int idx UNUSED) { return 0; }
 #ifdef PADDLE_WITH_CUDA
   virtual half get_neighbor_weight(int idx UNUSED) { return 1.; }
@@ -82,6 +91,12 @@ class Node {
   virtual void shrink_to_fit() {}
   virtual int get_feature_size() { return 0; }
   virtual size_t get_neighbor_size() { return 0; }
+  // contiguous neighbor ids and weights, nullptr unless the edges are frozen
+  virtual const int64_t *get_neighbor_ids() { return nullptr; }
+  virtual const float *get_neighbor_weights() { return nullptr; }
+  virtual bool has_neighbor_weight() { return false; }
+  virtual void freeze_edges(GraphCsrEdges *csr UNUSED,
+                            bool with_weight UNUSED) {}
   virtual bool get_is_weighted() { return is_weighted; }
 
  protected:
@@ -89,6 +104,10 @@ class Node {
   bool is_weighted;
 };
 
+// The edges of a GraphNode live either in its own GraphEdgeBlob, or after
+// freeze_edges in a range of the GraphCsrEdges shared by its shard, which
+// saves the blob and sampler allocations of every node. Adding edges to a
+// frozen node copies its range back into a new blob.
 class GraphNode : public Node {
  public:
   GraphNode() : Node(), sampler(nullptr), edges(nullptr) {}
@@ -98,23 +117,102 @@ class GraphNode : public Node {
   virtual void build_edges(bool is_weighted);
   virtual void build_sampler(std::string sample_type);
   virtual void add_edge(uint64_t id, float weight) {
+    if (edges == nullptr && csr_edges != nullptr) {
+      thaw_edges();
+    }
     edges->add_edge(id, weight);
   }
   virtual std::vector<int> sample_k(
       int k, const std::shared_ptr<std::mt19937_64> rng) {
+    if (csr_edges != nullptr && sampler == nullptr) {
+      if (csr_sampler == kWeightedCsrSampler && !csr_edges->weights.empty()) {
+        return weighted_sample_k(
+            csr_edges->weights.data() + csr_begin, csr_size, k, rng);
+      }
+      return random_sample_k(csr_size, k, rng);
+    }
     return sampler->sample_k(k, rng);
   }
-  virtual uint64_t get_neighbor_id(int idx) { return edges->get_id(idx); }
+  virtual int sample_k_to(int k,
+                          const std::shared_ptr<std::mt19937_64> rng,
+                          int *res) {
+    if (csr_edges != nullptr && sampler == nullptr) {
+      if (csr_sampler == kWeightedCsrSampler && !csr_edges->weights.empty()) {
+        return weighted_sample_k(
+            csr_edges->weights.data() + csr_begin, csr_size, k, rng, res);
+      }
+      return random_sample_k(csr_size, k, rng, res);
+    }
+    return sampler->sample_k_to(k, rng, res);
+  }
+  virtual uint64_t get_neighbor_id(int idx) {
+    if (csr_edges != nullptr) {
+      return csr_edges->ids[csr_begin + idx];
+    }
+    return edges->get_id(idx);
+  }
 #ifdef PADDLE_WITH_CUDA
-  virtual half get_neighbor_weight(int idx) { return edges->get_weight(idx); }
+  virtual half get_neighbor_weight(int idx) {
+    if (csr_edges != nullptr) {
+      return csr_edges->weights.empty()
+                 ? (half)(1.0)
+                 : (half)(csr_edges->weights[csr_begin + idx]);
+    }
+    return edges->get_weight(idx);
+  }
 #else
-  virtual float get_neighbor_weight(int idx) { return edges->get_weight(idx); }
+  virtual float get_neighbor_weight(int idx) {
+    if (csr_edges != nullptr) {
+      return csr_edges->weights.empty() ? 1.0
+                                        : csr_edges->weights[csr_begin + idx];
+    }
+    return edges->get_weight(idx);
+  }
 #endif
-  virtual size_t get_neighbor_size() { return edges->size(); }
+  virtual size_t get_neighbor_size() {
+    if (csr_edges != nullptr) {
+      return csr_size;
+    }
+    return edges == nullptr ? 0 : edges->size();
+  }
+  virtual const int64_t *get_neighbor_ids() {
+    return csr_edges == nullptr ? nullptr : csr_edges->ids.data() + csr_begin;
+  }
+  virtual const float *get_neighbor_weights() {
+    return csr_edges == nullptr || csr_edges->weights.empty()
+               ? nullptr
+               : csr_edges->weights.data() + csr_begin;
+  }
+  virtual bool has_neighbor_weight() {
+    if (csr_edges != nullptr) {
+      return !csr_edges->weights.empty();
+    }
+    return edges != nullptr && edges->has_weight();
+  }
+  // Appends the edges to csr and releases the blob and the sampler, except
+  // for the AliasSampler of a node of high degree, which moves to the csr
+  // range. Weights are appended if with_weight, 1 for nodes without weights.
+  virtual void freeze_edges(GraphCsrEdges *csr, bool with_weight);
 
  protected:
+  enum CsrSampler : uint8_t {
+    kNoCsrSampler = 0,
+    kRandomCsrSampler = 1,
+    kWeightedCsrSampler = 2
+  };
+  void thaw_edges();
+  // whether weighted sampling of size neighbors uses an AliasSampler
+  static bool use_alias_sampler(size_t size);
+
+  // nullptr for frozen nodes, unless weighted with a high degree
   Sampler *sampler;
   GraphEdgeBlob *edges;
+  const GraphCsrEdges *csr_edges = nullptr;
+  uint64_t csr_begin = 0;
+  uint32_t csr_size = 0;
+  // the sampler and blob types released by freeze_edges
+  CsrSampler csr_sampler = kNoCsrSampler;
+  bool csr_weighted_blob = false;
 };
 
 class FeatureNode : public Node {
@@ -14,8 +14,13 @@
 
 #include "paddle/fluid/distributed/ps/table/graph/graph_weighted_sampler.h"
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <unordered_map>
 
 #include "paddle/phi/core/generator.h"
@@ -23,28 +28,26 @@ namespace paddle::distributed {
 
 void RandomSampler::build(GraphEdgeBlob *edges) { this->edges = edges; }
 
-std::vector<int> RandomSampler::sample_k(
-    int k, const std::shared_ptr<std::mt19937_64> rng) {
-  int n = edges->size();
+int random_sample_k(int n,
+                    int k,
+                    const std::shared_ptr<std::mt19937_64> rng,
+                    int *res) {
   if (k >= n) {
-    k = n;
-    std::vector<int> sample_result;
-    sample_result.reserve(k);
-    for (int i = 0; i < k; i++) {
-      sample_result.push_back(i);
+    for (int i = 0; i < n; i++) {
+      res[i] = i;
     }
-    return sample_result;
+    return n;
   }
-  std::vector<int> sample_result;
+  int num = 0;
   std::unordered_map<int, int> replace_map;
   while (k--) {
     std::uniform_int_distribution<int> distrib(0, n - 1);
     int rand_int = distrib(*rng);
     auto iter = replace_map.find(rand_int);
     if (iter == replace_map.end()) {
-      sample_result.push_back(rand_int);
+      res[num++] = rand_int;
     } else {
-      sample_result.push_back(iter->second);
+      res[num++] = iter->second;
     }
 
     iter = replace_map.find(n - 1);
@@ -55,9 +58,196 @@ std::vector<int> RandomSampler::sample_k(
     }
     --n;
   }
+  return num;
+}
+
+std::vector<int> random_sample_k(int n,
+                                 int k,
+                                 const std::shared_ptr<std::mt19937_64> rng) {
+  std::vector<int> sample_result(std::max(std::min(k, n), 0));
+  random_sample_k(n, k, rng, sample_result.data());
   return sample_result;
 }
 
+// Fills res[num, k) with indices of [0, n) not in res[0, num), sampled
+// without replacement by weight. Efraimidis-Spirakis: keep the largest
+// u^(1/w), compared as log(u)/w.
+static void weighted_sample_rest(const float *weights,
+                                 int n,
+                                 int k,
+                                 const std::shared_ptr<std::mt19937_64> rng,
+                                 int *res,
+                                 int num) {
+  std::vector<char> sampled(n, 0);
+  for (int i = 0; i < num; i++) {
+    sampled[res[i]] = 1;
+  }
+  std::vector<std::pair<float, int>> keys;
+  keys.reserve(n - num);
+  std::uniform_real_distribution<float> distrib(0, 1);
+  for (int i = 0; i < n; i++) {
+    if (sampled[i]) {
+      continue;
+    }
+    float key = weights[i] > 0 ? std::log(1 - distrib(*rng)) / weights[i]
+                               : -std::numeric_limits<float>::infinity();
+    keys.emplace_back(key, i);
+  }
+  int rest = k - num;
+  std::nth_element(keys.begin(),
+                   keys.begin() + rest,
+                   keys.end(),
+                   std::greater<std::pair<float, int>>());
+  for (int i = 0; i < rest; i++) {
+    res[num + i] = keys[i].second;
+  }
+}
+
+int weighted_sample_k(const float *weights,
+                      int n,
+                      int k,
+                      const std::shared_ptr<std::mt19937_64> rng,
+                      int *res) {
+  if (k >= n) {
+    return random_sample_k(n, k, rng, res);
+  }
+  weighted_sample_rest(weights, n, k, rng, res, 0);
+  return k;
+}
+
+std::vector<int> weighted_sample_k(const float *weights,
+                                   int n,
+                                   int k,
+                                   const std::shared_ptr<std::mt19937_64> rng) {
+  std::vector<int> sample_result(std::max(std::min(k, n), 0));
+  weighted_sample_k(weights, n, k, rng, sample_result.data());
+  return sample_result;
+}
+
+int Sampler::sample_k_to(int k,
+                         const std::shared_ptr<std::mt19937_64> rng,
+                         int *res) {
+  std::vector<int> sample_result = sample_k(k, rng);
+  std::copy(sample_result.begin(), sample_result.end(), res);
+  return sample_result.size();
+}
+
+std::vector<int> RandomSampler::sample_k(
+    int k, const std::shared_ptr<std::mt19937_64> rng) {
+  return random_sample_k(edges->size(), k, rng);
+}
+
+int RandomSampler::sample_k_to(int k,
+                               const std::shared_ptr<std::mt19937_64> rng,
+                               int *res) {
+  return random_sample_k(edges->size(), k, rng, res);
+}
+
+void AliasSampler::build(GraphEdgeBlob *edges) {
+  this->edges = edges;
+  this->csr_edges = nullptr;
+  this->size = edges->size();
+}
+
+void AliasSampler::build(const GraphCsrEdges *csr_edges,
+                         uint64_t begin,
+                         int size) {
+  this->edges = nullptr;
+  this->csr_edges = csr_edges;
+  this->csr_begin = begin;
+  this->size = size;
+}
+
+void AliasSampler::build_table() {
+  if (csr_edges != nullptr) {
+    weight_ptr = csr_edges->weights.data() + csr_begin;
+  } else {
+    weights.resize(size, 1.0);
+    if (edges->has_weight()) {
+      for (int i = 0; i < size; i++) {
+        weights[i] = static_cast<float>(edges->get_weight(i));
+      }
+    }
+    weight_ptr = weights.data();
+  }
+  // Vose's alias method
+  double sum = 0;
+  for (int i = 0; i < size; i++) {
+    sum += std::max(weight_ptr[i], 0.0f);
+  }
+  std::vector<double> scaled(size);
+  std::vector<int> small_idx, large_idx;
+  for (int i = 0; i < size; i++) {
+    scaled[i] = sum > 0 ? std::max(weight_ptr[i], 0.0f) * size / sum : 1.0;
+    if (scaled[i] < 1.0) {
+      small_idx.push_back(i);
+    } else {
+      large_idx.push_back(i);
+    }
+  }
+  prob.resize(size);
+  alias.resize(size);
+  while (!small_idx.empty() && !large_idx.empty()) {
+    int s = small_idx.back();
+    int l = large_idx.back();
+    small_idx.pop_back();
+    large_idx.pop_back();
+    prob[s] = scaled[s];
+    alias[s] = l;
+    scaled[l] = scaled[l] + scaled[s] - 1.0;
+    if (scaled[l] < 1.0) {
+      small_idx.push_back(l);
+    } else {
+      large_idx.push_back(l);
+    }
+  }
+  // the rest are 1 up to rounding errors
+  for (int i : small_idx) {
+    prob[i] = 1.0;
+    alias[i] = i;
+  }
+  for (int i : large_idx) {
+    prob[i] = 1.0;
+    alias[i] = i;
+  }
+}
+
+std::vector<int> AliasSampler::sample_k(
+    int k, const std::shared_ptr<std::mt19937_64> rng) {
+  std::vector<int> sample_result(std::max(std::min(k, size), 0));
+  sample_k_to(k, rng, sample_result.data());
+  return sample_result;
+}
+
+int AliasSampler::sample_k_to(int k,
+                              const std::shared_ptr<std::mt19937_64> rng,
+                              int *res) {
+  if (k >= size) {
+    return random_sample_k(size, k, rng, res);
+  }
+  std::call_once(build_flag, [this] { build_table(); });
+  std::uniform_int_distribution<int> bucket(0, size - 1);
+  std::uniform_real_distribution<float> coin(0, 1);
+  // Repeated draws are rejected, which samples each next index from the
+  // weights of the remaining ones, i.e. exactly without replacement.
+  int num = 0;
+  int max_draws = 4 * k + 32;
+  while (num < k && max_draws-- > 0) {
+    int idx = bucket(*rng);
+    if (coin(*rng) >= prob[idx]) {
+      idx = alias[idx];
+    }
+    if (std::find(res, res + num, idx) == res + num) {
+      res[num++] = idx;
+    }
+  }
+  if (num < k) {
+    // most of the weight is already sampled
+    weighted_sample_rest(weight_ptr, size, k, rng, res, num);
+  }
+  return k;
+}
+
 WeightedSampler::WeightedSampler() {
   left = nullptr;
   right = nullptr;
@@ -100,7 +290,8 @@ void WeightedSampler::build_one(WeightedGraphEdgeBlob *edges,
     left = right = nullptr;
     idx = start;
     count = 1;
-    weight = edges->get_weight(idx);
+    // cpu builds keep no weights in the blob
+    weight = edges->has_weight() ? edges->get_weight(idx) : 1.0;
 
   } else {
     left = new WeightedSampler();
@@ -15,6 +15,7 @@
 #pragma once
 #include <ctime>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <random>
 #include <unordered_map>
 #include <vector>
@@ -23,12 +24,38 @@
 namespace paddle {
 namespace distributed {
 
+// Samples min(k, n) distinct indices of [0, n) uniformly.
+std::vector<int> random_sample_k(int n,
+                                 int k,
+                                 const std::shared_ptr<std::mt19937_64> rng);
+// the same into res, returns the number of sampled indices
+int random_sample_k(int n,
+                    int k,
+                    const std::shared_ptr<std::mt19937_64> rng,
+                    int *res);
+// Samples min(k, n) distinct indices of [0, n) without replacement, each
+// with probability proportional to weights[i].
+std::vector<int> weighted_sample_k(const float *weights,
+                                   int n,
+                                   int k,
+                                   const std::shared_ptr<std::mt19937_64> rng);
+int weighted_sample_k(const float *weights,
+                      int n,
+                      int k,
+                      const std::shared_ptr<std::mt19937_64> rng,
+                      int *res);
+
 class Sampler {
  public:
   virtual ~Sampler() {}
   virtual void build(GraphEdgeBlob *edges) = 0;
   virtual std::vector<int> sample_k(
       int k, const std::shared_ptr<std::mt19937_64> rng) = 0;
+  // Writes the sampled indices to res, which holds at least k of them, and
+  // returns their number.
+  virtual int sample_k_to(int k,
+                          const std::shared_ptr<std::mt19937_64> rng,
+                          int *res);
 };
 
 class RandomSampler : public Sampler {
@@ -37,9 +64,43 @@ class RandomSampler : public Sampler {
   virtual void build(GraphEdgeBlob *edges);
   virtual std::vector<int> sample_k(int k,
                                     const std::shared_ptr<std::mt19937_64> rng);
+  virtual int sample_k_to(int k,
+                          const std::shared_ptr<std::mt19937_64> rng,
+                          int *res);
   GraphEdgeBlob *edges;
 };
 
+// Weighted sampling with Vose's alias method for nodes of high degree: a draw
+// is O(1) after an O(degree) table build, where WeightedSampler walks a tree
+// per draw. The table is built by the first sample_k, so only the nodes that
+// are sampled pay for it, and concurrent first calls build it once.
+class AliasSampler : public Sampler {
+ public:
+  virtual ~AliasSampler() {}
+  virtual void build(GraphEdgeBlob *edges);
+  // samples the range [begin, begin + size) of the frozen edges
+  void build(const GraphCsrEdges *csr_edges, uint64_t begin, int size);
+  virtual std::vector<int> sample_k(int k,
+                                    const std::shared_ptr<std::mt19937_64> rng);
+  virtual int sample_k_to(int k,
+                          const std::shared_ptr<std::mt19937_64> rng,
+                          int *res);
+
+ private:
+  void build_table();
+
+  GraphEdgeBlob *edges = nullptr;
+  const GraphCsrEdges *csr_edges = nullptr;
+  uint64_t csr_begin = 0;
+  int size = 0;
+  std::once_flag build_flag;
+  const float *weight_ptr = nullptr;
+  // copy of the blob weights, which may be half
+  std::vector<float> weights;
+  std::vector<float> prob;
+  std::vector<int> alias;
+};
+
 class WeightedSampler : public Sampler {
  public:
   WeightedSampler();
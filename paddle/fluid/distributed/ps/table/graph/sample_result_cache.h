@@ -0,0 +1,206 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "paddle/phi/core/utils/rw_lock.h"
+#include "paddle/utils/string/string_helper.h"
+
+namespace paddle {
+namespace distributed {
+
+struct SampleCacheStat {
+  uint64_t hit = 0;
+  uint64_t miss = 0;
+  uint64_t evict = 0;
+  uint64_t expire = 0;
+  uint64_t entry_num = 0;
+  uint64_t bytes = 0;
+
+  std::string to_string() const {
+    return ::paddle::string::format_string(
+        "sample cache hit:%lu miss:%lu hit_ratio:%.4f evict:%lu expire:%lu "
+        "entries:%lu bytes:%lu",
+        hit,
+        miss,
+        hit + miss == 0 ? 0.0 : static_cast<double>(hit) / (hit + miss),
+        evict,
+        expire,
+        entry_num,
+        bytes);
+  }
+};
+
+// Concurrent cache of neighbor sample results, split into segments by key
+// hash. Each segment is a hash map under a read-write lock and evicts with
+// CLOCK: a lookup takes the read lock only, it marks the entry referenced
+// and counts down its ttl with atomics instead of reordering a list, so
+// queries of different threads do not serialize. Inserts take the write
+// lock of their segment and sweep the clock hand until the segment is
+// within its share of the entry and byte limits; entries whose ttl ran out
+// are dropped first, so a cached sample is served at most ttl times before
+// the node is sampled again.
+//
+// V must have a size_t actual_size, the bytes it holds besides the entry.
+template <typename K, typename V>
+class SampleResultCache {
+ public:
+  // size_limit and bytes_limit bound the whole cache, 0 bytes_limit means
+  // no byte limit
+  SampleResultCache(size_t segment_num,
+                    size_t size_limit,
+                    size_t ttl,
+                    size_t bytes_limit = 0)
+      : ttl_(ttl), segments_(std::max<size_t>(segment_num, 1)) {
+    for (auto &segment : segments_) {
+      segment.size_limit = std::max<size_t>(size_limit / segments_.size(), 1);
+      segment.bytes_limit = bytes_limit / segments_.size();
+    }
+  }
+
+  // appends (key, value) of the cached keys to res, in the order of keys
+  void query(const K *keys, size_t length, std::vector<std::pair<K, V>> *res) {
+    for (size_t i = 0; i < length; i++) {
+      Segment &segment = get_segment(keys[i]);
+      phi::AutoRDLock lock(&segment.rwlock);
+      auto iter = segment.key_map.find(keys[i]);
+      if (iter == segment.key_map.end() ||
+          iter->second->ttl.fetch_sub(1, std::memory_order_relaxed) <= 0) {
+        segment.miss.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      Entry *entry = iter->second.get();
+      if (!entry->referenced.load(std::memory_order_relaxed)) {
+        entry->referenced.store(true, std::memory_order_relaxed);
+      }
+      res->emplace_back(keys[i], entry->data);
+      segment.hit.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  void insert(const K *keys, const V *data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+      Segment &segment = get_segment(keys[i]);
+      phi::AutoWRLock lock(&segment.rwlock);
+      size_t bytes = sizeof(Entry) + data[i].actual_size;
+      auto iter = segment.key_map.find(keys[i]);
+      if (iter != segment.key_map.end()) {
+        Entry *entry = iter->second.get();
+        segment.bytes += bytes - entry->bytes;
+        entry->data = data[i];
+        entry->bytes = bytes;
+        entry->ttl.store(ttl_, std::memory_order_relaxed);
+      } else {
+        std::unique_ptr<Entry> entry(new Entry(keys[i], data[i], bytes, ttl_));
+        segment.clock.push_back(entry.get());
+        segment.key_map.emplace(keys[i], std::move(entry));
+        segment.bytes += bytes;
+      }
+      shrink(&segment);
+    }
+  }
+
+  SampleCacheStat get_stat() {
+    SampleCacheStat stat;
+    for (auto &segment : segments_) {
+      stat.hit += segment.hit.load(std::memory_order_relaxed);
+      stat.miss += segment.miss.load(std::memory_order_relaxed);
+      stat.evict += segment.evict.load(std::memory_order_relaxed);
+      stat.expire += segment.expire.load(std::memory_order_relaxed);
+      phi::AutoRDLock lock(&segment.rwlock);
+      stat.entry_num += segment.key_map.size();
+      stat.bytes += segment.bytes;
+    }
+    return stat;
+  }
+
+  size_t get_ttl() { return ttl_; }
+
+ private:
+  struct Entry {
+    Entry(const K &key, const V &data, size_t bytes, size_t ttl)
+        : key(key), data(data), bytes(bytes), ttl(ttl), referenced(true) {}
+    K key;
+    V data;
+    size_t bytes;
+    // remaining lookups, counted down under the read lock
+    std::atomic<int64_t> ttl;
+    // set by lookups, new entries start referenced to survive one sweep
+    std::atomic<bool> referenced;
+  };
+
+  struct alignas(64) Segment {
+    phi::RWLock rwlock;
+    std::unordered_map<K, std::unique_ptr<Entry>> key_map;
+    // the clock ring, hand points to the next entry to inspect
+    std::vector<Entry *> clock;
+    size_t hand = 0;
+    size_t bytes = 0;
+    size_t size_limit = 0;
+    size_t bytes_limit = 0;
+    std::atomic<uint64_t> hit{0};
+    std::atomic<uint64_t> miss{0};
+    std::atomic<uint64_t> evict{0};
+    std::atomic<uint64_t> expire{0};
+  };
+
+  Segment &get_segment(const K &key) {
+    uint64_t hash = std::hash<K>()(key) * 0x9E3779B97F4A7C15ULL;
+    return segments_[(hash >> 32) % segments_.size()];
+  }
+
+  bool over_limit(const Segment &segment) const {
+    return segment.key_map.size() > segment.size_limit ||
+           (segment.bytes_limit > 0 && segment.bytes > segment.bytes_limit);
+  }
+
+  // called with the write lock of segment held
+  void shrink(Segment *segment) {
+    // every entry gets one second chance, so this ends within two laps
+    while (over_limit(*segment) && !segment->clock.empty()) {
+      if (segment->hand >= segment->clock.size()) {
+        segment->hand = 0;
+      }
+      Entry *entry = segment->clock[segment->hand];
+      bool expired = entry->ttl.load(std::memory_order_relaxed) <= 0;
+      if (!expired && entry->referenced.load(std::memory_order_relaxed)) {
+        entry->referenced.store(false, std::memory_order_relaxed);
+        ++segment->hand;
+        continue;
+      }
+      (expired ? segment->expire : segment->evict)
+          .fetch_add(1, std::memory_order_relaxed);
+      segment->bytes -= entry->bytes;
+      segment->clock[segment->hand] = segment->clock.back();
+      segment->clock.pop_back();
+      segment->key_map.erase(entry->key);
+    }
+  }
+
+  int64_t ttl_;
+  std::vector<Segment> segments_;
+};
+
+}  // namespace distributed
+}  // namespace paddle
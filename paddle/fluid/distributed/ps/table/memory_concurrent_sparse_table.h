@@ -0,0 +1,118 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <ThreadPool.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/distributed/ps/table/accessor.h"
+#include "paddle/fluid/distributed/ps/table/common_table.h"
+#include "paddle/fluid/distributed/ps/table/depends/concurrent_sparse_shard.h"
+#include "paddle/fluid/distributed/ps/table/depends/feature_value.h"
+#include "paddle/utils/string/string_helper.h"
+
+namespace paddle {
+namespace distributed {
+
+// A MemorySparseTable variant backed by ConcurrentSparseTableShard.
+//
+// MemorySparseTable funnels every request touching a shard through that
+// shard's single-thread task pool, so concurrent pulls and pushes queue up
+// behind each other. Here keys are locked per bucket instead, a request is
+// split into key ranges that run on a shared pool (or inline when small), and
+// pulls and pushes of different keys proceed in parallel even inside one
+// shard. Select it with table_class "MemoryConcurrentSparseTable"; the text
+// checkpoint format is the same as MemorySparseTable's.
+class MemoryConcurrentSparseTable : public Table {
+ public:
+  typedef ConcurrentSparseTableShard<uint64_t, FixedFeatureValue> shard_type;
+  MemoryConcurrentSparseTable() {}
+  virtual ~MemoryConcurrentSparseTable() {}
+
+  int32_t Pull(TableContext& context) override;
+  int32_t Push(TableContext& context) override;
+
+  int32_t Initialize() override;
+  int32_t InitializeShard() override { return 0; }
+
+  int32_t Load(const std::string& path, const std::string& param) override;
+  int32_t Save(const std::string& path, const std::string& param) override;
+#if defined(PADDLE_WITH_HETERPS) && defined(PADDLE_WITH_PSCORE)
+  int32_t Save_v2(const std::string& path, const std::string& param) override {
+    return Save(path, param);
+  }
+#endif
+
+  int64_t LocalSize();
+  int64_t LocalMFSize();
+  std::pair<int64_t, int64_t> PrintTableStat() override;
+
+  int32_t PullSparse(float* values,
+                     const PullSparseValue& pull_value,
+                     float** select_values = nullptr);
+  // Same pointer contract as MemorySparseTable::PullSparsePtr: the values
+  // live in the bucket allocators and are only freed by Shrink, Clear or a
+  // Load, none of which may run while a pass holds the pointers. Writes
+  // through them bypass the bucket locks, so a pass must not push the same
+  // keys through PushSparse concurrently.
+  int32_t PullSparsePtr(char** pull_values, const uint64_t* keys, size_t num);
+  int32_t PushSparse(const uint64_t* keys, const float* values, size_t num);
+  // values[i] is the push value of keys[i]; with headers, its first
+  // header_dim fields are headers[i] instead (see TablePushContext)
+  int32_t PushSparse(const uint64_t* keys,
+                     const float** values,
+                     size_t num,
+                     const float** headers = nullptr,
+                     size_t header_dim = 0);
+
+  int32_t Flush() override { return 0; }
+  int32_t Shrink(const std::string& param) override;
+  void Clear() override;
+
+  void* GetShard(size_t shard_idx) override {
+    return &_local_shards[shard_idx];
+  }
+
+ protected:
+  size_t GetLocalShardId(uint64_t key) const {
+    return (key % _sparse_table_shard_num) % _avg_local_shard_num;
+  }
+  // Splits [0, num) into ranges and runs func(begin, end) on each of them,
+  // either inline or on the shared task pool.
+  void ParallelRun(size_t num,
+                   const std::function<void(size_t, size_t)>& func);
+  // Applies one gradient to an existing value, extending its mf if needed.
+  // A non-null update_header holds the first header_dim fields of it.
+  void UpdateValue(FixedFeatureValue* feature_value,
+                   const float* update_header,
+                   size_t header_dim,
+                   const float* update_data,
+                   float* data_buffer);
+
+  int _task_pool_size = 24;
+  int _avg_local_shard_num;
+  int _real_local_shard_num;
+  int _sparse_table_shard_num;
+  std::shared_ptr<::ThreadPool> _task_pool;
+  std::unique_ptr<shard_type[]> _local_shards;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -19,6 +19,7 @@
 #include "paddle/fluid/distributed/common/cost_timer.h"
 #include "paddle/fluid/distributed/common/local_random.h"
 #include "paddle/fluid/distributed/common/topk_calculator.h"
+#include "paddle/fluid/distributed/ps/table/depends/sparse_binary_file.h"
 #include "paddle/fluid/distributed/ps/table/memory_sparse_table.h"
 #include "paddle/fluid/framework/archive.h"
 #include "paddle/fluid/framework/io/fs.h"
@@ -77,6 +78,9 @@ int32_t MemorySparseTable::InitializeValue() {
           << " _use_gpu_graph:" << _use_gpu_graph;
 
   _local_shards.reset(new shard_type[_real_local_shard_num]);
+  if (_config.enable_delta_save()) {
+    _dirty_trackers.reset(new DirtyKeyTracker[_real_local_shard_num]);
+  }
 
   if (_config.enable_revert()) {
     // calculate merged shard number based on config param;
@@ -122,6 +126,9 @@ int32_t MemorySparseTable::InitializeValue() {
 
 int32_t MemorySparseTable::Load(const std::string &path,
                                 const std::string &param) {
+  if (atoi(param.c_str()) == SPARSE_DELTA_SAVE_PARAM) {
+    return LoadDelta(path);
+  }
   std::string table_path = TableDir(path);
   auto file_list = _afs_client.list(table_path);
 
@@ -183,26 +190,31 @@ int32_t MemorySparseTable::Load(const std::string &path,
     do {
       is_read_failed = false;
       err_no = 0;
-      std::string line_data;
-      auto read_channel = _afs_client.open_r(channel_config, 0, &err_no);
-      char *end = nullptr;
       auto &shard = _local_shards[i];
       try {
-        while (read_channel->read_line(line_data) == 0 &&
-               line_data.size() > 1) {
-          uint64_t key = std::strtoul(line_data.data(), &end, 10);
-          auto &value = shard[key];
-          value.resize(feature_value_size);
-          int parse_size =
-              _value_accessor->ParseFromString(++end, value.data());
-          mem_count++;
-          value.resize(parse_size);
-          if (parse_size >
-              static_cast<int>(feature_value_size - mf_value_size)) {
-            mem_mf_count++;
+        if (IsSparseBinaryFile(channel_config.path)) {
+          err_no = LoadBinaryShard(
+              &shard, channel_config.path, &mem_count, &mem_mf_count);
+        } else {
+          std::string line_data;
+          auto read_channel = _afs_client.open_r(channel_config, 0, &err_no);
+          char *end = nullptr;
+          while (read_channel->read_line(line_data) == 0 &&
+                 line_data.size() > 1) {
+            uint64_t key = std::strtoul(line_data.data(), &end, 10);
+            auto &value = shard[key];
+            value.resize(feature_value_size);
+            int parse_size =
+                _value_accessor->ParseFromString(++end, value.data());
+            mem_count++;
+            value.resize(parse_size);
+            if (parse_size >
+                static_cast<int>(feature_value_size - mf_value_size)) {
+              mem_mf_count++;
+            }
           }
+          read_channel->close();
         }
-        read_channel->close();
         if (err_no == -1) {
           ++retry_num;
           is_read_failed = true;
@@ -224,12 +236,52 @@ int32_t MemorySparseTable::Load(const std::string &path,
     VLOG(0) << "Table>> load done. ALL[" << mem_count << "] MEM[" << mem_count
             << "] MEM_MF[" << mem_mf_count << "]";
   }
+  ResetDirtyTrackers();
   LOG(INFO) << "MemorySparseTable load success, path from "
             << file_list[file_start_idx] << " to "
             << file_list[file_start_idx + _real_local_shard_num - 1];
   return 0;
 }
 
+int32_t MemorySparseTable::LoadBinaryShard(shard_type *shard,
+                                           const std::string &path,
+                                           uint64_t *mem_count,
+                                           uint64_t *mem_mf_count) {
+  size_t feature_value_size =
+      _value_accessor->GetAccessorInfo().size / sizeof(float);
+  size_t mf_value_size =
+      _value_accessor->GetAccessorInfo().mf_size / sizeof(float);
+  FsChannelConfig channel_config = {};
+  channel_config.path = path;
+  SparseBinaryFileReader reader;
+  if (reader.Open(&_afs_client, channel_config) != 0) {
+    return -1;
+  }
+  if (reader.value_dim() != feature_value_size) {
+    LOG(ERROR) << "MemorySparseTable binary file value dim "
+               << reader.value_dim() << " not equal to accessor value dim "
+               << feature_value_size << ", path:" << path;
+    return -1;
+  }
+  SparseBinaryBlock block;
+  int ret = 0;
+  while ((ret = reader.NextBlock(&block)) > 0) {
+    const float *value_data = block.values;
+    for (size_t j = 0; j < block.record_num; ++j) {
+      size_t value_size = block.sizes[j];
+      auto &value = (*shard)[block.keys[j]];
+      value.resize(value_size);
+      memcpy(value.data(), value_data, value_size * sizeof(float));
+      value_data += value_size;
+      ++(*mem_count);
+      if (value_size > feature_value_size - mf_value_size) {
+        ++(*mem_mf_count);
+      }
+    }
+  }
+  return ret < 0 ? -1 : 0;
+}
+
 int32_t MemorySparseTable::LoadPatch(const std::vector<std::string> &file_list,
                                      int load_param) {
   if (!_config.enable_revert()) {
@@ -342,6 +394,9 @@ void MemorySparseTable::CheckSavePrePatchDone() {
 
 int32_t MemorySparseTable::Save(const std::string &dirname,
                                 const std::string &param) {
+  if (atoi(param.c_str()) == SPARSE_DELTA_SAVE_PARAM) {
+    return SaveDelta(dirname);
+  }
 #if defined(PADDLE_WITH_HETERPS) && defined(PADDLE_WITH_PSCORE)
   // gpu graph mode
   if (_use_gpu_graph) {
@@ -379,6 +434,10 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
   std::atomic<uint32_t> feasign_size_all{0};
 
   size_t file_start_idx = _avg_local_shard_num * _shard_idx;
+  // only checkpoints are read back by Load, keep xbox outputs as text
+  bool save_binary =
+      _config.binary_in_save() && (save_param == 0 || save_param == 3);
+  uint32_t value_dim = _value_accessor->GetAccessorInfo().size / sizeof(float);
 
 #ifdef PADDLE_WITH_HETERPS
   int thread_num = _real_local_shard_num;
@@ -389,7 +448,15 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
 #pragma omp parallel for schedule(dynamic)
   for (int i = 0; i < _real_local_shard_num; ++i) {
     FsChannelConfig channel_config = {};
-    if (_config.compress_in_save() && (save_param == 0 || save_param == 3)) {
+    if (save_binary) {
+      channel_config.path =
+          ::paddle::string::format_string("%s/part-%03d-%05d%s",
+                                          table_path.c_str(),
+                                          _shard_idx,
+                                          file_start_idx + i,
+                                          SPARSE_BINARY_FILE_SUFFIX);
+    } else if (_config.compress_in_save() &&
+               (save_param == 0 || save_param == 3)) {
       channel_config.path =
           ::paddle::string::format_string("%s/part-%03d-%05d.gz",
                                           table_path.c_str(),
@@ -401,9 +468,12 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
                                                             _shard_idx,
                                                             file_start_idx + i);
     }
-    channel_config.converter = _value_accessor->Converter(save_param).converter;
-    channel_config.deconverter =
-        _value_accessor->Converter(save_param).deconverter;
+    if (!save_binary) {
+      channel_config.converter =
+          _value_accessor->Converter(save_param).converter;
+      channel_config.deconverter =
+          _value_accessor->Converter(save_param).deconverter;
+    }
     bool is_write_failed = false;
     int feasign_size = 0;
     int retry_num = 0;
@@ -413,7 +483,13 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
     // for incremental training, batch_model increase unseenday before save
     if (_use_gpu_graph && save_param == 3) {
       for (auto it = shard.begin(); it != shard.end(); ++it) {
-        _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
+        ApplyAndTrack(i,
+                      it.key(),
+                      it.value().data(),
+                      it.value().size(),
+                      [this, save_param](float *value) {
+                        _value_accessor->UpdateStatAfterSave(value, save_param);
+                      });
       }
     }
 #endif
@@ -423,6 +499,11 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
       is_write_failed = false;
       auto write_channel =
           _afs_client.open_w(channel_config, 1024 * 1024 * 40, &err_no);
+      std::unique_ptr<SparseBinaryFileWriter> binary_writer;
+      if (save_binary) {
+        binary_writer.reset(
+            new SparseBinaryFileWriter(write_channel, value_dim));
+      }
       for (auto it = shard.begin(); it != shard.end(); ++it) {
         if (_config.enable_sparse_table_cache() &&
             (save_param == 1 || save_param == 2) &&
@@ -431,11 +512,26 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
           tk.push(i, _value_accessor->GetField(it.value().data(), "show"));
         }
 
-        if (_value_accessor->Save(it.value().data(), save_param)) {
-          std::string format_value = _value_accessor->ParseToString(
-              it.value().data(), it.value().size());
-          if (0 != write_channel->write_line(::paddle::string::format_string(
-                       "%lu %s", it.key(), format_value.c_str()))) {
+        bool need_save = false;
+        ApplyAndTrack(i,
+                      it.key(),
+                      it.value().data(),
+                      it.value().size(),
+                      [this, save_param, &need_save](float *value) {
+                        need_save = _value_accessor->Save(value, save_param);
+                      });
+        if (need_save) {
+          int ret = 0;
+          if (save_binary) {
+            ret = binary_writer->Append(
+                it.key(), it.value().data(), it.value().size());
+          } else {
+            std::string format_value = _value_accessor->ParseToString(
+                it.value().data(), it.value().size());
+            ret = write_channel->write_line(::paddle::string::format_string(
+                "%lu %s", it.key(), format_value.c_str()));
+          }
+          if (0 != ret) {
             ++retry_num;
             is_write_failed = true;
             LOG(ERROR)
@@ -446,6 +542,12 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
           ++feasign_size;
         }
       }
+      if (save_binary && !is_write_failed && binary_writer->Close() != 0) {
+        ++retry_num;
+        is_write_failed = true;
+        LOG(ERROR) << "MemorySparseTable save prefix failed, retry it! path:"
+                   << channel_config.path << " , retry_num=" << retry_num;
+      }
       write_channel->close();
       if (err_no == -1) {
         ++retry_num;
@@ -462,14 +564,30 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
         exit(-1);
       }
     } while (is_write_failed);
+    // a full checkpoint is the base of the following deltas
+    if (_dirty_trackers && (save_param == 0 || save_param == 3)) {
+      _dirty_trackers[i].Reset();
+    }
     feasign_size_all += feasign_size;
     if (!_use_gpu_graph) {
       for (auto it = shard.begin(); it != shard.end(); ++it) {
-        _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
+        ApplyAndTrack(i,
+                      it.key(),
+                      it.value().data(),
+                      it.value().size(),
+                      [this, save_param](float *value) {
+                        _value_accessor->UpdateStatAfterSave(value, save_param);
+                      });
       }
     } else if (save_param != 3) {
       for (auto it = shard.begin(); it != shard.end(); ++it) {
-        _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
+        ApplyAndTrack(i,
+                      it.key(),
+                      it.value().data(),
+                      it.value().size(),
+                      [this, save_param](float *value) {
+                        _value_accessor->UpdateStatAfterSave(value, save_param);
+                      });
       }
     }
     LOG(INFO) << "MemorySparseTable save prefix success, path: "
@@ -571,7 +689,13 @@ int32_t MemorySparseTable::Save_v2(const std::string &dirname,
     // for incremental training, batch_model increase unseenday before save
     if (_use_gpu_graph && save_param == 3) {
       for (auto it = shard.begin(); it != shard.end(); ++it) {
-        _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
+        ApplyAndTrack(i,
+                      it.key(),
+                      it.value().data(),
+                      it.value().size(),
+                      [this, save_param](float *value) {
+                        _value_accessor->UpdateStatAfterSave(value, save_param);
+                      });
       }
     }
 #endif
@@ -596,7 +720,15 @@ int32_t MemorySparseTable::Save_v2(const std::string &dirname,
           tk.push(i, _value_accessor->GetField(it.value().data(), "show"));
         }
 
-        if (_value_accessor->Save(it.value().data(), save_param)) {
+        bool need_save = false;
+        ApplyAndTrack(i,
+                      it.key(),
+                      it.value().data(),
+                      it.value().size(),
+                      [this, save_param, &need_save](float *value) {
+                        need_save = _value_accessor->Save(value, save_param);
+                      });
+        if (need_save) {
           std::string format_value = _value_accessor->ParseToString(
               it.value().data(), it.value().size());
           if (0 != write_channel->write_line(::paddle::string::format_string(
@@ -659,16 +791,32 @@ int32_t MemorySparseTable::Save_v2(const std::string &dirname,
         exit(-1);
       }
     } while (is_write_failed && is_write_failed_for_slot_feature);
+    // a full checkpoint is the base of the following deltas
+    if (_dirty_trackers && (save_param == 0 || save_param == 3)) {
+      _dirty_trackers[i].Reset();
+    }
 
     feasign_size_all += feasign_size;
     feasign_size_all_for_slot_feature += feasign_size_for_slot_feature;
     if (!_use_gpu_graph) {
       for (auto it = shard.begin(); it != shard.end(); ++it) {
-        _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
+        ApplyAndTrack(i,
+                      it.key(),
+                      it.value().data(),
+                      it.value().size(),
+                      [this, save_param](float *value) {
+                        _value_accessor->UpdateStatAfterSave(value, save_param);
+                      });
       }
     } else if (save_param != 3) {
       for (auto it = shard.begin(); it != shard.end(); ++it) {
-        _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
+        ApplyAndTrack(i,
+                      it.key(),
+                      it.value().data(),
+                      it.value().size(),
+                      [this, save_param](float *value) {
+                        _value_accessor->UpdateStatAfterSave(value, save_param);
+                      });
       }
     }
     LOG(INFO) << "MemorySparseTable save prefix&feature success, path: "
@@ -771,6 +919,210 @@ int32_t MemorySparseTable::SavePatch(const std::string &path, int save_param) {
   return 0;
 }
 
+int32_t MemorySparseTable::SaveDelta(const std::string &dirname) {
+  if (!_dirty_trackers) {
+    LOG(ERROR) << "MemorySparseTable delta save needs enable_delta_save";
+    return -1;
+  }
+  if (_real_local_shard_num == 0) {
+    return 0;
+  }
+  std::string table_path = TableDir(dirname);
+  _afs_client.remove(::paddle::string::format_string(
+      "%s/delta-%03d-*", table_path.c_str(), _shard_idx));
+  std::atomic<uint32_t> feasign_size_all{0};
+  std::atomic<uint32_t> erased_size_all{0};
+
+  size_t file_start_idx = _avg_local_shard_num * _shard_idx;
+  int thread_num = _real_local_shard_num < 20 ? _real_local_shard_num : 20;
+  omp_set_num_threads(thread_num);
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    FsChannelConfig channel_config = {};
+    if (_config.compress_in_save()) {
+      channel_config.path =
+          ::paddle::string::format_string("%s/delta-%03d-%05d.gz",
+                                          table_path.c_str(),
+                                          _shard_idx,
+                                          file_start_idx + i);
+    } else {
+      channel_config.path =
+          ::paddle::string::format_string("%s/delta-%03d-%05d",
+                                          table_path.c_str(),
+                                          _shard_idx,
+                                          file_start_idx + i);
+    }
+    channel_config.converter = _value_accessor->Converter(0).converter;
+    channel_config.deconverter = _value_accessor->Converter(0).deconverter;
+    bool is_write_failed = false;
+    int feasign_size = 0;
+    int erased_size = 0;
+    int retry_num = 0;
+    int err_no = 0;
+    do {
+      err_no = 0;
+      feasign_size = 0;
+      erased_size = 0;
+      is_write_failed = false;
+      auto write_channel =
+          _afs_client.open_w(channel_config, 1024 * 1024 * 40, &err_no);
+      int ret = VisitDeltaShard(
+          i, [&](uint64_t key, const float *value, size_t value_size) -> int {
+            if (value == nullptr) {
+              ++erased_size;
+              return write_channel->write_line(
+                  ::paddle::string::format_string("%lu", key));
+            }
+            ++feasign_size;
+            std::string format_value =
+                _value_accessor->ParseToString(value, value_size);
+            return write_channel->write_line(::paddle::string::format_string(
+                "%lu %s", key, format_value.c_str()));
+          });
+      write_channel->close();
+      if (ret != 0 || err_no == -1) {
+        ++retry_num;
+        is_write_failed = true;
+        LOG(ERROR) << "MemorySparseTable save delta failed, retry it! path:"
+                   << channel_config.path << " , retry_num=" << retry_num;
+        _afs_client.remove(channel_config.path);
+      }
+      if (retry_num > FLAGS_pserver_table_save_max_retry) {
+        LOG(ERROR) << "MemorySparseTable save delta failed reach max limit!";
+        exit(-1);
+      }
+    } while (is_write_failed);
+    _dirty_trackers[i].Reset();
+    feasign_size_all += feasign_size;
+    erased_size_all += erased_size;
+  }
+  LOG(INFO) << "MemorySparseTable save delta success, path:"
+            << ::paddle::string::format_string("%s/%03d/delta-%03d-",
+                                               dirname.c_str(),
+                                               _config.table_id(),
+                                               _shard_idx)
+            << " from " << file_start_idx << " to "
+            << file_start_idx + _real_local_shard_num - 1
+            << ", feasign size: " << feasign_size_all
+            << ", erased size: " << erased_size_all;
+  return 0;
+}
+
+int32_t MemorySparseTable::VisitDeltaShard(
+    int shard_id,
+    const std::function<int(uint64_t, const float *, size_t)> &func) {
+  auto &shard = _local_shards[shard_id];
+  auto &tracker = _dirty_trackers[shard_id];
+  int ret = 0;
+  if (tracker.all_dirty()) {
+    for (auto it = shard.begin(); it != shard.end() && ret == 0; ++it) {
+      ret = func(it.key(), it.value().data(), it.value().size());
+    }
+  } else {
+    for (auto key : tracker.dirty_keys()) {
+      auto it = shard.find(key);
+      if (it != shard.end()) {
+        ret = func(key, it.value().data(), it.value().size());
+      }
+      if (ret != 0) {
+        return ret;
+      }
+    }
+  }
+  for (auto key : tracker.erased_keys()) {
+    if (ret != 0) {
+      break;
+    }
+    if (shard.find(key) == shard.end()) {
+      ret = func(key, nullptr, 0);
+    }
+  }
+  return ret;
+}
+
+int32_t MemorySparseTable::LoadDelta(const std::string &path) {
+  std::string table_path = TableDir(path);
+  auto file_list = _afs_client.list(
+      ::paddle::string::format_string("%s/delta-*", table_path.c_str()));
+  std::sort(file_list.begin(), file_list.end());
+  size_t expect_shard_num = _sparse_table_shard_num;
+  if (file_list.size() != expect_shard_num) {
+    LOG(WARNING) << "MemorySparseTable delta file_size:" << file_list.size()
+                 << " not equal to expect_shard_num:" << expect_shard_num;
+    return -1;
+  }
+  size_t file_start_idx = _shard_idx * _avg_local_shard_num;
+  if (file_start_idx >= file_list.size()) {
+    return 0;
+  }
+
+  int thread_num = _real_local_shard_num < 15 ? _real_local_shard_num : 15;
+  omp_set_num_threads(thread_num);
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    FsChannelConfig channel_config = {};
+    channel_config.path = file_list[file_start_idx + i];
+    channel_config.converter = _value_accessor->Converter(0).converter;
+    channel_config.deconverter = _value_accessor->Converter(0).deconverter;
+    bool is_read_failed = false;
+    int retry_num = 0;
+    int err_no = 0;
+    // replaying a delta again is harmless, so a failed read simply restarts
+    do {
+      is_read_failed = false;
+      err_no = 0;
+      try {
+        std::string line_data;
+        auto read_channel = _afs_client.open_r(channel_config, 0, &err_no);
+        char *end = nullptr;
+        while (read_channel->read_line(line_data) == 0 &&
+               !line_data.empty()) {
+          uint64_t key = std::strtoul(line_data.data(), &end, 10);
+          ApplyDeltaRecord(i, key, *end == '\0' ? nullptr : end + 1);
+        }
+        read_channel->close();
+        if (err_no == -1) {
+          ++retry_num;
+          is_read_failed = true;
+          LOG(ERROR)
+              << "MemorySparseTable load delta failed after read, retry it! "
+              << "path:" << channel_config.path << " , retry_num=" << retry_num;
+        }
+      } catch (...) {
+        ++retry_num;
+        is_read_failed = true;
+        LOG(ERROR) << "MemorySparseTable load delta failed, retry it! path:"
+                   << channel_config.path << " , retry_num=" << retry_num;
+      }
+      if (retry_num > FLAGS_pserver_table_save_max_retry) {
+        LOG(ERROR) << "MemorySparseTable load delta failed reach max limit!";
+        exit(-1);
+      }
+    } while (is_read_failed);
+  }
+  ResetDirtyTrackers();
+  LOG(INFO) << "MemorySparseTable load delta success, path from "
+            << file_list[file_start_idx] << " to "
+            << file_list[file_start_idx + _real_local_shard_num - 1];
+  return 0;
+}
+
+void MemorySparseTable::ApplyDeltaRecord(int shard_id,
+                                         uint64_t key,
+                                         char *value_str) {
+  auto &shard = _local_shards[shard_id];
+  if (value_str == nullptr) {
+    shard.erase(key);
+    return;
+  }
+  size_t feature_value_size =
+      _value_accessor->GetAccessorInfo().size / sizeof(float);
+  auto &value = shard[key];
+  value.resize(feature_value_size);
+  int parse_size = _value_accessor->ParseFromString(value_str, value.data());
+  value.resize(parse_size);
+}
+
 int64_t MemorySparseTable::CacheShuffle(
     const std::string &path,
     const std::string &param,
@@ -971,6 +1323,8 @@ int64_t MemorySparseTable::LocalMFSize() {
 std::pair<int64_t, int64_t> MemorySparseTable::PrintTableStat() {
   int64_t feasign_size = LocalSize();
   int64_t mf_size = LocalMFSize();
+  VLOG(1) << "MemorySparseTable feature value slab: "
+          << FeatureValueSlab::Instance().StatString();
   return {feasign_size, mf_size};
 }
 
@@ -989,7 +1343,8 @@ int32_t MemorySparseTable::Pull(TableContext &context) {
   } else {
     float *pull_values = context.pull_context.values;
     const PullSparseValue &pull_value = context.pull_context.pull_value;
-    return PullSparse(pull_values, pull_value);
+    return PullSparse(
+        pull_values, pull_value, context.pull_context.select_values);
   }
 }
 
@@ -1006,12 +1361,15 @@ int32_t MemorySparseTable::Push(TableContext &context) {
   } else {
     return PushSparse(context.push_context.keys,
                       context.push_context.ptr_values,
-                      context.num);
+                      context.num,
+                      context.push_context.ptr_headers,
+                      context.push_context.header_dim);
   }
 }
 
 int32_t MemorySparseTable::PullSparse(float *pull_values,
-                                      const PullSparseValue &pull_value) {
+                                      const PullSparseValue &pull_value,
+                                      float **select_values) {
   CostTimer timer("pserver_sparse_select_all");
   std::vector<std::future<int>> tasks(_real_local_shard_num);
 
@@ -1039,6 +1397,7 @@ int32_t MemorySparseTable::PullSparse(float *pull_values,
              &task_keys,
              value_size,
              pull_values,
+             select_values,
              mf_value_size,
              select_value_size]() -> int {
               auto &local_shard = _local_shards[shard_id];
@@ -1050,6 +1409,7 @@ int32_t MemorySparseTable::PullSparse(float *pull_values,
                 uint64_t key = item.first;
                 auto itr = local_shard.find(key);
                 size_t data_size = value_size - mf_value_size;
+                const float *select_from = data_buffer_ptr;
                 if (itr == local_shard.end()) {
                   // ++missed_keys;
                   if (FLAGS_pserver_create_value_when_push) {
@@ -1061,20 +1421,27 @@ int32_t MemorySparseTable::PullSparse(float *pull_values,
                     _value_accessor->Create(&data_buffer_ptr, 1);
                     memcpy(
                         data_ptr, data_buffer_ptr, data_size * sizeof(float));
+                    MarkDirty(shard_id, key);
                   }
-                } else {
+                } else if (itr.value().size() < value_size) {
                   data_size = itr.value().size();
                   memcpy(data_buffer_ptr,
                          itr.value().data(),
                          data_size * sizeof(float));
+                } else {
+                  // a complete value is selected in place
+                  data_size = value_size;
+                  select_from = itr.value().data();
                 }
                 for (size_t mf_idx = data_size; mf_idx < value_size; ++mf_idx) {
                   data_buffer[mf_idx] = 0.0;
                 }
                 auto offset = item.second;
-                float *select_data = pull_values + select_value_size * offset;
-                _value_accessor->Select(
-                    &select_data, (const float **)&data_buffer_ptr, 1);
+                float *select_data =
+                    select_values != nullptr
+                        ? select_values[offset]
+                        : pull_values + select_value_size * offset;
+                _value_accessor->Select(&select_data, &select_from, 1);
               }
 
               return 0;
@@ -1134,6 +1501,8 @@ int32_t MemorySparseTable::PullSparsePtr(int shard_id,  // fake num
                 } else {
                   ret = itr.value_ptr();
                 }
+                // the caller updates the value through the returned pointer
+                MarkDirty(shard_id, key);
                 int pull_data_idx = item.second;
                 pull_values[pull_data_idx] = reinterpret_cast<char *>(ret);
               }
@@ -1226,6 +1595,7 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
                      value_data,
                      new_size * sizeof(float));
             }
+            MarkDirty(shard_id, key);
           }
           return 0;
         });
@@ -1239,7 +1609,9 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
 
 int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
                                       const float **values,
-                                      size_t num) {
+                                      size_t num,
+                                      const float **headers,
+                                      size_t header_dim) {
   std::vector<std::future<int>> tasks(_real_local_shard_num);
   std::vector<std::vector<std::pair<uint64_t, int>>> task_keys(
       _real_local_shard_num);
@@ -1254,7 +1626,14 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
 
   for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
     tasks[shard_id] = _shards_task_pool[shard_id % _task_pool_size]->enqueue(
-        [this, shard_id, value_col, mf_value_col, values, &task_keys]() -> int {
+        [this,
+         shard_id,
+         value_col,
+         mf_value_col,
+         values,
+         headers,
+         header_dim,
+         &task_keys]() -> int {
           auto &keys = task_keys[shard_id];
           auto &local_shard = _local_shards[shard_id];
           float data_buffer[value_col];  // NOLINT
@@ -1263,10 +1642,23 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
             uint64_t key = item.first;
             uint64_t push_data_idx = item.second;
             const float *update_data = values[push_data_idx];
+            const float *update_header =
+                headers == nullptr ? nullptr : headers[push_data_idx];
+            auto update = [&](float **value) {
+              if (update_header == nullptr) {
+                _value_accessor->Update(value, &update_data, 1);
+              } else {
+                _value_accessor->SplitUpdate(
+                    value, &update_header, header_dim, &update_data, 1);
+              }
+            };
             auto itr = local_shard.find(key);
             if (itr == local_shard.end()) {
               if (FLAGS_pserver_enable_create_feasign_randomly &&
-                  !_value_accessor->CreateValue(1, update_data)) {
+                  !(update_header == nullptr
+                        ? _value_accessor->CreateValue(1, update_data)
+                        : _value_accessor->SplitCreateValue(
+                              1, update_header, header_dim, update_data))) {
                 continue;
               }
               auto value_size = value_col - mf_value_col;
@@ -1282,11 +1674,11 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
             float *value_data = feature_value.data();
             size_t value_size = feature_value.size();
             if (value_size == value_col) {  // 已拓展到最大size, 则就地update
-              _value_accessor->Update(&value_data, &update_data, 1);
+              update(&value_data);
             } else {
               // 拷入buffer区进行update，然后再回填，不需要的mf则回填时抛弃了
               memcpy(data_buffer_ptr, value_data, value_size * sizeof(float));
-              _value_accessor->Update(&data_buffer_ptr, &update_data, 1);
+              update(&data_buffer_ptr);
               if (_value_accessor->NeedExtendMF(data_buffer)) {
                 feature_value.resize(value_col);
                 value_data = feature_value.data();
@@ -1294,6 +1686,7 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
               }
               memcpy(value_data, data_buffer_ptr, value_size * sizeof(float));
             }
+            MarkDirty(shard_id, key);
           }
           return 0;
         });
@@ -1317,8 +1710,13 @@ int32_t MemorySparseTable::Shrink(const std::string &param) {
     // Shrink
     int feasign_size = 0;
     auto &shard = _local_shards[shard_id];
+    // Shrink decays every value
+    if (_dirty_trackers) {
+      _dirty_trackers[shard_id].MarkAllDirty();
+    }
     for (auto it = shard.begin(); it != shard.end();) {
       if (_value_accessor->Shrink(it.value().data())) {
+        MarkErased(shard_id, it.key());
         it = shard.erase(it);
         ++feasign_size;
       } else {
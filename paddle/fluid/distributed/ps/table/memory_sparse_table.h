@@ -18,6 +18,7 @@
 #include <assert.h>
 #include <pthread.h>
 
+#include <functional>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <string>
@@ -28,6 +29,7 @@
 #include "Eigen/Dense"
 #include "paddle/fluid/distributed/ps/table/accessor.h"
 #include "paddle/fluid/distributed/ps/table/common_table.h"
+#include "paddle/fluid/distributed/ps/table/depends/dirty_key_tracker.h"
 #include "paddle/fluid/distributed/ps/table/depends/feature_value.h"
 #include "paddle/utils/string/string_helper.h"
 
@@ -91,8 +93,14 @@ class MemorySparseTable : public Table {
   int64_t LocalMFSize();
 
   std::pair<int64_t, int64_t> PrintTableStat() override;
-  int32_t PullSparse(float* values, const PullSparseValue& pull_value);
-
+  // writes the value of key i to select_values[i] if given, else to values
+  int32_t PullSparse(float* values,
+                     const PullSparseValue& pull_value,
+                     float** select_values = nullptr);
+
+  // Hands out pointers to the values of keys. Values never move in a shard,
+  // so the pointers stay valid until the value is erased by Shrink, Clear or
+  // a Load; the caller must not run those while a pass still holds them.
   int32_t PullSparsePtr(int shard_id,
                         char** pull_values,
                         const uint64_t* keys,
@@ -101,7 +109,13 @@ class MemorySparseTable : public Table {
 
   int32_t PushSparse(const uint64_t* keys, const float* values, size_t num);
 
-  int32_t PushSparse(const uint64_t* keys, const float** values, size_t num);
+  // values[i] is the push value of keys[i]; with headers, its first
+  // header_dim fields are headers[i] instead (see TablePushContext)
+  int32_t PushSparse(const uint64_t* keys,
+                     const float** values,
+                     size_t num,
+                     const float** headers = nullptr,
+                     size_t header_dim = 0);
 
   int32_t Flush() override;
   int32_t Shrink(const std::string& param) override;
@@ -118,6 +132,59 @@ class MemorySparseTable : public Table {
   virtual int32_t SavePatch(const std::string& path, int save_param);
   virtual int32_t LoadPatch(const std::vector<std::string>& file_list,
                             int save_param);
+  // loads one file written with binary_in_save, returns 0 on success
+  int32_t LoadBinaryShard(shard_type* shard,
+                          const std::string& path,
+                          uint64_t* mem_count,
+                          uint64_t* mem_mf_count);
+
+  // Incremental checkpoints, enabled by TableParameter.enable_delta_save.
+  // SaveDelta writes one delta-XXX-XXXXX file per shard holding the keys
+  // changed since the last checkpoint, as "key value" lines, and the keys
+  // erased since then, as lines with the key only. LoadDelta replays such a
+  // directory on top of the current values, so a base checkpoint followed by
+  // its deltas in order restores the latest state.
+  int32_t SaveDelta(const std::string& path);
+  int32_t LoadDelta(const std::string& path);
+  // Calls func(key, value, value_size) for every changed value of local shard
+  // shard_id and func(key, nullptr, 0) for every erased key, stops at the
+  // first non-zero result and returns it.
+  virtual int32_t VisitDeltaShard(
+      int shard_id,
+      const std::function<int(uint64_t, const float*, size_t)>& func);
+  // Applies one line of a delta file, value_str is nullptr for erased keys.
+  virtual void ApplyDeltaRecord(int shard_id, uint64_t key, char* value_str);
+  void MarkDirty(int shard_id, uint64_t key) {
+    if (_dirty_trackers) {
+      _dirty_trackers[shard_id].MarkDirty(key);
+    }
+  }
+  void MarkErased(int shard_id, uint64_t key) {
+    if (_dirty_trackers) {
+      _dirty_trackers[shard_id].MarkErased(key);
+    }
+  }
+  // Runs func(value) and marks key dirty if it changed the value, for
+  // accessor calls such as UpdateStatAfterSave that may touch some stats.
+  template <class FUNC>
+  void ApplyAndTrack(
+      int shard_id, uint64_t key, float* value, size_t size, FUNC&& func) {
+    if (!_dirty_trackers || _dirty_trackers[shard_id].all_dirty()) {
+      func(value);
+      return;
+    }
+    float origin[size];  // NOLINT
+    memcpy(origin, value, size * sizeof(float));
+    func(value);
+    if (memcmp(origin, value, size * sizeof(float)) != 0) {
+      _dirty_trackers[shard_id].MarkDirty(key);
+    }
+  }
+  void ResetDirtyTrackers() {
+    for (int i = 0; _dirty_trackers && i < _real_local_shard_num; ++i) {
+      _dirty_trackers[i].Reset();
+    }
+  }
 
   int _task_pool_size = 24;
   int _avg_local_shard_num;
@@ -125,6 +192,8 @@ class MemorySparseTable : public Table {
   int _sparse_table_shard_num;
   std::vector<std::shared_ptr<::ThreadPool>> _shards_task_pool;
   std::unique_ptr<shard_type[]> _local_shards;
+  // one per local shard when enable_delta_save is set, otherwise null
+  std::unique_ptr<DirtyKeyTracker[]> _dirty_trackers;
 
   // for patch model
   int _m_avg_local_shard_num;
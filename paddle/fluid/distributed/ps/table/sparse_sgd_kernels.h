@@ -0,0 +1,398 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <math.h>
+
+#include <cstddef>
+
+#include "paddle/phi/backends/cpu/cpu_info.h"
+
+// Update kernels of the sparse sgd rules, specialized per instruction set the
+// same way as phi/kernels/funcs/cpu_vec.h. A specialization falls back to a
+// narrower one when the compiler does not target its instruction set, the
+// caller picks one at runtime with SelectSparseSGDKernel.
+namespace paddle {
+namespace distributed {
+
+#define SPARSE_SGD_YMM_FLOAT_BLOCK 8
+#define SPARSE_SGD_ZMM_FLOAT_BLOCK 16
+
+inline float sparse_sgd_bound(float w, float min_bound, float max_bound) {
+  if (!(w >= min_bound)) {
+    return min_bound;
+  } else if (!(w <= max_bound)) {
+    return max_bound;
+  }
+  return w;
+}
+
+// w[i] = bound(w[i] - alpha * g[i]), returns the sum of g[i] * g[i]
+template <phi::backends::cpu::cpu_isa_t isa = phi::backends::cpu::isa_any>
+inline double vec_sgd_update(const size_t n,
+                             const double alpha,
+                             const float* g,
+                             const float min_bound,
+                             const float max_bound,
+                             float* w) {
+  double g2 = 0;
+  for (size_t i = 0; i < n; ++i) {
+    w[i] = sparse_sgd_bound(w[i] - alpha * g[i], min_bound, max_bound);
+    g2 += static_cast<double>(g[i]) * g[i];
+  }
+  return g2;
+}
+
+// adagrad with one g2sum per dimension:
+// w[i] = bound(w[i] - lr * g[i] / scale *
+//                     sqrt(initial_g2sum / (initial_g2sum + g2sum[i])))
+// g2sum[i] += (g[i] / scale)^2
+template <phi::backends::cpu::cpu_isa_t isa = phi::backends::cpu::isa_any>
+inline void vec_std_adagrad_update(const size_t n,
+                                   const float lr,
+                                   const float initial_g2sum,
+                                   const float scale,
+                                   const float* g,
+                                   const float min_bound,
+                                   const float max_bound,
+                                   float* w,
+                                   float* g2sum) {
+  for (size_t i = 0; i < n; ++i) {
+    double scaled_grad = g[i] / scale;
+    float ratio = sqrt(initial_g2sum / (initial_g2sum + g2sum[i]));
+    w[i] = sparse_sgd_bound(
+        w[i] - lr * scaled_grad * ratio, min_bound, max_bound);
+    g2sum[i] += scaled_grad * scaled_grad;
+  }
+}
+
+// one adam step of every dimension, lr already holds the bias correction
+template <phi::backends::cpu::cpu_isa_t isa = phi::backends::cpu::isa_any>
+inline void vec_adam_update(const size_t n,
+                            const float lr,
+                            const float beta1,
+                            const float beta2,
+                            const float epsilon,
+                            const float* g,
+                            const float min_bound,
+                            const float max_bound,
+                            float* w,
+                            float* gsum,
+                            float* g2sum) {
+  for (size_t i = 0; i < n; ++i) {
+    gsum[i] = beta1 * gsum[i] + (1 - beta1) * g[i];
+    g2sum[i] = beta2 * g2sum[i] + (1 - beta2) * g[i] * g[i];
+    w[i] = sparse_sgd_bound(w[i] - lr * (gsum[i] / (sqrtf(g2sum[i]) + epsilon)),
+                            min_bound,
+                            max_bound);
+  }
+}
+
+template <>
+inline double vec_sgd_update<phi::backends::cpu::avx>(const size_t n,
+                                                      const double alpha,
+                                                      const float* g,
+                                                      const float min_bound,
+                                                      const float max_bound,
+                                                      float* w) {
+#ifdef __AVX__
+  constexpr size_t block = SPARSE_SGD_YMM_FLOAT_BLOCK;
+  size_t end = n & ~(block - 1);
+  __m256 alpha_v = _mm256_set1_ps(static_cast<float>(alpha));
+  __m256 min_v = _mm256_set1_ps(min_bound);
+  __m256 max_v = _mm256_set1_ps(max_bound);
+  __m256 g2_v = _mm256_setzero_ps();
+  for (size_t i = 0; i < end; i += block) {
+    __m256 g_v = _mm256_loadu_ps(g + i);
+    __m256 w_v =
+        _mm256_sub_ps(_mm256_loadu_ps(w + i), _mm256_mul_ps(alpha_v, g_v));
+    // max_ps returns its second operand for NaN, as sparse_sgd_bound does
+    w_v = _mm256_min_ps(_mm256_max_ps(w_v, min_v), max_v);
+    _mm256_storeu_ps(w + i, w_v);
+    g2_v = _mm256_add_ps(g2_v, _mm256_mul_ps(g_v, g_v));
+  }
+  float g2_lanes[block];
+  _mm256_storeu_ps(g2_lanes, g2_v);
+  double g2 = 0;
+  for (size_t i = 0; i < block; ++i) {
+    g2 += g2_lanes[i];
+  }
+  return g2 + vec_sgd_update<phi::backends::cpu::isa_any>(
+                  n - end, alpha, g + end, min_bound, max_bound, w + end);
+#else
+  return vec_sgd_update<phi::backends::cpu::isa_any>(
+      n, alpha, g, min_bound, max_bound, w);
+#endif
+}
+
+template <>
+inline void vec_std_adagrad_update<phi::backends::cpu::avx>(
+    const size_t n,
+    const float lr,
+    const float initial_g2sum,
+    const float scale,
+    const float* g,
+    const float min_bound,
+    const float max_bound,
+    float* w,
+    float* g2sum) {
+#ifdef __AVX__
+  constexpr size_t block = SPARSE_SGD_YMM_FLOAT_BLOCK;
+  size_t end = n & ~(block - 1);
+  __m256 lr_v = _mm256_set1_ps(lr);
+  __m256 initial_v = _mm256_set1_ps(initial_g2sum);
+  __m256 scale_v = _mm256_set1_ps(scale);
+  __m256 min_v = _mm256_set1_ps(min_bound);
+  __m256 max_v = _mm256_set1_ps(max_bound);
+  for (size_t i = 0; i < end; i += block) {
+    __m256 g_v = _mm256_div_ps(_mm256_loadu_ps(g + i), scale_v);
+    __m256 g2sum_v = _mm256_loadu_ps(g2sum + i);
+    __m256 ratio_v = _mm256_sqrt_ps(
+        _mm256_div_ps(initial_v, _mm256_add_ps(initial_v, g2sum_v)));
+    __m256 w_v = _mm256_sub_ps(
+        _mm256_loadu_ps(w + i),
+        _mm256_mul_ps(_mm256_mul_ps(lr_v, g_v), ratio_v));
+    w_v = _mm256_min_ps(_mm256_max_ps(w_v, min_v), max_v);
+    _mm256_storeu_ps(w + i, w_v);
+    _mm256_storeu_ps(g2sum + i,
+                     _mm256_add_ps(g2sum_v, _mm256_mul_ps(g_v, g_v)));
+  }
+  vec_std_adagrad_update<phi::backends::cpu::isa_any>(n - end,
+                                                      lr,
+                                                      initial_g2sum,
+                                                      scale,
+                                                      g + end,
+                                                      min_bound,
+                                                      max_bound,
+                                                      w + end,
+                                                      g2sum + end);
+#else
+  vec_std_adagrad_update<phi::backends::cpu::isa_any>(
+      n, lr, initial_g2sum, scale, g, min_bound, max_bound, w, g2sum);
+#endif
+}
+
+template <>
+inline void vec_adam_update<phi::backends::cpu::avx>(const size_t n,
+                                                     const float lr,
+                                                     const float beta1,
+                                                     const float beta2,
+                                                     const float epsilon,
+                                                     const float* g,
+                                                     const float min_bound,
+                                                     const float max_bound,
+                                                     float* w,
+                                                     float* gsum,
+                                                     float* g2sum) {
+#ifdef __AVX__
+  constexpr size_t block = SPARSE_SGD_YMM_FLOAT_BLOCK;
+  size_t end = n & ~(block - 1);
+  __m256 lr_v = _mm256_set1_ps(lr);
+  __m256 beta1_v = _mm256_set1_ps(beta1);
+  __m256 beta2_v = _mm256_set1_ps(beta2);
+  __m256 one_minus_beta1_v = _mm256_set1_ps(1 - beta1);
+  __m256 one_minus_beta2_v = _mm256_set1_ps(1 - beta2);
+  __m256 epsilon_v = _mm256_set1_ps(epsilon);
+  __m256 min_v = _mm256_set1_ps(min_bound);
+  __m256 max_v = _mm256_set1_ps(max_bound);
+  for (size_t i = 0; i < end; i += block) {
+    __m256 g_v = _mm256_loadu_ps(g + i);
+    __m256 gsum_v =
+        _mm256_add_ps(_mm256_mul_ps(beta1_v, _mm256_loadu_ps(gsum + i)),
+                      _mm256_mul_ps(one_minus_beta1_v, g_v));
+    __m256 g2sum_v = _mm256_add_ps(
+        _mm256_mul_ps(beta2_v, _mm256_loadu_ps(g2sum + i)),
+        _mm256_mul_ps(_mm256_mul_ps(one_minus_beta2_v, g_v), g_v));
+    __m256 w_v = _mm256_sub_ps(
+        _mm256_loadu_ps(w + i),
+        _mm256_mul_ps(
+            lr_v,
+            _mm256_div_ps(gsum_v,
+                          _mm256_add_ps(_mm256_sqrt_ps(g2sum_v), epsilon_v))));
+    w_v = _mm256_min_ps(_mm256_max_ps(w_v, min_v), max_v);
+    _mm256_storeu_ps(gsum + i, gsum_v);
+    _mm256_storeu_ps(g2sum + i, g2sum_v);
+    _mm256_storeu_ps(w + i, w_v);
+  }
+  vec_adam_update<phi::backends::cpu::isa_any>(n - end,
+                                               lr,
+                                               beta1,
+                                               beta2,
+                                               epsilon,
+                                               g + end,
+                                               min_bound,
+                                               max_bound,
+                                               w + end,
+                                               gsum + end,
+                                               g2sum + end);
+#else
+  vec_adam_update<phi::backends::cpu::isa_any>(
+      n, lr, beta1, beta2, epsilon, g, min_bound, max_bound, w, gsum, g2sum);
+#endif
+}
+
+template <>
+inline double vec_sgd_update<phi::backends::cpu::avx512f>(
+    const size_t n,
+    const double alpha,
+    const float* g,
+    const float min_bound,
+    const float max_bound,
+    float* w) {
+#ifdef __AVX512F__
+  constexpr size_t block = SPARSE_SGD_ZMM_FLOAT_BLOCK;
+  size_t end = n & ~(block - 1);
+  __m512 alpha_v = _mm512_set1_ps(static_cast<float>(alpha));
+  __m512 min_v = _mm512_set1_ps(min_bound);
+  __m512 max_v = _mm512_set1_ps(max_bound);
+  __m512 g2_v = _mm512_setzero_ps();
+  for (size_t i = 0; i < end; i += block) {
+    __m512 g_v = _mm512_loadu_ps(g + i);
+    __m512 w_v =
+        _mm512_sub_ps(_mm512_loadu_ps(w + i), _mm512_mul_ps(alpha_v, g_v));
+    w_v = _mm512_min_ps(_mm512_max_ps(w_v, min_v), max_v);
+    _mm512_storeu_ps(w + i, w_v);
+    g2_v = _mm512_add_ps(g2_v, _mm512_mul_ps(g_v, g_v));
+  }
+  return _mm512_reduce_add_ps(g2_v) +
+         vec_sgd_update<phi::backends::cpu::avx>(
+             n - end, alpha, g + end, min_bound, max_bound, w + end);
+#else
+  return vec_sgd_update<phi::backends::cpu::avx>(
+      n, alpha, g, min_bound, max_bound, w);
+#endif
+}
+
+template <>
+inline void vec_std_adagrad_update<phi::backends::cpu::avx512f>(
+    const size_t n,
+    const float lr,
+    const float initial_g2sum,
+    const float scale,
+    const float* g,
+    const float min_bound,
+    const float max_bound,
+    float* w,
+    float* g2sum) {
+#ifdef __AVX512F__
+  constexpr size_t block = SPARSE_SGD_ZMM_FLOAT_BLOCK;
+  size_t end = n & ~(block - 1);
+  __m512 lr_v = _mm512_set1_ps(lr);
+  __m512 initial_v = _mm512_set1_ps(initial_g2sum);
+  __m512 scale_v = _mm512_set1_ps(scale);
+  __m512 min_v = _mm512_set1_ps(min_bound);
+  __m512 max_v = _mm512_set1_ps(max_bound);
+  for (size_t i = 0; i < end; i += block) {
+    __m512 g_v = _mm512_div_ps(_mm512_loadu_ps(g + i), scale_v);
+    __m512 g2sum_v = _mm512_loadu_ps(g2sum + i);
+    __m512 ratio_v = _mm512_sqrt_ps(
+        _mm512_div_ps(initial_v, _mm512_add_ps(initial_v, g2sum_v)));
+    __m512 w_v = _mm512_sub_ps(
+        _mm512_loadu_ps(w + i),
+        _mm512_mul_ps(_mm512_mul_ps(lr_v, g_v), ratio_v));
+    w_v = _mm512_min_ps(_mm512_max_ps(w_v, min_v), max_v);
+    _mm512_storeu_ps(w + i, w_v);
+    _mm512_storeu_ps(g2sum + i,
+                     _mm512_add_ps(g2sum_v, _mm512_mul_ps(g_v, g_v)));
+  }
+  vec_std_adagrad_update<phi::backends::cpu::avx>(n - end,
+                                                  lr,
+                                                  initial_g2sum,
+                                                  scale,
+                                                  g + end,
+                                                  min_bound,
+                                                  max_bound,
+                                                  w + end,
+                                                  g2sum + end);
+#else
+  vec_std_adagrad_update<phi::backends::cpu::avx>(
+      n, lr, initial_g2sum, scale, g, min_bound, max_bound, w, g2sum);
+#endif
+}
+
+template <>
+inline void vec_adam_update<phi::backends::cpu::avx512f>(const size_t n,
+                                                         const float lr,
+                                                         const float beta1,
+                                                         const float beta2,
+                                                         const float epsilon,
+                                                         const float* g,
+                                                         const float min_bound,
+                                                         const float max_bound,
+                                                         float* w,
+                                                         float* gsum,
+                                                         float* g2sum) {
+#ifdef __AVX512F__
+  constexpr size_t block = SPARSE_SGD_ZMM_FLOAT_BLOCK;
+  size_t end = n & ~(block - 1);
+  __m512 lr_v = _mm512_set1_ps(lr);
+  __m512 beta1_v = _mm512_set1_ps(beta1);
+  __m512 beta2_v = _mm512_set1_ps(beta2);
+  __m512 one_minus_beta1_v = _mm512_set1_ps(1 - beta1);
+  __m512 one_minus_beta2_v = _mm512_set1_ps(1 - beta2);
+  __m512 epsilon_v = _mm512_set1_ps(epsilon);
+  __m512 min_v = _mm512_set1_ps(min_bound);
+  __m512 max_v = _mm512_set1_ps(max_bound);
+  for (size_t i = 0; i < end; i += block) {
+    __m512 g_v = _mm512_loadu_ps(g + i);
+    __m512 gsum_v =
+        _mm512_add_ps(_mm512_mul_ps(beta1_v, _mm512_loadu_ps(gsum + i)),
+                      _mm512_mul_ps(one_minus_beta1_v, g_v));
+    __m512 g2sum_v = _mm512_add_ps(
+        _mm512_mul_ps(beta2_v, _mm512_loadu_ps(g2sum + i)),
+        _mm512_mul_ps(_mm512_mul_ps(one_minus_beta2_v, g_v), g_v));
+    __m512 w_v = _mm512_sub_ps(
+        _mm512_loadu_ps(w + i),
+        _mm512_mul_ps(
+            lr_v,
+            _mm512_div_ps(gsum_v,
+                          _mm512_add_ps(_mm512_sqrt_ps(g2sum_v), epsilon_v))));
+    w_v = _mm512_min_ps(_mm512_max_ps(w_v, min_v), max_v);
+    _mm512_storeu_ps(gsum + i, gsum_v);
+    _mm512_storeu_ps(g2sum + i, g2sum_v);
+    _mm512_storeu_ps(w + i, w_v);
+  }
+  vec_adam_update<phi::backends::cpu::avx>(n - end,
+                                           lr,
+                                           beta1,
+                                           beta2,
+                                           epsilon,
+                                           g + end,
+                                           min_bound,
+                                           max_bound,
+                                           w + end,
+                                           gsum + end,
+                                           g2sum + end);
+#else
+  vec_adam_update<phi::backends::cpu::avx>(
+      n, lr, beta1, beta2, epsilon, g, min_bound, max_bound, w, gsum, g2sum);
+#endif
+}
+
+// returns the widest of the specializations the cpu supports
+template <typename Kernel>
+inline Kernel SelectSparseSGDKernel(Kernel any_kernel,
+                                    Kernel avx_kernel,
+                                    Kernel avx512f_kernel) {
+  if (phi::backends::cpu::MayIUse(phi::backends::cpu::avx512f)) {
+    return avx512f_kernel;
+  } else if (phi::backends::cpu::MayIUse(phi::backends::cpu::avx)) {
+    return avx_kernel;
+  }
+  return any_kernel;
+}
+
+}  // namespace distributed
+}  // namespace paddle
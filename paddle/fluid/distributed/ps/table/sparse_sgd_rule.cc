@@ -42,15 +42,27 @@ void SparseNaiveSGDRule::LoadConfig(const SparseCommonSGDRuleParameter &param,
     _min_bound = naive_param.weight_bounds(0);
     _max_bound = naive_param.weight_bounds(1);
   }
+  _update_kernel =
+      SelectSparseSGDKernel(&vec_sgd_update<phi::backends::cpu::isa_any>,
+                            &vec_sgd_update<phi::backends::cpu::avx>,
+                            &vec_sgd_update<phi::backends::cpu::avx512f>);
 }
 
 void SparseNaiveSGDRule::UpdateValueWork(float *w,
                                          float *sgd,
                                          const float *push_value,
                                          float scale) {
-  for (size_t i = 0; i < _embedding_dim; ++i) {
-    w[i] -= learning_rate_ * push_value[i];
-    BoundValue(w[i]);
+  _update_kernel(
+      _embedding_dim, learning_rate_, push_value, _min_bound, _max_bound, w);
+}
+
+void SparseNaiveSGDRule::BatchUpdateValueWork(float **w,
+                                              float **sgd,
+                                              const float **push_value,
+                                              const float *scale,
+                                              size_t num) {
+  for (size_t i = 0; i < num; ++i) {
+    SparseNaiveSGDRule::UpdateValueWork(w[i], sgd[i], push_value[i], scale[i]);
   }
 }
 
@@ -91,6 +103,10 @@ void SparseAdaGradSGDRule::LoadConfig(const SparseCommonSGDRuleParameter &param,
     _min_bound = adagrad_param.weight_bounds(0);
     _max_bound = adagrad_param.weight_bounds(1);
   }
+  _update_kernel =
+      SelectSparseSGDKernel(&vec_sgd_update<phi::backends::cpu::isa_any>,
+                            &vec_sgd_update<phi::backends::cpu::avx>,
+                            &vec_sgd_update<phi::backends::cpu::avx512f>);
 }
 
 void SparseAdaGradSGDRule::UpdateValueWork(float *w,
@@ -98,17 +114,23 @@ void SparseAdaGradSGDRule::UpdateValueWork(float *w,
                                            const float *grad,
                                            float scale) {
   float &g2sum = sgd[G2SumIndex()];
-  double add_g2sum = 0;
+  double alpha = static_cast<double>(learning_rate_) *
+                 sqrt(_initial_g2sum / (_initial_g2sum + g2sum)) / scale;
+  double add_g2sum =
+      _update_kernel(_embedding_dim, alpha, grad, _min_bound, _max_bound, w);
 
-  for (size_t i = 0; i < _embedding_dim; i++) {
-    double scaled_grad = grad[i] / scale;
-    w[i] -= learning_rate_ * scaled_grad *
-            sqrt(_initial_g2sum / (_initial_g2sum + g2sum));
-    BoundValue(w[i]);
-    add_g2sum += scaled_grad * scaled_grad;
-  }
+  g2sum += add_g2sum / (static_cast<double>(scale) * scale) / _embedding_dim;
+}
 
-  g2sum += add_g2sum / _embedding_dim;
+void SparseAdaGradSGDRule::BatchUpdateValueWork(float **w,
+                                                float **sgd,
+                                                const float **push_value,
+                                                const float *scale,
+                                                size_t num) {
+  for (size_t i = 0; i < num; ++i) {
+    SparseAdaGradSGDRule::UpdateValueWork(
+        w[i], sgd[i], push_value[i], scale[i]);
+  }
 }
 
 void SparseAdaGradSGDRule::InitValueWork(float *value,
@@ -150,19 +172,34 @@ void StdAdaGradSGDRule::LoadConfig(const SparseCommonSGDRuleParameter &param,
     _min_bound = adagrad_param.weight_bounds(0);
     _max_bound = adagrad_param.weight_bounds(1);
   }
+  _update_kernel = SelectSparseSGDKernel(
+      &vec_std_adagrad_update<phi::backends::cpu::isa_any>,
+      &vec_std_adagrad_update<phi::backends::cpu::avx>,
+      &vec_std_adagrad_update<phi::backends::cpu::avx512f>);
 }
 
 void StdAdaGradSGDRule::UpdateValueWork(float *w,
                                         float *sgd,
                                         const float *grad,
                                         float scale) {
-  for (size_t i = 0; i < _embedding_dim; i++) {
-    float &g2sum = sgd[G2SumIndex() + i];
-    double scaled_grad = grad[i] / scale;
-    w[i] -= learning_rate_ * scaled_grad *
-            sqrt(_initial_g2sum / (_initial_g2sum + g2sum));
-    BoundValue(w[i]);
-    g2sum += scaled_grad * scaled_grad;
+  _update_kernel(_embedding_dim,
+                 learning_rate_,
+                 _initial_g2sum,
+                 scale,
+                 grad,
+                 _min_bound,
+                 _max_bound,
+                 w,
+                 sgd + G2SumIndex());
+}
+
+void StdAdaGradSGDRule::BatchUpdateValueWork(float **w,
+                                             float **sgd,
+                                             const float **push_value,
+                                             const float *scale,
+                                             size_t num) {
+  for (size_t i = 0; i < num; ++i) {
+    StdAdaGradSGDRule::UpdateValueWork(w[i], sgd[i], push_value[i], scale[i]);
   }
 }
 
@@ -206,6 +243,10 @@ void SparseAdamSGDRule::LoadConfig(const SparseCommonSGDRuleParameter &param,
     _min_bound = adam_param.weight_bounds(0);
     _max_bound = adam_param.weight_bounds(1);
   }
+  _update_kernel =
+      SelectSparseSGDKernel(&vec_adam_update<phi::backends::cpu::isa_any>,
+                            &vec_adam_update<phi::backends::cpu::avx>,
+                            &vec_adam_update<phi::backends::cpu::avx512f>);
 }
 
 void SparseAdamSGDRule::UpdateValueWork(float *w,
@@ -223,19 +264,32 @@ void SparseAdamSGDRule::UpdateValueWork(float *w,
   float beta2_pow_ = *beta2_pow;
 
   lr *= sqrt(1 - beta2_pow_) / (1 - beta1_pow_);
-  for (size_t i = 0; i < _embedding_dim; i++) {
-    // Calculation
-    gsum[i] = _beta1_decay_rate * gsum[i] + (1 - _beta1_decay_rate) * g[i];
-    g2sum[i] =
-        _beta2_decay_rate * g2sum[i] + (1 - _beta2_decay_rate) * g[i] * g[i];
-    w[i] = w[i] - lr * (gsum[i] / (sqrt(g2sum[i]) + _ada_epsilon));
-    BoundValue(w[i]);
-  }
+  _update_kernel(_embedding_dim,
+                 lr,
+                 _beta1_decay_rate,
+                 _beta2_decay_rate,
+                 _ada_epsilon,
+                 g,
+                 _min_bound,
+                 _max_bound,
+                 w,
+                 gsum,
+                 g2sum);
   // update beta_pow_decay
   (*beta1_pow) *= _beta1_decay_rate;
   (*beta2_pow) *= _beta2_decay_rate;
 }
 
+void SparseAdamSGDRule::BatchUpdateValueWork(float **w,
+                                             float **sgd,
+                                             const float **push_value,
+                                             const float *scale,
+                                             size_t num) {
+  for (size_t i = 0; i < num; ++i) {
+    SparseAdamSGDRule::UpdateValueWork(w[i], sgd[i], push_value[i], scale[i]);
+  }
+}
+
 void SparseAdamSGDRule::InitValueWork(float *value,
                                       float *sgd,
                                       bool zero_init) {
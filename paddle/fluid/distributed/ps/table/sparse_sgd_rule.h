@@ -21,6 +21,7 @@
 #include "glog/logging.h"                                  // for CHECK
 #include "paddle/fluid/distributed/common/local_random.h"  // for local_uniform_real_distribution
 #include "paddle/fluid/distributed/common/registerer.h"
+#include "paddle/fluid/distributed/ps/table/sparse_sgd_kernels.h"
 #include "paddle/fluid/distributed/the_one_ps.pb.h"
 
 namespace paddle {
@@ -51,6 +52,24 @@ class SparseValueSGDRule {
                    float scale = 1) {
     UpdateValueWork(w, sgd, push_value, scale);
   }
+  // updates num values in one call, element i of each array is the argument
+  // UpdateValue would take for the i-th value
+  virtual void BatchUpdateValueWork(float** w,
+                                    float** sgd,
+                                    const float** push_value,
+                                    const float* scale,
+                                    size_t num) {
+    for (size_t i = 0; i < num; ++i) {
+      UpdateValueWork(w[i], sgd[i], push_value[i], scale[i]);
+    }
+  }
+  void BatchUpdateValue(float** w,
+                        float** sgd,
+                        const float** push_value,
+                        const float* scale,
+                        size_t num) {
+    BatchUpdateValueWork(w, sgd, push_value, scale, num);
+  }
   template <class T>
   void BoundValue(T& w) {  // NOLINT
     if (!(w >= _min_bound)) {
@@ -82,10 +101,16 @@ class SparseNaiveSGDRule : public SparseValueSGDRule {
                                float* sgd,
                                const float* push_value,
                                float scale);
+  virtual void BatchUpdateValueWork(float** w,
+                                    float** sgd,
+                                    const float** push_value,
+                                    const float* scale,
+                                    size_t num);
   virtual void InitValueWork(float* value, float* sgd, bool zero_init);
   virtual size_t Dim() { return 0; }
 
  private:
+  decltype(&vec_sgd_update<>) _update_kernel;
   float learning_rate_;
 };
 
@@ -97,11 +122,17 @@ class SparseAdaGradSGDRule : public SparseValueSGDRule {
                                float* sgd,
                                const float* push_value,
                                float scale);
+  virtual void BatchUpdateValueWork(float** w,
+                                    float** sgd,
+                                    const float** push_value,
+                                    const float* scale,
+                                    size_t num);
   virtual void InitValueWork(float* value, float* sgd, bool zero_init);
   virtual size_t Dim() { return 1; }
   size_t G2SumIndex() { return 0; }
 
  private:
+  decltype(&vec_sgd_update<>) _update_kernel;
   float learning_rate_;
   float _initial_g2sum;
 };
@@ -134,11 +165,17 @@ class StdAdaGradSGDRule : public SparseValueSGDRule {
                                float* sgd,
                                const float* push_value,
                                float scale);
+  virtual void BatchUpdateValueWork(float** w,
+                                    float** sgd,
+                                    const float** push_value,
+                                    const float* scale,
+                                    size_t num);
   virtual void InitValueWork(float* value, float* sgd, bool zero_init);
   virtual size_t Dim() { return _embedding_dim; }
   size_t G2SumIndex() { return 0; }
 
  private:
+  decltype(&vec_std_adagrad_update<>) _update_kernel;
   float learning_rate_;
   float _initial_g2sum;
 };
@@ -151,6 +188,11 @@ class SparseAdamSGDRule : public SparseValueSGDRule {
                                float* sgd,
                                const float* push_value,
                                float scale);
+  virtual void BatchUpdateValueWork(float** w,
+                                    float** sgd,
+                                    const float** push_value,
+                                    const float* scale,
+                                    size_t num);
   virtual void InitValueWork(float* value, float* sgd, bool zero_init);
   virtual size_t Dim() { return _embedding_dim * 2 + 2; }
   size_t GSumIndex() { return 0; }
@@ -159,6 +201,7 @@ class SparseAdamSGDRule : public SparseValueSGDRule {
   size_t Beta2PowIndex() { return Beta1PowIndex() + 1; }
 
  protected:
+  decltype(&vec_adam_update<>) _update_kernel;
   float learning_rate_;
   float _beta1_decay_rate;
   float _beta2_decay_rate;
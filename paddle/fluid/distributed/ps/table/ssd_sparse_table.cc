@@ -14,6 +14,8 @@
 
 #include "paddle/fluid/distributed/ps/table/ssd_sparse_table.h"
 
+#include <algorithm>
+
 #include "paddle/common/flags.h"
 #include "paddle/fluid/distributed/common/cost_timer.h"
 #include "paddle/fluid/distributed/common/local_random.h"
@@ -25,6 +27,14 @@ PD_DECLARE_bool(pserver_create_value_when_push);
 PD_DECLARE_bool(pserver_enable_create_feasign_randomly);
 PD_DEFINE_bool(pserver_open_strict_check, false, "pserver_open_strict_check");
 PD_DEFINE_int32(pserver_load_batch_size, 5000, "load batch size for ssd");
+PD_DEFINE_uint64(pserver_ssd_cache_capacity,
+                 0,
+                 "max values kept in memory per SSDSparseTable shard, the "
+                 "coldest ones are moved to rocksdb beyond it, 0 is unlimited");
+PD_DEFINE_int32(pserver_ssd_cache_admit_threshold,
+                1,
+                "recent accesses a key needs before its value read from "
+                "rocksdb is kept in memory, 1 admits every value");
 PHI_DEFINE_EXPORTED_string(rocksdb_path,
                            "database",
                            "path of sparse table rocksdb file");
@@ -35,6 +45,16 @@ int32_t SSDSparseTable::Initialize() {
   MemorySparseTable::Initialize();
   _db = ::paddle::distributed::RocksDBHandler::GetInstance();
   _db->initialize(FLAGS_rocksdb_path, _real_local_shard_num);
+  _cache_policies.reserve(_real_local_shard_num);
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    _cache_policies.emplace_back(FLAGS_pserver_ssd_cache_capacity,
+                                 FLAGS_pserver_ssd_cache_admit_threshold);
+  }
+  _enable_cache_policy = FLAGS_pserver_ssd_cache_capacity > 0 ||
+                         FLAGS_pserver_ssd_cache_admit_threshold > 1;
+  _ssd_read_pool.reset(new ::ThreadPool(_task_pool_size));
+  _pinned_keys.resize(_real_local_shard_num);
+  _pinned_pass_id.assign(_real_local_shard_num, -1);
   VLOG(0) << "initialize SSDSparseTable succ";
   VLOG(0) << "SSD FLAGS_pserver_print_missed_key_num_every_push:"
           << FLAGS_pserver_print_missed_key_num_every_push;
@@ -68,7 +88,10 @@ int32_t SSDSparseTable::Pull(TableContext& context) {
   } else {
     float* pull_values = context.pull_context.values;
     const PullSparseValue& pull_value = context.pull_context.pull_value;
-    return PullSparse(pull_values, pull_value.feasigns_, pull_value.numel_);
+    return PullSparse(pull_values,
+                      pull_value.feasigns_,
+                      pull_value.numel_,
+                      context.pull_context.select_values);
   }
 }
 
@@ -80,7 +103,9 @@ int32_t SSDSparseTable::Push(TableContext& context) {
   if (context.use_ptr) {
     return PushSparse(context.push_context.keys,
                       context.push_context.ptr_values,
-                      context.num);
+                      context.num,
+                      context.push_context.ptr_headers,
+                      context.push_context.header_dim);
   } else {
     const uint64_t* keys = context.push_context.keys;
     const float* values = context.push_context.values;
@@ -91,7 +116,8 @@ int32_t SSDSparseTable::Push(TableContext& context) {
 
 int32_t SSDSparseTable::PullSparse(float* pull_values,
                                    const uint64_t* keys,
-                                   size_t num) {
+                                   size_t num,
+                                   float** select_values) {
   CostTimer timer("pserver_downpour_sparse_select_all");
   size_t value_size = _value_accessor->GetAccessorInfo().size / sizeof(float);
   size_t mf_value_size =
@@ -119,41 +145,124 @@ int32_t SSDSparseTable::PullSparse(float* pull_values,
                mf_value_size,
                select_value_size,
                pull_values,
+               select_values,
                &missed_keys]() -> int {
                 auto& keys = task_keys[shard_id];
                 auto& local_shard = _local_shards[shard_id];
+                auto& cache_policy = _cache_policies[shard_id];
                 float data_buffer[value_size];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
-                for (size_t i = 0; i < keys.size(); ++i) {
-                  uint64_t key = keys[i].first;
-                  auto itr = local_shard.find(key);
-                  size_t data_size = value_size - mf_value_size;
+                uint64_t ssd_hit_num = 0;
+                uint64_t admit_num = 0;
+
+                // values in memory are selected while rocksdb reads the rest
+                std::vector<std::pair<FixedFeatureValue*, int>> mem_values;
+                std::vector<std::pair<uint64_t, int>> ssd_keys;
+                mem_values.reserve(keys.size());
+                for (auto& key_pair : keys) {
+                  cache_policy.RecordAccess(key_pair.first);
+                  auto itr = local_shard.find(key_pair.first);
                   if (itr == local_shard.end()) {
-                    // pull rocksdb
-                    std::string tmp_string("");
-                    if (_db->get(shard_id,
-                                 reinterpret_cast<char*>(&key),
-                                 sizeof(uint64_t),
-                                 tmp_string) > 0) {
-                      ++missed_keys;
-                      if (FLAGS_pserver_create_value_when_push) {
-                        memset(data_buffer, 0, sizeof(float) * data_size);
-                      } else {
-                        auto& feature_value = local_shard[key];
-                        feature_value.resize(data_size);
-                        float* data_ptr =
-                            const_cast<float*>(feature_value.data());
-                        _value_accessor->Create(&data_buffer_ptr, 1);
-                        memcpy(data_ptr,
-                               data_buffer_ptr,
-                               data_size * sizeof(float));
-                      }
+                    ssd_keys.push_back(key_pair);
+                  } else {
+                    mem_values.emplace_back(&itr.value(), key_pair.second);
+                  }
+                }
+
+                // one multi_get of the distinct missed keys in db order
+                std::sort(ssd_keys.begin(), ssd_keys.end());
+                std::vector<uint64_t> read_keys;
+                read_keys.reserve(ssd_keys.size());
+                for (auto& key_pair : ssd_keys) {
+                  if (read_keys.empty() || read_keys.back() != key_pair.first) {
+                    read_keys.push_back(key_pair.first);
+                  }
+                }
+                std::vector<rocksdb::Slice> read_slices;
+                read_slices.reserve(read_keys.size());
+                for (auto& key : read_keys) {
+                  read_slices.emplace_back(reinterpret_cast<const char*>(&key),
+                                           sizeof(uint64_t));
+                }
+                std::vector<rocksdb::PinnableSlice> read_values(
+                    read_keys.size());
+                std::vector<rocksdb::Status> read_status(read_keys.size());
+                auto multi_get = [&]() -> int {
+                  _db->multi_get(shard_id,
+                                 read_keys.size(),
+                                 read_slices.data(),
+                                 read_values.data(),
+                                 read_status.data(),
+                                 true);
+                  return 0;
+                };
+                std::future<int> read_task;
+                if (!read_keys.empty()) {
+                  if (mem_values.empty()) {
+                    multi_get();
+                  } else {
+                    read_task = _ssd_read_pool->enqueue(multi_get);
+                  }
+                }
+
+                size_t data_size = value_size - mf_value_size;
+                for (auto& mem_value : mem_values) {
+                  data_size = mem_value.first->size();
+                  memcpy(data_buffer_ptr,
+                         mem_value.first->data(),
+                         data_size * sizeof(float));
+                  for (size_t mf_idx = data_size; mf_idx < value_size;
+                       ++mf_idx) {
+                    data_buffer[mf_idx] = 0.0;
+                  }
+                  float* select_data =
+                      select_values != nullptr
+                          ? select_values[mem_value.second]
+                          : pull_values + mem_value.second * select_value_size;
+                  _value_accessor->Select(
+                      &select_data, (const float**)&data_buffer_ptr, 1);
+                }
+                if (read_task.valid()) {
+                  read_task.get();
+                }
+
+                size_t ssd_key_idx = 0;
+                for (size_t i = 0; i < read_keys.size(); ++i) {
+                  uint64_t key = read_keys[i];
+                  data_size = value_size - mf_value_size;
+                  if (read_status[i].IsNotFound()) {
+                    ++missed_keys;
+                    if (FLAGS_pserver_create_value_when_push) {
+                      memset(data_buffer, 0, sizeof(float) * data_size);
                     } else {
-                      data_size = tmp_string.size() / sizeof(float);
-                      memcpy(data_buffer_ptr,
-                             ::paddle::string::str_to_float(tmp_string),
+                      auto& feature_value = local_shard[key];
+                      feature_value.resize(data_size);
+                      float* data_ptr =
+                          const_cast<float*>(feature_value.data());
+                      _value_accessor->Create(&data_buffer_ptr, 1);
+                      memcpy(data_ptr,
+                             data_buffer_ptr,
                              data_size * sizeof(float));
-                      // from rocksdb to mem
+                      MarkDirty(shard_id, key);
+                    }
+                  } else {
+                    PADDLE_ENFORCE_EQ(
+                        read_status[i].ok(),
+                        true,
+                        common::errors::Unavailable(
+                            "SSDSparseTable read key %lu of shard %d from "
+                            "rocksdb failed: %s",
+                            key,
+                            shard_id,
+                            read_status[i].ToString()));
+                    ++ssd_hit_num;
+                    data_size = read_values[i].size() / sizeof(float);
+                    memcpy(data_buffer_ptr,
+                           read_values[i].data(),
+                           data_size * sizeof(float));
+                    // from rocksdb to mem, cold values are served in place
+                    if (cache_policy.Admit(key)) {
+                      ++admit_num;
                       auto& feature_value = local_shard[key];
                       feature_value.resize(data_size);
                       memcpy(const_cast<float*>(feature_value.data()),
@@ -163,28 +272,40 @@ int32_t SSDSparseTable::PullSparse(float* pull_values,
                                     reinterpret_cast<char*>(&key),
                                     sizeof(uint64_t));
                     }
-                  } else {
-                    data_size = itr.value().size();
-                    memcpy(data_buffer_ptr,
-                           itr.value().data(),
-                           data_size * sizeof(float));
                   }
                   for (size_t mf_idx = data_size; mf_idx < value_size;
                        ++mf_idx) {
                     data_buffer[mf_idx] = 0.0;
                   }
-                  int pull_data_idx = keys[i].second;
-                  float* select_data =
-                      pull_values + pull_data_idx * select_value_size;
-                  _value_accessor->Select(
-                      &select_data, (const float**)&data_buffer_ptr, 1);
+                  // a key may be pulled several times in one request
+                  for (; ssd_key_idx < ssd_keys.size() &&
+                         ssd_keys[ssd_key_idx].first == key;
+                       ++ssd_key_idx) {
+                    int pull_data_idx = ssd_keys[ssd_key_idx].second;
+                    float* select_data =
+                        select_values != nullptr
+                            ? select_values[pull_data_idx]
+                            : pull_values + pull_data_idx * select_value_size;
+                    _value_accessor->Select(
+                        &select_data, (const float**)&data_buffer_ptr, 1);
+                  }
                 }
+                _cache_stat.mem_hit_num += mem_values.size();
+                _cache_stat.ssd_hit_num += ssd_hit_num;
+                _cache_stat.admit_num += admit_num;
+                _cache_stat.reject_num += ssd_hit_num - admit_num;
+                EvictToSSD(shard_id);
                 return 0;
               });
     }
     for (int i = 0; i < _real_local_shard_num; ++i) {
       tasks[i].wait();
     }
+    // rethrows the error of a shard once no task uses the keys any more
+    for (int i = 0; i < _real_local_shard_num; ++i) {
+      tasks[i].get();
+    }
+    _cache_stat.miss_num += missed_keys.load();
     if (FLAGS_pserver_print_missed_key_num_every_push) {
       LOG(WARNING) << "total pull keys:" << num
                    << " missed_keys:" << missed_keys.load();
@@ -212,6 +333,43 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
     auto& local_shard = _local_shards[shard_id];
     float data_buffer[value_size];  // NOLINT
     float* data_buffer_ptr = data_buffer;
+    // the caller updates the values through the returned pointers until the
+    // pass ends, so they are kept in memory and pinned against eviction
+    auto& pinned_keys = _pinned_keys[shard_id];
+    if (_pinned_pass_id[shard_id] != pass_id) {
+      pinned_keys.clear();
+      _pinned_pass_id[shard_id] = pass_id;
+    }
+    if (_enable_cache_policy) {
+      std::vector<uint64_t> new_pinned_keys;
+      for (size_t i = 0; i < num; ++i) {
+        if (pinned_keys.insert(pull_keys[i]).second) {
+          new_pinned_keys.push_back(pull_keys[i]);
+        }
+      }
+      // EvictToSSD can not make room once the pinned values alone exceed
+      // the cache capacity, so a pass may not pin more than that
+      size_t pinned_num = pinned_keys.size();
+      if (_cache_policies[shard_id].NeedEvict(pinned_num)) {
+        for (uint64_t key : new_pinned_keys) {
+          pinned_keys.erase(key);
+        }
+        LOG(ERROR) << "SSDSparseTable::PullSparsePtr: pass " << pass_id
+                   << " would pin " << pinned_num << " values of shard "
+                   << shard_id
+                   << ", more than pserver_ssd_cache_capacity="
+                   << FLAGS_pserver_ssd_cache_capacity
+                   << ", raise it or pull fewer keys per pass";
+        return -1;
+      }
+    }
+    for (size_t i = 0; i < num; ++i) {
+      MarkDirty(shard_id, pull_keys[i]);
+      _cache_policies[shard_id].RecordAccess(pull_keys[i]);
+    }
+    uint64_t mem_hit_num = 0;
+    uint64_t ssd_hit_num = 0;
+    uint64_t miss_num = 0;
 
     for (size_t i = 0; i < num; ++i) {
       uint64_t key = pull_keys[i];
@@ -230,7 +388,8 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
                                    cur_ctx->batch_keys.size(),
                                    cur_ctx->batch_keys.data(),
                                    cur_ctx->batch_values.data(),
-                                   cur_ctx->status.data());
+                                   cur_ctx->status.data(),
+                                   false);
                     return 0;
                   });
           cur_ctx = context.switch_item();
@@ -240,6 +399,7 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
               uint64_t cur_key = *(reinterpret_cast<uint64_t*>(
                   const_cast<char*>(cur_ctx->batch_keys[idx].data())));
               if (cur_ctx->status[idx].IsNotFound()) {
+                ++miss_num;
                 auto& feature_value = local_shard[cur_key];
                 int init_size = value_size - mf_value_size;
                 feature_value.resize(init_size);
@@ -249,6 +409,7 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
                        init_size * sizeof(float));
                 ret = &feature_value;
               } else {
+                ++ssd_hit_num;
                 int data_size =
                     cur_ctx->batch_values[idx].size() / sizeof(float);
                 // from rocksdb to mem
@@ -277,6 +438,7 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
           tasks.push_back(std::move(fut));
         }
       } else {
+        ++mem_hit_num;
         ret = itr.value_ptr();
         // int pull_data_idx = keys[i].second;
         _value_accessor->UpdateTimeDecay(ret->data(), true);
@@ -296,7 +458,8 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
                                cur_ctx->batch_keys.size(),
                                cur_ctx->batch_keys.data(),
                                cur_ctx->batch_values.data(),
-                               cur_ctx->status.data());
+                               cur_ctx->status.data(),
+                               false);
                 return 0;
               });
       tasks.push_back(std::move(fut));
@@ -310,6 +473,7 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
         uint64_t cur_key = *(reinterpret_cast<uint64_t*>(
             const_cast<char*>(cur_ctx->batch_keys[idx].data())));
         if (cur_ctx->status[idx].IsNotFound()) {
+          ++miss_num;
           auto& feature_value = local_shard[cur_key];
           int init_size = value_size - mf_value_size;
           feature_value.resize(init_size);
@@ -319,6 +483,7 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
                  init_size * sizeof(float));
           ret = &feature_value;
         } else {
+          ++ssd_hit_num;
           int data_size = cur_ctx->batch_values[idx].size() / sizeof(float);
           // from rocksdb to mem
           auto& feature_value = local_shard[cur_key];
@@ -340,6 +505,10 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
       }
       cur_ctx->reset();
     }
+    _cache_stat.mem_hit_num += mem_hit_num;
+    _cache_stat.ssd_hit_num += ssd_hit_num;
+    _cache_stat.admit_num += ssd_hit_num;
+    _cache_stat.miss_num += miss_num;
   }
   return 0;
 }
@@ -374,6 +543,17 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                &task_keys]() -> int {
                 auto& keys = task_keys[shard_id];
                 auto& local_shard = _local_shards[shard_id];
+                if (_enable_cache_policy) {
+                  // evicted or not admitted values are updated on ssd
+                  PushSSDValues(
+                      shard_id,
+                      &keys,
+                      [this, values, update_value_col](int idx, float** value) {
+                        const float* update_data =
+                            values + idx * update_value_col;
+                        _value_accessor->Update(value, &update_data, 1);
+                      });
+                }
                 float data_buffer[value_col];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
                 for (size_t i = 0; i < keys.size(); ++i) {
@@ -418,13 +598,19 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                            data_buffer_ptr,
                            value_size * sizeof(float));
                   }
+                  MarkDirty(shard_id, key);
                 }
+                EvictToSSD(shard_id);
                 return 0;
               });
     }
     for (int i = 0; i < _real_local_shard_num; ++i) {
       tasks[i].wait();
     }
+    // rethrows the error of a shard once no task uses the keys any more
+    for (int i = 0; i < _real_local_shard_num; ++i) {
+      tasks[i].get();
+    }
   }
   /*
   //update && value 的转置
@@ -452,7 +638,9 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
 
 int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                                    const float** values,
-                                   size_t num) {
+                                   size_t num,
+                                   const float** headers,
+                                   size_t header_dim) {
   CostTimer timer("pserver_downpour_sparse_update_all");
   // 构造value push_value的数据指针
   size_t value_col = _value_accessor->GetAccessorInfo().size / sizeof(float);
@@ -471,10 +659,30 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
     for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
       tasks[shard_id] =
           _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
-              [this, shard_id, value_col, mf_value_col, values, &task_keys]()
-                  -> int {
+              [this,
+               shard_id,
+               value_col,
+               mf_value_col,
+               values,
+               headers,
+               header_dim,
+               &task_keys]() -> int {
                 auto& keys = task_keys[shard_id];
                 auto& local_shard = _local_shards[shard_id];
+                // applies push idx, reading a split push value in its parts
+                auto update = [this, values, headers, header_dim](
+                                  int idx, float** value) {
+                  if (headers == nullptr) {
+                    _value_accessor->Update(value, &values[idx], 1);
+                  } else {
+                    _value_accessor->SplitUpdate(
+                        value, &headers[idx], header_dim, &values[idx], 1);
+                  }
+                };
+                if (_enable_cache_policy) {
+                  // evicted or not admitted values are updated on ssd
+                  PushSSDValues(shard_id, &keys, update);
+                }
                 float data_buffer[value_col];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
                 for (size_t i = 0; i < keys.size(); ++i) {
@@ -484,7 +692,13 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                   auto itr = local_shard.find(key);
                   if (itr == local_shard.end()) {
                     if (FLAGS_pserver_enable_create_feasign_randomly &&
-                        !_value_accessor->CreateValue(1, update_data)) {
+                        !(headers == nullptr
+                              ? _value_accessor->CreateValue(1, update_data)
+                              : _value_accessor->SplitCreateValue(
+                                    1,
+                                    headers[push_data_idx],
+                                    header_dim,
+                                    update_data))) {
                       continue;
                     }
                     auto value_size = value_col - mf_value_col;
@@ -502,13 +716,13 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
 
                   if (value_size ==
                       value_col) {  // 已拓展到最大size, 则就地update
-                    _value_accessor->Update(&value_data, &update_data, 1);
+                    update(push_data_idx, &value_data);
                   } else {
                     // 拷入buffer区进行update，然后再回填，不需要的mf则回填时抛弃了
                     memcpy(data_buffer_ptr,
                            value_data,
                            value_size * sizeof(float));
-                    _value_accessor->Update(&data_buffer_ptr, &update_data, 1);
+                    update(push_data_idx, &data_buffer_ptr);
                     if (_value_accessor->NeedExtendMF(data_buffer)) {
                       feature_value.resize(value_col);
                       value_data = const_cast<float*>(feature_value.data());
@@ -518,13 +732,19 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                            data_buffer_ptr,
                            value_size * sizeof(float));
                   }
+                  MarkDirty(shard_id, key);
                 }
+                EvictToSSD(shard_id);
                 return 0;
               });
     }
     for (int i = 0; i < _real_local_shard_num; ++i) {
       tasks[i].wait();
     }
+    // rethrows the error of a shard once no task uses the keys any more
+    for (int i = 0; i < _real_local_shard_num; ++i) {
+      tasks[i].get();
+    }
   }
   return 0;
 }
@@ -539,8 +759,13 @@ int32_t SSDSparseTable::Shrink(const std::string& param) {
 
     LOG(INFO) << "SSDSparseTable begin shrink shard:" << i;
     auto& shard = _local_shards[i];
+    // Shrink decays every value
+    if (_dirty_trackers) {
+      _dirty_trackers[i].MarkAllDirty();
+    }
     for (auto it = shard.begin(); it != shard.end();) {
       if (_value_accessor->Shrink(it.value().data())) {
+        MarkErased(i, it.key());
         it = shard.erase(it);
         mem_count++;
       } else {
@@ -551,6 +776,7 @@ int32_t SSDSparseTable::Shrink(const std::string& param) {
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
       if (_value_accessor->Shrink(
               ::paddle::string::str_to_float(it->value().data()))) {
+        MarkErased(i, *(reinterpret_cast<const uint64_t*>(it->key().data())));
         _db->del_data(i, it->key().data(), it->key().size());
         ssd_count++;
       } else {
@@ -593,6 +819,204 @@ int32_t SSDSparseTable::UpdateTable() {
   return 0;
 }
 
+void SSDSparseTable::TrackSavedShards(int save_param) {
+  if (!_dirty_trackers) {
+    return;
+  }
+  // the binary and multi output saves do not report which values
+  // UpdateStatAfterSave touched, so only a plain checkpoint is taken as the
+  // new base and any other save makes the next delta a full one
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    if (save_param == 0) {
+      _dirty_trackers[i].Reset();
+    } else {
+      _dirty_trackers[i].MarkAllDirty();
+    }
+  }
+}
+
+int32_t SSDSparseTable::VisitDeltaShard(
+    int shard_id,
+    const std::function<int(uint64_t, const float*, size_t)>& func) {
+  auto& shard = _local_shards[shard_id];
+  auto& tracker = _dirty_trackers[shard_id];
+  int ret = 0;
+  std::string value;
+  if (tracker.all_dirty()) {
+    for (auto it = shard.begin(); it != shard.end() && ret == 0; ++it) {
+      ret = func(it.key(), it.value().data(), it.value().size());
+    }
+    auto* it = _db->get_iterator(shard_id);
+    for (it->SeekToFirst(); it->Valid() && ret == 0; it->Next()) {
+      ret = func(*(reinterpret_cast<const uint64_t*>(it->key().data())),
+                 ::paddle::string::str_to_float(it->value().data()),
+                 it->value().size() / sizeof(float));
+    }
+    delete it;
+  } else {
+    for (auto key : tracker.dirty_keys()) {
+      auto it = shard.find(key);
+      if (it != shard.end()) {
+        ret = func(key, it.value().data(), it.value().size());
+      } else if (_db->get(shard_id,
+                          reinterpret_cast<const char*>(&key),
+                          sizeof(uint64_t),
+                          value) == 0) {
+        // moved to rocksdb by UpdateTable after it changed
+        ret = func(key,
+                   ::paddle::string::str_to_float(value),
+                   value.size() / sizeof(float));
+      }
+      if (ret != 0) {
+        return ret;
+      }
+    }
+  }
+  for (auto key : tracker.erased_keys()) {
+    if (ret != 0) {
+      break;
+    }
+    if (shard.find(key) == shard.end() &&
+        _db->get(shard_id,
+                 reinterpret_cast<const char*>(&key),
+                 sizeof(uint64_t),
+                 value) != 0) {
+      ret = func(key, nullptr, 0);
+    }
+  }
+  return ret;
+}
+
+void SSDSparseTable::ApplyDeltaRecord(int shard_id,
+                                      uint64_t key,
+                                      char* value_str) {
+  // the replayed value lives in memory, drop any older copy on ssd
+  _db->del_data(
+      shard_id, reinterpret_cast<const char*>(&key), sizeof(uint64_t));
+  MemorySparseTable::ApplyDeltaRecord(shard_id, key, value_str);
+}
+
+void SSDSparseTable::PushSSDValues(
+    int shard_id,
+    std::vector<std::pair<uint64_t, int>>* keys,
+    const std::function<void(int, float**)>& update) {
+  auto& local_shard = _local_shards[shard_id];
+  std::vector<std::pair<uint64_t, int>> ssd_keys;
+  for (auto& key_pair : *keys) {
+    if (local_shard.find(key_pair.first) == local_shard.end()) {
+      ssd_keys.push_back(key_pair);
+    }
+  }
+  if (ssd_keys.empty()) {
+    return;
+  }
+  // one multi_get of the distinct keys in db order, a key pushed several
+  // times keeps the order of its pushes
+  std::sort(ssd_keys.begin(), ssd_keys.end());
+  std::vector<uint64_t> read_keys;
+  read_keys.reserve(ssd_keys.size());
+  for (auto& key_pair : ssd_keys) {
+    if (read_keys.empty() || read_keys.back() != key_pair.first) {
+      read_keys.push_back(key_pair.first);
+    }
+  }
+  std::vector<rocksdb::Slice> read_slices;
+  read_slices.reserve(read_keys.size());
+  for (auto& key : read_keys) {
+    read_slices.emplace_back(reinterpret_cast<const char*>(&key),
+                             sizeof(uint64_t));
+  }
+  std::vector<rocksdb::PinnableSlice> read_values(read_keys.size());
+  std::vector<rocksdb::Status> read_status(read_keys.size());
+  _db->multi_get(shard_id,
+                 read_keys.size(),
+                 read_slices.data(),
+                 read_values.data(),
+                 read_status.data(),
+                 true);
+
+  size_t value_col = _value_accessor->GetAccessorInfo().size / sizeof(float);
+  float data_buffer[value_col];    // NOLINT
+  float extend_buffer[value_col];  // NOLINT
+  std::vector<uint64_t> found_keys;
+  size_t key_end = 0;
+  for (size_t i = 0; i < read_keys.size(); ++i) {
+    uint64_t key = read_keys[i];
+    // the pushes of key are ssd_keys[key_begin, key_end)
+    size_t key_begin = key_end;
+    while (key_end < ssd_keys.size() && ssd_keys[key_end].first == key) {
+      ++key_end;
+    }
+    if (read_status[i].IsNotFound()) {
+      continue;
+    }
+    PADDLE_ENFORCE_EQ(
+        read_status[i].ok(),
+        true,
+        common::errors::Unavailable(
+            "SSDSparseTable read key %lu of shard %d from rocksdb failed: %s",
+            key,
+            shard_id,
+            read_status[i].ToString()));
+    size_t value_size = read_values[i].size() / sizeof(float);
+    float* data_buffer_ptr = data_buffer;
+    memcpy(data_buffer_ptr, read_values[i].data(), value_size * sizeof(float));
+    for (size_t j = key_begin; j < key_end; ++j) {
+      update(ssd_keys[j].second, &data_buffer_ptr);
+      if (value_size < value_col &&
+          _value_accessor->NeedExtendMF(data_buffer_ptr)) {
+        float* extend_buffer_ptr = extend_buffer;
+        _value_accessor->Create(&extend_buffer_ptr, 1);
+        memcpy(extend_buffer_ptr, data_buffer_ptr, value_size * sizeof(float));
+        data_buffer_ptr = extend_buffer_ptr;
+        value_size = value_col;
+      }
+    }
+    _db->put(shard_id,
+             reinterpret_cast<const char*>(&key),
+             sizeof(uint64_t),
+             reinterpret_cast<const char*>(data_buffer_ptr),
+             value_size * sizeof(float));
+    MarkDirty(shard_id, key);
+    found_keys.push_back(key);
+  }
+  if (found_keys.empty()) {
+    return;
+  }
+  keys->erase(std::remove_if(keys->begin(),
+                             keys->end(),
+                             [&found_keys](const std::pair<uint64_t, int>& p) {
+                               return std::binary_search(found_keys.begin(),
+                                                         found_keys.end(),
+                                                         p.first);
+                             }),
+              keys->end());
+}
+
+void SSDSparseTable::EvictToSSD(int shard_id) {
+  auto& local_shard = _local_shards[shard_id];
+  auto& cache_policy = _cache_policies[shard_id];
+  if (!cache_policy.NeedEvict(local_shard.size())) {
+    return;
+  }
+  size_t evict_num = cache_policy.Evict(
+      &local_shard,
+      [this](FixedFeatureValue& value) {
+        return _value_accessor->GetField(value.data(), "show");
+      },
+      [this, shard_id](uint64_t key, FixedFeatureValue& value) {
+        _db->put(shard_id,
+                 reinterpret_cast<const char*>(&key),
+                 sizeof(uint64_t),
+                 reinterpret_cast<const char*>(value.data()),
+                 value.size() * sizeof(float));
+      },
+      [&pinned_keys = _pinned_keys[shard_id]](uint64_t key) {
+        return pinned_keys.find(key) == pinned_keys.end();
+      });
+  _cache_stat.evict_num += evict_num;
+}
+
 int64_t SSDSparseTable::LocalSize() {
   int64_t local_size = 0;
   for (int i = 0; i < _real_local_shard_num; ++i) {
@@ -603,6 +1027,10 @@ int64_t SSDSparseTable::LocalSize() {
 
 int32_t SSDSparseTable::Save(const std::string& path,
                              const std::string& param) {
+  if (atoi(param.c_str()) == SPARSE_DELTA_SAVE_PARAM) {
+    std::lock_guard<std::mutex> guard(_table_mutex);
+    return SaveDelta(path);
+  }
 #if defined(PADDLE_WITH_HETERPS) && defined(PADDLE_WITH_PSCORE)
   // gpu graph mode
   if (_use_gpu_graph) {
@@ -621,6 +1049,7 @@ int32_t SSDSparseTable::Save(const std::string& path,
   } else {
     ret = SaveWithBinary(path, param);  // batch_model:0  xbox:1
   }
+  TrackSavedShards(save_param);
   return ret;
 #else
   // CPUPS PSCORE
@@ -640,6 +1069,7 @@ int32_t SSDSparseTable::Save_v2(const std::string& path,
   } else {
     ret = SaveWithBinary_v2(path, param);  // batch_model:0  xbox:1
   }
+  TrackSavedShards(save_param);
   return ret;
 #else
   // CPUPS PSCORE
@@ -761,7 +1191,15 @@ int32_t SSDSparseTable::SaveWithString(const std::string& path,
           // get_field get right decayed show
           tk.push(i, _value_accessor->GetField(it.value().data(), "show"));
         }
-        if (_value_accessor->Save(it.value().data(), save_param)) {
+        bool need_save = false;
+        ApplyAndTrack(i,
+                      it.key(),
+                      it.value().data(),
+                      it.value().size(),
+                      [this, save_param, &need_save](float* value) {
+                        need_save = _value_accessor->Save(value, save_param);
+                      });
+        if (need_save) {
           std::vector<float> feature_value;
           feature_value.resize(it.value().size());
           memcpy(const_cast<float*>(feature_value.data()),
@@ -798,8 +1236,18 @@ int32_t SSDSparseTable::SaveWithString(const std::string& path,
     writer.Flush();
     fs_channel[i]->Close();
     feasign_size_all += feasign_size;
+    // a full checkpoint is the base of the following deltas
+    if (_dirty_trackers && (save_param == 0 || save_param == 3)) {
+      _dirty_trackers[i].Reset();
+    }
     for (auto it = shard.begin(); it != shard.end(); ++it) {
-      _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
+      ApplyAndTrack(i,
+                    it.key(),
+                    it.value().data(),
+                    it.value().size(),
+                    [this, save_param](float* value) {
+                      _value_accessor->UpdateStatAfterSave(value, save_param);
+                    });
     }
   }
   for (size_t i = 0; i < threads.size(); i++) {
@@ -2580,6 +3028,9 @@ int32_t SSDSparseTable::SaveCache(
 
 int32_t SSDSparseTable::Load(const std::string& path,
                              const std::string& param) {
+  if (atoi(param.c_str()) == SPARSE_DELTA_SAVE_PARAM) {
+    return LoadDelta(path);
+  }
   VLOG(0) << "LOAD FLAGS_rocksdb_path:" << FLAGS_rocksdb_path;
   std::string table_path = TableDir(path);
   auto file_list = _afs_client.list(::paddle::string::format_string(
@@ -2597,6 +3048,7 @@ int32_t SSDSparseTable::Load(const std::string& path,
   }
   _value_accessor->SetDayId(_day_id);
   VLOG(1) << " Load Set Dayid:" << _day_id;
+  int32_t ret = 0;
   if (load_param > 3) {
     size_t expect_shard_num = _sparse_table_shard_num;
     if (file_list.size() != expect_shard_num) {
@@ -2605,13 +3057,17 @@ int32_t SSDSparseTable::Load(const std::string& path,
       return -1;
     }
     size_t file_start_idx = _shard_idx * _avg_local_shard_num;
-    return LoadWithString(file_start_idx,
-                          file_start_idx + _real_local_shard_num,
-                          file_list,
-                          param);
+    ret = LoadWithString(file_start_idx,
+                         file_start_idx + _real_local_shard_num,
+                         file_list,
+                         param);
   } else {
-    return LoadWithBinary(table_path, load_param);
+    ret = LoadWithBinary(table_path, load_param);
+  }
+  if (ret == 0) {
+    ResetDirtyTrackers();
   }
+  return ret;
 }
 
 int32_t SSDSparseTable::LoadWithString(
@@ -3046,6 +3502,7 @@ int32_t SSDSparseTable::LoadWithBinary(const std::string& path, int param) {
 
 std::pair<int64_t, int64_t> SSDSparseTable::PrintTableStat() {
   int64_t feasign_size = LocalSize();
+  VLOG(0) << "SSDSparseTable cache stat: " << _cache_stat.ToString();
   return {feasign_size, -1};
 }
 
@@ -16,7 +16,9 @@
 
 #include "paddle/common/flags.h"
 #include "paddle/fluid/distributed/ps/table/depends/rocksdb_warpper.h"
+#include "paddle/fluid/distributed/ps/table/depends/sparse_cache_policy.h"
 #include "paddle/fluid/distributed/ps/table/memory_sparse_table.h"
+#include "paddle/fluid/distributed/ps/thirdparty/round_robin.h"
 
 #if defined(PADDLE_WITH_HETERPS) && defined(PADDLE_WITH_PSCORE)
 #include "paddle/fluid/framework/fleet/ps_gpu_wrapper.h"
@@ -76,14 +78,27 @@ class SSDSparseTable : public MemorySparseTable {
 
   int32_t Push(TableContext& context) override;
 
-  int32_t PullSparse(float* pull_values, const uint64_t* keys, size_t num);
+  int32_t PullSparse(float* pull_values,
+                     const uint64_t* keys,
+                     size_t num,
+                     float** select_values = nullptr);
+  // Hands out pointers to the values of pull_keys, which are loaded into
+  // memory and pinned until a later pass pulls the shard. Returns -1 without
+  // pulling anything if the pass would pin more values than the cache
+  // capacity of the shard.
   int32_t PullSparsePtr(int shard_id,
                         char** pull_values,
                         const uint64_t* keys,
                         size_t num,
                         uint16_t pass_id);
   int32_t PushSparse(const uint64_t* keys, const float* values, size_t num);
-  int32_t PushSparse(const uint64_t* keys, const float** values, size_t num);
+  // values[i] is the push value of keys[i]; with headers, its first
+  // header_dim fields are headers[i] instead (see TablePushContext)
+  int32_t PushSparse(const uint64_t* keys,
+                     const float** values,
+                     size_t num,
+                     const float** headers = nullptr,
+                     size_t header_dim = 0);
 
   int32_t Flush() override { return 0; }
   int32_t Shrink(const std::string& param) override;
@@ -134,7 +149,41 @@ class SSDSparseTable : public MemorySparseTable {
 
   void SetDayId(int day_id) override;
 
+  const SparseCacheStat& GetCacheStat() const { return _cache_stat; }
+
+ protected:
+  int32_t VisitDeltaShard(
+      int shard_id,
+      const std::function<int(uint64_t, const float*, size_t)>& func) override;
+  void ApplyDeltaRecord(int shard_id, uint64_t key, char* value_str) override;
+
  private:
+  // updates the dirty trackers after a save that does not track them itself
+  void TrackSavedShards(int save_param);
+  // moves the coldest values of a shard to rocksdb while it is over capacity
+  void EvictToSSD(int shard_id);
+  // applies the pushes of keys whose values live in rocksdb, reading them
+  // with one multi_get, and removes those keys from keys. update(idx, value)
+  // applies push idx to value.
+  void PushSSDValues(int shard_id,
+                     std::vector<std::pair<uint64_t, int>>* keys,
+                     const std::function<void(int, float**)>& update);
+
+  // per local shard, see FLAGS_pserver_ssd_cache_capacity
+  std::vector<SparseCachePolicy> _cache_policies;
+  // whether values can live in rocksdb while being trained, push must then
+  // look there before creating a value
+  bool _enable_cache_policy = false;
+  SparseCacheStat _cache_stat;
+  // runs the rocksdb reads of PullSparse while the shard threads select the
+  // values found in memory
+  std::shared_ptr<::ThreadPool> _ssd_read_pool;
+  // per local shard, keys whose values PullSparsePtr handed out in the pass
+  // _pinned_pass_id, they stay in memory until a new pass pulls the shard.
+  // At most pserver_ssd_cache_capacity keys are pinned per shard.
+  std::vector<robin_hood::unordered_set<uint64_t>> _pinned_keys;
+  std::vector<int> _pinned_pass_id;
+
   RocksDBHandler* _db;
   int64_t _cache_tk_size;
   double _local_show_threshold{0.0};
@@ -44,6 +44,9 @@ struct TablePullContext {
   PullSparseValue pull_value;
   float *values = nullptr;
   char **ptr_values = nullptr;
+  // sparse pull output of each key, replaces values when set, so callers in
+  // the same process get the selected values without a staging buffer
+  float **select_values = nullptr;
   std::vector<uint64_t> *geo_pull_keys = nullptr;  // for GEO
   std::vector<float> *geo_pull_values = nullptr;   // for GEO
 };
@@ -52,6 +55,10 @@ struct TablePushContext {
   const uint64_t *keys = nullptr;
   const float *values = nullptr;
   const float **ptr_values = nullptr;
+  // if set, the first header_dim fields of push value i are ptr_headers[i]
+  // and ptr_values[i] only holds the rest, see ValueAccessor::SplitUpdate
+  const float **ptr_headers = nullptr;
+  size_t header_dim = 0;
   const int64_t *push_steps = nullptr;  // for global step
   bool is_param = false;  // true: push param, false: push gradient
 };
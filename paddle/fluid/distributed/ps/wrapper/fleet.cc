@@ -632,12 +632,21 @@ void FleetWrapper::PushSparseFromTensorAsync(
                         "Got outputs->size() = %d, inputs->size() = %d.",
                         outputs->size(),
                         inputs->size()));
+  // slot show clk grad... consistent with CtrCommonPushValue defined in
+  // ctr_accessor.h, or slot and the cvm grad. Only the slot/show/click
+  // header is built here, the grad is pushed from the output tensor.
+  const size_t header_dim = use_cvm_op ? 1 : 3;
+  size_t max_push_num = 0;
+  for (auto* input : *inputs) {
+    max_push_num += input->numel();
+  }
   std::vector<uint64_t> push_keys;
-  push_keys.reserve(MAX_FEASIGN_NUM / 100);
-  std::vector<std::vector<float>> push_values;
-  push_values.reserve(MAX_FEASIGN_NUM / 100);
+  push_keys.reserve(max_push_num);
+  std::vector<float> push_headers;
+  push_headers.reserve(max_push_num * header_dim);
+  std::vector<const float*> push_grads;
+  push_grads.reserve(max_push_num);
   size_t output_len = 0;
-  size_t input_idx = 0;
 
   VLOG(2) << "fleet.cc::emb_dim: " << fea_dim;
 
@@ -697,28 +706,18 @@ void FleetWrapper::PushSparseFromTensorAsync(
             continue;
           }
           push_keys.emplace_back(real_id);
-          if (use_cvm_op) {
-            push_values.emplace_back(fea_dim + 1);
-            push_values.back()[0] = static_cast<float>(slots[index]);
-            float* data = push_values.back().data() + 1;
-            memcpy(data, g + output_len, sizeof(float) * fea_dim);
-          } else {
-            push_values.emplace_back(fea_dim + 3);
-            // slot show clk grad... consistent with CtrCommonPushValue defined
-            // in ctr_accessor.h
-            push_values.back()[0] = static_cast<float>(slots[index]);
-            push_values.back()[1] =
-                (i >= show_size ? 1
-                                : static_cast<float>(static_cast<const float*>(
-                                      show_tensor)[i]));
-            push_values.back()[2] =
-                (i >= clk_size ? 0
-                               : static_cast<float>(
-                                     static_cast<const float*>(clk_tensor)[i]));
-            float* data = push_values.back().data() + 3;
-            memcpy(data, g + output_len, sizeof(float) * fea_dim);
+          push_headers.push_back(static_cast<float>(slots[index]));
+          if (!use_cvm_op) {
+            push_headers.push_back(
+                i >= show_size ? 1
+                               : static_cast<float>(static_cast<const float*>(
+                                     show_tensor)[i]));
+            push_headers.push_back(
+                i >= clk_size ? 0
+                              : static_cast<float>(
+                                    static_cast<const float*>(clk_tensor)[i]));
           }
-          ++input_idx;
+          push_grads.push_back(g + output_len);
         }
       }
     } else {
@@ -728,24 +727,14 @@ void FleetWrapper::PushSparseFromTensorAsync(
           continue;
         }
         push_keys.emplace_back(real_id);
-        if (use_cvm_op) {
-          push_values.emplace_back(fea_dim + 1);
-          push_values.back()[0] = static_cast<float>(slots[index]);
-          float* data = push_values.back().data() + 1;
-          memcpy(data, g + output_len, sizeof(float) * fea_dim);
-        } else {
-          push_values.emplace_back(fea_dim + 3);
-          // slot show clk grad... consistent with CtrCommonPushValue defined in
-          // ctr_accessor.h
-          push_values.back()[0] = static_cast<float>(slots[index]);
-          push_values.back()[1] =
-              (i >= show_size ? 1 : static_cast<const float*>(show_tensor)[i]);
-          push_values.back()[2] =
-              (i >= clk_size ? 0 : static_cast<const float*>(clk_tensor)[i]);
-          float* data = push_values.back().data() + 3;
-          memcpy(data, g + output_len, sizeof(float) * fea_dim);
+        push_headers.push_back(static_cast<float>(slots[index]));
+        if (!use_cvm_op) {
+          push_headers.push_back(
+              i >= show_size ? 1 : static_cast<const float*>(show_tensor)[i]);
+          push_headers.push_back(
+              i >= clk_size ? 0 : static_cast<const float*>(clk_tensor)[i]);
         }
-        ++input_idx;
+        push_grads.push_back(g + output_len);
       }
     }
     PADDLE_ENFORCE_EQ(static_cast<int64_t>(output_len),
@@ -755,16 +744,17 @@ void FleetWrapper::PushSparseFromTensorAsync(
                           "number of elements in the tensor."));
   }
 
-  std::vector<float*> push_g_vec(input_idx, nullptr);
-
-  for (auto i = 0u; i < push_keys.size(); ++i) {
-    push_g_vec[i] = push_values.at(i).data();
+  std::vector<const float*> push_header_ptrs(push_keys.size());
+  for (size_t i = 0; i < push_keys.size(); ++i) {
+    push_header_ptrs[i] = push_headers.data() + i * header_dim;
   }
 
-  auto status = worker_ptr_->PushSparse(table_id,
-                                        push_keys.data(),
-                                        (const float**)push_g_vec.data(),
-                                        push_keys.size());
+  auto status = worker_ptr_->PushSparseSplit(table_id,
+                                             push_keys.data(),
+                                             push_header_ptrs.data(),
+                                             header_dim,
+                                             push_grads.data(),
+                                             push_keys.size());
 }
 
 void FleetWrapper::LoadModel(const std::string& path, const int mode) {
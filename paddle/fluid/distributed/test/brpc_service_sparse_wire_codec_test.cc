@@ -0,0 +1,269 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/service/brpc_ps_client.h"
+#include "paddle/fluid/distributed/ps/service/brpc_ps_server.h"
+#include "paddle/fluid/distributed/ps/service/env.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+namespace framework = paddle::framework;
+
+// Tables 1 and 2 hold the same values as table 0 but are pushed and pulled
+// through the wire codec, each with its own quantization tolerance. The
+// tolerances cover one quantization of every push and of the last pull.
+static const int kRawTableId = 0;
+static const int kFp16TableId = 1;
+static const int kInt8TableId = 2;
+static const int kTableNum = 3;
+static const size_t kEmbedxDim = 9;
+static const size_t kSelectDim = 1 + kEmbedxDim;
+static const size_t kUpdateDim = 4 + kEmbedxDim;
+
+void GetDownpourSparseTableProto(
+    ::paddle::distributed::TableParameter* sparse_table_proto, int table_id) {
+  sparse_table_proto->set_table_id(table_id);
+  sparse_table_proto->set_table_class("MemorySparseTable");
+  sparse_table_proto->set_shard_num(10);
+  ::paddle::distributed::TableAccessorParameter* accessor_config =
+      sparse_table_proto->mutable_accessor();
+
+  accessor_config->set_accessor_class("SparseAccessor");
+  accessor_config->set_fea_dim(kSelectDim);
+  accessor_config->set_embedx_dim(kEmbedxDim);
+  accessor_config->set_embedx_threshold(0);
+  accessor_config->mutable_ctr_accessor_param()->set_nonclk_coeff(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_click_coeff(1);
+  accessor_config->mutable_ctr_accessor_param()->set_base_threshold(0.5);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_threshold(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_keep_days(16);
+  accessor_config->mutable_ctr_accessor_param()->set_show_click_decay_rate(
+      0.99);
+
+  // zero initialized, so that the tables start from the same values
+  accessor_config->mutable_embed_sgd_param()->set_name("SparseNaiveSGDRule");
+  auto* naive_param =
+      accessor_config->mutable_embed_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(1.0);
+  naive_param->set_initial_range(0.0);
+  naive_param->add_weight_bounds(-10.0);
+  naive_param->add_weight_bounds(10.0);
+
+  accessor_config->mutable_embedx_sgd_param()->set_name("SparseNaiveSGDRule");
+  naive_param = accessor_config->mutable_embedx_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(1.0);
+  naive_param->set_initial_range(0.0);
+  naive_param->add_weight_bounds(-10.0);
+  naive_param->add_weight_bounds(10.0);
+
+  if (table_id == kFp16TableId) {
+    auto* wire_codec = sparse_table_proto->mutable_wire_codec();
+    wire_codec->set_value_type("fp16");
+    wire_codec->set_delta_keys(true);
+  } else if (table_id == kInt8TableId) {
+    // every pulled float is quantized
+    auto* wire_codec = sparse_table_proto->mutable_wire_codec();
+    wire_codec->set_value_type("int8");
+    wire_codec->set_pull_exact_dim(0);
+  }
+}
+
+void GetServerServiceProto(
+    ::paddle::distributed::DownpourServerParameter* downpour_server_proto) {
+  ::paddle::distributed::ServerServiceParameter* server_service_proto =
+      downpour_server_proto->mutable_service_param();
+  server_service_proto->set_service_class("BrpcPsService");
+  server_service_proto->set_server_class("BrpcPsServer");
+  server_service_proto->set_client_class("BrpcPsClient");
+  server_service_proto->set_start_server_port(0);
+  server_service_proto->set_server_thread_num(12);
+  for (int table_id = 0; table_id < kTableNum; ++table_id) {
+    GetDownpourSparseTableProto(
+        downpour_server_proto->add_downpour_table_param(), table_id);
+  }
+}
+
+::paddle::distributed::PSParameter GetServerProto() {
+  ::paddle::distributed::PSParameter server_fleet_desc;
+  GetServerServiceProto(server_fleet_desc.mutable_server_param()
+                            ->mutable_downpour_server_param());
+  return server_fleet_desc;
+}
+
+::paddle::distributed::PSParameter GetWorkerProto() {
+  ::paddle::distributed::PSParameter worker_fleet_desc;
+  ::paddle::distributed::DownpourWorkerParameter* downpour_worker_proto =
+      worker_fleet_desc.mutable_worker_param()
+          ->mutable_downpour_worker_param();
+  for (int table_id = 0; table_id < kTableNum; ++table_id) {
+    GetDownpourSparseTableProto(
+        downpour_worker_proto->add_downpour_table_param(), table_id);
+  }
+  // the client negotiates the codec of a table from the server tables
+  GetServerServiceProto(worker_fleet_desc.mutable_server_param()
+                            ->mutable_downpour_server_param());
+  return worker_fleet_desc;
+}
+
+/*-------------------------------------------------------------------------*/
+
+std::string ip_ = "127.0.0.1";  // NOLINT
+uint32_t port_ = 4216;
+
+std::vector<std::string> host_sign_list_;
+
+std::shared_ptr<paddle::distributed::PSServer> pserver_ptr_;
+
+std::shared_ptr<paddle::distributed::PSClient> worker_ptr_;
+
+void RunServer() {
+  ::paddle::distributed::PSParameter server_proto = GetServerProto();
+
+  auto _ps_env = paddle::distributed::PaddlePSEnvironment();
+  _ps_env.SetPsServers(&host_sign_list_, 1);
+  pserver_ptr_ = std::shared_ptr<paddle::distributed::PSServer>(
+      paddle::distributed::PSServerFactory::Create(server_proto));
+  std::vector<framework::ProgramDesc> empty_vec;
+  framework::ProgramDesc empty_prog;
+  empty_vec.push_back(empty_prog);
+  pserver_ptr_->Configure(server_proto, _ps_env, 0, empty_vec);
+  pserver_ptr_->Start(ip_, port_);
+}
+
+void RunClient(std::map<uint64_t, std::vector<paddle::distributed::Region>>&
+                   dense_regions) {
+  ::paddle::distributed::PSParameter worker_proto = GetWorkerProto();
+  paddle::distributed::PaddlePSEnvironment _ps_env;
+  auto servers_ = host_sign_list_.size();
+  _ps_env = paddle::distributed::PaddlePSEnvironment();
+  _ps_env.SetPsServers(&host_sign_list_, servers_);
+  worker_ptr_ = std::shared_ptr<paddle::distributed::PSClient>(
+      paddle::distributed::PSClientFactory::Create(worker_proto));
+  worker_ptr_->Configure(worker_proto, dense_regions, _ps_env, 0);
+}
+
+void PullAll(int table_id,
+             const std::vector<uint64_t>& keys,
+             std::vector<float>* values) {
+  values->assign(keys.size() * kSelectDim, 0);
+  std::vector<float*> value_ptrs(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    value_ptrs[i] = values->data() + i * kSelectDim;
+  }
+  auto status = worker_ptr_->PullSparse(
+      value_ptrs.data(), table_id, keys.data(), keys.size(), true);
+  status.wait();
+  ASSERT_EQ(status.get(), 0);
+}
+
+void PushAll(int table_id,
+             const std::vector<uint64_t>& keys,
+             const std::vector<float>& grads) {
+  std::vector<const float*> grad_ptrs(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    grad_ptrs[i] = grads.data() + i * kUpdateDim;
+  }
+  // the async pushes are merged by the client, the flush sends them
+  worker_ptr_->PushSparse(table_id, keys.data(), grad_ptrs.data(), keys.size());
+  worker_ptr_->Flush().wait();
+}
+
+void RunBrpcSparseWireCodec() {
+  setenv("http_proxy", "", 1);
+  setenv("https_proxy", "", 1);
+  auto ph_host = paddle::distributed::PSHost(ip_, port_, 0);
+  host_sign_list_.push_back(ph_host.SerializeToString());
+
+  // Start Server
+  std::thread server_thread(RunServer);
+  sleep(1);
+
+  // Start Client
+  std::map<uint64_t, std::vector<paddle::distributed::Region>> dense_regions;
+  dense_regions.insert(
+      std::pair<uint64_t, std::vector<paddle::distributed::Region>>(0, {}));
+  RunClient(dense_regions);
+
+  // sparse keys far apart, so that their deltas take several varint bytes
+  std::mt19937_64 engine(0);
+  std::vector<uint64_t> keys(1000);
+  for (auto& key : keys) {
+    key = engine() >> 8;
+  }
+  std::uniform_real_distribution<float> grad_dist(-1.0, 1.0);
+
+  // the first push creates the embedx, the second one updates it
+  for (int step = 0; step < 2; ++step) {
+    std::vector<float> grads(keys.size() * kUpdateDim);
+    for (size_t i = 0; i < keys.size(); ++i) {
+      float* grad = grads.data() + i * kUpdateDim;
+      grad[0] = static_cast<float>(i % 7);  // slot
+      grad[1] = 1.0;                        // show
+      grad[2] = static_cast<float>(i % 2);  // click
+      for (size_t j = 3; j < kUpdateDim; ++j) {
+        grad[j] = grad_dist(engine);
+      }
+    }
+    for (int table_id = 0; table_id < kTableNum; ++table_id) {
+      std::vector<float> values;
+      PullAll(table_id, keys, &values);
+      PushAll(table_id, keys, grads);
+    }
+  }
+
+  std::vector<float> raw_values;
+  PullAll(kRawTableId, keys, &raw_values);
+  // the pushes moved the values away from their zero initialization
+  float max_abs = 0;
+  for (float value : raw_values) {
+    max_abs = std::max(max_abs, std::abs(value));
+  }
+  EXPECT_GT(max_abs, 0.5);
+
+  // fp16 keeps 11 significant bits, int8 splits the range of a value in 255
+  // steps, the values moved by at most 2 and each push by at most 1
+  std::vector<std::pair<int, float>> codec_tables = {{kFp16TableId, 3e-3},
+                                                     {kInt8TableId, 4e-2}};
+  for (auto& codec_table : codec_tables) {
+    std::vector<float> codec_values;
+    PullAll(codec_table.first, keys, &codec_values);
+    ASSERT_EQ(codec_values.size(), raw_values.size());
+    for (size_t i = 0; i < raw_values.size(); ++i) {
+      EXPECT_NEAR(codec_values[i], raw_values[i], codec_table.second)
+          << "table " << codec_table.first << ", key " << keys[i / kSelectDim]
+          << ", dim " << i % kSelectDim;
+    }
+  }
+
+  LOG(INFO) << "Run stop_server";
+  worker_ptr_->StopServer();
+  LOG(INFO) << "Run finalize_worker";
+  worker_ptr_->FinalizeWorker();
+  server_thread.join();
+}
+
+TEST(RunBrpcSparseWireCodec, Run) { RunBrpcSparseWireCodec(); }
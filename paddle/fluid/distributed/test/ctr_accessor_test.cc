@@ -14,8 +14,10 @@ limitations under the License. */
 
 #include "paddle/fluid/distributed/ps/table/ctr_accessor.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "paddle/fluid/distributed/common/registerer.h"
@@ -279,6 +281,71 @@ TEST(downpour_feature_value_accessor_test, test_update) {
   }
 }
 
+TEST(downpour_feature_value_accessor_test, test_split_update) {
+  TableAccessorParameter parameter = gen_param();
+  CtrCommonAccessor acc;
+  ASSERT_EQ(acc.Configure(parameter), 0);
+  ASSERT_EQ(acc.Initialize(), 0);
+
+  const size_t dim = acc.GetAccessorInfo().dim;
+  const size_t update_dim = acc.GetAccessorInfo().update_dim;
+  const size_t item_size = 10;
+  std::vector<float> push_values(item_size * update_dim);
+  for (size_t i = 0; i < push_values.size(); ++i) {
+    push_values[i] = static_cast<float>(i % 7) * 0.5 + 1.0;
+  }
+  // the fleet push layouts: slot show click | grad, and slot | cvm grad
+  for (size_t header_dim : {3, 1}) {
+    std::vector<float> expected(item_size * dim, 0);
+    std::vector<float> split(item_size * dim, 0);
+    std::vector<float*> expected_ptrs(item_size);
+    std::vector<float*> split_ptrs(item_size);
+    std::vector<const float*> push_ptrs(item_size);
+    std::vector<const float*> header_ptrs(item_size);
+    std::vector<const float*> grad_ptrs(item_size);
+    // the grads live apart from the headers, like in the output tensor
+    std::vector<float> headers(item_size * header_dim);
+    std::vector<float> grads(item_size * (update_dim - header_dim));
+    for (size_t i = 0; i < item_size; ++i) {
+      const float* push_value = push_values.data() + i * update_dim;
+      std::copy(push_value,
+                push_value + header_dim,
+                headers.begin() + i * header_dim);
+      std::copy(push_value + header_dim,
+                push_value + update_dim,
+                grads.begin() + i * (update_dim - header_dim));
+      expected_ptrs[i] = expected.data() + i * dim;
+      split_ptrs[i] = split.data() + i * dim;
+      push_ptrs[i] = push_value;
+      header_ptrs[i] = headers.data() + i * header_dim;
+      grad_ptrs[i] = grads.data() + i * (update_dim - header_dim);
+    }
+    acc.Update(expected_ptrs.data(), push_ptrs.data(), item_size);
+    acc.SplitUpdate(split_ptrs.data(),
+                    header_ptrs.data(),
+                    header_dim,
+                    grad_ptrs.data(),
+                    item_size);
+    for (size_t i = 0; i < expected.size(); ++i) {
+      ASSERT_FLOAT_EQ(split[i], expected[i]);
+    }
+    // the joining default of ValueAccessor gives the same result
+    std::vector<float> joined(item_size * dim, 0);
+    std::vector<float*> joined_ptrs(item_size);
+    for (size_t i = 0; i < item_size; ++i) {
+      joined_ptrs[i] = joined.data() + i * dim;
+    }
+    acc.ValueAccessor::SplitUpdate(joined_ptrs.data(),
+                                   header_ptrs.data(),
+                                   header_dim,
+                                   grad_ptrs.data(),
+                                   item_size);
+    for (size_t i = 0; i < expected.size(); ++i) {
+      ASSERT_FLOAT_EQ(joined[i], expected[i]);
+    }
+  }
+}
+
 TEST(downpour_feature_value_accessor_test, test_show_click_score) {
   TableAccessorParameter parameter = gen_param();
   CtrCommonAccessor* acc = new CtrCommonAccessor();
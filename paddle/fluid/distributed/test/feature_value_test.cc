@@ -45,4 +45,48 @@ TEST(BENCHMARK, LargeScaleKV) {
   ASSERT_FLOAT_EQ(value_data[3], 0.3);
 }
 
+TEST(FixedFeatureValue, SlabResize) {
+  auto get_value_num = [](size_t capacity) -> int64_t {
+    for (auto &stat : FeatureValueSlab::Instance().GetStats()) {
+      if (stat.capacity == capacity) {
+        return stat.value_num;
+      }
+    }
+    return 0;
+  };
+  int64_t small_num = get_value_num(FeatureValueSlab::CapacityOf(5));
+  int64_t large_num = get_value_num(FeatureValueSlab::CapacityOf(13));
+  {
+    FixedFeatureValue value;
+    value.resize(5);
+    for (size_t i = 0; i < value.size(); ++i) {
+      value.data()[i] = i;
+    }
+    ASSERT_EQ(get_value_num(FeatureValueSlab::CapacityOf(5)), small_num + 1);
+
+    // resize within the size class keeps the slot
+    float *data = value.data();
+    value.resize(6);
+    ASSERT_EQ(value.data(), data);
+    ASSERT_FLOAT_EQ(value.data()[5], 0.0);
+
+    // extending mf moves the value to the larger class
+    value.resize(13);
+    ASSERT_EQ(get_value_num(FeatureValueSlab::CapacityOf(5)), small_num);
+    ASSERT_EQ(get_value_num(FeatureValueSlab::CapacityOf(13)), large_num + 1);
+    for (size_t i = 0; i < 5; ++i) {
+      ASSERT_FLOAT_EQ(value.data()[i], i);
+    }
+    for (size_t i = 5; i < value.size(); ++i) {
+      ASSERT_FLOAT_EQ(value.data()[i], 0.0);
+    }
+
+    FixedFeatureValue copied(value);
+    ASSERT_EQ(copied.size(), value.size());
+    ASSERT_NE(copied.data(), value.data());
+    ASSERT_FLOAT_EQ(copied.data()[4], 4.0);
+  }
+  ASSERT_EQ(get_value_num(FeatureValueSlab::CapacityOf(13)), large_num);
+}
+
 }  // namespace paddle::distributed
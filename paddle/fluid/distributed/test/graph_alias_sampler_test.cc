@@ -0,0 +1,244 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/common_graph_table.h"
+
+namespace paddle::distributed {
+
+// WeightedGraphEdgeBlob keeps the weights only in gpu builds, this one
+// always keeps them so that WeightedSampler can be compared on cpu.
+class TestWeightedEdgeBlob : public WeightedGraphEdgeBlob {
+ public:
+  void add_edge(int64_t id, float weight) override {
+    id_arr.push_back(id);
+    weight_arr.push_back(static_cast<decltype(weight_arr)::value_type>(weight));
+  }
+};
+
+static void CheckDistinct(const int *res, int num, int k, int size) {
+  ASSERT_EQ(num, std::min(k, size));
+  std::set<int> distinct(res, res + num);
+  ASSERT_EQ(distinct.size(), static_cast<size_t>(num));
+  ASSERT_GE(*distinct.begin(), 0);
+  ASSERT_LT(*distinct.rbegin(), size);
+}
+
+TEST(AliasSampler, InclusionMatchesWeightedSampleK) {
+  const int size = 100;
+  const int k = 3;
+  GraphCsrEdges csr;
+  csr.weights.push_back(7);  // a range after another node
+  for (int i = 0; i < size; ++i) {
+    csr.ids.push_back(i);
+    csr.weights.push_back(i % 10 == 0 ? 20.0 : (i % 3 == 0 ? 0 : 1));
+  }
+  AliasSampler sampler;
+  sampler.build(&csr, 1, size);
+  auto rng = std::make_shared<std::mt19937_64>(0);
+  const int trials = 20000;
+  std::vector<int> alias_count(size, 0);
+  std::vector<int> expect_count(size, 0);
+  int res[k];
+  for (int t = 0; t < trials; ++t) {
+    CheckDistinct(res, sampler.sample_k_to(k, rng, res), k, size);
+    for (int x : res) ++alias_count[x];
+    weighted_sample_k(csr.weights.data() + 1, size, k, rng, res);
+    for (int x : res) ++expect_count[x];
+  }
+  for (int i = 0; i < size; ++i) {
+    if (csr.weights[i + 1] == 0) {
+      ASSERT_EQ(alias_count[i], 0);
+    }
+    ASSERT_NEAR(static_cast<double>(alias_count[i]) / trials,
+                static_cast<double>(expect_count[i]) / trials,
+                0.02);
+  }
+}
+
+TEST(AliasSampler, SkewedWeights) {
+  // most draws repeat the heavy neighbors, the rest falls back
+  GraphCsrEdges csr;
+  const int size = 64;
+  for (int i = 0; i < size; ++i) {
+    csr.ids.push_back(i);
+    csr.weights.push_back(i < 2 ? 1e6 : (i < 40 ? 1e-3 : 0));
+  }
+  AliasSampler sampler;
+  sampler.build(&csr, 0, size);
+  auto rng = std::make_shared<std::mt19937_64>(0);
+  std::vector<int> res(size);
+  for (int k : {1, 10, 40, 50, 63, 64, 100}) {
+    int num = sampler.sample_k_to(k, rng, res.data());
+    CheckDistinct(res.data(), num, k, size);
+    // neighbors of zero weight only when the others are exhausted
+    int positive = std::count_if(
+        res.begin(), res.begin() + num, [](int x) { return x < 40; });
+    ASSERT_EQ(positive, std::min(num, 40));
+  }
+}
+
+TEST(AliasSampler, GraphNodeSampler) {
+  auto rng = std::make_shared<std::mt19937_64>(0);
+  for (int degree : {10, 1000}) {
+    GraphNode node(1);
+    node.build_edges(true);
+    for (int i = 0; i < degree; ++i) {
+      node.add_edge(i, 1.0 + i % 5);
+    }
+    node.build_sampler("weighted");
+    std::vector<int> res(20);
+    int num = node.sample_k_to(20, rng, res.data());
+    CheckDistinct(res.data(), num, 20, degree);
+    ASSERT_EQ(node.sample_k(20, rng).size(), std::min<size_t>(20, degree));
+
+    // frozen nodes of high degree keep an AliasSampler on the csr weights
+    GraphCsrEdges csr;
+    node.freeze_edges(&csr, true);
+    num = node.sample_k_to(20, rng, res.data());
+    CheckDistinct(res.data(), num, 20, degree);
+    // thawed nodes rebuild their sampler
+    node.add_edge(degree, 1.0);
+    ASSERT_EQ(node.get_neighbor_size(), static_cast<size_t>(degree + 1));
+    num = node.sample_k_to(20, rng, res.data());
+    CheckDistinct(res.data(), num, 20, degree);
+  }
+}
+
+TEST(AliasSampler, SampleNeighborsBatch) {
+  GraphParameter table_proto;
+  table_proto.set_task_pool_size(4);
+  table_proto.set_shard_num(16);
+  table_proto.add_node_types("user");
+  table_proto.add_graph_feature();
+  table_proto.add_edge_types("user2user");
+  GraphTable graph_table;
+  graph_table.Initialize(table_proto);
+  std::vector<uint64_t> node_ids = {1, 2, 3, 1000};
+  std::vector<int> degrees = {5, 100, 300, 0};
+  for (size_t i = 0; i < node_ids.size(); ++i) {
+    for (int j = 0; j < degrees[i]; ++j) {
+      graph_table.add_comm_edge(0, node_ids[i], 10000 + j);
+    }
+  }
+  graph_table.build_sampler(0, "weighted");
+
+  const int sample_size = 10;
+  std::vector<uint64_t> neighbor_ids(node_ids.size() * sample_size);
+  std::vector<float> weights(node_ids.size() * sample_size);
+  std::vector<int> actual_sizes(node_ids.size());
+  ASSERT_EQ(graph_table.sample_neighbors_batch(0,
+                                               node_ids.data(),
+                                               node_ids.size(),
+                                               sample_size,
+                                               neighbor_ids.data(),
+                                               weights.data(),
+                                               actual_sizes.data()),
+            0);
+  for (size_t i = 0; i < node_ids.size(); ++i) {
+    ASSERT_EQ(actual_sizes[i], std::min(sample_size, degrees[i]));
+    std::set<uint64_t> distinct;
+    for (int j = 0; j < actual_sizes[i]; ++j) {
+      uint64_t id = neighbor_ids[i * sample_size + j];
+      ASSERT_GE(id, 10000u);
+      ASSERT_LT(id, 10000u + degrees[i]);
+      ASSERT_FLOAT_EQ(weights[i * sample_size + j], 1.0);
+      distinct.insert(id);
+    }
+    ASSERT_EQ(distinct.size(), static_cast<size_t>(actual_sizes[i]));
+  }
+}
+
+// Samples 10 neighbors of a hot node of degree 100000 with WeightedSampler
+// and AliasSampler, and of 10000 nodes of degree 1000 into one buffer.
+TEST(AliasSampler, BENCHMARK_WeightedSampling) {
+  const int degree = 100000;
+  const int k = 10;
+  std::mt19937_64 engine(0);
+  std::lognormal_distribution<float> weight_dist(0, 1);
+  TestWeightedEdgeBlob blob;
+  for (int i = 0; i < degree; ++i) {
+    blob.add_edge(i, weight_dist(engine));
+  }
+  auto rng = std::make_shared<std::mt19937_64>(0);
+  const int rounds = 10000;
+  uint64_t checksum = 0;
+
+  WeightedSampler tree;
+  auto start = std::chrono::steady_clock::now();
+  tree.build(&blob);
+  for (int i = 0; i < rounds; ++i) {
+    for (int x : tree.sample_k(k, rng)) checksum += x;
+  }
+  double tree_seconds = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+
+  AliasSampler alias;
+  int res[k];
+  start = std::chrono::steady_clock::now();
+  alias.build(&blob);
+  for (int i = 0; i < rounds; ++i) {
+    int num = alias.sample_k_to(k, rng, res);
+    for (int j = 0; j < num; ++j) checksum += res[j];
+  }
+  double alias_seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  LOG(INFO) << "degree " << degree << " sample_k(" << k
+            << ") build + " << rounds << " calls, tree: " << tree_seconds
+            << " s, alias: " << alias_seconds << " s";
+
+  const int node_num = 10000;
+  const int node_degree = 1000;
+  std::vector<std::unique_ptr<GraphEdgeBlob>> blobs;
+  std::vector<std::unique_ptr<Sampler>> trees, aliases;
+  for (int i = 0; i < node_num; ++i) {
+    blobs.emplace_back(new TestWeightedEdgeBlob());
+    for (int j = 0; j < node_degree; ++j) {
+      blobs.back()->add_edge(j, weight_dist(engine));
+    }
+    trees.emplace_back(new WeightedSampler());
+    trees.back()->build(blobs.back().get());
+    aliases.emplace_back(new AliasSampler());
+    aliases.back()->build(blobs.back().get());
+  }
+  // the first pass also builds the lazy alias tables
+  std::vector<int> batch(node_num * k);
+  for (int pass = 0; pass < 2; ++pass) {
+    for (auto *samplers : {&trees, &aliases}) {
+      start = std::chrono::steady_clock::now();
+      for (int i = 0; i < node_num; ++i) {
+        (*samplers)[i]->sample_k_to(k, rng, batch.data() + i * k);
+      }
+      double seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+      LOG(INFO) << (samplers == &trees ? "tree" : "alias") << " pass " << pass
+                << " over " << node_num << " nodes of degree " << node_degree
+                << ": " << node_num / seconds << " nodes/s";
+    }
+  }
+  LOG(INFO) << "checksum " << checksum;
+}
+
+}  // namespace paddle::distributed
@@ -0,0 +1,164 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <malloc.h>
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/common_graph_table.h"
+
+namespace paddle::distributed {
+
+// Adds num_nodes nodes with random degrees in [0, 2 * avg_degree] to shard,
+// the same graph for the same seed.
+static void BuildShard(GraphShard *shard,
+                       size_t num_nodes,
+                       int avg_degree,
+                       bool is_weighted,
+                       const std::string &sample_type,
+                       uint64_t seed) {
+  std::mt19937_64 engine(seed);
+  std::uniform_int_distribution<int> degree_dist(0, 2 * avg_degree);
+  std::uniform_real_distribution<float> weight_dist(0.1, 2.0);
+  for (size_t i = 0; i < num_nodes; ++i) {
+    GraphNode *node = shard->add_graph_node(i);
+    node->build_edges(is_weighted);
+    int degree = degree_dist(engine);
+    for (int j = 0; j < degree; ++j) {
+      node->add_edge(engine() % num_nodes, weight_dist(engine));
+    }
+    node->build_sampler(sample_type);
+  }
+}
+
+static std::vector<std::vector<uint64_t>> Neighbors(GraphShard *shard) {
+  std::vector<std::vector<uint64_t>> res;
+  for (auto *node : shard->get_bucket()) {
+    res.emplace_back();
+    for (size_t i = 0; i < node->get_neighbor_size(); ++i) {
+      res.back().push_back(node->get_neighbor_id(i));
+    }
+  }
+  return res;
+}
+
+static size_t HeapBytes() {
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+  return mallinfo2().uordblks;
+#else
+  return mallinfo().uordblks;
+#endif
+}
+
+TEST(GraphCsr, FinalizeKeepsEdges) {
+  for (bool is_weighted : {false, true}) {
+    GraphShard shard;
+    BuildShard(&shard, 1000, 8, is_weighted, "random", 0);
+    auto expect = Neighbors(&shard);
+    ASSERT_GT(shard.finalize_edges(), 0u);
+    ASSERT_EQ(shard.csr_blocks.size(), 1u);
+    ASSERT_EQ(Neighbors(&shard), expect);
+
+    auto rng = std::make_shared<std::mt19937_64>(0);
+    for (auto *node : shard.get_bucket()) {
+      size_t size = node->get_neighbor_size();
+      ASSERT_NE(node->get_neighbor_ids(), nullptr);
+      std::vector<int> res = node->sample_k(5, rng);
+      ASSERT_EQ(res.size(), std::min<size_t>(5, size));
+      std::set<int> distinct(res.begin(), res.end());
+      ASSERT_EQ(distinct.size(), res.size());
+      for (int x : res) {
+        ASSERT_GE(x, 0);
+        ASSERT_LT(x, static_cast<int>(size));
+      }
+    }
+
+    // adding edges to a frozen node moves it back to a blob
+    GraphNode *node = shard.add_graph_node(7);
+    node->build_edges(is_weighted);
+    node->add_edge(12345, 1.0);
+    expect[7].push_back(12345);
+    ASSERT_EQ(node->get_neighbor_ids(), nullptr);
+    ASSERT_EQ(Neighbors(&shard), expect);
+    ASSERT_EQ(node->sample_k(1000, rng).size(), expect[7].size());
+
+    // finalizing again packs all nodes into a new block
+    shard.finalize_edges();
+    ASSERT_EQ(shard.csr_blocks.size(), 1u);
+    ASSERT_EQ(Neighbors(&shard), expect);
+  }
+}
+
+TEST(GraphCsr, WeightedSampleK) {
+  std::vector<float> weights = {1, 0, 3};
+  auto rng = std::make_shared<std::mt19937_64>(0);
+  std::vector<int> count(weights.size(), 0);
+  const int trials = 40000;
+  for (int i = 0; i < trials; ++i) {
+    std::vector<int> res = weighted_sample_k(weights.data(), 3, 1, rng);
+    ASSERT_EQ(res.size(), 1u);
+    ++count[res[0]];
+  }
+  ASSERT_EQ(count[1], 0);
+  ASSERT_NEAR(static_cast<double>(count[2]) / trials, 0.75, 0.02);
+  // all neighbors are returned when k is not smaller than the degree
+  ASSERT_EQ(weighted_sample_k(weights.data(), 3, 3, rng).size(), 3u);
+}
+
+// Heap bytes and sampling throughput of a shard with 1M nodes of average
+// degree 8, in blobs and after finalize_edges.
+TEST(GraphCsr, BENCHMARK_MemoryAndSampling) {
+  const size_t num_nodes = 1000000;
+  const int sample_size = 5;
+  for (bool finalize : {false, true}) {
+    size_t heap_before = HeapBytes();
+    GraphShard shard;
+    BuildShard(&shard, num_nodes, 8, false, "random", 0);
+    size_t edge_num = 0;
+    for (auto *node : shard.get_bucket()) {
+      edge_num += node->get_neighbor_size();
+    }
+    if (finalize) {
+      ASSERT_EQ(shard.finalize_edges(), edge_num);
+    }
+    size_t heap_bytes = HeapBytes() - heap_before;
+
+    auto rng = std::make_shared<std::mt19937_64>(0);
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto *node : shard.get_bucket()) {
+      const int64_t *ids = node->get_neighbor_ids();
+      for (int x : node->sample_k(sample_size, rng)) {
+        checksum += ids != nullptr ? ids[x] : node->get_neighbor_id(x);
+      }
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    LOG(INFO) << (finalize ? "csr" : "blob") << " edges: " << edge_num
+              << " heap: " << heap_bytes / (1 << 20) << " MB ("
+              << static_cast<double>(heap_bytes) / num_nodes
+              << " B/node), sample_k(" << sample_size
+              << "): " << num_nodes / seconds << " nodes/s, checksum "
+              << checksum;
+  }
+}
+
+}  // namespace paddle::distributed
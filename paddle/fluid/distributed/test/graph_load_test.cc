@@ -0,0 +1,132 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/distributed/ps/table/common_graph_table.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_file_reader.h"
+
+COMMON_DECLARE_bool(graph_load_with_mmap);
+
+namespace paddle::distributed {
+
+static std::unique_ptr<GraphTable> MakeGraphTable() {
+  GraphParameter table_proto;
+  table_proto.set_task_pool_size(4);
+  table_proto.set_shard_num(16);
+  table_proto.add_node_types("user");
+  table_proto.add_graph_feature();
+  table_proto.add_edge_types("user2user");
+  std::unique_ptr<GraphTable> graph_table(new GraphTable());
+  graph_table->Initialize(table_proto);
+  return graph_table;
+}
+
+// Writes edge_num random edges from node_num nodes, the last line without a
+// newline, and returns the file size.
+static size_t WriteEdgeFile(const std::string &path,
+                            size_t node_num,
+                            size_t edge_num) {
+  std::ofstream file(path);
+  std::mt19937_64 engine(0);
+  for (size_t i = 0; i < edge_num; ++i) {
+    file << engine() % node_num << "\t" << engine() % 1000000000000ULL << "\t"
+         << (engine() % 100) / 10.0;
+    if (i + 1 < edge_num) file << "\n";
+  }
+  return file.tellp();
+}
+
+TEST(GraphFileReader, SplitTextChunks) {
+  std::string data = "1\t2\n33\t4\n555\t6\n7\t8";
+  for (size_t chunk_size : {1, 3, 5, 100}) {
+    auto chunks = split_text_chunks(data.data(), data.size(), chunk_size);
+    size_t begin = 0;
+    for (auto &chunk : chunks) {
+      ASSERT_EQ(chunk.first, begin);
+      ASSERT_TRUE(chunk.first == 0 || data[chunk.first - 1] == '\n');
+      begin = chunk.second;
+    }
+    ASSERT_EQ(begin, data.size());
+  }
+}
+
+TEST(GraphLoad, MmapMatchesIfstream) {
+  std::string edge_path = "graph_load_test_edges.txt";
+  WriteEdgeFile(edge_path, 1000, 100000);
+  std::string node_path = "graph_load_test_nodes.txt";
+  {
+    std::ofstream file(node_path);
+    for (int i = 0; i < 1000; ++i) {
+      file << (i % 3 == 0 ? "item" : "user") << "\t" << i << "\n";
+    }
+  }
+
+  std::vector<std::unique_ptr<GraphTable>> tables;
+  for (bool with_mmap : {false, true}) {
+    FLAGS_graph_load_with_mmap = with_mmap;
+    tables.push_back(MakeGraphTable());
+    auto res = tables.back()->load_edges(edge_path, false, "user2user", true);
+    ASSERT_EQ(res.second, 100000u);
+    ASSERT_EQ(tables.back()->load_nodes(node_path, "user", false), 0);
+  }
+  FLAGS_graph_load_with_mmap = false;
+
+  for (uint64_t id = 0; id < 1000; ++id) {
+    Node *expect = tables[0]->find_node(GraphTableType::EDGE_TABLE, 0, id);
+    Node *node = tables[1]->find_node(GraphTableType::EDGE_TABLE, 0, id);
+    ASSERT_EQ(expect == nullptr, node == nullptr);
+    if (node != nullptr) {
+      ASSERT_EQ(node->get_neighbor_size(), expect->get_neighbor_size());
+      for (size_t i = 0; i < node->get_neighbor_size(); ++i) {
+        ASSERT_EQ(node->get_neighbor_id(i), expect->get_neighbor_id(i));
+      }
+    }
+    ASSERT_EQ(tables[1]->find_node(GraphTableType::NODE_TABLE, 0, id) !=
+                  nullptr,
+              id % 3 != 0);
+  }
+  std::remove(edge_path.c_str());
+  std::remove(node_path.c_str());
+}
+
+// Loads 20M edges of 2M nodes with the line by line parser and with mmap.
+TEST(GraphLoad, BENCHMARK_LoadEdges) {
+  std::string edge_path = "graph_load_bench_edges.txt";
+  size_t bytes = WriteEdgeFile(edge_path, 2000000, 20000000);
+  for (bool with_mmap : {false, true}) {
+    FLAGS_graph_load_with_mmap = with_mmap;
+    auto graph_table = MakeGraphTable();
+    auto start = std::chrono::steady_clock::now();
+    auto res = graph_table->load_edges(edge_path, false, "user2user", true);
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    LOG(INFO) << (with_mmap ? "mmap" : "ifstream") << " loads " << res.second
+              << " edges: " << bytes / seconds / (1 << 30) << " GB/s";
+  }
+  FLAGS_graph_load_with_mmap = false;
+  std::remove(edge_path.c_str());
+}
+
+}  // namespace paddle::distributed
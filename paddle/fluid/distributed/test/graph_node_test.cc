@@ -645,8 +645,8 @@ void RunBrpcPushSparse() {
 }
 
 /*void testCache() {
-  ::paddle::distributed::ScaledLRU<::paddle::distributed::SampleKey,
-                                   ::paddle::distributed::SampleResult>
+  ::paddle::distributed::SampleResultCache<::paddle::distributed::SampleKey,
+                                           ::paddle::distributed::SampleResult>
       st(1, 2, 4);
   char* str = new char[7];
   strcpy(str, "54321");
@@ -656,26 +656,26 @@ void RunBrpcPushSparse() {
   std::vector<std::pair<::paddle::distributed::SampleKey,
                         paddle::distributed::SampleResult>>
       r;
-  st.query(0, &skey, 1, r);
+  st.query(&skey, 1, &r);
   ASSERT_EQ((int)r.size(), 0);
 
-  st.insert(0, &skey, result, 1);
+  st.insert(&skey, result, 1);
   for (size_t i = 0; i < st.get_ttl(); i++) {
-    st.query(0, &skey, 1, r);
+    st.query(&skey, 1, &r);
     ASSERT_EQ((int)r.size(), 1);
     char* p = (char*)r[0].second.buffer.get();
     for (size_t j = 0; j < r[0].second.actual_size; j++)
       ASSERT_EQ(p[j], str[j]);
     r.clear();
   }
-  st.query(0, &skey, 1, r);
+  st.query(&skey, 1, &r);
   ASSERT_EQ((int)r.size(), 0);
   str = new char[10];
   strcpy(str, "54321678");
   result = new ::paddle::distributed::SampleResult(strlen(str), str);
-  st.insert(0, &skey, result, 1);
+  st.insert(&skey, result, 1);
   for (size_t i = 0; i < st.get_ttl() / 2; i++) {
-    st.query(0, &skey, 1, r);
+    st.query(&skey, 1, &r);
     ASSERT_EQ((int)r.size(), 1);
     char* p = (char*)r[0].second.buffer.get();
     for (size_t j = 0; j < r[0].second.actual_size; j++)
@@ -685,16 +685,16 @@ void RunBrpcPushSparse() {
   str = new char[18];
   strcpy(str, "343332d4321");
   result = new ::paddle::distributed::SampleResult(strlen(str), str);
-  st.insert(0, &skey, result, 1);
+  st.insert(&skey, result, 1);
   for (size_t i = 0; i < st.get_ttl(); i++) {
-    st.query(0, &skey, 1, r);
+    st.query(&skey, 1, &r);
     ASSERT_EQ((int)r.size(), 1);
     char* p = (char*)r[0].second.buffer.get();
     for (int j = 0; j < (int)r[0].second.actual_size; j++)
       ASSERT_EQ(p[j], str[j]);
     r.clear();
   }
-  st.query(0, &skey, 1, r);
+  st.query(&skey, 1, &r);
   ASSERT_EQ((int)r.size(), 0);
 }*/
 void testGraphToBuffer() {
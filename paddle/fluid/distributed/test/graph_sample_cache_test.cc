@@ -0,0 +1,196 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/table/graph/sample_result_cache.h"
+
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+namespace paddle::distributed {
+
+struct TestSample {
+  size_t actual_size;
+  uint64_t value;
+};
+
+TEST(SampleResultCache, Ttl) {
+  SampleResultCache<uint64_t, TestSample> cache(4, 100, 3);
+  uint64_t key = 6;
+  std::vector<std::pair<uint64_t, TestSample>> res;
+  cache.query(&key, 1, &res);
+  ASSERT_TRUE(res.empty());
+
+  TestSample sample = {5, 54321};
+  cache.insert(&key, &sample, 1);
+  for (size_t i = 0; i < cache.get_ttl(); ++i) {
+    res.clear();
+    cache.query(&key, 1, &res);
+    ASSERT_EQ(res.size(), 1u);
+    ASSERT_EQ(res[0].second.value, 54321u);
+  }
+  res.clear();
+  cache.query(&key, 1, &res);
+  ASSERT_TRUE(res.empty());
+
+  // inserting again refreshes the value and the ttl
+  sample = {8, 5432167};
+  cache.insert(&key, &sample, 1);
+  res.clear();
+  cache.query(&key, 1, &res);
+  ASSERT_EQ(res.size(), 1u);
+  ASSERT_EQ(res[0].second.value, 5432167u);
+
+  SampleCacheStat stat = cache.get_stat();
+  ASSERT_EQ(stat.hit, 4u);
+  ASSERT_EQ(stat.miss, 2u);
+  ASSERT_EQ(stat.entry_num, 1u);
+  LOG(INFO) << stat.to_string();
+}
+
+TEST(SampleResultCache, Limits) {
+  const size_t size_limit = 64;
+  SampleResultCache<uint64_t, TestSample> cache(1, size_limit, 100);
+  std::vector<uint64_t> keys(1000);
+  std::vector<TestSample> samples(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = i;
+    samples[i] = {16, i};
+  }
+  cache.insert(keys.data(), samples.data(), keys.size());
+  SampleCacheStat stat = cache.get_stat();
+  ASSERT_EQ(stat.entry_num, size_limit);
+  ASSERT_EQ(stat.evict, keys.size() - size_limit);
+
+  // the referenced keys survive the next round of evictions
+  std::vector<uint64_t> hot(keys.end() - 8, keys.end());
+  std::vector<std::pair<uint64_t, TestSample>> res;
+  cache.query(hot.data(), hot.size(), &res);
+  ASSERT_EQ(res.size(), hot.size());
+  for (int round = 0; round < 4; ++round) {
+    cache.insert(keys.data() + round * 16, samples.data(), 16);
+    res.clear();
+    cache.query(hot.data(), hot.size(), &res);
+    ASSERT_EQ(res.size(), hot.size());
+  }
+
+  // entries whose ttl ran out go first and count as expired
+  SampleResultCache<uint64_t, TestSample> expiring(1, 2, 1);
+  expiring.insert(keys.data(), samples.data(), 2);
+  expiring.query(keys.data(), 1, &res);
+  expiring.query(keys.data(), 1, &res);
+  expiring.insert(keys.data() + 2, samples.data() + 2, 1);
+  stat = expiring.get_stat();
+  ASSERT_EQ(stat.expire, 1u);
+  ASSERT_EQ(stat.evict, 0u);
+
+  // the byte limit holds entries of large samples to fewer
+  SampleResultCache<uint64_t, TestSample> bytes_limited(
+      1, size_limit, 100, 10 * 1024);
+  for (auto &sample : samples) {
+    sample.actual_size = 1024;
+  }
+  bytes_limited.insert(keys.data(), samples.data(), keys.size());
+  stat = bytes_limited.get_stat();
+  ASSERT_LE(stat.bytes, 10 * 1024u);
+  ASSERT_GT(stat.entry_num, 0u);
+  ASSERT_LT(stat.entry_num, 10u);
+}
+
+TEST(SampleResultCache, Concurrent) {
+  SampleResultCache<uint64_t, TestSample> cache(16, 1000, 5);
+  const int thread_num = 8;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&cache, t]() {
+      std::mt19937_64 engine(t);
+      std::vector<uint64_t> keys(32);
+      std::vector<TestSample> samples(keys.size());
+      std::vector<std::pair<uint64_t, TestSample>> res;
+      for (int i = 0; i < 2000; ++i) {
+        for (size_t j = 0; j < keys.size(); ++j) {
+          keys[j] = engine() % 5000;
+          samples[j] = {keys[j] % 64, keys[j] * 3};
+        }
+        res.clear();
+        cache.query(keys.data(), keys.size(), &res);
+        for (auto &item : res) {
+          ASSERT_EQ(item.second.value, item.first * 3);
+        }
+        cache.insert(keys.data(), samples.data(), keys.size());
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  SampleCacheStat stat = cache.get_stat();
+  ASSERT_EQ(stat.hit + stat.miss, thread_num * 2000u * 32);
+  ASSERT_LE(stat.entry_num, 1000u);
+  LOG(INFO) << stat.to_string();
+}
+
+// Queries of 8 threads over a working set of 100k keys, a hot tenth of the
+// keys gets nine tenths of the lookups.
+TEST(SampleResultCache, BENCHMARK_ConcurrentQuery) {
+  const uint64_t key_num = 100000;
+  SampleResultCache<uint64_t, TestSample> cache(64, key_num / 2, 10);
+  const int thread_num = 8;
+  const int batch_num = 2000;
+  const size_t batch_size = 256;
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&cache, t]() {
+      std::mt19937_64 engine(t);
+      std::vector<uint64_t> keys(batch_size);
+      std::vector<TestSample> samples(batch_size);
+      std::vector<std::pair<uint64_t, TestSample>> res;
+      for (int i = 0; i < batch_num; ++i) {
+        for (auto &key : keys) {
+          key = engine() % 10 == 0 ? engine() % key_num
+                                   : engine() % (key_num / 10);
+        }
+        res.clear();
+        cache.query(keys.data(), keys.size(), &res);
+        std::vector<uint64_t> missed;
+        size_t index = 0;
+        for (auto key : keys) {
+          if (index < res.size() && res[index].first == key) {
+            ++index;
+          } else {
+            missed.push_back(key);
+          }
+        }
+        samples.resize(missed.size(), TestSample{40, 0});
+        cache.insert(missed.data(), samples.data(), missed.size());
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  LOG(INFO) << thread_num << " threads: "
+            << thread_num * batch_num * batch_size / seconds
+            << " lookups/s, " << cache.get_stat().to_string();
+}
+
+}  // namespace paddle::distributed
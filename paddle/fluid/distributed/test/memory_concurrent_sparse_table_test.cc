@@ -0,0 +1,186 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/table/memory_concurrent_sparse_table.h"
+
+#include <ThreadPool.h>
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/memory_sparse_table.h"
+#include "paddle/fluid/distributed/ps/table/table.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+
+namespace paddle::distributed {
+
+static const int kEmbDim = 8;
+
+static TableParameter MakeTableConfig(const std::string &table_class) {
+  TableParameter table_config;
+  table_config.set_table_class(table_class);
+  table_config.set_shard_num(10);
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(kEmbDim);
+  accessor_config->set_embedx_threshold(5);
+  accessor_config->mutable_ctr_accessor_param()->set_nonclk_coeff(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_click_coeff(1);
+  accessor_config->mutable_ctr_accessor_param()->set_base_threshold(0.5);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_threshold(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_keep_days(16);
+  accessor_config->mutable_ctr_accessor_param()->set_show_click_decay_rate(
+      0.99);
+  for (auto *sgd_param : {accessor_config->mutable_embed_sgd_param(),
+                          accessor_config->mutable_embedx_sgd_param()}) {
+    sgd_param->set_name("SparseNaiveSGDRule");
+    auto *naive_param = sgd_param->mutable_naive();
+    naive_param->set_learning_rate(0.1);
+    // zero init range keeps both tables deterministic
+    naive_param->set_initial_range(0.0);
+    naive_param->add_weight_bounds(-10.0);
+    naive_param->add_weight_bounds(10.0);
+  }
+  return table_config;
+}
+
+static Table *CreateTable(Table *table, const std::string &table_class) {
+  FsClientParameter fs_config;
+  table->SetShard(0, 1);
+  EXPECT_EQ(table->Initialize(MakeTableConfig(table_class), fs_config), 0);
+  return table;
+}
+
+static void PullValues(Table *table,
+                       const std::vector<uint64_t> &keys,
+                       std::vector<float> *values) {
+  std::vector<uint32_t> fres(keys.size(), 1);
+  values->resize(keys.size() * (kEmbDim + 3));
+  TableContext table_context;
+  table_context.value_type = Sparse;
+  table_context.pull_context.pull_value = PullSparseValue(keys, fres, kEmbDim);
+  table_context.pull_context.values = values->data();
+  table->Pull(table_context);
+}
+
+static void PushGradients(Table *table,
+                          const std::vector<uint64_t> &keys,
+                          const std::vector<float> &gradients) {
+  TableContext table_context;
+  table_context.value_type = Sparse;
+  table_context.push_context.keys = keys.data();
+  table_context.push_context.values = gradients.data();
+  table_context.num = keys.size();
+  table->Push(table_context);
+}
+
+TEST(MemoryConcurrentSparseTable, SameResultAsMemorySparseTable) {
+  std::unique_ptr<Table> base_table(
+      CreateTable(new MemorySparseTable(), "MemorySparseTable"));
+  std::unique_ptr<Table> table(CreateTable(new MemoryConcurrentSparseTable(),
+                                           "MemoryConcurrentSparseTable"));
+
+  std::vector<uint64_t> keys;
+  for (uint64_t key = 0; key < 1000; ++key) {
+    keys.push_back(key);
+  }
+  std::vector<float> gradients;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    gradients.push_back(0);                  // slot
+    gradients.push_back(1);                  // show
+    gradients.push_back(i % 2);              // click
+    for (int k = 0; k < kEmbDim + 1; ++k) {  // embed_g, embedx_g
+      gradients.push_back(0.01 * (k + 1));
+    }
+  }
+
+  const int trainers = 4;
+  for (Table *t : {base_table.get(), table.get()}) {
+    ::ThreadPool pool(trainers);
+    std::vector<std::future<void>> task_status;
+    for (int i = 0; i < trainers; i++) {
+      task_status.push_back(pool.enqueue(
+          [t, &keys, &gradients] { PushGradients(t, keys, gradients); }));
+    }
+    for (auto &status : task_status) {
+      status.wait();
+    }
+  }
+
+  std::vector<float> base_values;
+  std::vector<float> values;
+  PullValues(base_table.get(), keys, &base_values);
+  PullValues(table.get(), keys, &values);
+  ASSERT_EQ(base_values.size(), values.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    ASSERT_NEAR(base_values[i], values[i], 1e-5);
+  }
+  ASSERT_EQ(base_table->PrintTableStat(), table->PrintTableStat());
+
+  table->Shrink("0");
+  table->Clear();
+  ASSERT_EQ(table->PrintTableStat().first, 0);
+}
+
+// Reports pull/push QPS of both table classes as the number of concurrent
+// client threads grows.
+TEST(MemoryConcurrentSparseTable, BENCHMARK_PullPushQPS) {
+  const size_t key_num_per_request = 1024;
+  const int request_num_per_thread = 50;
+  for (const std::string table_class :
+       {"MemorySparseTable", "MemoryConcurrentSparseTable"}) {
+    for (int thread_num : {1, 2, 4, 8, 16}) {
+      std::unique_ptr<Table> table(
+          table_class == "MemorySparseTable"
+              ? CreateTable(new MemorySparseTable(), table_class)
+              : CreateTable(new MemoryConcurrentSparseTable(), table_class));
+      std::vector<std::vector<uint64_t>> keys(thread_num);
+      for (int t = 0; t < thread_num; ++t) {
+        for (size_t i = 0; i < key_num_per_request; ++i) {
+          keys[t].push_back(t * key_num_per_request + i);
+        }
+      }
+      std::vector<float> gradients(key_num_per_request * (kEmbDim + 4), 0.01);
+
+      ::ThreadPool pool(thread_num);
+      std::vector<std::future<void>> task_status;
+      auto start = std::chrono::steady_clock::now();
+      for (int t = 0; t < thread_num; ++t) {
+        task_status.push_back(pool.enqueue([&, t] {
+          std::vector<float> values;
+          for (int r = 0; r < request_num_per_thread; ++r) {
+            PullValues(table.get(), keys[t], &values);
+            PushGradients(table.get(), keys[t], gradients);
+          }
+        }));
+      }
+      for (auto &status : task_status) {
+        status.wait();
+      }
+      double seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+      double qps = thread_num * request_num_per_thread * key_num_per_request /
+                   seconds;
+      LOG(INFO) << table_class << " threads: " << thread_num
+                << " pull+push keys/s: " << qps;
+    }
+  }
+}
+
+}  // namespace paddle::distributed
@@ -17,11 +17,16 @@ limitations under the License. */
 #include <ThreadPool.h>
 #include <unistd.h>
 
+#include <chrono>  // NOLINT
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <string>
 #include <thread>  // NOLINT
 
 #include "google/protobuf/text_format.h"
 #include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/depends/sparse_binary_file.h"
 #include "paddle/fluid/distributed/ps/table/table.h"
 #include "paddle/fluid/distributed/the_one_ps.pb.h"
 
@@ -151,4 +156,239 @@ TEST(MemorySparseTable, SGD) {
   }
 }
 
+static Table *CreateSaveLoadTable(bool binary_in_save,
+                                  bool enable_delta_save = false) {
+  TableParameter table_config;
+  table_config.set_table_class("MemorySparseTable");
+  table_config.set_shard_num(10);
+  table_config.set_table_id(0);
+  table_config.set_compress_in_save(false);
+  table_config.set_enable_sparse_table_cache(false);
+  table_config.set_binary_in_save(binary_in_save);
+  table_config.set_enable_delta_save(enable_delta_save);
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(8);
+  accessor_config->set_embedx_threshold(0);
+  for (auto *sgd_param : {accessor_config->mutable_embed_sgd_param(),
+                          accessor_config->mutable_embedx_sgd_param()}) {
+    sgd_param->set_name("SparseAdaGradSGDRule");
+    sgd_param->mutable_adagrad()->set_learning_rate(0.05);
+    sgd_param->mutable_adagrad()->set_initial_g2sum(3.0);
+    sgd_param->mutable_adagrad()->set_initial_range(0.0001);
+    sgd_param->mutable_adagrad()->add_weight_bounds(-10.0);
+    sgd_param->mutable_adagrad()->add_weight_bounds(10.0);
+  }
+  FsClientParameter fs_config;
+  Table *table = new MemorySparseTable();
+  table->SetShard(0, 1);
+  EXPECT_EQ(table->Initialize(table_config, fs_config), 0);
+  return table;
+}
+
+static void PullAll(Table *table,
+                    std::vector<uint64_t> &keys,  // NOLINT
+                    std::vector<float> *values) {
+  std::vector<uint32_t> fres(keys.size(), 1);
+  values->assign(keys.size() * 9, 0);
+  TableContext table_context;
+  table_context.value_type = Sparse;
+  table_context.pull_context.pull_value = PullSparseValue(keys, fres, 8);
+  table_context.pull_context.values = values->data();
+  table->Pull(table_context);
+}
+
+// Creates a directory of its own under the gtest temp dir, so that tests
+// running in parallel do not share their checkpoints, and removes it when
+// it goes away.
+class TestDir {
+ public:
+  explicit TestDir(const std::string &name) {
+    std::string path = ::testing::TempDir() + name + "_XXXXXX";
+    PADDLE_ENFORCE_NOT_NULL(
+        mkdtemp(path.data()),
+        common::errors::Unavailable("Failed to create %s.", path));
+    _path = path;
+  }
+  ~TestDir() {
+    std::error_code ec;
+    std::filesystem::remove_all(_path, ec);
+  }
+  std::string Sub(const std::string &name) const { return _path + "/" + name; }
+
+ private:
+  std::string _path;
+};
+
+TEST(MemorySparseTable, SaveLoadBinary) {
+  const size_t key_num = 200000;
+  std::unique_ptr<Table> table(CreateSaveLoadTable(true));
+  std::vector<uint64_t> keys(key_num);
+  std::vector<float> gradients;
+  for (size_t i = 0; i < key_num; ++i) {
+    keys[i] = i * 7919;
+    float grad[12] = {0, 1, static_cast<float>(i % 2), 0.1, 0.2, 0.3};
+    gradients.insert(gradients.end(), grad, grad + 12);
+  }
+  TableContext push_context;
+  push_context.value_type = Sparse;
+  push_context.push_context.keys = keys.data();
+  push_context.push_context.values = gradients.data();
+  push_context.num = keys.size();
+  table->Push(push_context);
+  std::vector<float> expect_values;
+  PullAll(table.get(), keys, &expect_values);
+
+  TestDir temp_dir("memory_sparse_table_test_binary");
+  const std::string binary_dir = temp_dir.Sub("binary");
+  const std::string text_dir = temp_dir.Sub("text");
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_EQ(table->Save(binary_dir, "0"), 0);
+  auto binary_save_time = std::chrono::steady_clock::now() - start;
+
+  std::unique_ptr<Table> text_table(CreateSaveLoadTable(false));
+  text_table->Push(push_context);
+  start = std::chrono::steady_clock::now();
+  ASSERT_EQ(text_table->Save(text_dir, "0"), 0);
+  auto text_save_time = std::chrono::steady_clock::now() - start;
+
+  std::unique_ptr<Table> loaded_table(CreateSaveLoadTable(true));
+  start = std::chrono::steady_clock::now();
+  ASSERT_EQ(loaded_table->Load(binary_dir, "0"), 0);
+  auto binary_load_time = std::chrono::steady_clock::now() - start;
+
+  std::unique_ptr<Table> text_loaded_table(CreateSaveLoadTable(false));
+  start = std::chrono::steady_clock::now();
+  ASSERT_EQ(text_loaded_table->Load(text_dir, "0"), 0);
+  auto text_load_time = std::chrono::steady_clock::now() - start;
+
+  auto ms = [](std::chrono::steady_clock::duration d) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+  };
+  LOG(INFO) << "save " << key_num << " keys, text: " << ms(text_save_time)
+            << "ms binary: " << ms(binary_save_time) << "ms";
+  LOG(INFO) << "load " << key_num << " keys, text: " << ms(text_load_time)
+            << "ms binary: " << ms(binary_load_time) << "ms";
+
+  // binary keeps values bit for bit
+  std::vector<float> loaded_values;
+  PullAll(loaded_table.get(), keys, &loaded_values);
+  ASSERT_EQ(expect_values, loaded_values);
+  ASSERT_EQ(table->PrintTableStat(), loaded_table->PrintTableStat());
+
+  // converting to text and back keeps every record
+  auto accessor = table->GetValueAccessor();
+  AfsClient afs_client;
+  ASSERT_EQ(afs_client.initialize(FsClientParameter()), 0);
+  std::string binary_file = binary_dir + "/000/part-000-00000.bin";
+  std::string text_file = binary_dir + "/part-000-00000.txt";
+  std::string converted_file = binary_dir + "/part-000-00000.converted.bin";
+  int64_t record_num = ConvertSparseBinaryToText(
+      accessor.get(), &afs_client, binary_file, text_file);
+  ASSERT_GT(record_num, 0);
+  ASSERT_EQ(ConvertSparseTextToBinary(
+                accessor.get(), &afs_client, text_file, converted_file),
+            record_num);
+}
+
+static void PushAll(Table *table, const std::vector<uint64_t> &keys) {
+  std::vector<float> gradients;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    float grad[12] = {0, 1, static_cast<float>(i % 2), 0.1, 0.2, 0.3};
+    gradients.insert(gradients.end(), grad, grad + 12);
+  }
+  TableContext push_context;
+  push_context.value_type = Sparse;
+  push_context.push_context.keys = keys.data();
+  push_context.push_context.values = gradients.data();
+  push_context.num = keys.size();
+  table->Push(push_context);
+}
+
+static size_t CountDeltaLines(const std::string &dir) {
+  size_t line_num = 0;
+  for (int i = 0; i < 10; ++i) {
+    std::ifstream file(::paddle::string::format_string(
+        "%s/000/delta-000-%05d", dir.c_str(), i));
+    std::string line;
+    while (std::getline(file, line)) {
+      ++line_num;
+    }
+  }
+  return line_num;
+}
+
+TEST(MemorySparseTable, SaveLoadDelta) {
+  std::unique_ptr<Table> table(CreateSaveLoadTable(false, true));
+  std::vector<uint64_t> keys(10000);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = i;
+  }
+  PushAll(table.get(), keys);
+  TestDir temp_dir("memory_sparse_table_test_delta");
+  const std::string base_dir = temp_dir.Sub("base");
+  ASSERT_EQ(table->Save(base_dir, "0"), 0);
+
+  // only the pushed keys go to the delta
+  std::vector<uint64_t> changed_keys = {1, 2, 3, 20000, 20001};
+  PushAll(table.get(), changed_keys);
+  const std::string delta_dir_1 = temp_dir.Sub("delta_1");
+  ASSERT_EQ(table->Save(delta_dir_1, "8"), 0);
+  ASSERT_EQ(CountDeltaLines(delta_dir_1), changed_keys.size());
+
+  changed_keys = {3, 4, 30000};
+  PushAll(table.get(), changed_keys);
+  const std::string delta_dir_2 = temp_dir.Sub("delta_2");
+  ASSERT_EQ(table->Save(delta_dir_2, "8"), 0);
+  ASSERT_EQ(CountDeltaLines(delta_dir_2), changed_keys.size());
+
+  std::unique_ptr<Table> loaded_table(CreateSaveLoadTable(false, true));
+  ASSERT_EQ(loaded_table->Load(base_dir, "0"), 0);
+  ASSERT_EQ(loaded_table->Load(delta_dir_1, "8"), 0);
+  ASSERT_EQ(loaded_table->Load(delta_dir_2, "8"), 0);
+  ASSERT_EQ(table->PrintTableStat(), loaded_table->PrintTableStat());
+  for (auto key : {20000, 20001, 30000}) {
+    keys.push_back(key);
+  }
+  std::vector<float> expect_values;
+  std::vector<float> loaded_values;
+  PullAll(table.get(), keys, &expect_values);
+  PullAll(loaded_table.get(), keys, &loaded_values);
+  ASSERT_EQ(expect_values.size(), loaded_values.size());
+  for (size_t i = 0; i < expect_values.size(); ++i) {
+    ASSERT_NEAR(expect_values[i], loaded_values[i], 1e-5);
+  }
+}
+
+TEST(MemorySparseTable, PullIntoSelectValues) {
+  std::unique_ptr<Table> table(CreateSaveLoadTable(false));
+  std::vector<uint64_t> keys;
+  for (uint64_t key = 0; key < 1000; ++key) {
+    keys.push_back(key * 31);
+  }
+  PushAll(table.get(), keys);
+  PushAll(table.get(), keys);
+  std::vector<float> expect_values;
+  PullAll(table.get(), keys, &expect_values);
+
+  // every key is selected straight into its own row, in reversed order
+  std::vector<float> select_buffer(keys.size() * 9, 0);
+  std::vector<float *> select_values(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    select_values[i] = select_buffer.data() + (keys.size() - 1 - i) * 9;
+  }
+  std::vector<uint32_t> fres(keys.size(), 1);
+  TableContext table_context;
+  table_context.value_type = Sparse;
+  table_context.pull_context.pull_value = PullSparseValue(keys, fres, 8);
+  table_context.pull_context.select_values = select_values.data();
+  table->Pull(table_context);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    for (int j = 0; j < 9; ++j) {
+      ASSERT_FLOAT_EQ(select_values[i][j], expect_values[i * 9 + j]);
+    }
+  }
+}
+
 }  // namespace paddle::distributed
@@ -0,0 +1,170 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/table/depends/sparse_cache_policy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/depends/feature_value.h"
+
+namespace paddle::distributed {
+
+typedef SparseTableShard<uint64_t, FixedFeatureValue> shard_type;
+
+TEST(FrequencySketch, Estimate) {
+  FrequencySketch sketch(1024);
+  for (int i = 0; i < 5; ++i) {
+    sketch.Increment(1);
+  }
+  sketch.Increment(2);
+  ASSERT_GE(sketch.Estimate(1), 5u);
+  ASSERT_GE(sketch.Estimate(2), 1u);
+  ASSERT_LT(sketch.Estimate(2), sketch.Estimate(1));
+  for (int i = 0; i < 100; ++i) {
+    sketch.Increment(3);
+  }
+  // counters saturate at 15
+  ASSERT_EQ(sketch.Estimate(3), 15u);
+}
+
+TEST(SparseCachePolicy, EvictColdValues) {
+  const size_t capacity = 100;
+  SparseCachePolicy policy(capacity, 2);
+  shard_type shard;
+  std::unordered_map<uint64_t, float> ssd;
+  for (uint64_t key = 0; key < 200; ++key) {
+    // the first ten keys are hot
+    for (int i = 0; i < (key < 10 ? 8 : 1); ++i) {
+      policy.RecordAccess(key);
+    }
+    auto &value = shard[key];
+    value.resize(1);
+    value.data()[0] = key;
+  }
+  ASSERT_TRUE(policy.Admit(0));
+  size_t evicted = policy.Evict(
+      &shard,
+      [](FixedFeatureValue &value) { return 0.0; },
+      [&ssd](uint64_t key, FixedFeatureValue &value) {
+        ssd[key] = value.data()[0];
+      });
+  ASSERT_EQ(evicted, 100u);
+  ASSERT_EQ(shard.size(), capacity);
+  for (uint64_t key = 0; key < 10; ++key) {
+    ASSERT_TRUE(shard.find(key) != shard.end());
+  }
+  for (auto &item : ssd) {
+    ASSERT_EQ(item.second, static_cast<float>(item.first));
+  }
+}
+
+TEST(SparseCachePolicy, KeepPinnedValues) {
+  SparseCachePolicy policy(10, 1);
+  shard_type shard;
+  for (uint64_t key = 0; key < 100; ++key) {
+    shard[key].resize(1);
+  }
+  // all but 5 values are pinned, every call goes on where the last stopped
+  size_t evicted = 0;
+  for (int i = 0; i < 10; ++i) {
+    evicted += policy.Evict(
+        &shard,
+        [](FixedFeatureValue &value) { return 0.0; },
+        [](uint64_t key, FixedFeatureValue &value) {},
+        [](uint64_t key) { return key < 5; });
+  }
+  ASSERT_EQ(evicted, 5u);
+  ASSERT_EQ(shard.size(), 95u);
+  for (uint64_t key = 5; key < 100; ++key) {
+    ASSERT_TRUE(shard.find(key) != shard.end());
+  }
+}
+
+// Replays a Zipf distributed key stream against a memory tier of 5% of the
+// keys in front of a simulated ssd, and reports the memory hit rate and the
+// ssd reads and writes of several admission thresholds.
+TEST(SparseCachePolicy, BENCHMARK_ZipfReplay) {
+  const size_t key_num = 200000;
+  const size_t access_num = 2000000;
+  const size_t capacity = key_num / 20;
+  std::vector<double> cdf(key_num);
+  double sum = 0;
+  for (size_t i = 0; i < key_num; ++i) {
+    sum += 1.0 / std::pow(i + 1, 0.99);
+    cdf[i] = sum;
+  }
+  std::mt19937_64 engine(0);
+  std::uniform_real_distribution<double> uniform(0, sum);
+  std::vector<uint64_t> stream(access_num);
+  for (auto &key : stream) {
+    // scatter ranks so hot keys are not adjacent
+    uint64_t rank =
+        std::lower_bound(cdf.begin(), cdf.end(), uniform(engine)) - cdf.begin();
+    key = rank * 0x9E3779B97F4A7C15ULL;
+  }
+
+  for (uint32_t admit_threshold : {1, 2, 3}) {
+    SparseCachePolicy policy(capacity, admit_threshold);
+    shard_type shard;
+    std::unordered_map<uint64_t, float> ssd;
+    size_t mem_hit = 0;
+    size_t ssd_read = 0;
+    size_t ssd_write = 0;
+    for (auto key : stream) {
+      policy.RecordAccess(key);
+      auto it = shard.find(key);
+      if (it != shard.end()) {
+        ++mem_hit;
+        it.value().data()[0] += 1;
+      } else {
+        auto ssd_it = ssd.find(key);
+        float show = 1;
+        if (ssd_it != ssd.end()) {
+          ++ssd_read;
+          show += ssd_it->second;
+        }
+        if (policy.Admit(key)) {
+          auto &value = shard[key];
+          value.resize(1);
+          value.data()[0] = show;
+          if (ssd_it != ssd.end()) {
+            ssd.erase(ssd_it);
+          }
+        } else {
+          ssd[key] = show;
+          ++ssd_write;
+        }
+      }
+      policy.Evict(
+          &shard,
+          [](FixedFeatureValue &value) { return value.data()[0]; },
+          [&ssd, &ssd_write](uint64_t key, FixedFeatureValue &value) {
+            ssd[key] = value.data()[0];
+            ++ssd_write;
+          });
+    }
+    ASSERT_LE(shard.size(), capacity);
+    LOG(INFO) << "zipf replay admit_threshold: " << admit_threshold
+              << " mem_hit_rate: " << static_cast<double>(mem_hit) / access_num
+              << " ssd_read: " << ssd_read << " ssd_write: " << ssd_write;
+  }
+}
+
+}  // namespace paddle::distributed
@@ -0,0 +1,121 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/service/communicator/sparse_key_merger.h"
+
+#include <map>
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+namespace paddle::distributed {
+
+static void CheckMerge(SparseKeyMerger *merger,
+                       const std::vector<uint64_t> &keys,
+                       const std::vector<float> &values,
+                       size_t dim) {
+  std::map<uint64_t, std::vector<float>> expect;
+  merger->Reset(dim);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    merger->Append(keys[i], values.data() + i * dim);
+    auto &sum = expect[keys[i]];
+    sum.resize(dim, 0);
+    for (size_t j = 0; j < dim; ++j) {
+      sum[j] += values[i * dim + j];
+    }
+  }
+  merger->Merge();
+  ASSERT_EQ(merger->input_num(), keys.size());
+  ASSERT_EQ(merger->size(), expect.size());
+  size_t idx = 0;
+  for (auto &item : expect) {
+    ASSERT_EQ(merger->keys()[idx], item.first);
+    for (size_t j = 0; j < dim; ++j) {
+      ASSERT_FLOAT_EQ(merger->values()[idx][j], item.second[j]);
+    }
+    ++idx;
+  }
+}
+
+TEST(SparseKeyMerger, MergeSmallWindow) {
+  SparseKeyMerger merger;
+  std::vector<uint64_t> keys = {7, 3, 7, 1, 3, 7};
+  std::vector<float> values;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    values.push_back(i);
+    values.push_back(1);
+  }
+  CheckMerge(&merger, keys, values, 2);
+  ASSERT_EQ(merger.size(), 3u);
+  ASSERT_FLOAT_EQ(merger.values()[2][0], 0 + 2 + 5);
+  ASSERT_FLOAT_EQ(merger.values()[2][1], 3);
+}
+
+TEST(SparseKeyMerger, MergeLargeWindow) {
+  SparseKeyMerger merger;
+  std::mt19937_64 engine(0);
+  // the merger is reused by windows of different sizes and key ranges
+  for (uint64_t key_range : {1000ULL, 1ULL << 20, ~0ULL}) {
+    for (size_t num : {100, 5000, 20000}) {
+      std::uniform_int_distribution<uint64_t> dist(0, key_range);
+      std::vector<uint64_t> keys(num);
+      std::vector<float> values(num * 3);
+      for (size_t i = 0; i < num; ++i) {
+        keys[i] = dist(engine);
+        for (int j = 0; j < 3; ++j) {
+          values[i * 3 + j] = (i + j) % 7;
+        }
+      }
+      CheckMerge(&merger, keys, values, 3);
+    }
+  }
+}
+
+TEST(SparseKeyMerger, MergeWithHeader) {
+  SparseKeyMerger merger;
+  std::vector<uint64_t> keys = {5, 9, 5};
+  std::vector<float> grads = {1, 2, 3, 4, 5, 6};
+  merger.Reset(2);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    merger.Append(keys[i], grads.data() + i * 2);
+  }
+  merger.Merge(
+      3,
+      [](float *dst, const float *src) {
+        dst[0] = 2;
+        dst[1] = src[0];
+        dst[2] = src[1];
+      },
+      [](float *dst, const float *src) {
+        dst[1] += src[0];
+        dst[2] += src[1];
+      });
+  ASSERT_EQ(merger.size(), 2u);
+  std::vector<float> expect_5 = {2, 6, 8};
+  std::vector<float> expect_9 = {2, 3, 4};
+  for (int j = 0; j < 3; ++j) {
+    ASSERT_FLOAT_EQ(merger.values()[0][j], expect_5[j]);
+    ASSERT_FLOAT_EQ(merger.values()[1][j], expect_9[j]);
+  }
+
+  SparseMergeStat stat;
+  stat.Add(merger.input_num(), merger.size());
+  ASSERT_EQ(stat.input_num.load(), 3u);
+  ASSERT_EQ(stat.output_num.load(), 2u);
+  LOG(INFO) << stat.ToString();
+}
+
+}  // namespace paddle::distributed
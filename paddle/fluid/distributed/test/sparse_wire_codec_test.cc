@@ -0,0 +1,181 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/service/sparse_wire_codec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+namespace paddle::distributed {
+
+static std::vector<uint64_t> SortedKeys(size_t num) {
+  std::mt19937_64 engine(0);
+  std::vector<uint64_t> keys(num);
+  for (auto &key : keys) {
+    key = engine();
+  }
+  std::sort(keys.begin(), keys.end());
+  return keys;
+}
+
+TEST(SparseWireCodec, Header) {
+  SparseWireCodecParameter param;
+  param.set_value_type("int8");
+  param.set_delta_keys(true);
+  SparseWireCodec codec(param, param.push_exact_dim());
+  SparseWireCodec loaded;
+  ASSERT_TRUE(loaded.IsRaw());
+  ASSERT_EQ(loaded.Deserialize(codec.Serialize()), 0);
+  ASSERT_EQ(loaded.value_type(), SparseWireCodec::kInt8);
+  ASSERT_TRUE(loaded.delta_keys());
+  ASSERT_EQ(loaded.exact_dim(), 3u);
+  ASSERT_EQ(loaded.Deserialize("garbage"), -1);
+  SparseWireCodec::ValueType value_type;
+  ASSERT_EQ(SparseWireCodec::ParseValueType("fp8", &value_type), -1);
+}
+
+TEST(SparseWireCodec, KeysLoopback) {
+  auto keys = SortedKeys(10000);
+  // unsorted keys still decode, only less compact
+  std::vector<uint64_t> shuffled = keys;
+  std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937_64(1));
+  std::vector<uint32_t> counts(keys.size());
+  for (size_t i = 0; i < counts.size(); ++i) {
+    counts[i] = i % 3 == 0 ? 1 : i;
+  }
+  for (bool delta_keys : {false, true}) {
+    SparseWireCodec codec(SparseWireCodec::kRaw, delta_keys, 0);
+    for (auto *input : {&keys, &shuffled}) {
+      std::string data;
+      codec.EncodeKeys(input->data(), input->size(), &data);
+      codec.EncodeCounts(counts.data(), counts.size(), &data);
+      std::vector<uint64_t> decoded_keys(input->size());
+      std::vector<uint32_t> decoded_counts(counts.size());
+      size_t keys_size = codec.DecodeKeys(
+          data.data(), data.size(), input->size(), decoded_keys.data());
+      ASSERT_GT(keys_size, 0u);
+      ASSERT_EQ(codec.DecodeCounts(data.data() + keys_size,
+                                   data.size() - keys_size,
+                                   counts.size(),
+                                   decoded_counts.data()),
+                data.size() - keys_size);
+      ASSERT_EQ(decoded_keys, *input);
+      ASSERT_EQ(decoded_counts, counts);
+      // truncated data is rejected
+      ASSERT_EQ(codec.DecodeKeys(data.data(),
+                                 keys_size - 1,
+                                 input->size(),
+                                 decoded_keys.data()),
+                0u);
+    }
+  }
+}
+
+TEST(SparseWireCodec, ValuesLoopback) {
+  const size_t dim = 12;
+  const size_t exact_dim = 3;
+  std::mt19937 engine(0);
+  std::normal_distribution<float> dist(0, 0.1);
+  std::vector<float> value(dim);
+  for (size_t i = 0; i < dim; ++i) {
+    value[i] = i < exact_dim ? 1000.0f + i : dist(engine);
+  }
+  value[exact_dim] = 0.5f;  // the largest magnitude of the quantized part
+  for (auto value_type : {SparseWireCodec::kRaw,
+                          SparseWireCodec::kFp16,
+                          SparseWireCodec::kBf16,
+                          SparseWireCodec::kInt8}) {
+    SparseWireCodec codec(value_type, false, exact_dim);
+    std::vector<char> data(codec.ValueBytes(dim));
+    std::vector<float> decoded(dim);
+    codec.EncodeValue(value.data(), dim, data.data());
+    codec.DecodeValue(data.data(), dim, decoded.data());
+    float tolerance = value_type == SparseWireCodec::kRaw    ? 0
+                      : value_type == SparseWireCodec::kFp16 ? 1e-3
+                      : value_type == SparseWireCodec::kBf16 ? 4e-3
+                                                             : 0.5f / 127;
+    for (size_t i = 0; i < dim; ++i) {
+      if (i < exact_dim) {
+        ASSERT_EQ(decoded[i], value[i]);
+      } else {
+        ASSERT_NEAR(decoded[i], value[i], tolerance);
+      }
+    }
+  }
+  SparseWireCodec int8_codec(SparseWireCodec::kInt8, false, exact_dim);
+  ASSERT_EQ(int8_codec.ValueBytes(dim), exact_dim * 4 + 4 + (dim - exact_dim));
+  // all zero values keep a zero scale
+  std::vector<float> zeros(dim, 0);
+  std::vector<char> data(int8_codec.ValueBytes(dim));
+  int8_codec.EncodeValue(zeros.data(), dim, data.data());
+  int8_codec.DecodeValue(data.data(), dim, value.data());
+  ASSERT_EQ(value, zeros);
+}
+
+// Encodes and decodes pushes of 100k keys with CtrCommonAccessor sized values,
+// and reports the wire size against the raw format and the throughput.
+TEST(SparseWireCodec, BENCHMARK_PushThroughput) {
+  const size_t num = 100000;
+  const size_t dim = 12;
+  auto keys = SortedKeys(num);
+  std::mt19937 engine(0);
+  std::normal_distribution<float> dist(0, 0.01);
+  std::vector<float> values(num * dim);
+  for (auto &value : values) {
+    value = dist(engine);
+  }
+  size_t raw_size = num * (sizeof(uint64_t) + dim * sizeof(float));
+  for (auto value_type : {SparseWireCodec::kRaw,
+                          SparseWireCodec::kFp16,
+                          SparseWireCodec::kBf16,
+                          SparseWireCodec::kInt8}) {
+    SparseWireCodec codec(value_type, true, 3);
+    size_t encoded_size = codec.ValueBytes(dim);
+    std::string data;
+    std::vector<uint64_t> decoded_keys(num);
+    std::vector<float> decoded_values(num * dim);
+    auto start = std::chrono::steady_clock::now();
+    data.clear();
+    codec.EncodeKeys(keys.data(), num, &data);
+    size_t keys_size = data.size();
+    data.resize(keys_size + num * encoded_size);
+    for (size_t i = 0; i < num; ++i) {
+      codec.EncodeValue(
+          values.data() + i * dim, dim, &data[keys_size + i * encoded_size]);
+    }
+    ASSERT_EQ(codec.DecodeKeys(data.data(), data.size(), num, &decoded_keys[0]),
+              keys_size);
+    for (size_t i = 0; i < num; ++i) {
+      codec.DecodeValue(data.data() + keys_size + i * encoded_size,
+                        dim,
+                        decoded_values.data() + i * dim);
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    ASSERT_EQ(decoded_keys, keys);
+    LOG(INFO) << "wire codec " << static_cast<int>(value_type)
+              << " size ratio: " << static_cast<double>(data.size()) / raw_size
+              << " encode+decode: " << raw_size / seconds / (1 << 20)
+              << " MB/s of raw data";
+  }
+}
+
+}  // namespace paddle::distributed
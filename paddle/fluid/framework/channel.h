@@ -22,11 +22,13 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>  // NOLINT
 #include <deque>
 #include <limits>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -36,6 +38,120 @@
 namespace paddle {
 namespace framework {
 
+// Bounded multi-producer multi-consumer ring after Dmitry Vyukov's queue.
+// Every cell carries a sequence number telling of which lap it is free or
+// full, so producers and consumers only CAS their own position and never
+// take a lock. Push and Pop claim a run of ready cells with one CAS.
+template <class T>
+class MpmcRing {
+ public:
+  // capacity is rounded up to a power of two, at least 2 so that the full
+  // and the free sequence numbers of a cell differ
+  explicit MpmcRing(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    mask_ = size - 1;
+    cells_.reset(new Cell[size]);
+    for (size_t i = 0; i < size; ++i) {
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  size_t Capacity() const { return mask_ + 1; }
+
+  size_t Size() const {
+    size_t tail = dequeue_pos_.load(std::memory_order_acquire);
+    size_t head = enqueue_pos_.load(std::memory_order_acquire);
+    return head > tail ? head - tail : 0;
+  }
+
+  // whether the next Push or Pop would move something
+  bool CanPush() const {
+    size_t pos = enqueue_pos_.load(std::memory_order_acquire);
+    return cells_[pos & mask_].seq.load(std::memory_order_acquire) == pos;
+  }
+  bool CanPop() const {
+    size_t pos = dequeue_pos_.load(std::memory_order_acquire);
+    return cells_[pos & mask_].seq.load(std::memory_order_acquire) == pos + 1;
+  }
+
+  // pushes up to n values, moving them if kMove, returns the number pushed
+  template <bool kMove, class P>
+  size_t Push(P* p, size_t n) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    size_t m = 0;
+    while (true) {
+      m = 0;
+      while (m < n && cells_[(pos + m) & mask_].seq.load(
+                          std::memory_order_acquire) == pos + m) {
+        ++m;
+      }
+      if (m == 0 && !CanPush()) {
+        return 0;
+      }
+      if (m != 0 && enqueue_pos_.compare_exchange_weak(
+                        pos, pos + m, std::memory_order_relaxed)) {
+        break;
+      }
+      if (m == 0) {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    for (size_t i = 0; i < m; ++i) {
+      Cell& cell = cells_[(pos + i) & mask_];
+      if constexpr (kMove) {
+        cell.value = std::move(p[i]);
+      } else {
+        cell.value = p[i];
+      }
+      cell.seq.store(pos + i + 1, std::memory_order_release);
+    }
+    return m;
+  }
+
+  // pops up to n values into p, returns the number popped
+  size_t Pop(T* p, size_t n) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    size_t m = 0;
+    while (true) {
+      m = 0;
+      while (m < n && cells_[(pos + m) & mask_].seq.load(
+                          std::memory_order_acquire) == pos + m + 1) {
+        ++m;
+      }
+      if (m == 0 && !CanPop()) {
+        return 0;
+      }
+      if (m != 0 && dequeue_pos_.compare_exchange_weak(
+                        pos, pos + m, std::memory_order_relaxed)) {
+        break;
+      }
+      if (m == 0) {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    for (size_t i = 0; i < m; ++i) {
+      Cell& cell = cells_[(pos + i) & mask_];
+      p[i] = std::move(cell.value);
+      cell.seq.store(pos + i + mask_ + 1, std::memory_order_release);
+    }
+    return m;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> seq;
+    T value;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_ = 0;
+  alignas(64) std::atomic<size_t> enqueue_pos_{0};
+  alignas(64) std::atomic<size_t> dequeue_pos_{0};
+};
+
 template <class T>
 class ChannelObject {
  public:
@@ -46,8 +162,39 @@ class ChannelObject {
     capacity_ = (std::min)(MaxCapacity(), capacity);
   }
 
-  const std::deque<T>& GetData() const { return data_; }
+  // With lock_free the data live in a MpmcRing of the given capacity, which
+  // must be at least 1 and is fixed. Readers and writers only take the mutex
+  // to sleep when the ring is empty or full.
+  ChannelObject(size_t capacity, bool lock_free) : ChannelObject(capacity) {
+    if (lock_free) {
+      PADDLE_ENFORCE_GE(capacity,
+                        1,
+                        common::errors::InvalidArgument(
+                            "The capacity of a lock-free channel must be "
+                            "greater than or equal to 1, but got %d.",
+                            capacity));
+      ring_.reset(new MpmcRing<T>(capacity));
+      capacity_ = ring_->Capacity();
+    }
+  }
+
+  bool LockFree() const { return ring_ != nullptr; }
+
+  const std::deque<T>& GetData() const {
+    PADDLE_ENFORCE_EQ(ring_,
+                      nullptr,
+                      common::errors::Unimplemented(
+                          "GetData is not supported by a lock-free channel."));
+    return data_;
+  }
   void Clear() {
+    if (ring_) {
+      T val;
+      while (ring_->Pop(&val, 1) != 0) {
+      }
+      Wake(&full_waiters_, &full_cond_);
+      return;
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     data_.clear();
     data_.shrink_to_fit();
@@ -58,6 +205,10 @@ class ChannelObject {
   }
 
   void SetCapacity(size_t x) {  // capacity can be zero
+    PADDLE_ENFORCE_EQ(ring_,
+                      nullptr,
+                      common::errors::Unimplemented(
+                          "The capacity of a lock-free channel is fixed."));
     std::lock_guard<std::mutex> lock(mutex_);
     capacity_ = std::min(MaxCapacity(), x);
     Notify();
@@ -81,7 +232,9 @@ class ChannelObject {
   template <class U>
   void InheritFrom(const std::shared_ptr<ChannelObject<U>>& other) {
     std::lock_guard<std::mutex> lock(mutex_);
-    capacity_ = other->Capacity();
+    if (ring_ == nullptr) {
+      capacity_ = other->Capacity();
+    }
     block_size_ = other->BlockSize();
   }
 
@@ -100,15 +253,27 @@ class ChannelObject {
   void Close() {
     std::lock_guard<std::mutex> lock(mutex_);
     closed_ = true;
+    if (ring_) {
+      // ring readers and writers do not pass the wake up on
+      empty_cond_.notify_all();
+      full_cond_.notify_all();
+      return;
+    }
     Notify();
   }
 
   size_t Size() {
+    if (ring_) {
+      return ring_->Size();
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return data_.size();
   }
 
   bool Empty() {
+    if (ring_) {
+      return !ring_->CanPop();
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return EmptyUnlocked();
   }
@@ -122,6 +287,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_) {
+      return RingRead(n, p, false);
+    }
 
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Read(n, p, lock);
@@ -141,6 +309,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_) {
+      return RingWrite<false>(n, p);
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Write(n, p, lock);
     Notify();
@@ -152,6 +323,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_) {
+      return RingWrite<true>(n, p);
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = WriteMove(n, p, lock);
     Notify();
@@ -170,6 +344,12 @@ class ChannelObject {
     if (size == 0) {
       return 0;
     }
+    if (ring_) {
+      p.resize(size);
+      size_t finished = RingRead(size, &p[0], true);
+      p.resize(finished);
+      return finished;
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     p.resize(size);
     size_t finished = Read(size, &p[0], lock, true);
@@ -202,13 +382,15 @@ class ChannelObject {
  private:
   size_t capacity_ = MaxCapacity();
   size_t block_size_ = 1024;
-  bool closed_ = false;
+  std::atomic<bool> closed_{false};
   std::mutex mutex_;
   // use deque to store data
   std::deque<T> data_;
+  // stores the data instead of data_ in a lock-free channel
+  std::unique_ptr<MpmcRing<T>> ring_;
   size_t reading_count_ = 0;
-  int empty_waiters_ = 0;
-  int full_waiters_ = 0;
+  std::atomic<int> empty_waiters_{0};
+  std::atomic<int> full_waiters_{0};
   std::condition_variable empty_cond_;
   std::condition_variable full_cond_;
 
@@ -225,9 +407,78 @@ class ChannelObject {
     }
   }
 
-  bool EmptyUnlocked() { return data_.empty(); }
+  bool EmptyUnlocked() { return ring_ ? !ring_->CanPop() : data_.empty(); }
 
-  bool FullUnlocked() { return data_.size() >= capacity_ + reading_count_; }
+  bool FullUnlocked() {
+    return ring_ ? !ring_->CanPush()
+                 : data_.size() >= capacity_ + reading_count_;
+  }
+
+  // Sleeps until ready() holds. The waiter count is raised before ready() is
+  // checked under the mutex and Wake() checks it after the ring changed, so
+  // one of them always sees the other.
+  template <class Ready>
+  void Park(std::atomic<int>* waiters,
+            std::condition_variable* cond,
+            Ready ready) {
+    for (int i = 0; i < 16 && !ready(); ++i) {
+      std::this_thread::yield();
+    }
+    waiters->fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond->wait(lock, ready);
+    }
+    waiters->fetch_sub(1);
+  }
+
+  void Wake(std::atomic<int>* waiters, std::condition_variable* cond) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters->load() != 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cond->notify_all();
+    }
+  }
+
+  size_t RingRead(size_t n, T* p, bool once) {
+    size_t finished = 0;
+    while (finished < n) {
+      size_t m = ring_->Pop(p + finished, n - finished);
+      if (m != 0) {
+        finished += m;
+        Wake(&full_waiters_, &full_cond_);
+        if (once) {
+          break;
+        }
+        continue;
+      }
+      if (closed_ && !ring_->CanPop()) {
+        break;
+      }
+      Park(&empty_waiters_, &empty_cond_, [this]() {
+        return ring_->CanPop() || closed_;
+      });
+    }
+    return finished;
+  }
+
+  template <bool kMove, class P>
+  size_t RingWrite(size_t n, P* p) {
+    size_t finished = 0;
+    while (finished < n && !closed_) {
+      size_t m = ring_->template Push<kMove>(p + finished, n - finished);
+      if (m != 0) {
+        finished += m;
+        Wake(&empty_waiters_, &empty_cond_);
+        continue;
+      }
+      Park(&full_waiters_, &full_cond_, [this]() {
+        return ring_->CanPush() || closed_;
+      });
+    }
+    return finished;
+  }
 
   bool WaitForRead(std::unique_lock<std::mutex>& lock) {  // NOLINT
 #ifdef _LINUX
@@ -326,6 +577,12 @@ Channel<T> MakeChannel(size_t capacity = (std::numeric_limits<size_t>::max)()) {
   return std::make_shared<ChannelObject<T>>(capacity);
 }
 
+// a bounded lock-free channel, see ChannelObject(capacity, lock_free)
+template <class T>
+Channel<T> MakeLockFreeChannel(size_t capacity) {
+  return std::make_shared<ChannelObject<T>>(capacity, true);
+}
+
 template <class T, class U>
 Channel<T> MakeChannel(const Channel<U>& other) {
   PADDLE_ENFORCE_NE(
@@ -27,11 +27,15 @@ limitations under the License. */
 #endif
 #include "io/fs.h"
 #include "paddle/common/enforce.h"
+#include "paddle/fluid/framework/slot_line_scanner.h"
+#include "paddle/fluid/framework/slot_record_cache.h"
 #include "paddle/phi/core/platform/monitor.h"
 #include "paddle/phi/core/platform/timer.h"
 
 USE_INT_STAT(STAT_total_feasign_num_in_mem);
 COMMON_DECLARE_bool(enable_ins_parser_file);
+COMMON_DECLARE_bool(enable_lock_free_data_feed_queue);
+COMMON_DECLARE_int32(data_feed_prefetch_files);
 namespace paddle::framework {
 
 DLManager& global_dlmanager_pool() {
@@ -52,6 +56,14 @@ class BufferedLineFileReader {
    private:
     FILE* fp_;
   };
+  class PrefetchReader {
+   public:
+    explicit PrefetchReader(PrefetchFileReader* reader) : reader_(reader) {}
+    int read(char* buf, int len) { return reader_->Read(buf, len); }
+
+   private:
+    PrefetchFileReader* reader_;
+  };
 
  public:
   typedef std::function<bool(const std::string&)> LineFunc;
@@ -117,6 +129,13 @@ class BufferedLineFileReader {
     FILEReader reader(fp);
     return read_lines<FILEReader>(&reader, func, skip_lines);
   }
+  // reads the current file of a prefetching reader
+  int read_file(PrefetchFileReader* prefetch_reader,
+                LineFunc func,
+                int skip_lines) {
+    PrefetchReader reader(prefetch_reader);
+    return read_lines<PrefetchReader>(&reader, func, skip_lines);
+  }
   uint64_t file_size() { return total_len_; }
   void set_sample_rate(float r) { sample_rate_ = r; }
   size_t get_sample_line() { return sample_line_; }
@@ -245,6 +264,35 @@ bool DataFeed::PickOneFile(std::string* filename) {
   return true;
 }
 
+std::unique_ptr<PrefetchFileReader> DataFeed::CreatePrefetchFileReader(
+    const std::string& converter) {
+  if (FLAGS_data_feed_prefetch_files <= 0) {
+    return nullptr;
+  }
+  // blocks as large as the buffer of BufferedLineFileReader
+  static const size_t kPrefetchBlockSize = 4 * 1024 * 1024;
+  return std::make_unique<PrefetchFileReader>(
+      [this](std::string* filename) { return PickOneFile(filename); },
+      PrefetchFileReader::FsOpenRead(converter),
+      FLAGS_data_feed_prefetch_files,
+      kPrefetchBlockSize);
+}
+
+#ifdef _LINUX
+static void log_prefetch_stats(const PrefetchFileReader& reader,
+                               int thread_id) {
+  auto stats = reader.GetStats();
+  VLOG(1) << "prefetched " << stats.files << " files, "
+          << stats.bytes / 1024.0 / 1024.0 << "MB at "
+          << stats.bytes / 1024.0 / 1024.0 / stats.elapsed_seconds
+          << "MB/s, open time=" << stats.open_seconds
+          << " seconds, read time=" << stats.read_seconds
+          << " seconds, stalls=" << stats.stalls
+          << ", stall time=" << stats.stall_seconds
+          << " seconds, thread_id=" << thread_id;
+}
+#endif
+
 void DataFeed::CheckInit() {
   PADDLE_ENFORCE_EQ(
       finish_init_,
@@ -299,8 +347,12 @@ void PrivateQueueDataFeed<T>::SetQueueSize(int queue_size) {
       common::errors::InvalidArgument(
           "Queue size %d is illegal in PrivateQueueDataFeed.", queue_size));
   queue_size_ = queue_size;
-  queue_ = paddle::framework::MakeChannel<T>();
-  queue_->SetCapacity(queue_size);
+  if (FLAGS_enable_lock_free_data_feed_queue) {
+    queue_ = paddle::framework::MakeLockFreeChannel<T>(queue_size);
+  } else {
+    queue_ = paddle::framework::MakeChannel<T>();
+    queue_->SetCapacity(queue_size);
+  }
 }
 
 template <typename T>
@@ -889,13 +941,10 @@ bool MultiSlotDataFeed::ParseOneInstanceFromPipe(
     int use_slots_num = use_slots_.size();
     instance->resize(use_slots_num);
     const char* str = reader.get();
-    std::string line = std::string(str);
-
-    char* endptr = const_cast<char*>(str);
-    int pos = 0;
+    SlotLineScanner scanner(str, reader.length());
     for (size_t i = 0; i < use_slots_index_.size(); ++i) {
       int idx = use_slots_index_[i];
-      int num = strtol(&str[pos], &endptr, 10);
+      int num = static_cast<int>(scanner.ParseInt64());
 
       if (num <= 0) {
         std::stringstream ss;
@@ -904,7 +953,7 @@ bool MultiSlotDataFeed::ParseOneInstanceFromPipe(
         ss << "The Origin Input Data:\n";
         ss << "----------------------\n";
 
-        ss << line << "\n";
+        ss << str << "\n";
 
         ss << "\n----------------------\n";
         ss << "Some Possible Errors:\n";
@@ -922,22 +971,18 @@ bool MultiSlotDataFeed::ParseOneInstanceFromPipe(
         (*instance)[idx].Init(all_slots_type_[i]);
         if ((*instance)[idx].GetType()[0] == 'f') {  // float
           for (int j = 0; j < num; ++j) {
-            float feasign = strtof(endptr, &endptr);
+            float feasign = scanner.ParseFloat();
             (*instance)[idx].AddValue(feasign);
           }
         } else if ((*instance)[idx].GetType()[0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
-            uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
+            uint64_t feasign = scanner.ParseUint64();
             (*instance)[idx].AddValue(feasign);
           }
         }
-        pos = endptr - str;
       } else {
-        for (int j = 0; j <= num; ++j) {
-          // pos = line.find_first_of(' ', pos + 1);
-          while (line[pos + 1] != ' ') {
-            pos++;
-          }
+        for (int j = 0; j < num; ++j) {
+          scanner.SkipToken();
         }
       }
     }
@@ -956,11 +1001,10 @@ bool MultiSlotDataFeed::ParseOneInstance(std::vector<MultiSlotType>* instance) {
     instance->resize(use_slots_num);
     // parse line
     const char* str = line.c_str();
-    char* endptr = const_cast<char*>(str);
-    int pos = 0;
+    SlotLineScanner scanner(str, line.size());
     for (size_t i = 0; i < use_slots_index_.size(); ++i) {
       int idx = use_slots_index_[i];
-      int num = strtol(&str[pos], &endptr, 10);
+      int num = static_cast<int>(scanner.ParseInt64());
       PADDLE_ENFORCE_NE(
           num,
           0,
@@ -982,19 +1026,18 @@ bool MultiSlotDataFeed::ParseOneInstance(std::vector<MultiSlotType>* instance) {
         (*instance)[idx].Init(all_slots_type_[i]);
         if ((*instance)[idx].GetType()[0] == 'f') {  // float
           for (int j = 0; j < num; ++j) {
-            float feasign = strtof(endptr, &endptr);
+            float feasign = scanner.ParseFloat();
             (*instance)[idx].AddValue(feasign);
           }
         } else if ((*instance)[idx].GetType()[0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
-            uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
+            uint64_t feasign = scanner.ParseUint64();
             (*instance)[idx].AddValue(feasign);
           }
         }
-        pos = endptr - str;
       } else {
-        for (int j = 0; j <= num; ++j) {
-          pos = line.find_first_of(' ', pos + 1);
+        for (int j = 0; j < num; ++j) {
+          scanner.SkipToken();
         }
       }
     }
@@ -1176,8 +1219,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
     return false;
   } else {
     const char* str = reader.get();
-    std::string line = std::string(str);
-    // VLOG(3) << line;
+    // VLOG(3) << str;
     char* endptr = const_cast<char*>(str);
     int pos = 0;
     if (parse_ins_id_) {
@@ -1234,9 +1276,10 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
       instance->rank = rank;
       pos += static_cast<int>(len) + 1;
     }
+    SlotLineScanner scanner(str + pos, reader.length() - pos);
     for (size_t i = 0; i < use_slots_index_.size(); ++i) {
       int idx = use_slots_index_[i];
-      int num = strtol(&str[pos], &endptr, 10);
+      int num = static_cast<int>(scanner.ParseInt64());
       PADDLE_ENFORCE_NE(
           num,
           0,
@@ -1261,15 +1304,15 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
                            "please check this error line: %s",
                            str));
 
-        char* uidptr = endptr;
-        uint64_t feasign = (uint64_t)strtoull(uidptr, &uidptr, 10);
+        SlotLineScanner uid_scanner = scanner;
+        uint64_t feasign = uid_scanner.ParseUint64();
         instance->uid_ = feasign;
       }
 #endif
       if (idx != -1) {
         if (all_slots_type_[i][0] == 'f') {  // float
           for (int j = 0; j < num; ++j) {
-            float feasign = strtof(endptr, &endptr);
+            float feasign = scanner.ParseFloat();
             // if float feasign is equal to zero, ignore it
             // except when slot is dense
             if (fabs(feasign) < 1e-6 && !use_slots_is_dense_[i]) {
@@ -1281,7 +1324,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
           }
         } else if (all_slots_type_[i][0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
-            uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
+            uint64_t feasign = scanner.ParseUint64();
             // if uint64 feasign is equal to zero, ignore it
             // except when slot is dense
             if (feasign == 0 && !use_slots_is_dense_[i]) {
@@ -1292,13 +1335,9 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
             instance->uint64_feasigns_.emplace_back(f, idx);
           }
         }
-        pos = endptr - str;
       } else {
-        for (int j = 0; j <= num; ++j) {
-          // pos = line.find_first_of(' ', pos + 1);
-          while (line[pos + 1] != ' ') {
-            pos++;
-          }
+        for (int j = 0; j < num; ++j) {
+          scanner.SkipToken();
         }
       }
     }
@@ -1319,11 +1358,10 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
     VLOG(3) << line;
     // parse line
     const char* str = line.c_str();
-    char* endptr = const_cast<char*>(str);
-    int pos = 0;
+    SlotLineScanner scanner(str, line.size());
     for (size_t i = 0; i < use_slots_index_.size(); ++i) {
       int idx = use_slots_index_[i];
-      int num = strtol(&str[pos], &endptr, 10);
+      int num = static_cast<int>(scanner.ParseInt64());
       PADDLE_ENFORCE_NE(
           num,
           0,
@@ -1344,7 +1382,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
       if (idx != -1) {
         if (all_slots_type_[i][0] == 'f') {  // float
           for (int j = 0; j < num; ++j) {
-            float feasign = strtof(endptr, &endptr);
+            float feasign = scanner.ParseFloat();
             if (fabs(feasign) < 1e-6) {
               continue;
             }
@@ -1354,7 +1392,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
           }
         } else if (all_slots_type_[i][0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
-            uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
+            uint64_t feasign = scanner.ParseUint64();
             if (feasign == 0) {
               continue;
             }
@@ -1363,10 +1401,9 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
             instance->uint64_feasigns_.emplace_back(f, idx);
           }
         }
-        pos = endptr - str;
       } else {
-        for (int j = 0; j <= num; ++j) {
-          pos = line.find_first_of(' ', pos + 1);
+        for (int j = 0; j < num; ++j) {
+          scanner.SkipToken();
         }
       }
     }
@@ -2166,6 +2203,7 @@ void SlotRecordInMemoryDataFeed::Init(const DataFeedDesc& data_feed_desc) {
                        1);  // Each lod info will prepend a zero
   }
   visit_.resize(all_slot_num, false);
+  binary_cache_layout_ = SlotRecordCacheLayoutHash(data_feed_desc);
   pipe_command_ = data_feed_desc.pipe_command();
   finish_init_ = true;
   input_type_ = data_feed_desc.input_type();
@@ -2211,7 +2249,9 @@ void SlotRecordInMemoryDataFeed::InitGraphTrainResource() {
 
 void SlotRecordInMemoryDataFeed::LoadIntoMemory() {
   VLOG(3) << "SlotRecord LoadIntoMemory() begin, thread_id=" << thread_id_;
-  if (!so_parser_name_.empty()) {
+  if (binary_cache_mode_) {
+    LoadIntoMemoryByBinaryCache();
+  } else if (!so_parser_name_.empty()) {
     LoadIntoMemoryByLib();
   } else {
     LoadIntoMemoryByCommand();
@@ -2323,8 +2363,10 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByLine() {
   BufferedLineFileReader line_reader;
   line_reader.set_sample_rate(sample_rate_);
   BufferedLineFileReader::LineFunc line_func = nullptr;
+  auto prefetch_reader = CreatePrefetchFileReader(this->pipe_command_);
 
-  while (this->PickOneFile(&filename)) {
+  while (prefetch_reader ? prefetch_reader->NextFile(&filename)
+                         : this->PickOneFile(&filename)) {
     VLOG(3) << "PickOneFile, filename=" << filename
             << ", thread_id=" << thread_id_;
     std::vector<SlotRecord> record_vec;
@@ -2377,8 +2419,19 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByLine() {
     };
 
     int lines = 0;
+    bool prefetched = prefetch_reader != nullptr;
 
     do {
+      // a failed prefetched file is opened again, skipping the read lines
+      if (prefetched) {
+        prefetched = false;
+        lines = line_reader.read_file(prefetch_reader.get(), line_func, lines);
+        if (!prefetch_reader->Failed()) {
+          continue;
+        }
+        LOG(WARNING) << "prefetch file:[" << filename
+                     << "] failed, read it again from line " << lines;
+      }
       int err_no = 0;
       this->fp_ = fs_open_read(filename, &err_no, this->pipe_command_, true);
       PADDLE_ENFORCE_EQ(this->fp_ != nullptr,
@@ -2409,6 +2462,9 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByLine() {
             << "MB";
   }
 
+  if (prefetch_reader) {
+    log_prefetch_stats(*prefetch_reader, thread_id_);
+  }
   VLOG(3) << "LoadIntoMemoryByLib() end, thread_id=" << thread_id_
           << ", total size: " << line_reader.file_size();
 #endif
@@ -2419,8 +2475,10 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByCommand() {
   std::string filename;
   BufferedLineFileReader line_reader;
   line_reader.set_sample_rate(sample_rate_);
+  auto prefetch_reader = CreatePrefetchFileReader(this->pipe_command_);
 
-  while (this->PickOneFile(&filename)) {
+  while (prefetch_reader ? prefetch_reader->NextFile(&filename)
+                         : this->PickOneFile(&filename)) {
     VLOG(3) << "PickOneFile, filename=" << filename
             << ", thread_id=" << thread_id_;
     int lines = 0;
@@ -2429,8 +2487,36 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByCommand() {
     timeline.Start();
     SlotRecordPool().get(&record_vec, OBJPOOL_BLOCK_SIZE);
     int offset = 0;
+    auto line_func = [this, &record_vec, &offset, &filename](
+                         const std::string& line) {
+      if (ParseOneInstance(line, &record_vec[offset])) {
+        ++offset;
+      } else {
+        LOG(WARNING) << "read file:[" << filename << "] item error, line:["
+                     << line << "]";
+        return false;
+      }
+      if (offset >= OBJPOOL_BLOCK_SIZE) {
+        input_channel_->Write(std::move(record_vec));
+        record_vec.clear();
+        SlotRecordPool().get(&record_vec, OBJPOOL_BLOCK_SIZE);
+        offset = 0;
+      }
+      return true;
+    };
+    bool prefetched = prefetch_reader != nullptr;
 
     do {
+      // a failed prefetched file is opened again, skipping the read lines
+      if (prefetched) {
+        prefetched = false;
+        lines = line_reader.read_file(prefetch_reader.get(), line_func, lines);
+        if (!prefetch_reader->Failed()) {
+          continue;
+        }
+        LOG(WARNING) << "prefetch file:[" << filename
+                     << "] failed, read it again from line " << lines;
+      }
       int err_no = 0;
       this->fp_ = fs_open_read(filename, &err_no, this->pipe_command_, true);
       PADDLE_ENFORCE_EQ(this->fp_ != nullptr,
@@ -2439,25 +2525,7 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByCommand() {
                             "This fp should not be null, please check!"));
       __fsetlocking(&*(this->fp_), FSETLOCKING_BYCALLER);
 
-      lines = line_reader.read_file(
-          this->fp_.get(),
-          [this, &record_vec, &offset, &filename](const std::string& line) {
-            if (ParseOneInstance(line, &record_vec[offset])) {
-              ++offset;
-            } else {
-              LOG(WARNING) << "read file:[" << filename
-                           << "] item error, line:[" << line << "]";
-              return false;
-            }
-            if (offset >= OBJPOOL_BLOCK_SIZE) {
-              input_channel_->Write(std::move(record_vec));
-              record_vec.clear();
-              SlotRecordPool().get(&record_vec, OBJPOOL_BLOCK_SIZE);
-              offset = 0;
-            }
-            return true;
-          },
-          lines);
+      lines = line_reader.read_file(this->fp_.get(), line_func, lines);
     } while (line_reader.is_error());
     if (offset > 0) {
       input_channel_->WriteMove(offset, &record_vec[0]);
@@ -2477,11 +2545,54 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByCommand() {
             << ", cost time=" << timeline.ElapsedSec()
             << " seconds, thread_id=" << thread_id_;
   }
+  if (prefetch_reader) {
+    log_prefetch_stats(*prefetch_reader, thread_id_);
+  }
   VLOG(3) << "LoadIntoMemory() end, thread_id=" << thread_id_
           << ", total size: " << line_reader.file_size();
 #endif
 }
 
+void SlotRecordInMemoryDataFeed::LoadIntoMemoryByBinaryCache() {
+  std::string filename;
+  uint64_t total_ins_num = 0;
+  while (this->PickOneFile(&filename)) {
+    VLOG(3) << "PickOneFile, filename=" << filename
+            << ", thread_id=" << thread_id_;
+    platform::Timer timeline;
+    timeline.Start();
+    SlotRecordCacheReader reader(filename);
+    const SlotRecordCacheHeader& header = reader.header();
+    PADDLE_ENFORCE_EQ(
+        header.layout_hash == binary_cache_layout_ &&
+            header.uint64_slot_num ==
+                static_cast<uint32_t>(uint64_use_slot_size_) &&
+            header.float_slot_num ==
+                static_cast<uint32_t>(float_use_slot_size_),
+        true,
+        common::errors::InvalidArgument(
+            "The binary cache %s was dumped with other used slots, please "
+            "dump it again with the current data feed.",
+            filename));
+    std::vector<SlotRecord> record_vec;
+    uint64_t ins_num = 0;
+    size_t num = 0;
+    while ((num = reader.ReadBlock(&record_vec)) > 0) {
+      input_channel_->Write(std::move(record_vec));
+      record_vec.clear();
+      ins_num += num;
+    }
+    total_ins_num += ins_num;
+    timeline.Pause();
+    VLOG(3) << "LoadIntoMemoryByBinaryCache() read all records, file="
+            << filename << ", ins num=" << ins_num
+            << ", cost time=" << timeline.ElapsedSec()
+            << " seconds, thread_id=" << thread_id_;
+  }
+  VLOG(3) << "LoadIntoMemoryByBinaryCache() end, thread_id=" << thread_id_
+          << ", total ins num: " << total_ins_num;
+}
+
 static void parser_log_key(const std::string& log_key,
                            uint64_t* search_id,
                            uint32_t* cmatch,
@@ -2503,11 +2614,6 @@ bool SlotRecordInMemoryDataFeed::ParseOneInstance(const std::string& line,
   char* endptr = const_cast<char*>(str);
   int pos = 0;
 
-  thread_local std::vector<std::vector<float>> slot_float_feasigns;
-  thread_local std::vector<std::vector<uint64_t>> slot_uint64_feasigns;
-  slot_float_feasigns.resize(float_use_slot_size_);
-  slot_uint64_feasigns.resize(uint64_use_slot_size_);
-
   if (parse_ins_id_) {
     int num = static_cast<int>(strtol(&str[pos], &endptr, 10));
     PADDLE_ENFORCE_EQ(num == 1,
@@ -2550,8 +2656,15 @@ bool SlotRecordInMemoryDataFeed::ParseOneInstance(const std::string& line,
   int float_total_slot_num = 0;
   int uint64_total_slot_num = 0;
 
+  // the used slots of each type come in the order of slot_value_idx, so
+  // the values go straight into the record in one pass
+  auto& float_values = rec->slot_float_feasigns_;
+  auto& uint64_values = rec->slot_uint64_feasigns_;
+  float_values.begin_slots();
+  uint64_values.begin_slots();
+  SlotLineScanner scanner(str + pos, line.size() - pos);
   for (auto& info : all_slots_info_) {
-    int num = static_cast<int>(strtol(&str[pos], &endptr, 10));
+    int num = static_cast<int>(scanner.ParseInt64());
     PADDLE_ENFORCE(num,
                    "The number of ids can not be zero, you need padding "
                    "it in data generator; or if there is something wrong with "
@@ -2560,40 +2673,28 @@ bool SlotRecordInMemoryDataFeed::ParseOneInstance(const std::string& line,
                    str);
     if (info.used_idx != -1) {
       if (info.type[0] == 'f') {  // float
-        auto& slot_fea = slot_float_feasigns[info.slot_value_idx];
-        slot_fea.clear();
         for (int j = 0; j < num; ++j) {
-          float feasign = strtof(endptr, &endptr);
+          float feasign = scanner.ParseFloat();
           if (fabs(feasign) < 1e-6 && !used_slots_info_[info.used_idx].dense) {
             continue;
           }
-          slot_fea.push_back(feasign);
+          float_values.slot_values.push_back(feasign);
           ++float_total_slot_num;
         }
+        float_values.end_slot();
       } else if (info.type[0] == 'u') {  // uint64
-        auto& slot_fea = slot_uint64_feasigns[info.slot_value_idx];
-        slot_fea.clear();
         for (int j = 0; j < num; ++j) {
-          uint64_t feasign =
-              static_cast<uint64_t>(strtoull(endptr, &endptr, 10));
-          slot_fea.push_back(feasign);
+          uint64_values.slot_values.push_back(scanner.ParseUint64());
           ++uint64_total_slot_num;
         }
+        uint64_values.end_slot();
       }
-      pos = static_cast<int>(endptr - str);
     } else {
-      for (int j = 0; j <= num; ++j) {
-        // pos = line.find_first_of(' ', pos + 1);
-        while (line[pos + 1] != ' ') {
-          pos++;
-        }
+      for (int j = 0; j < num; ++j) {
+        scanner.SkipToken();
       }
     }
   }
-  rec->slot_float_feasigns_.add_slot_feasigns(slot_float_feasigns,
-                                              float_total_slot_num);
-  rec->slot_uint64_feasigns_.add_slot_feasigns(slot_uint64_feasigns,
-                                               uint64_total_slot_num);
 
   return (uint64_total_slot_num > 0);
 }
@@ -2851,6 +2952,20 @@ bool SlotRecordInMemoryDataFeed::Start() {
 int SlotRecordInMemoryDataFeed::Next() {
 #ifdef _LINUX
   this->CheckStart();
+  if (stream_channel_ != nullptr) {
+    // blocks until a full batch is ready or the stream ends
+    stream_batch_.resize(default_batch_size_);
+    size_t num =
+        stream_channel_->Read(stream_batch_.size(), stream_batch_.data());
+    stream_batch_.resize(num);
+    this->batch_size_ = static_cast<int>(num);
+    if (num != 0) {
+      PutToFeedVec(stream_batch_.data(), this->batch_size_);
+    }
+    // the batch is copied into the feed vars, nothing refers to it any more
+    SlotRecordPool().put(&stream_batch_);
+    return this->batch_size_;
+  }
   if (!gpu_graph_mode_) {
 #if defined(PADDLE_WITH_CUDA) && defined(PADDLE_WITH_HETERPS)
     while (true) {
@@ -36,6 +36,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/blocking_queue.h"
 #include "paddle/fluid/framework/channel.h"
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
+#include "paddle/fluid/framework/io/prefetch_file_reader.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/variable.h"
 #include "paddle/phi/core/framework/data_feed.pb.h"
@@ -110,6 +111,15 @@ struct SlotValues {
     (*size) = slot_offsets[idx + 1] - offset;
     return &slot_values[offset];
   }
+  // fill the slots in order in place: begin_slots(), then the values of
+  // each slot pushed to slot_values followed by end_slot()
+  void begin_slots() {
+    slot_offsets.resize(1);
+    slot_offsets[0] = static_cast<uint32_t>(slot_values.size());
+  }
+  void end_slot() {
+    slot_offsets.push_back(static_cast<uint32_t>(slot_values.size()));
+  }
   void add_slot_feasigns(const std::vector<std::vector<T>>& slot_feasigns,
                          uint32_t fea_num) {
     slot_values.reserve(fea_num);
@@ -1207,6 +1217,10 @@ class DataFeed {
   virtual void SetParseLogKey(bool parse_logkey UNUSED) {}
   virtual void SetEnablePvMerge(bool enable_pv_merge UNUSED) {}
   virtual void SetCurrentPhase(int current_phase UNUSED) {}
+  // This function will do nothing at default
+  virtual void SetBinaryCacheMode(bool binary_cache_mode UNUSED) {}
+  // This function will do nothing at default
+  virtual void SetStreamChannel(void* channel UNUSED) {}
 #if defined(PADDLE_WITH_PSCORE) && defined(PADDLE_WITH_HETERPS)
   virtual void InitGraphResource() {}
   virtual void InitGraphTrainResource() {}
@@ -1432,6 +1446,11 @@ class DataFeed {
   // This function is used to pick one file from the global filelist(thread
   // safe).
   virtual bool PickOneFile(std::string* filename);
+  // Returns a reader of the files picked by PickOneFile that keeps
+  // FLAGS_data_feed_prefetch_files of them in flight, nullptr when the flag
+  // is 0.
+  std::unique_ptr<PrefetchFileReader> CreatePrefetchFileReader(
+      const std::string& converter);
   virtual void CopyToFeedTensor(void* dst, const void* src, size_t size);
 
   std::vector<std::string> filelist_;
@@ -1972,6 +1991,15 @@ class SlotRecordInMemoryDataFeed : public InMemoryDataFeed<SlotRecord> {
   void Init(const DataFeedDesc& data_feed_desc) override;
   void LoadIntoMemory() override;
   void ExpandSlotRecord(SlotRecord* ins);
+  // read the files as binary caches dumped by SlotRecordDataset
+  void SetBinaryCacheMode(bool binary_cache_mode) override {
+    binary_cache_mode_ = binary_cache_mode;
+  }
+  // Next() reads its batches from channel, which a streaming
+  // SlotRecordDataset fills while the pass is still loading
+  void SetStreamChannel(void* channel) override {
+    stream_channel_ = static_cast<ChannelObject<SlotRecord>*>(channel);
+  }
 
  protected:
   bool Start() override;
@@ -1988,6 +2016,7 @@ class SlotRecordInMemoryDataFeed : public InMemoryDataFeed<SlotRecord> {
   virtual void LoadIntoMemoryByLib(void);
   virtual void LoadIntoMemoryByLine(void);
   virtual void LoadIntoMemoryByFile(void);
+  virtual void LoadIntoMemoryByBinaryCache(void);
   void SetInputChannel(void* channel) override {
     input_channel_ = static_cast<ChannelObject<SlotRecord>*>(channel);
   }
@@ -2060,6 +2089,10 @@ class SlotRecordInMemoryDataFeed : public InMemoryDataFeed<SlotRecord> {
   std::vector<UsedSlotInfo> used_slots_info_;
   size_t float_total_dims_size_ = 0;
   std::vector<int> float_total_dims_without_inductives_;
+  bool binary_cache_mode_ = false;
+  uint64_t binary_cache_layout_ = 0;
+  ChannelObject<SlotRecord>* stream_channel_ = nullptr;
+  std::vector<SlotRecord> stream_batch_;
 
 #if defined(PADDLE_WITH_CUDA) && defined(PADDLE_WITH_HETERPS)
   int pack_thread_num_{5};
@@ -14,6 +14,10 @@
 
 #include "paddle/fluid/framework/data_set.h"
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+
 #include "google/protobuf/text_format.h"
 #if (defined PADDLE_WITH_DISTRIBUTE) && (defined PADDLE_WITH_PSCORE)
 #include "paddle/fluid/distributed/index_dataset/index_sampler.h"
@@ -22,6 +26,7 @@
 #include "paddle/fluid/framework/data_feed_factory.h"
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
 #include "paddle/fluid/framework/io/fs.h"
+#include "paddle/fluid/framework/slot_record_cache.h"
 #include "paddle/fluid/framework/threadpool.h"
 #include "paddle/phi/core/platform/monitor.h"
 #include "paddle/phi/core/platform/timer.h"
@@ -631,6 +636,36 @@ void DatasetImpl<T>::PreLoadIntoMemory() {
   VLOG(3) << "DatasetImpl<T>::PreLoadIntoMemory() end";
 }
 
+template <typename T>
+void DatasetImpl<T>::DumpIntoBinaryCache(const std::string& cache_dir UNUSED) {
+  PADDLE_THROW(common::errors::Unimplemented(
+      "DumpIntoBinaryCache is only supported by SlotRecordDataset."));
+}
+
+template <typename T>
+void DatasetImpl<T>::SetBinaryCacheDir(const std::string& cache_dir) {
+  PADDLE_ENFORCE_EQ(cache_dir.empty(),
+                    true,
+                    common::errors::Unimplemented(
+                        "SetBinaryCacheDir is only supported by "
+                        "SlotRecordDataset."));
+}
+
+template <typename T>
+void DatasetImpl<T>::SetStreamingMode(int64_t window_size,
+                                      const std::string& spill_dir UNUSED) {
+  PADDLE_ENFORCE_EQ(window_size,
+                    0,
+                    common::errors::Unimplemented(
+                        "The streaming mode is only supported by "
+                        "SlotRecordDataset."));
+}
+
+template <typename T>
+int64_t DatasetImpl<T>::GetStreamDataSize() {
+  return 0;
+}
+
 template <typename T>
 void DatasetImpl<T>::WaitPreLoadDone() {
   VLOG(3) << "DatasetImpl<T>::WaitPreLoadDone() begin";
@@ -1255,7 +1290,9 @@ void DatasetImpl<T>::CreatePreLoadReaders() {
     preload_readers_[i]->SetThreadNum(preload_thread_num_);
     preload_readers_[i]->SetFileListMutex(&mutex_for_pick_file_);
     preload_readers_[i]->SetFileListIndex(&file_idx_);
-    preload_readers_[i]->SetFileList(filelist_);
+    preload_readers_[i]->SetFileList(
+        binary_cache_files_.empty() ? filelist_ : binary_cache_files_);
+    preload_readers_[i]->SetBinaryCacheMode(!binary_cache_files_.empty());
     preload_readers_[i]->SetFeaNumMutex(&mutex_for_fea_num_);
     preload_readers_[i]->SetFeaNum(&total_fea_num_);
     preload_readers_[i]->SetParseInsId(parse_ins_id_);
@@ -2032,7 +2069,9 @@ void SlotRecordDataset::CreateReaders() {
     readers_[i]->SetFileListIndex(&file_idx_);
     readers_[i]->SetFeaNumMutex(&mutex_for_fea_num_);
     readers_[i]->SetFeaNum(&total_fea_num_);
-    readers_[i]->SetFileList(filelist_);
+    readers_[i]->SetFileList(
+        binary_cache_files_.empty() ? filelist_ : binary_cache_files_);
+    readers_[i]->SetBinaryCacheMode(!binary_cache_files_.empty());
     readers_[i]->SetParseInsId(parse_ins_id_);
     readers_[i]->SetParseContent(parse_content_);
     readers_[i]->SetParseLogKey(parse_logkey_);
@@ -2046,6 +2085,9 @@ void SlotRecordDataset::CreateReaders() {
     if (input_channel_ != nullptr) {
       readers_[i]->SetInputChannel(input_channel_.get());
     }
+    if (stream_output_channel_ != nullptr) {
+      readers_[i]->SetStreamChannel(stream_output_channel_.get());
+    }
   }
   VLOG(3) << "readers size: " << readers_.size();
 }
@@ -2080,9 +2122,469 @@ void SlotRecordDataset::ReleaseMemory() {
           << " object pool size=" << SlotRecordPool().capacity();  // For Debug
   STAT_SUB(STAT_total_feasign_num_in_mem, total_fea_num_);
 }
+// the used slots of desc, which are the slots of a SlotRecord
+static void count_used_slots(const paddle::framework::DataFeedDesc& desc,
+                             uint32_t* uint64_slot_num,
+                             uint32_t* float_slot_num) {
+  const auto& multi_slot_desc = desc.multi_slot_desc();
+  for (int i = 0; i < multi_slot_desc.slots_size(); ++i) {
+    const auto& slot = multi_slot_desc.slots(i);
+    if (slot.is_used() && slot.type()[0] == 'u') {
+      ++(*uint64_slot_num);
+    } else if (slot.is_used() && slot.type()[0] == 'f') {
+      ++(*float_slot_num);
+    }
+  }
+}
+
+void SlotRecordDataset::DumpIntoBinaryCache(const std::string& cache_dir) {
+  VLOG(3) << "SlotRecordDataset::DumpIntoBinaryCache() begin";
+  platform::Timer timeline;
+  timeline.Start();
+  // the records are in input_records_ once PrepareTrain read them for heterps
+  std::vector<SlotRecord> channel_records;
+  if (input_records_.empty() && input_channel_ != nullptr) {
+    bool closed = input_channel_->Closed();
+    input_channel_->Close();
+    input_channel_->ReadAll(channel_records);
+    input_channel_->Open();
+    if (!channel_records.empty()) {
+      input_channel_->Write(channel_records);
+    }
+    if (closed) {
+      input_channel_->Close();
+    }
+  }
+  const std::vector<SlotRecord>& records =
+      input_records_.empty() ? channel_records : input_records_;
+
+  uint32_t uint64_slot_num = 0;
+  uint32_t float_slot_num = 0;
+  count_used_slots(data_feed_desc_, &uint64_slot_num, &float_slot_num);
+  uint64_t layout_hash = SlotRecordCacheLayoutHash(data_feed_desc_);
+
+  localfs_mkdir(cache_dir);
+  localfs_remove(cache_dir + "/part-*");
+  int part_num = std::max(thread_num_, 1);
+  size_t part_size = (records.size() + part_num - 1) / part_num;
+  std::vector<std::thread> dump_threads;
+  for (int i = 0; i < part_num; ++i) {
+    dump_threads.emplace_back([&, i]() {
+      size_t begin = std::min(records.size(), i * part_size);
+      size_t end = std::min(records.size(), begin + part_size);
+      SlotRecordCacheWriter writer(
+          string::format_string("%s/part-%05d", cache_dir.c_str(), i),
+          layout_hash,
+          uint64_slot_num,
+          float_slot_num);
+      writer.Write(records.data() + begin, end - begin);
+      writer.Close();
+    });
+  }
+  for (std::thread& t : dump_threads) {
+    t.join();
+  }
+  timeline.Pause();
+  VLOG(3) << "SlotRecordDataset::DumpIntoBinaryCache() end, ins num="
+          << records.size() << ", part num=" << part_num
+          << ", cost time=" << timeline.ElapsedSec() << " seconds";
+}
+
+void SlotRecordDataset::SetBinaryCacheDir(const std::string& cache_dir) {
+  binary_cache_files_.clear();
+  if (!cache_dir.empty()) {
+    for (auto& path : localfs_list(cache_dir)) {
+      std::string name = path.substr(path.rfind('/') + 1);
+      if (name.compare(0, 5, "part-") == 0) {
+        binary_cache_files_.push_back(path);
+      }
+    }
+    PADDLE_ENFORCE_GT(binary_cache_files_.size(),
+                      0,
+                      common::errors::NotFound(
+                          "There is no binary cache under %s, please dump "
+                          "one with DumpIntoBinaryCache first.",
+                          cache_dir));
+    // the readers check it again, but fail in their threads
+    uint64_t layout_hash = SlotRecordCacheLayoutHash(data_feed_desc_);
+    for (auto& path : binary_cache_files_) {
+      SlotRecordCacheReader reader(path);
+      PADDLE_ENFORCE_EQ(reader.header().layout_hash,
+                        layout_hash,
+                        common::errors::InvalidArgument(
+                            "The binary cache %s was dumped with other used "
+                            "slots, please dump it again.",
+                            path));
+    }
+  }
+  file_idx_ = 0;
+}
+
+void SlotRecordDataset::SetStreamingMode(int64_t window_size,
+                                         const std::string& spill_dir) {
+  PADDLE_ENFORCE_GE(window_size,
+                    0,
+                    common::errors::InvalidArgument(
+                        "The stream window size should be greater than or "
+                        "equal to 0, but got %d.",
+                        window_size));
+#if defined(PADDLE_WITH_CUDA) && defined(PADDLE_WITH_HETERPS)
+  PADDLE_ENFORCE_EQ(window_size,
+                    0,
+                    common::errors::Unimplemented(
+                        "The streaming mode does not support the batch "
+                        "packing of heterps yet."));
+#endif
+  stream_window_size_ = window_size;
+  stream_spill_dir_ = spill_dir;
+  if (!spill_dir.empty()) {
+    localfs_mkdir(spill_dir);
+  }
+}
+
+void SlotRecordDataset::PreLoadIntoMemory() {
+  if (stream_window_size_ == 0) {
+    DatasetImpl<SlotRecord>::PreLoadIntoMemory();
+    return;
+  }
+  VLOG(3) << "SlotRecordDataset::PreLoadIntoMemory() begin, stream window "
+          << stream_window_size_;
+  PADDLE_ENFORCE_EQ(stream_threads_.empty(),
+                    true,
+                    common::errors::PreconditionNotMet(
+                        "The last stream is not finished, please call "
+                        "WaitPreLoadDone first."));
+  PADDLE_ENFORCE_GT(preload_readers_.size(),
+                    0,
+                    common::errors::PreconditionNotMet(
+                        "The streaming mode loads with the preload readers, "
+                        "please call CreatePreLoadReaders first."));
+  // Both channels and the window hold up to stream_window_size_ records,
+  // which bounds the memory of the stream.
+  stream_input_channel_ = paddle::framework::MakeChannel<SlotRecord>();
+  stream_input_channel_->SetCapacity(stream_window_size_);
+  stream_out_ins_ = 0;
+  stream_data_size_ = 0;
+  stream_output_channel_ =
+      paddle::framework::MakeLockFreeChannel<SlotRecord>(stream_window_size_);
+  for (auto& reader : readers_) {
+    reader->SetStreamChannel(stream_output_channel_.get());
+  }
+  preload_threads_.clear();
+  for (auto& reader : preload_readers_) {
+    reader->SetInputChannel(stream_input_channel_.get());
+    preload_threads_.emplace_back(&paddle::framework::DataFeed::LoadIntoMemory,
+                                  reader.get());
+  }
+  stream_threads_.emplace_back([this]() {
+    for (std::thread& t : preload_threads_) {
+      t.join();
+    }
+    stream_input_channel_->Close();
+  });
+  stream_threads_.emplace_back([this]() { StreamShuffle(); });
+  VLOG(3) << "SlotRecordDataset::PreLoadIntoMemory() end";
+}
+
+void SlotRecordDataset::WaitPreLoadDone() {
+  if (stream_threads_.empty()) {
+    DatasetImpl<SlotRecord>::WaitPreLoadDone();
+    return;
+  }
+  VLOG(3) << "SlotRecordDataset::WaitPreLoadDone() begin";
+  // the readers are done with the pass by now. Closing the channel keeps
+  // StreamShuffle from blocking on it when they stopped early or never
+  // ran, it then drops the records still loading.
+  stream_output_channel_->Close();
+  for (std::thread& t : stream_threads_) {
+    t.join();
+  }
+  stream_threads_.clear();
+  preload_threads_.clear();
+  for (auto& reader : readers_) {
+    reader->SetStreamChannel(nullptr);
+  }
+  // the records no reader took
+  std::vector<SlotRecord> rest;
+  stream_output_channel_->ReadAll(rest);
+  stream_data_size_ = stream_out_ins_ - static_cast<int64_t>(rest.size());
+  SlotRecordPool().put(&rest);
+  stream_input_channel_ = nullptr;
+  stream_output_channel_ = nullptr;
+  VLOG(3) << "SlotRecordDataset::WaitPreLoadDone() end";
+}
+
+void SlotRecordDataset::StreamShuffle() {
+#ifdef PADDLE_WITH_PSCORE
+  auto fleet_ptr = distributed::FleetWrapper::GetInstance();
+#else
+  auto fleet_ptr = framework::FleetWrapper::GetInstance();
+#endif
+  // records per spill file, which is deleted once read back
+  constexpr size_t kSpillFileIns = 16 * SlotRecordCacheWriter::kBlockSize;
+  static std::atomic<int> spill_file_id(0);
+  platform::Timer timeline;
+  timeline.Start();
+  auto& engine = fleet_ptr->LocalRandomEngine();
+  size_t window_size = stream_window_size_;
+  size_t out_block = stream_output_channel_->BlockSize();
+  uint32_t uint64_slot_num = 0;
+  uint32_t float_slot_num = 0;
+  count_used_slots(data_feed_desc_, &uint64_slot_num, &float_slot_num);
+  uint64_t layout_hash = SlotRecordCacheLayoutHash(data_feed_desc_);
+
+  std::vector<SlotRecord> window;
+  std::vector<SlotRecord> out;
+  window.reserve(window_size);
+  // the spill files not read back yet, the last one is open while
+  // spill_writer is set
+  std::deque<std::string> spill_files;
+  std::unique_ptr<SlotRecordCacheWriter> spill_writer;
+  std::unique_ptr<SlotRecordCacheReader> spill_reader;
+  size_t spill_file_ins = 0;
+  uint64_t total_ins = 0;
+  uint64_t spilled_ins = 0;
+  bool input_done = false;
+
+  // a closed channel takes nothing, the records it left go back to the pool
+  auto write_out = [&](std::vector<SlotRecord>* records) {
+    if (records->empty()) {
+      return;
+    }
+    size_t num = stream_output_channel_->Write(std::move(*records));
+    stream_out_ins_ += num;
+    if (num < records->size()) {
+      SlotRecordPool().put(records->data() + num, records->size() - num);
+    }
+    records->clear();
+  };
+  // hands out to the readers, or spills when they are a window behind
+  auto emit = [&]() {
+    if (out.empty()) {
+      return;
+    }
+    bool behind = stream_output_channel_->Size() + out.size() >
+                  stream_output_channel_->Capacity();
+    if (!behind || input_done || stream_spill_dir_.empty() ||
+        stream_output_channel_->Closed()) {
+      write_out(&out);
+      return;
+    }
+    if (spill_writer == nullptr) {
+      spill_files.push_back(string::format_string(
+          "%s/stream-spill-%05d", stream_spill_dir_.c_str(), spill_file_id++));
+      spill_writer = std::make_unique<SlotRecordCacheWriter>(
+          spill_files.back(), layout_hash, uint64_slot_num, float_slot_num);
+      spill_file_ins = 0;
+    }
+    spill_writer->Write(out.data(), out.size());
+    spill_file_ins += out.size();
+    spilled_ins += out.size();
+    SlotRecordPool().put(&out);
+    if (spill_file_ins >= kSpillFileIns) {
+      spill_writer->Close();
+      spill_writer = nullptr;
+    }
+  };
+  // a full window gives a random record out for each new one
+  auto add = [&](std::vector<SlotRecord>* block) {
+    for (auto& rec : *block) {
+      if (window.size() < window_size) {
+        window.push_back(rec);
+      } else {
+        size_t j = engine() % window_size;
+        out.push_back(window[j]);
+        window[j] = rec;
+        if (out.size() >= out_block) {
+          emit();
+        }
+      }
+    }
+    block->clear();
+  };
+  // reads a spilled block back into the window, false if there is none
+  auto unspill = [&]() -> bool {
+    std::vector<SlotRecord> block;
+    while (block.empty()) {
+      if (spill_reader == nullptr) {
+        if (spill_files.size() <= (spill_writer != nullptr ? 1 : 0)) {
+          return false;
+        }
+        spill_reader =
+            std::make_unique<SlotRecordCacheReader>(spill_files.front());
+      }
+      if (spill_reader->ReadBlock(&block) == 0) {
+        spill_reader = nullptr;
+        localfs_remove(spill_files.front());
+        spill_files.pop_front();
+      }
+    }
+    add(&block);
+    return true;
+  };
+
+  std::vector<SlotRecord> block;
+  while (stream_input_channel_->Read(block) != 0) {
+    total_ins += block.size();
+    add(&block);
+    if (stream_output_channel_->Size() <
+        stream_output_channel_->Capacity() / 2) {
+      // the readers caught up, read the spilled records back
+      if (spill_writer != nullptr) {
+        spill_writer->Close();
+        spill_writer = nullptr;
+      }
+      unspill();
+    }
+  }
+  input_done = true;
+  if (spill_writer != nullptr) {
+    spill_writer->Close();
+    spill_writer = nullptr;
+  }
+  while (unspill()) {
+  }
+  emit();
+  std::shuffle(window.begin(), window.end(), engine);
+  write_out(&window);
+  stream_output_channel_->Close();
+  timeline.Pause();
+  VLOG(3) << "SlotRecordDataset::StreamShuffle() end, ins num=" << total_ins
+          << ", spilled ins num=" << spilled_ins
+          << ", cost time=" << timeline.ElapsedSec() << " seconds";
+}
+
 void SlotRecordDataset::GlobalShuffle(int thread_num) {
-  // TODO(yaoxuefeng)
-  return;
+  VLOG(3) << "SlotRecordDataset::GlobalShuffle() begin";
+  platform::Timer timeline;
+  timeline.Start();
+#ifdef PADDLE_WITH_PSCORE
+  auto fleet_ptr = distributed::FleetWrapper::GetInstance();
+#else
+  auto fleet_ptr = framework::FleetWrapper::GetInstance();
+#endif
+
+  if (!input_channel_ || input_channel_->Size() == 0) {
+    VLOG(3) << "SlotRecordDataset::GlobalShuffle() end, no data to shuffle";
+    return;
+  }
+
+  // Take the local records out and leave input_channel_ closed and empty,
+  // ReceiveFromClient puts the records of all trainers back into it. Records
+  // other trainers sent before this point are just shuffled once more.
+  std::vector<SlotRecord> data;
+  {
+    std::unique_lock<std::mutex> lk(global_index_mutex_);
+    input_channel_->Close();
+    input_channel_->ReadAll(data);
+  }
+  std::shuffle(data.begin(), data.end(), fleet_ptr->LocalRandomEngine());
+  VLOG(3) << "SlotRecordDataset::GlobalShuffle() local ins num "
+          << data.size();
+
+  uint32_t uint64_slot_num = 0;
+  uint32_t float_slot_num = 0;
+  count_used_slots(data_feed_desc_, &uint64_slot_num, &float_slot_num);
+  size_t batch_size = std::max<int64_t>(fleet_send_batch_size_, 1);
+  std::atomic<size_t> next_batch(0);
+
+  // Each batch is split by trainer and every part is encoded once into a
+  // block of its own message, the receiver fills its pooled records from
+  // the block columns without parsing record by record.
+  auto global_shuffle_func = [&]() {
+    std::vector<std::vector<SlotRecord>> parts(this->trainer_num_);
+    std::vector<std::string> msgs(this->trainer_num_);
+    std::vector<int> send_index(this->trainer_num_);
+    for (int i = 0; i < this->trainer_num_; ++i) {
+      send_index[i] = i;
+    }
+    size_t begin = 0;
+    while ((begin = next_batch.fetch_add(batch_size)) < data.size()) {
+      size_t end = std::min(data.size(), begin + batch_size);
+      for (size_t i = begin; i < end; ++i) {
+        const SlotRecord& rec = data[i];
+        size_t client_id =
+            this->merge_by_ins_id_
+                ? XXH64(rec->ins_id_.data(), rec->ins_id_.length(), 0) %
+                      this->trainer_num_
+                : fleet_ptr->LocalRandomEngine()() % this->trainer_num_;
+        parts[client_id].push_back(rec);
+      }
+      std::vector<std::future<int32_t>> total_status;
+      std::shuffle(
+          send_index.begin(), send_index.end(), fleet_ptr->LocalRandomEngine());
+      for (int index = 0; index < this->trainer_num_; ++index) {
+        int i = send_index[index];
+        if (parts[i].empty()) {
+          continue;
+        }
+        msgs[i].clear();
+        EncodeSlotRecordBlock(parts[i].data(),
+                              parts[i].size(),
+                              uint64_slot_num,
+                              float_slot_num,
+                              &msgs[i]);
+        parts[i].clear();
+        total_status.push_back(fleet_ptr->SendClientToClientMsg(0, i, msgs[i]));
+      }
+      for (auto& t : total_status) {
+        t.wait();
+      }
+      if (fleet_send_sleep_seconds_ != 0) {
+        sleep(this->fleet_send_sleep_seconds_);
+      }
+    }
+  };
+
+  std::vector<std::thread> global_shuffle_threads;
+  if (thread_num == -1) {
+    thread_num = thread_num_;
+  }
+  VLOG(3) << "start global shuffle threads, num = " << thread_num;
+  for (int i = 0; i < thread_num; ++i) {
+    global_shuffle_threads.emplace_back(global_shuffle_func);
+  }
+  for (std::thread& t : global_shuffle_threads) {
+    t.join();
+  }
+  // the sent records live on in the messages, reuse their memory
+  SlotRecordPool().put(&data);
+  timeline.Pause();
+  VLOG(3) << "SlotRecordDataset::GlobalShuffle() end, cost time="
+          << timeline.ElapsedSec() << " seconds";
+}
+
+int SlotRecordDataset::ReceiveFromClient(int msg_type,
+                                         int client_id,
+                                         const std::string& msg) {
+  VLOG(3) << "ReceiveFromClient msg_type=" << msg_type
+          << ", client_id=" << client_id << ", msg length=" << msg.length();
+  if (msg.empty()) {
+    return 0;
+  }
+  uint32_t uint64_slot_num = 0;
+  uint32_t float_slot_num = 0;
+  count_used_slots(data_feed_desc_, &uint64_slot_num, &float_slot_num);
+  std::vector<SlotRecord> data;
+  std::string name = "client " + std::to_string(client_id);
+  size_t pos = 0;
+  while (pos < msg.size()) {
+    pos += DecodeSlotRecordBlock(msg.data() + pos,
+                                 msg.size() - pos,
+                                 uint64_slot_num,
+                                 float_slot_num,
+                                 name,
+                                 &data);
+  }
+  // input_channel_ stays closed for its readers, open it only to write
+  std::unique_lock<std::mutex> lk(global_index_mutex_);
+  bool closed = input_channel_->Closed();
+  input_channel_->Open();
+  input_channel_->Write(std::move(data));
+  if (closed) {
+    input_channel_->Close();
+  }
+  return 0;
 }
 
 void SlotRecordDataset::DynamicAdjustChannelNum(int channel_num,
@@ -2192,7 +2694,10 @@ void SlotRecordDataset::DynamicAdjustReadersNum(int thread_num) {
   std::vector<std::shared_ptr<paddle::framework::DataFeed>>().swap(readers_);
   CreateReaders();
   VLOG(3) << "adjust readers num done";
-  PrepareTrain();
+  // streaming readers take their batches from stream_output_channel_
+  if (stream_output_channel_ == nullptr) {
+    PrepareTrain();
+  }
 }
 
 }  // namespace paddle::framework
@@ -121,6 +121,18 @@ class Dataset {
   virtual void PreLoadIntoMemory() = 0;
   // wait async load done
   virtual void WaitPreLoadDone() = 0;
+  // dump the parsed data in memory into binary cache files under cache_dir
+  virtual void DumpIntoBinaryCache(const std::string& cache_dir) = 0;
+  // load the binary cache files under cache_dir instead of the filelist,
+  // an empty cache_dir switches back to the filelist
+  virtual void SetBinaryCacheDir(const std::string& cache_dir) = 0;
+  // stream the data to the readers while they load, shuffled within
+  // window_size records, window_size 0 turns it off
+  virtual void SetStreamingMode(int64_t window_size,
+                                const std::string& spill_dir) = 0;
+  // the records the readers took from the last stream, set by
+  // WaitPreLoadDone
+  virtual int64_t GetStreamDataSize() = 0;
   // release all memory data
   virtual void ReleaseMemory() = 0;
   // local shuffle data
@@ -245,6 +257,11 @@ class DatasetImpl : public Dataset {
   virtual void LoadIntoMemory();
   virtual void PreLoadIntoMemory();
   virtual void WaitPreLoadDone();
+  virtual void DumpIntoBinaryCache(const std::string& cache_dir);
+  virtual void SetBinaryCacheDir(const std::string& cache_dir);
+  virtual void SetStreamingMode(int64_t window_size,
+                                const std::string& spill_dir);
+  virtual int64_t GetStreamDataSize();
   virtual void ReleaseMemory();
   virtual void LocalShuffle();
   virtual void GlobalShuffle(int thread_num UNUSED = -1) {}
@@ -338,6 +355,8 @@ class DatasetImpl : public Dataset {
   paddle::framework::DataFeedDesc data_feed_desc_;
   int trainer_num_;
   std::vector<std::string> filelist_;
+  // read by the readers instead of filelist_ when not empty
+  std::vector<std::string> binary_cache_files_;
   size_t file_idx_;
   uint64_t total_fea_num_;
   std::mutex mutex_for_pick_file_;
@@ -434,6 +453,14 @@ class SlotRecordDataset : public DatasetImpl<SlotRecord> {
   virtual void CreateReaders();
   // release memory
   virtual void ReleaseMemory();
+  virtual void DumpIntoBinaryCache(const std::string& cache_dir);
+  virtual void SetBinaryCacheDir(const std::string& cache_dir);
+  virtual void SetStreamingMode(int64_t window_size,
+                                const std::string& spill_dir);
+  virtual int64_t GetStreamDataSize() { return stream_data_size_; }
+  // in streaming mode they start and finish the stream
+  virtual void PreLoadIntoMemory();
+  virtual void WaitPreLoadDone();
   virtual void GlobalShuffle(int thread_num = -1);
   virtual void DynamicAdjustChannelNum(int channel_num,
                                        bool discard_remaining_ins);
@@ -442,7 +469,23 @@ class SlotRecordDataset : public DatasetImpl<SlotRecord> {
   void DynamicAdjustBatchNum();
 
  protected:
+  virtual int ReceiveFromClient(int msg_type,
+                                int client_id,
+                                const std::string& msg);
+  // Shuffles the records of the preload readers within a window of
+  // stream_window_size_ records and feeds them to the readers, spilling
+  // to stream_spill_dir_ while the readers are behind.
+  void StreamShuffle();
   bool enable_heterps_ = true;
+  int64_t stream_window_size_ = 0;
+  std::string stream_spill_dir_;
+  paddle::framework::Channel<SlotRecord> stream_input_channel_;
+  paddle::framework::Channel<SlotRecord> stream_output_channel_;
+  std::vector<std::thread> stream_threads_;
+  // the records StreamShuffle handed to the readers, and of those the ones
+  // they took by the end of the stream
+  int64_t stream_out_ins_ = 0;
+  int64_t stream_data_size_ = 0;
 };
 
 }  // namespace framework
@@ -0,0 +1,248 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/io/prefetch_file_reader.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#include "paddle/fluid/framework/io/fs.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle::framework {
+
+static double prefetch_now_seconds() {
+  return std::chrono::duration<double>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+PrefetchFileReader::PrefetchFileReader(PickFunc pick,
+                                       OpenFunc open,
+                                       int files_in_flight,
+                                       size_t block_size,
+                                       size_t max_blocks_per_file)
+    : pick_(std::move(pick)),
+      open_(std::move(open)),
+      block_size_(block_size),
+      max_blocks_per_file_(max_blocks_per_file) {
+  PADDLE_ENFORCE_GT(files_in_flight,
+                    0,
+                    common::errors::InvalidArgument(
+                        "files_in_flight should be positive, but got %d.",
+                        files_in_flight));
+  PADDLE_ENFORCE_GT(
+      block_size_ * max_blocks_per_file_,
+      0UL,
+      common::errors::InvalidArgument(
+          "block_size and max_blocks_per_file should be positive."));
+  start_seconds_ = prefetch_now_seconds();
+  running_ = files_in_flight;
+  for (int i = 0; i < files_in_flight; ++i) {
+    threads_.emplace_back([this]() { FetchThread(); });
+  }
+}
+
+PrefetchFileReader::~PrefetchFileReader() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  room_cond_.notify_all();
+  for (auto& t : threads_) {
+    t.join();
+  }
+}
+
+std::unique_ptr<char[]> PrefetchFileReader::TakeBuffer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_buffers_.empty()) {
+      auto buffer = std::move(free_buffers_.back());
+      free_buffers_.pop_back();
+      return buffer;
+    }
+  }
+  return std::unique_ptr<char[]>(new char[block_size_]);
+}
+
+void PrefetchFileReader::FetchThread() {
+  while (true) {
+    auto file = std::make_shared<File>();
+    int err_no = 0;
+    std::shared_ptr<FILE> fp;
+    double begin = prefetch_now_seconds();
+    try {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_) {
+          break;
+        }
+      }
+      if (!pick_(&file->name)) {
+        break;
+      }
+      begin = prefetch_now_seconds();
+      fp = open_(file->name, &err_no);
+      PADDLE_ENFORCE_NOT_NULL(
+          fp,
+          common::errors::Unavailable("Failed to open file %s.", file->name));
+    } catch (...) {
+      file->error = std::current_exception();
+      file->done = true;
+      std::lock_guard<std::mutex> lock(mutex_);
+      ready_.push_back(std::move(file));
+      data_cond_.notify_all();
+      break;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stats_.open_seconds += prefetch_now_seconds() - begin;
+      ready_.push_back(file);
+    }
+    data_cond_.notify_all();
+
+    double read_seconds = 0;
+    while (true) {
+      auto buffer = TakeBuffer();
+      begin = prefetch_now_seconds();
+      size_t size = fread(buffer.get(), 1, block_size_, fp.get());
+      read_seconds += prefetch_now_seconds() - begin;
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (size == 0 || file->abandoned || stop_) {
+        free_buffers_.push_back(std::move(buffer));
+        break;
+      }
+      stats_.bytes += size;
+      file->blocks.push_back(Block{std::move(buffer), size});
+      data_cond_.notify_all();
+      room_cond_.wait(lock, [this, &file]() {
+        return stop_ || file->abandoned ||
+               file->blocks.size() < max_blocks_per_file_;
+      });
+    }
+    bool read_error = ferror(fp.get()) != 0;
+    // closing a pipe reports the exit status of its command in err_no
+    begin = prefetch_now_seconds();
+    fp = nullptr;
+    read_seconds += prefetch_now_seconds() - begin;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      file->failed = read_error || err_no != 0;
+      file->done = true;
+      stats_.read_seconds += read_seconds;
+      ++stats_.files;
+    }
+    data_cond_.notify_all();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --running_;
+  }
+  data_cond_.notify_all();
+}
+
+bool PrefetchFileReader::NextFile(std::string* filename) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (current_ != nullptr) {
+    for (auto& block : current_->blocks) {
+      free_buffers_.push_back(std::move(block.data));
+    }
+    current_->blocks.clear();
+    current_->abandoned = true;
+    current_ = nullptr;
+    room_cond_.notify_all();
+  }
+  if (ready_.empty() && running_ > 0) {
+    double begin = prefetch_now_seconds();
+    data_cond_.wait(lock,
+                    [this]() { return !ready_.empty() || running_ == 0; });
+    stats_.stall_seconds += prefetch_now_seconds() - begin;
+    ++stats_.stalls;
+  }
+  if (ready_.empty()) {
+    return false;
+  }
+  current_ = std::move(ready_.front());
+  ready_.pop_front();
+  current_offset_ = 0;
+  if (current_->error) {
+    auto error = current_->error;
+    current_ = nullptr;
+    std::rethrow_exception(error);
+  }
+  *filename = current_->name;
+  return true;
+}
+
+int PrefetchFileReader::Read(char* buf, int len) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  PADDLE_ENFORCE_NOT_NULL(
+      current_,
+      common::errors::PreconditionNotMet(
+          "Call NextFile before reading from the PrefetchFileReader."));
+  auto file = current_;
+  if (file->blocks.empty() && !file->done) {
+    double begin = prefetch_now_seconds();
+    data_cond_.wait(lock,
+                    [&file]() { return !file->blocks.empty() || file->done; });
+    stats_.stall_seconds += prefetch_now_seconds() - begin;
+    ++stats_.stalls;
+  }
+  if (file->blocks.empty() || len <= 0) {
+    return 0;
+  }
+  // only the consumer pops blocks and a deque keeps its elements in place
+  // on push_back, so the front block can be copied without the lock
+  Block& block = file->blocks.front();
+  size_t num =
+      std::min(static_cast<size_t>(len), block.size - current_offset_);
+  lock.unlock();
+  memcpy(buf, block.data.get() + current_offset_, num);
+  current_offset_ += num;
+  if (current_offset_ == block.size) {
+    lock.lock();
+    free_buffers_.push_back(std::move(block.data));
+    file->blocks.pop_front();
+    current_offset_ = 0;
+    lock.unlock();
+    room_cond_.notify_all();
+  }
+  return static_cast<int>(num);
+}
+
+bool PrefetchFileReader::Failed() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return current_ != nullptr && current_->done && current_->blocks.empty() &&
+         current_->failed;
+}
+
+PrefetchFileReader::Stats PrefetchFileReader::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats = stats_;
+  stats.elapsed_seconds = prefetch_now_seconds() - start_seconds_;
+  return stats;
+}
+
+PrefetchFileReader::OpenFunc PrefetchFileReader::FsOpenRead(
+    const std::string& converter) {
+  return [converter](const std::string& path, int* err_no) {
+    return fs_open_read(path, err_no, converter, true);
+  };
+}
+
+}  // namespace paddle::framework
@@ -0,0 +1,128 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+// Reads the files handed out by a pick callback ahead of their consumer.
+// Each of files_in_flight threads picks a file, opens it and reads it in
+// blocks of block_size bytes, so a remote file's shell pipe is started and
+// its first blocks are buffered while the consumer is still parsing the
+// previous file. Blocks are recycled through a free list, at most
+// max_blocks_per_file of them are buffered per file.
+//
+// The consumer takes the files in the order they were opened:
+//
+//   PrefetchFileReader reader(pick, open, 2, 4 << 20);
+//   while (reader.NextFile(&filename)) {
+//     while ((len = reader.Read(buf, sizeof(buf))) > 0) { ... }
+//     if (reader.Failed()) { ... read filename again ... }
+//   }
+class PrefetchFileReader {
+ public:
+  using PickFunc = std::function<bool(std::string*)>;
+  using OpenFunc =
+      std::function<std::shared_ptr<FILE>(const std::string&, int*)>;
+
+  struct Stats {
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+    // time the reading threads spent opening and reading the files
+    double open_seconds = 0;
+    double read_seconds = 0;
+    // time the consumer waited for a file or a block
+    double stall_seconds = 0;
+    uint64_t stalls = 0;
+    double elapsed_seconds = 0;
+  };
+
+  PrefetchFileReader(PickFunc pick,
+                     OpenFunc open,
+                     int files_in_flight,
+                     size_t block_size,
+                     size_t max_blocks_per_file = 4);
+  ~PrefetchFileReader();
+
+  // Moves to the next file, dropping what is left of the current one.
+  // Returns false once every picked file was handed out. Rethrows an
+  // exception thrown while picking or opening the file.
+  bool NextFile(std::string* filename);
+
+  // Reads up to len bytes of the current file, 0 at its end.
+  int Read(char* buf, int len);
+
+  // Whether the current file ended with a read error, e.g. a pipe command
+  // exiting with a non-zero status. Set once Read returned 0.
+  bool Failed();
+
+  Stats GetStats() const;
+
+  // Opens path through fs_open_read with the given converter.
+  static OpenFunc FsOpenRead(const std::string& converter);
+
+ private:
+  struct Block {
+    std::unique_ptr<char[]> data;
+    size_t size = 0;
+  };
+
+  struct File {
+    std::string name;
+    std::deque<Block> blocks;
+    bool done = false;
+    bool failed = false;
+    bool abandoned = false;
+    std::exception_ptr error;
+  };
+
+  void FetchThread();
+  std::unique_ptr<char[]> TakeBuffer();
+
+  PickFunc pick_;
+  OpenFunc open_;
+  size_t block_size_;
+  size_t max_blocks_per_file_;
+
+  mutable std::mutex mutex_;
+  // the consumer waits for data, the reading threads for room
+  std::condition_variable data_cond_;
+  std::condition_variable room_cond_;
+  std::deque<std::shared_ptr<File>> ready_;
+  std::shared_ptr<File> current_;
+  size_t current_offset_ = 0;
+  std::vector<std::unique_ptr<char[]>> free_buffers_;
+  int running_ = 0;
+  bool stop_ = false;
+  Stats stats_;
+  double start_seconds_ = 0;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -14,6 +14,8 @@
 
 #include "paddle/fluid/framework/new_executor/instruction/instruction_base.h"
 
+#include <algorithm>
+
 #include "paddle/fluid/framework/new_executor/instruction/instruction_util.h"
 #include "paddle/fluid/framework/new_executor/interpreter/interpreter_util.h"
 #include "paddle/fluid/framework/new_executor/pir_adaptor/pir_adaptor_util.h"
@@ -241,6 +243,15 @@ void InstructionBase::WaitEvent(const Place& place) const {
 
 void InstructionBase::AddGCCheckVar(size_t id) { gc_check_vars_.push_back(id); }
 
+bool InstructionBase::RemoveGCCheckVar(size_t id) {
+  auto it = std::find(gc_check_vars_.begin(), gc_check_vars_.end(), id);
+  if (it == gc_check_vars_.end()) {
+    return false;
+  }
+  gc_check_vars_.erase(it);
+  return true;
+}
+
 const std::vector<size_t>& InstructionBase::GCCheckVars() const {
   return gc_check_vars_;
 }
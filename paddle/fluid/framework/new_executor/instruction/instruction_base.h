@@ -126,6 +126,8 @@ class InstructionBase {
 
   const std::vector<size_t>& GCCheckVars() const;
   void AddGCCheckVar(size_t id);
+  // returns whether id was checked by this instruction
+  bool RemoveGCCheckVar(size_t id);
   const std::vector<Variable*>& EagerGCVars() const;
   void AddEagerGCVar(Variable* var);
   void ClearEagerGCVars();
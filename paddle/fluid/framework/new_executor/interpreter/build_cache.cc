@@ -0,0 +1,236 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/interpreter/build_cache.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <utility>
+
+#include "glog/logging.h"
+
+namespace paddle::framework::interpreter {
+
+static const char kBuildCacheMagic[8] = {
+    'P', 'I', 'R', 'B', 'C', 'A', 'C', 'H'};
+static const uint64_t kBuildCacheVersion = 2;
+
+static void write_u64(std::ostream& os, uint64_t value) {
+  os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void write_ids(std::ostream& os, const std::set<size_t>& ids) {
+  write_u64(os, ids.size());
+  for (size_t id : ids) {
+    write_u64(os, id);
+  }
+}
+
+static void write_id_map(std::ostream& os,
+                         const std::map<size_t, std::set<size_t>>& id_map) {
+  write_u64(os, id_map.size());
+  for (auto& item : id_map) {
+    write_u64(os, item.first);
+    write_ids(os, item.second);
+  }
+}
+
+// Reads the cache, every id is checked to be less than limit and every
+// count to be at most limit, so that a corrupted file is rejected instead of
+// indexing out of the instructions or allocating without bound.
+class BuildCacheReader {
+ public:
+  explicit BuildCacheReader(std::istream* is) : is_(is) {}
+
+  bool ok() const { return ok_; }
+
+  uint64_t U64() {
+    uint64_t value = 0;
+    if (ok_ && !is_->read(reinterpret_cast<char*>(&value), sizeof(value))) {
+      ok_ = false;
+    }
+    return value;
+  }
+
+  size_t Id(size_t limit) {
+    uint64_t id = U64();
+    if (id >= limit) {
+      ok_ = false;
+    }
+    return ok_ ? id : 0;
+  }
+
+  uint64_t Count(size_t limit) {
+    uint64_t num = U64();
+    if (num > limit) {
+      ok_ = false;
+    }
+    return ok_ ? num : 0;
+  }
+
+  void Ids(size_t limit, std::set<size_t>* ids) {
+    uint64_t num = Count(limit);
+    for (uint64_t i = 0; ok_ && i < num; ++i) {
+      ids->insert(Id(limit));
+    }
+  }
+
+  void IdMap(size_t key_limit,
+             size_t id_limit,
+             std::map<size_t, std::set<size_t>>* id_map) {
+    uint64_t num = Count(key_limit);
+    for (uint64_t i = 0; ok_ && i < num; ++i) {
+      size_t key = Id(key_limit);
+      Ids(id_limit, &(*id_map)[key]);
+    }
+  }
+
+ private:
+  std::istream* is_;
+  bool ok_ = true;
+};
+
+uint64_t InterpreterBuildCacheKey(const std::string& fingerprint) {
+  // FNV-1a, stable across builds and processes unlike std::hash
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : fingerprint) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+bool LoadInterpreterBuildCache(const std::string& path,
+                               const std::string& fingerprint,
+                               size_t instr_num,
+                               size_t var_num,
+                               InterpreterBuildCache* cache) {
+  std::ifstream is(path, std::ios::binary);
+  if (!is) {
+    return false;
+  }
+  char magic[sizeof(kBuildCacheMagic)];
+  if (!is.read(magic, sizeof(magic)) ||
+      !std::equal(magic, magic + sizeof(magic), kBuildCacheMagic)) {
+    LOG(WARNING) << path << " is not a PirInterpreter build cache.";
+    return false;
+  }
+  BuildCacheReader reader(&is);
+  if (reader.U64() != kBuildCacheVersion ||
+      reader.U64() != fingerprint.size()) {
+    VLOG(1) << path << " was saved for another program or version.";
+    return false;
+  }
+  std::string saved_fingerprint(fingerprint.size(), '\0');
+  if (!is.read(saved_fingerprint.data(),
+               static_cast<std::streamsize>(saved_fingerprint.size())) ||
+      saved_fingerprint != fingerprint) {
+    VLOG(1) << path << " was saved for another program.";
+    return false;
+  }
+
+  InterpreterBuildCache loaded;
+  size_t num = reader.U64();
+  // checked before the happens before matrix of num * num bits is allocated
+  if (!reader.ok() || num != instr_num) {
+    LOG(WARNING) << path << " does not match the program.";
+    return false;
+  }
+  loaded.instr_num = num;
+  reader.IdMap(num, num, &loaded.op_downstream_map);
+  loaded.op_happens_before.assign(num, std::vector<bool>(num, false));
+  std::vector<char> row((num + 7) / 8);
+  for (size_t i = 0; reader.ok() && i < num; ++i) {
+    if (!is.read(row.data(), static_cast<std::streamsize>(row.size()))) {
+      break;
+    }
+    for (size_t j = 0; j < num; ++j) {
+      loaded.op_happens_before[i][j] = (row[j / 8] >> (j % 8)) & 1;
+    }
+  }
+  // the stream analysis runs on two steps of instructions
+  uint64_t context_num = reader.Count(num);
+  for (uint64_t i = 0; reader.ok() && i < context_num; ++i) {
+    size_t context_instr = reader.Id(num);
+    reader.IdMap(2 * num, 2 * num, &loaded.event_info[context_instr]);
+  }
+  reader.IdMap(var_num, num, &loaded.last_live_ops);
+  uint64_t order_num = reader.Count(num);
+  for (uint64_t i = 0; reader.ok() && i < order_num; ++i) {
+    loaded.trace_execute_order.push_back(reader.Id(num));
+  }
+  if (!reader.ok() || !is) {
+    LOG(WARNING) << path << " is corrupted.";
+    return false;
+  }
+  *cache = std::move(loaded);
+  return true;
+}
+
+void SaveInterpreterBuildCache(const std::string& path,
+                               const std::string& fingerprint,
+                               const InterpreterBuildCache& cache) {
+  std::string tmp_path =
+      path + ".tmp." +
+      std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                     static_cast<size_t>(std::chrono::steady_clock::now()
+                                             .time_since_epoch()
+                                             .count()));
+  {
+    std::ofstream os(tmp_path, std::ios::binary | std::ios::trunc);
+    os.write(kBuildCacheMagic, sizeof(kBuildCacheMagic));
+    write_u64(os, kBuildCacheVersion);
+    write_u64(os, fingerprint.size());
+    os.write(fingerprint.data(),
+             static_cast<std::streamsize>(fingerprint.size()));
+    write_u64(os, cache.instr_num);
+    write_id_map(os, cache.op_downstream_map);
+    std::vector<char> row((cache.instr_num + 7) / 8);
+    for (auto& happens_before : cache.op_happens_before) {
+      std::fill(row.begin(), row.end(), 0);
+      for (size_t j = 0; j < happens_before.size(); ++j) {
+        if (happens_before[j]) {
+          row[j / 8] = static_cast<char>(row[j / 8] | (1 << (j % 8)));
+        }
+      }
+      os.write(row.data(), static_cast<std::streamsize>(row.size()));
+    }
+    write_u64(os, cache.event_info.size());
+    for (auto& item : cache.event_info) {
+      write_u64(os, item.first);
+      write_id_map(os, item.second);
+    }
+    write_id_map(os, cache.last_live_ops);
+    write_u64(os, cache.trace_execute_order.size());
+    for (size_t id : cache.trace_execute_order) {
+      write_u64(os, id);
+    }
+    if (!os) {
+      LOG(WARNING) << "Failed to write the PirInterpreter build cache "
+                   << tmp_path;
+      remove(tmp_path.c_str());
+      return;
+    }
+  }
+  if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG(WARNING) << "Failed to rename " << tmp_path << " to " << path;
+    remove(tmp_path.c_str());
+  }
+}
+
+}  // namespace paddle::framework::interpreter
@@ -0,0 +1,66 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+namespace interpreter {
+
+// The analysis results of a PirInterpreter that only depend on its
+// instructions, saved so that building the same program again, e.g. in
+// another process, skips the analysis.
+struct InterpreterBuildCache {
+  size_t instr_num = 0;
+  // the dependencies of PirDependencyBuilder
+  std::map<size_t, std::set<size_t>> op_downstream_map;
+  std::vector<std::vector<bool>> op_happens_before;
+  // the event info of PirStreamAnalyzer, keyed by the id of an instruction
+  // running on the device context instead of the context
+  std::map<size_t, std::map<size_t, std::set<size_t>>> event_info;
+  // the gc plan, the last instructions using each var
+  std::map<size_t, std::set<size_t>> last_live_ops;
+  std::vector<size_t> trace_execute_order;
+};
+
+// A stable 64 bit hash of the fingerprint describing the instructions of
+// an interpreter, which names its cache file.
+uint64_t InterpreterBuildCacheKey(const std::string& fingerprint);
+
+// Returns false if path does not exist, was saved for another fingerprint,
+// does not fit instr_num instructions and var_num vars, or is corrupted.
+bool LoadInterpreterBuildCache(const std::string& path,
+                               const std::string& fingerprint,
+                               size_t instr_num,
+                               size_t var_num,
+                               InterpreterBuildCache* cache);
+
+// Saves through a temporary file renamed to path, so that the processes
+// loading the cache concurrently never read a partial one. The fingerprint
+// is saved with the cache, a hash collision of two programs is detected on
+// load. Failures are only logged.
+void SaveInterpreterBuildCache(const std::string& path,
+                               const std::string& fingerprint,
+                               const InterpreterBuildCache& cache);
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,80 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/interpreter/critical_path.h"
+
+#include <algorithm>
+
+#include "paddle/common/errors.h"
+#include "paddle/phi/core/enforce.h"
+
+namespace paddle::framework::interpreter {
+
+std::vector<double> ComputeCriticalPathLengths(
+    const std::map<size_t, std::set<size_t>>& downstream_map,
+    const std::vector<double>& costs) {
+  size_t num = costs.size();
+  std::vector<size_t> dep_count(num, 0);
+  for (auto& item : downstream_map) {
+    for (size_t next_id : item.second) {
+      PADDLE_ENFORCE_LT(next_id,
+                        num,
+                        common::errors::OutOfRange(
+                            "The downstream instruction %d is out of the %d "
+                            "instructions.",
+                            next_id,
+                            num));
+      ++dep_count[next_id];
+    }
+  }
+
+  // topological order, then the lengths from the last instruction backwards
+  std::vector<size_t> order;
+  order.reserve(num);
+  for (size_t id = 0; id < num; ++id) {
+    if (dep_count[id] == 0) {
+      order.push_back(id);
+    }
+  }
+  for (size_t i = 0; i < order.size(); ++i) {
+    auto it = downstream_map.find(order[i]);
+    if (it == downstream_map.end()) {
+      continue;
+    }
+    for (size_t next_id : it->second) {
+      if (--dep_count[next_id] == 0) {
+        order.push_back(next_id);
+      }
+    }
+  }
+  PADDLE_ENFORCE_EQ(order.size(),
+                    num,
+                    common::errors::PreconditionNotMet(
+                        "The instruction dependencies contain a cycle."));
+
+  std::vector<double> lengths(num, 0);
+  for (auto rit = order.rbegin(); rit != order.rend(); ++rit) {
+    double downstream_length = 0;
+    auto it = downstream_map.find(*rit);
+    if (it != downstream_map.end()) {
+      for (size_t next_id : it->second) {
+        downstream_length = std::max(downstream_length, lengths[next_id]);
+      }
+    }
+    lengths[*rit] = costs[*rit] + downstream_length;
+  }
+  return lengths;
+}
+
+}  // namespace paddle::framework::interpreter
@@ -0,0 +1,34 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+namespace interpreter {
+
+// Returns, for each of the costs.size() instructions of a dependency DAG,
+// its cost plus the most expensive path through its downstream instructions,
+// i.e. the least time left to finish the program once it starts.
+std::vector<double> ComputeCriticalPathLengths(
+    const std::map<size_t, std::set<size_t>>& downstream_map,
+    const std::vector<double>& costs);
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
@@ -773,6 +773,19 @@ void PirDependencyBuilder::ShareDependencyFrom(
   is_build_ = true;
 }
 
+void PirDependencyBuilder::LoadDependency(
+    std::vector<paddle::framework::InstructionBase*> instructions,
+    std::map<size_t, std::set<size_t>> op_downstream_map,
+    std::vector<std::vector<bool>> op_happens_before) {
+  instructions_ = std::move(instructions);
+  op_num_ = instructions_.size();
+  op_downstream_map_ = std::make_shared<std::map<size_t, std::set<size_t>>>(
+      std::move(op_downstream_map));
+  op_happens_before_ = std::make_shared<std::vector<std::vector<bool>>>(
+      std::move(op_happens_before));
+  is_build_ = true;
+}
+
 void DependencyBuilderSimplify::GetAllbehind() {
   auto update_op_happen_before = [this](size_t prior_op_idx,
                                         size_t posterior_op_idx) {
@@ -124,6 +124,13 @@ class PirDependencyBuilder : public DependencyBuilder {
 
   void ShareDependencyFrom(const PirDependencyBuilder& src);
 
+  // Sets the dependencies of instructions computed by an earlier Build, e.g.
+  // loaded from a build cache, Build then returns them directly.
+  void LoadDependency(
+      std::vector<paddle::framework::InstructionBase*> instructions,
+      std::map<size_t, std::set<size_t>> op_downstream_map,
+      std::vector<std::vector<bool>> op_happens_before);
+
   bool IsSameDeviceContext(size_t op1, size_t op2) const {
     return &((instructions_)[op1]->DeviceContext()) ==
            &((instructions_)[op2]->DeviceContext());
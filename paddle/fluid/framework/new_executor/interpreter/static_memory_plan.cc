@@ -0,0 +1,179 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/interpreter/static_memory_plan.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "paddle/fluid/framework/variable.h"
+#include "paddle/phi/common/memory_utils.h"
+#include "paddle/phi/core/dense_tensor.h"
+
+namespace paddle::framework::interpreter {
+
+namespace {
+
+// A slice of the arena that keeps the arena alive while a tensor holds it.
+class ArenaSliceAllocation : public phi::Allocation {
+ public:
+  ArenaSliceAllocation(std::shared_ptr<phi::Allocation> arena,
+                       size_t offset,
+                       size_t size)
+      : phi::Allocation(static_cast<uint8_t*>(arena->ptr()) + offset,
+                        size,
+                        arena->place()),
+        arena_(std::move(arena)) {}
+
+ private:
+  std::shared_ptr<phi::Allocation> arena_;
+};
+
+size_t AlignUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+std::vector<size_t> PlanMemoryOffsets(
+    const std::vector<MemoryLiveRange>& ranges,
+    size_t alignment,
+    size_t* arena_size) {
+  std::vector<size_t> order(ranges.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&ranges](size_t a, size_t b) {
+    return ranges[a].size > ranges[b].size;
+  });
+
+  std::vector<size_t> offsets(ranges.size(), 0);
+  std::vector<size_t> placed;
+  std::vector<size_t> live;
+  *arena_size = 0;
+  for (size_t i : order) {
+    const MemoryLiveRange& range = ranges[i];
+    size_t size = AlignUp(range.size, alignment);
+    live.clear();
+    for (size_t j : placed) {
+      if (ranges[j].begin <= range.end && range.begin <= ranges[j].end) {
+        live.push_back(j);
+      }
+    }
+    std::sort(live.begin(), live.end(), [&offsets](size_t a, size_t b) {
+      return offsets[a] < offsets[b];
+    });
+    size_t best = std::numeric_limits<size_t>::max();
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t end = 0;
+    for (size_t j : live) {
+      if (offsets[j] >= end + size && offsets[j] - end < best_gap) {
+        best = end;
+        best_gap = offsets[j] - end;
+      }
+      end = std::max(end, offsets[j] + AlignUp(ranges[j].size, alignment));
+    }
+    offsets[i] = best == std::numeric_limits<size_t>::max() ? end : best;
+    *arena_size = std::max(*arena_size, offsets[i] + size);
+    placed.push_back(i);
+  }
+  return offsets;
+}
+
+void StaticMemoryPlan::AddVar(size_t var_id,
+                              Variable* var,
+                              const MemoryLiveRange& range) {
+  vars_[var_id] = PlannedVar{var, range, nullptr};
+}
+
+void StaticMemoryPlan::RemoveVar(size_t var_id) { vars_.erase(var_id); }
+
+void StaticMemoryPlan::ReserveSize(size_t var_id, size_t size) {
+  auto it = vars_.find(var_id);
+  if (it != vars_.end()) {
+    it->second.range.size = std::max(it->second.range.size, size);
+  }
+}
+
+std::vector<size_t> StaticMemoryPlan::VarIds() const {
+  std::vector<size_t> ids;
+  ids.reserve(vars_.size());
+  for (auto& kv : vars_) {
+    ids.push_back(kv.first);
+  }
+  return ids;
+}
+
+size_t StaticMemoryPlan::TotalSize() const {
+  size_t total = 0;
+  for (auto& kv : vars_) {
+    total += kv.second.range.size;
+  }
+  return total;
+}
+
+void StaticMemoryPlan::Build(const phi::Place& place) {
+  // the alignment of the GPU allocators, enough for vectorized CPU kernels
+  static const size_t kAlignment = 256;
+  std::vector<MemoryLiveRange> ranges;
+  ranges.reserve(vars_.size());
+  for (auto& kv : vars_) {
+    ranges.push_back(kv.second.range);
+  }
+  std::vector<size_t> offsets =
+      PlanMemoryOffsets(ranges, kAlignment, &arena_size_);
+  arena_ = phi::memory_utils::AllocShared(place, std::max<size_t>(
+                                                     arena_size_, kAlignment));
+  size_t i = 0;
+  for (auto& kv : vars_) {
+    kv.second.slice = std::make_shared<ArenaSliceAllocation>(
+        arena_, offsets[i], AlignUp(kv.second.range.size, kAlignment));
+    ++i;
+  }
+}
+
+void StaticMemoryPlan::Bind() {
+  for (auto& kv : vars_) {
+    auto* tensor = kv.second.var->GetMutable<phi::DenseTensor>();
+    if (tensor->Holder() != kv.second.slice) {
+      tensor->clear();
+      tensor->ResetHolder(kv.second.slice);
+    }
+  }
+}
+
+bool StaticMemoryPlan::Check() const {
+  for (auto& kv : vars_) {
+    if (kv.second.var->Get<phi::DenseTensor>().Holder() != kv.second.slice) {
+      VLOG(4) << "var " << kv.first << " left its slice of the arena";
+      return false;
+    }
+  }
+  return true;
+}
+
+void StaticMemoryPlan::Clear() {
+  for (auto& kv : vars_) {
+    auto* tensor = kv.second.var->GetMutable<phi::DenseTensor>();
+    if (kv.second.slice != nullptr && tensor->Holder() == kv.second.slice) {
+      tensor->clear();
+    }
+  }
+  vars_.clear();
+  arena_ = nullptr;
+  arena_size_ = 0;
+}
+
+}  // namespace paddle::framework::interpreter
@@ -0,0 +1,91 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "paddle/phi/common/place.h"
+#include "paddle/phi/core/allocator.h"
+
+namespace paddle {
+namespace framework {
+class Variable;
+
+namespace interpreter {
+
+// A buffer of size bytes used from the step begin to the step end, both
+// included, of a linear execution order.
+struct MemoryLiveRange {
+  size_t size;
+  size_t begin;
+  size_t end;
+};
+
+// Returns the offsets of the ranges in one arena of *arena_size bytes, such
+// that ranges live at a common step never overlap. The ranges are placed by
+// decreasing size, each one into the smallest gap left between the placed
+// ranges it is live with, or after all of them.
+std::vector<size_t> PlanMemoryOffsets(
+    const std::vector<MemoryLiveRange>& ranges,
+    size_t alignment,
+    size_t* arena_size);
+
+// The DenseTensors of a program run in a fixed order, bound to slices of one
+// arena allocated once. A kernel allocating an output through
+// DeviceContext::Alloc finds its slice large enough and does not call the
+// allocator; when the shape grew it allocates a holder of its own, which
+// Check reports after the run.
+class StaticMemoryPlan {
+ public:
+  void AddVar(size_t var_id, Variable* var, const MemoryLiveRange& range);
+  void RemoveVar(size_t var_id);
+  bool HasVar(size_t var_id) const { return vars_.count(var_id) > 0; }
+  // grows the planned size of var_id, e.g. to the size a kernel allocated
+  void ReserveSize(size_t var_id, size_t size);
+  std::vector<size_t> VarIds() const;
+  bool Empty() const { return vars_.empty(); }
+
+  // Places the vars and allocates the arena.
+  void Build(const phi::Place& place);
+  bool IsBuilt() const { return arena_ != nullptr; }
+
+  // Binds each tensor to its slice, before a run.
+  void Bind();
+  // Whether every tensor still holds its slice, after a run.
+  bool Check() const;
+  // Drops the vars and releases the arena.
+  void Clear();
+
+  size_t ArenaSize() const { return arena_size_; }
+  // the bytes the vars would take without sharing the arena
+  size_t TotalSize() const;
+
+ private:
+  struct PlannedVar {
+    Variable* var;
+    MemoryLiveRange range;
+    std::shared_ptr<phi::Allocation> slice;
+  };
+
+  std::map<size_t, PlannedVar> vars_;
+  std::shared_ptr<phi::Allocation> arena_;
+  size_t arena_size_ = 0;
+};
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
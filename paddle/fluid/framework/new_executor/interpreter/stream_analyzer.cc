@@ -857,6 +857,15 @@ void PirStreamAnalyzer::ShareEventInfoFrom(const PirStreamAnalyzer& src) {
   is_event_info_build_ = true;
 }
 
+void PirStreamAnalyzer::LoadEventInfo(
+    std::map<const DeviceContext*, std::map<size_t, std::set<size_t>>>
+        event_info) {
+  event_info_ = std::make_shared<
+      std::map<const DeviceContext*, std::map<size_t, std::set<size_t>>>>(
+      std::move(event_info));
+  is_event_info_build_ = true;
+}
+
 std::shared_ptr<
     std::map<const DeviceContext*, std::map<size_t, std::set<size_t>>>>
 PirStreamAnalyzer::GetEventInfo() const {
@@ -144,6 +144,12 @@ class PirStreamAnalyzer {
 
   void ShareEventInfoFrom(const PirStreamAnalyzer& src);
 
+  // Sets the event info computed by an earlier ConstructEvents, e.g. loaded
+  // from a build cache, ConstructEvents then only creates the events.
+  void LoadEventInfo(
+      std::map<const DeviceContext*, std::map<size_t, std::set<size_t>>>
+          event_info);
+
   void SetForceEventsToWaitInfo(
       std::unordered_map<std::string, std::shared_ptr<EventInter>>*
           program_force_events_to_wait) {
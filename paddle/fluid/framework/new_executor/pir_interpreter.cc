@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/framework/new_executor/pir_interpreter.h"
 
+#include <algorithm>
 #include <chrono>
 #include <unordered_set>
 
@@ -90,6 +91,14 @@ COMMON_DECLARE_bool(enable_pir_in_executor_trace_run);
 COMMON_DECLARE_bool(enable_collect_shape);
 COMMON_DECLARE_int32(low_precision_op_list);
 COMMON_DECLARE_bool(pir_interpreter_record_stream_for_gc_cache);
+COMMON_DECLARE_bool(pir_interpreter_static_memory_plan);
+COMMON_DECLARE_bool(pir_interpreter_critical_path_schedule);
+COMMON_DECLARE_double(pir_interpreter_inline_op_cost_us);
+COMMON_DECLARE_bool(pir_interpreter_batch_cpu_instructions);
+COMMON_DECLARE_bool(pir_interpreter_log_dispatch_overhead);
+COMMON_DECLARE_string(pir_interpreter_build_cache_dir);
+COMMON_DECLARE_bool(add_dependency_for_communication_op);
+COMMON_DECLARE_int32(enable_adjust_op_order);
 
 #define CREATE_INSTR(instr_name)                                   \
   vec_instruction_base_.emplace_back(std::make_unique<instr_name>( \
@@ -114,9 +123,11 @@ void RecordLowPrecisionOp(const InstructionBase* instr_node) {
 
 bool UseTraceRun(const ExecutionConfig& execution_config,
                  size_t onednn_op_num,
-                 size_t sync_op_num) {
+                 size_t sync_op_num,
+                 bool trace_inference = true) {
   return FLAGS_enable_pir_in_executor_trace_run || onednn_op_num ||
-         execution_config.used_for_inference || execution_config.used_for_sot ||
+         (trace_inference && execution_config.used_for_inference) ||
+         execution_config.used_for_sot ||
          ((execution_config.used_for_jit || execution_config.used_for_cinn) &&
           (sync_op_num == 0));
 }
@@ -197,6 +208,10 @@ PirInterpreter::PirInterpreter(const phi::Place& place,
     SchedulingPriority rhs_scheduling_priority =
         vec_instruction_base_[rhs]->GetSchedulingPriority();
     if (lhs_scheduling_priority == rhs_scheduling_priority) {
+      if (!critical_path_.empty() &&
+          critical_path_[lhs] != critical_path_[rhs]) {
+        return critical_path_[lhs] < critical_path_[rhs];
+      }
       return lhs > rhs;
     }
     return lhs_scheduling_priority > rhs_scheduling_priority;
@@ -288,6 +303,10 @@ PirInterpreter::PirInterpreter(
     SchedulingPriority rhs_scheduling_priority =
         vec_instruction_base_[rhs]->GetSchedulingPriority();
     if (lhs_scheduling_priority == rhs_scheduling_priority) {
+      if (!critical_path_.empty() &&
+          critical_path_[lhs] != critical_path_[rhs]) {
+        return critical_path_[lhs] < critical_path_[rhs];
+      }
       return lhs > rhs;
     }
     return lhs_scheduling_priority > rhs_scheduling_priority;
@@ -1101,6 +1120,11 @@ void PirInterpreter::BuildInstructionDependences() {
   for (auto& instr : vec_instruction_base_) {
     instructions_ptr.push_back(instr.get());
   }
+  if (build_cache_ != nullptr) {
+    ir_dependency_builder_.LoadDependency(instructions_ptr,
+                                          build_cache_->op_downstream_map,
+                                          build_cache_->op_happens_before);
+  }
   auto downstream_map = ir_dependency_builder_.Build(instructions_ptr);
 
   for (size_t instr_id = 0; instr_id < instr_num; ++instr_id) {
@@ -1456,6 +1480,451 @@ void PirInterpreter::CalculateLastLiveOps() {
   VLOG(4) << "done CalculateLastLiveOps";
 }
 
+void PirInterpreter::RestoreLastLiveOps() {
+  // the cached last_live_ops_ are already shrunk
+  last_live_ops_ = build_cache_->last_live_ops;
+  var_ref_count_.resize(value_exe_info_->GetVarList().size());
+  for (auto& kv : last_live_ops_) {
+    for (size_t op_idx : kv.second) {
+      vec_instruction_base_[op_idx]->AddGCCheckVar(kv.first);
+    }
+    var_ref_count_[kv.first] = static_cast<int>(kv.second.size());
+  }
+
+  for (auto& dep : *dependency_count_) {
+    deps_.emplace_back(std::make_shared<interpreter::OpDepInfo>(dep));
+  }
+  for (size_t i = 0; i < value_exe_info_->GetVarList().size(); ++i) {
+    refs_.emplace_back(std::make_shared<interpreter::VarRefInfo>(
+        var_ref_count_[i], value_exe_info_->GetVarList()[i]));
+  }
+  VLOG(4) << "done RestoreLastLiveOps";
+}
+
+static std::string build_cache_var_ids(
+    const std::unordered_map<::pir::Value, std::vector<int>>& vars,
+    const std::unordered_set<::pir::Value>& no_need_buffer) {
+  std::vector<std::string> items;
+  for (auto& item : vars) {
+    std::stringstream ss;
+    ss << (no_need_buffer.count(item.first) ? "~" : "");
+    for (int var_id : item.second) {
+      ss << var_id << ",";
+    }
+    items.push_back(ss.str());
+  }
+  std::sort(items.begin(), items.end());
+  std::string ids;
+  for (auto& item : items) {
+    ids += " " + item;
+  }
+  return ids;
+}
+
+std::string PirInterpreter::BuildCacheFingerprint() const {
+  // the var names embed the address of the interpreter, the fingerprint
+  // describes the instructions by the ids of their vars instead
+  std::stringstream ss;
+  ss << place_ << " " << FLAGS_new_executor_sequential_run << " "
+     << FLAGS_new_executor_serial_run << " "
+     << FLAGS_add_dependency_for_communication_op << " "
+     << FLAGS_enable_adjust_op_order << "\nskip_gc";
+  std::vector<int> skip_gc_var_ids;
+  for (const std::string& name : execution_config_.skip_gc_vars) {
+    skip_gc_var_ids.push_back(value_exe_info_->GetIdByName(name));
+  }
+  std::sort(skip_gc_var_ids.begin(), skip_gc_var_ids.end());
+  for (int var_id : skip_gc_var_ids) {
+    ss << " " << var_id;
+  }
+  // the device contexts are numbered in the order they are first used
+  std::map<const phi::DeviceContext*, size_t> contexts;
+  for (auto& instr : vec_instruction_base_) {
+    size_t context =
+        contexts.emplace(&instr->DeviceContext(), contexts.size())
+            .first->second;
+    ss << "\n"
+       << instr->Name() << " " << static_cast<int>(instr->KernelType()) << " "
+       << instr->GetSchedulingPriority() << " " << context << " "
+       << (instr->Operation() != nullptr &&
+           interpreter::IsCommunicationOp(instr->Operation()))
+       << " " << instr->EventToRecordInfo() << " wait";
+    for (const std::string& info : instr->EventsToWaitInfo()) {
+      ss << " " << info;
+    }
+    ss << "\nin" << build_cache_var_ids(instr->Inputs(), instr->NoNeedBuffer())
+       << "\nout" << build_cache_var_ids(instr->Outputs(), {});
+  }
+  ss << "\nvars";
+  for (Variable* var : value_exe_info_->GetVarList()) {
+    ss << " " << (var->IsInitialized() ? var->Type() : -1);
+  }
+  return ss.str();
+}
+
+void PirInterpreter::LoadBuildCache() {
+  build_cache_ = nullptr;
+  build_cache_path_.clear();
+  // the shared results were analysed by another interpreter
+  if (FLAGS_pir_interpreter_build_cache_dir.empty() ||
+      is_shared_results_build_) {
+    return;
+  }
+  build_cache_fingerprint_ = BuildCacheFingerprint();
+  std::stringstream path;
+  path << FLAGS_pir_interpreter_build_cache_dir << "/pir_interpreter_"
+       << std::hex
+       << interpreter::InterpreterBuildCacheKey(build_cache_fingerprint_)
+       << std::dec << "_"
+       << phi::AllocationTypeStr(place_.GetType()) << place_.GetDeviceId()
+       << ".cache";
+  build_cache_path_ = path.str();
+
+  auto cache = std::make_unique<interpreter::InterpreterBuildCache>();
+  size_t instr_num = vec_instruction_base_.size();
+  if (!interpreter::LoadInterpreterBuildCache(
+          build_cache_path_,
+          build_cache_fingerprint_,
+          instr_num,
+          value_exe_info_->GetVarList().size(),
+          cache.get())) {
+    return;
+  }
+  if (cache->trace_execute_order.size() != instr_num) {
+    LOG(WARNING) << build_cache_path_ << " does not match the program.";
+    return;
+  }
+  VLOG(1) << "Load the PirInterpreter build cache " << build_cache_path_;
+  build_cache_ = std::move(cache);
+}
+
+void PirInterpreter::SaveBuildCache() {
+  interpreter::InterpreterBuildCache cache;
+  cache.instr_num = vec_instruction_base_.size();
+  cache.op_downstream_map = ir_dependency_builder_.OpDownstreamMap();
+  cache.op_happens_before =
+      *std::get<1>(ir_dependency_builder_.GetDependency());
+  // the device contexts are saved as the first instruction running on them
+  std::map<const phi::DeviceContext*, size_t> context_instr;
+  for (size_t i = vec_instruction_base_.size(); i > 0; --i) {
+    context_instr[&vec_instruction_base_[i - 1]->DeviceContext()] = i - 1;
+  }
+  for (auto& item : *ir_stream_analyzer_.GetEventInfo()) {
+    auto iter = context_instr.find(item.first);
+    if (iter == context_instr.end()) {
+      VLOG(1) << "Skip the build cache, an event is on a device context no "
+                 "instruction runs on.";
+      return;
+    }
+    cache.event_info[iter->second] = item.second;
+  }
+  cache.last_live_ops = last_live_ops_;
+  cache.trace_execute_order = trace_execute_order_;
+  interpreter::SaveInterpreterBuildCache(
+      build_cache_path_, build_cache_fingerprint_, cache);
+  VLOG(1) << "Save the PirInterpreter build cache " << build_cache_path_;
+}
+
+// the bytes of a value allocated on place with a static shape, 0 otherwise
+static size_t static_dense_tensor_size(::pir::Value value,
+                                       const phi::Place& place) {
+  if (!value || !value.type()) {
+    return 0;
+  }
+  auto type =
+      value.type().dyn_cast<paddle::dialect::AllocatedDenseTensorType>();
+  if (!type || type.place() != place ||
+      common::contain_unknown_dim(type.dims())) {
+    return 0;
+  }
+  return static_cast<size_t>(common::product(type.dims())) *
+         phi::SizeOf(paddle::dialect::TransToPhiDataType(type.dtype()));
+}
+
+void PirInterpreter::PrepareStaticMemoryPlan() {
+  // the instructions may have been rebuilt, do not restore their gc checks
+  static_memory_gc_instrs_.clear();
+  static_memory_plan_.Clear();
+  probe_static_memory_plan_ = false;
+  if (!FLAGS_pir_interpreter_static_memory_plan || !TraceRunEnabled()) {
+    return;
+  }
+
+  // the vars read after the run, or shared with other vars
+  std::unordered_set<int> excluded;
+  for (auto& op : *ir_block_) {
+    if (op.name() == "builtin.shadow_output") {
+      excluded.insert(value_exe_info_->GetVarId(op.operand_source(0)));
+    }
+  }
+
+  // only kernels on the default context of place_ are planned, so that the
+  // slices of the arena are reused in the order of a single stream
+  phi::DeviceContext* dev_ctx = phi::DeviceContextPool::Instance().Get(place_);
+  std::map<int, interpreter::MemoryLiveRange> ranges;
+  for (size_t step = 0; step < trace_execute_order_.size(); ++step) {
+    InstructionBase* instr =
+        vec_instruction_base_[trace_execute_order_[step]].get();
+    bool plannable =
+        dynamic_cast<BuiltinCombineInstruction*>(instr) != nullptr ||
+        ((dynamic_cast<PhiKernelInstruction*>(instr) != nullptr ||
+          dynamic_cast<LegacyKernelInstruction*>(instr) != nullptr) &&
+         &instr->DeviceContext() == dev_ctx);
+    for (auto& pair : instr->InplaceInfo()) {
+      excluded.insert(value_exe_info_->GetVarId(pair.first));
+      excluded.insert(value_exe_info_->GetVarId(pair.second));
+    }
+    for (auto& item : instr->Inputs()) {
+      bool no_need_buffer = instr->NoNeedBuffer().count(item.first) > 0;
+      for (int var_id : item.second) {
+        auto it = ranges.find(var_id);
+        if (!plannable || it == ranges.end()) {
+          // fed, persistable or used by an instruction we cannot follow
+          excluded.insert(var_id);
+        } else if (!no_need_buffer) {
+          it->second.end = step;
+        }
+      }
+    }
+    for (auto& item : instr->Outputs()) {
+      for (size_t i = 0; i < item.second.size(); ++i) {
+        int var_id = item.second[i];
+        auto it = ranges.find(var_id);
+        if (!plannable) {
+          excluded.insert(var_id);
+        } else if (it != ranges.end()) {
+          it->second.end = step;
+        } else {
+          // the other ids of a value are the vars of a VariableRefArray
+          size_t size =
+              i == 0 ? static_dense_tensor_size(item.first, place_) : 0;
+          if (size == 0) {
+            excluded.insert(var_id);
+          } else {
+            ranges[var_id] = interpreter::MemoryLiveRange{size, step, step};
+          }
+        }
+      }
+    }
+  }
+
+  for (auto& item : ranges) {
+    int var_id = item.first;
+    const std::string& var_name = value_exe_info_->GetNameById(var_id);
+    Variable* var = value_exe_info_->GetVarList()[var_id];
+    if (excluded.count(var_id) || var_ref_count_[var_id] == 0 ||
+        !var->IsType<phi::DenseTensor>() ||
+        var->Get<phi::DenseTensor>().initialized() ||
+        parameter_var_names_.count(var_name) ||
+        std::find(fetch_var_names_.begin(),
+                  fetch_var_names_.end(),
+                  var_name) != fetch_var_names_.end()) {
+      continue;
+    }
+    static_memory_plan_.AddVar(var_id, var, item.second);
+  }
+  VLOG(4) << "static memory plan candidates: "
+          << static_memory_plan_.VarIds().size();
+  probe_static_memory_plan_ = !static_memory_plan_.Empty();
+}
+
+void PirInterpreter::ProbeStaticMemoryPlan(InstructionBase* instr) {
+  std::vector<std::pair<int, const phi::Allocation*>> input_holders;
+  for (auto& item : instr->Inputs()) {
+    for (int var_id : item.second) {
+      Variable* var = value_exe_info_->GetVarList()[var_id];
+      if (var->IsType<phi::DenseTensor>() &&
+          var->Get<phi::DenseTensor>().Holder() != nullptr) {
+        input_holders.emplace_back(
+            var_id, var->Get<phi::DenseTensor>().Holder().get());
+      }
+    }
+  }
+  for (auto& item : instr->Outputs()) {
+    for (int var_id : item.second) {
+      Variable* var = value_exe_info_->GetVarList()[var_id];
+      if (!var->IsType<phi::DenseTensor>()) {
+        continue;
+      }
+      const phi::DenseTensor& tensor = var->Get<phi::DenseTensor>();
+      // an output sharing the buffer of an input, e.g. a view, keeps it
+      // alive beyond the live range of the input
+      bool shared = false;
+      for (auto& input : input_holders) {
+        if (input.first != var_id && input.second == tensor.Holder().get()) {
+          static_memory_plan_.RemoveVar(input.first);
+          shared = true;
+        }
+      }
+      if (!static_memory_plan_.HasVar(var_id)) {
+        continue;
+      }
+      if (shared || tensor.Holder() == nullptr) {
+        static_memory_plan_.RemoveVar(var_id);
+      } else {
+        static_memory_plan_.ReserveSize(
+            var_id,
+            tensor.numel() * phi::SizeOf(tensor.dtype()) +
+                tensor.meta().offset);
+      }
+    }
+  }
+}
+
+void PirInterpreter::BuildStaticMemoryPlan() {
+  if (static_memory_plan_.Empty()) {
+    return;
+  }
+  static_memory_plan_.Build(place_);
+  // the planned vars keep their slices between runs
+  for (size_t var_id : static_memory_plan_.VarIds()) {
+    for (size_t op_id : last_live_ops_[var_id]) {
+      InstructionBase* instr = vec_instruction_base_[op_id].get();
+      if (instr->RemoveGCCheckVar(var_id)) {
+        static_memory_gc_instrs_[var_id].push_back(instr);
+      }
+    }
+  }
+  VLOG(1) << "PirInterpreter(): " << this << " plans "
+          << static_memory_plan_.VarIds().size()
+          << " tensors in an arena of " << static_memory_plan_.ArenaSize()
+          << " bytes, " << static_memory_plan_.TotalSize()
+          << " bytes without reuse";
+}
+
+void PirInterpreter::DropStaticMemoryPlan() {
+  for (auto& item : static_memory_gc_instrs_) {
+    for (InstructionBase* instr : item.second) {
+      instr->AddGCCheckVar(item.first);
+    }
+  }
+  static_memory_gc_instrs_.clear();
+  static_memory_plan_.Clear();
+  LOG(WARNING) << "PirInterpreter(): " << this
+               << " falls back to dynamic allocation since a planned tensor "
+                  "was reallocated, e.g. because its shape changed";
+}
+
+bool PirInterpreter::TraceRunEnabled() const {
+  // inference runs in trace mode for its lower dispatch overhead, the
+  // critical path schedule opts it into the multi-thread scheduler, unless
+  // hooks that expect to be called in the execution order are registered
+  bool trace_inference = !FLAGS_pir_interpreter_critical_path_schedule ||
+                         !pir_input_hookfuncs_.empty() ||
+                         !pir_output_hookfuncs_.empty();
+  return UseTraceRun(
+      execution_config_, onednn_op_num_, sync_op_num_, trace_inference);
+}
+
+void PirInterpreter::PrepareCriticalPathSchedule() {
+  instruction_costs_.clear();
+  critical_path_.clear();
+  profile_instruction_costs_ = false;
+  if (!FLAGS_pir_interpreter_critical_path_schedule || TraceRunEnabled()) {
+    return;
+  }
+
+  // until the first run is profiled, an instruction is assumed to take 1us
+  // plus 1ns per element of its static outputs
+  instruction_costs_.assign(vec_instruction_base_.size(), 1.0);
+  for (size_t i = 0; i < vec_instruction_base_.size(); ++i) {
+    for (auto& item : vec_instruction_base_[i]->Outputs()) {
+      if (!item.first || !item.first.type()) {
+        continue;
+      }
+      auto type = item.first.type()
+                      .dyn_cast<paddle::dialect::AllocatedDenseTensorType>();
+      if (type && !common::contain_unknown_dim(type.dims())) {
+        instruction_costs_[i] += common::product(type.dims()) * 1e-3;
+      }
+    }
+  }
+  UpdateCriticalPath();
+  profile_instruction_costs_ = true;
+}
+
+void PirInterpreter::UpdateCriticalPath() {
+  critical_path_ = interpreter::ComputeCriticalPathLengths(
+      ir_dependency_builder_.OpDownstreamMap(), instruction_costs_);
+  if (VLOG_IS_ON(4)) {
+    for (size_t i = 0; i < critical_path_.size(); ++i) {
+      VLOG(4) << "critical path of " << i << "["
+              << vec_instruction_base_[i]->Name()
+              << "]: cost = " << instruction_costs_[i]
+              << "us, length = " << critical_path_[i] << "us";
+    }
+  }
+}
+
+void PirInterpreter::BuildTraceBatches() {
+  trace_batch_end_.clear();
+  if (!FLAGS_pir_interpreter_batch_cpu_instructions || !TraceRunEnabled()) {
+    return;
+  }
+
+  // cpu kernels without events to wait or record only need their kernel run
+  // and their gc checked
+  auto batchable = [](const InstructionBase* instr) {
+    return dynamic_cast<const PhiKernelInstruction*>(instr) != nullptr &&
+           instr->KernelType() == OpFuncType::kCpuSync &&
+           phi::is_cpu_place(instr->DeviceContext().GetPlace()) &&
+           !instr->IsArtificial() && !instr->IsSyncAfterLaunch() &&
+           instr->EventsToWait().empty() && instr->EventToRecord() == nullptr;
+  };
+  size_t instr_num = trace_execute_order_.size();
+  trace_batch_end_.assign(instr_num, 0);
+  size_t batch_num = 0;
+  size_t batched_instr_num = 0;
+  size_t begin = 0;
+  while (begin < instr_num) {
+    size_t end = begin;
+    while (end < instr_num &&
+           batchable(vec_instruction_base_[trace_execute_order_[end]].get())) {
+      ++end;
+    }
+    if (end - begin > 1) {
+      trace_batch_end_[begin] = end;
+      ++batch_num;
+      batched_instr_num += end - begin;
+    }
+    begin = std::max(end, begin + 1);
+  }
+  VLOG(4) << "PirInterpreter(): " << this << " batches " << batched_instr_num
+          << " of " << instr_num << " instructions in " << batch_num
+          << " batches";
+  if (batch_num == 0) {
+    trace_batch_end_.clear();
+  }
+}
+
+bool PirInterpreter::CanRunTraceBatches() const {
+  // the per instruction debugging and hooks need RunInstructionBase
+  return !trace_batch_end_.empty() && !FLAGS_check_nan_inf &&
+         !FLAGS_enable_collect_shape && !FLAGS_low_precision_op_list &&
+         !enable_job_schedule_profiler_ && !VLOG_IS_ON(2) &&
+         !(execution_config_.used_for_inference &&
+           (!pir_input_hookfuncs_.empty() || !pir_output_hookfuncs_.empty()));
+}
+
+void PirInterpreter::RunInstructionBatch(size_t begin, size_t end) {
+  phi::RecordEvent batch_event(
+      "InstructionBatch", phi::TracerEventType::Operator, 1);
+  for (size_t idx = begin; idx < end; ++idx) {
+    InstructionBase* instr_node =
+        vec_instruction_base_[trace_execute_order_[idx]].get();
+    try {
+      RunInstructionKernel(instr_node);
+      if (UNLIKELY(probe_static_memory_plan_)) {
+        ProbeStaticMemoryPlan(instr_node);
+      }
+      CheckGC(instr_node);
+    } catch (...) {
+      HandleInstructionException(instr_node);
+      return;
+    }
+  }
+}
+
 void PirInterpreter::ConstructEventForJitInput() {
   for (size_t i = 0; i < dependency_count_->size(); ++i) {
     if ((*dependency_count_)[i] == 0) {
@@ -1532,7 +2001,7 @@ paddle::framework::FetchList PirInterpreter::Run(
     PreAnalysis();
     VLOG(4) << "Done PreAnalysis";
 
-    if (UseTraceRun(execution_config_, onednn_op_num_, sync_op_num_)) {
+    if (TraceRunEnabled()) {
       LOG_FIRST_N(INFO, 1) << "pir interpreter is running by trace mode ...";
       TraceRunImpl();
     } else {
@@ -1544,7 +2013,7 @@ paddle::framework::FetchList PirInterpreter::Run(
     is_build_ = true;
     is_shared_results_build_ = true;
   } else {
-    if (UseTraceRun(execution_config_, onednn_op_num_, sync_op_num_)) {
+    if (TraceRunEnabled()) {
       TraceRunImpl();
     } else {
       MultiThreadRunImpl();
@@ -1611,7 +2080,7 @@ FetchList PirInterpreter::Run(const std::vector<std::string>& feed_names,
     VLOG(4) << "Done PreAnalysis";
 
     // Run
-    if (UseTraceRun(execution_config_, onednn_op_num_, sync_op_num_)) {
+    if (TraceRunEnabled()) {
       LOG_FIRST_N(INFO, 1) << "pir interpreter is running by trace mode ...";
       TraceRunImpl();
     } else {
@@ -1623,7 +2092,7 @@ FetchList PirInterpreter::Run(const std::vector<std::string>& feed_names,
     is_build_ = true;
     is_shared_results_build_ = true;
   } else {
-    if (UseTraceRun(execution_config_, onednn_op_num_, sync_op_num_)) {
+    if (TraceRunEnabled()) {
       TraceRunImpl();
     } else {
       MultiThreadRunImpl();
@@ -1659,8 +2128,17 @@ void PirInterpreter::TraceRunImpl() {
   interpreter::ResetAtomicGuard guard(&deps_, &refs_);
   VLOG(4) << "Tracing Instruction List";
 
+  if (static_memory_plan_.IsBuilt()) {
+    static_memory_plan_.Bind();
+  }
   TraceRunInstructionList(vec_instruction_base_);
   VLOG(4) << "Done TraceRunInstructionList";
+  if (probe_static_memory_plan_) {
+    probe_static_memory_plan_ = false;
+    BuildStaticMemoryPlan();
+  } else if (static_memory_plan_.IsBuilt() && !static_memory_plan_.Check()) {
+    DropStaticMemoryPlan();
+  }
 #ifdef PADDLE_WITH_CUSTOM_DEVICE
   if (phi::is_custom_place(place_)) {
     phi::DeviceContextPool::Instance().Get(place_)->Wait();
@@ -1680,6 +2158,10 @@ void PirInterpreter::MultiThreadRunImpl() {
   async_work_queue_ = GetWorkQueue();
   MultiThreadRunInstructionList(vec_instruction_base_);
   VLOG(4) << "Done MultiThreadRunInstructionList";
+  if (profile_instruction_costs_) {
+    profile_instruction_costs_ = false;
+    UpdateCriticalPath();
+  }
 #ifdef PADDLE_WITH_CUSTOM_DEVICE
   if (phi::is_custom_place(place_)) {
     phi::DeviceContextPool::Instance().Get(place_)->Wait();
@@ -1718,19 +2200,50 @@ void PirInterpreter::TraceRunInstructionList(
     }
   }
 
-  for (size_t idx = 0; idx < trace_execute_order_.size(); idx++) {
-    auto instr_id = trace_execute_order_[idx];
-    InstructionBase* instr_node = vec_instruction_base_.at(instr_id).get();
+  bool run_batches = CanRunTraceBatches();
+  log_dispatch_overhead_ = FLAGS_pir_interpreter_log_dispatch_overhead;
+  kernel_run_us_ = 0;
+  size_t dispatch_num = 0;
+  auto run_begin = std::chrono::steady_clock::now();
 
-    VLOG(6) << "Run InstructionBase " << instr_node->Name() << "[" << instr_id
-            << "], op id: " << instr_node->Operation()->id();
-    RunInstructionBase(instr_node);
+  size_t idx = 0;
+  while (idx < trace_execute_order_.size()) {
+    ++dispatch_num;
+    if (run_batches && trace_batch_end_[idx] != 0) {
+      VLOG(6) << "Run instruction batch [" << idx << ", "
+              << trace_batch_end_[idx] << ")";
+      RunInstructionBatch(idx, trace_batch_end_[idx]);
+      idx = trace_batch_end_[idx];
+    } else {
+      auto instr_id = trace_execute_order_[idx];
+      InstructionBase* instr_node = vec_instruction_base_.at(instr_id).get();
+
+      VLOG(6) << "Run InstructionBase " << instr_node->Name() << "["
+              << instr_id << "], op id: " << instr_node->Operation()->id();
+      RunInstructionBase(instr_node);
+      ++idx;
+    }
 
     if (UNLIKELY(exception_holder_.IsCaught())) {
       VLOG(4) << "Exception caught";
       break;
     }
   }
+  last_dispatch_num_ = dispatch_num;
+
+  if (log_dispatch_overhead_) {
+    log_dispatch_overhead_ = false;
+    double run_us = std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - run_begin)
+                        .count();
+    LOG(INFO) << "PirInterpreter(): " << this << " ran " << idx << " of "
+              << trace_execute_order_.size() << " instructions in "
+              << dispatch_num << " dispatches, " << run_us << "us in total, "
+              << kernel_run_us_ << "us in kernels, dispatch overhead "
+              << run_us - kernel_run_us_ << "us ("
+              << (run_us - kernel_run_us_) / std::max<size_t>(idx, 1)
+              << "us per instruction)";
+  }
 
   if (UNLIKELY(exception_holder_.IsCaught())) {
     VLOG(1) << "Exception caught " << exception_holder_.Type();
@@ -1768,16 +2281,28 @@ void PirInterpreter::MultiThreadRunInstructionList(
     }
   }
 
+  std::vector<size_t> first_instr_ids;
   for (size_t i = 0; i < dependency_count_->size(); ++i) {
     if ((*dependency_count_)[i] == 0) {
-      // NOTE(zhiqiu): hot fix for jit input var
-      RecordMemcpyD2H(vec_instr.at(i).get());
-      if (FLAGS_new_executor_serial_run) {
-        RunInstructionBaseAsync(i);
-      } else {
-        async_work_queue_->AddTask(vec_instr.at(i)->KernelType(),
-                                   [this, i] { RunInstructionBaseAsync(i); });
-      }
+      first_instr_ids.push_back(i);
+    }
+  }
+  if (!critical_path_.empty()) {
+    // the workqueue starts its tasks in the order they were added
+    std::stable_sort(first_instr_ids.begin(),
+                     first_instr_ids.end(),
+                     [this](size_t lhs, size_t rhs) {
+                       return critical_path_[lhs] > critical_path_[rhs];
+                     });
+  }
+  for (size_t i : first_instr_ids) {
+    // NOTE(zhiqiu): hot fix for jit input var
+    RecordMemcpyD2H(vec_instr.at(i).get());
+    if (FLAGS_new_executor_serial_run) {
+      RunInstructionBaseAsync(i);
+    } else {
+      async_work_queue_->AddTask(vec_instr.at(i)->KernelType(),
+                                 [this, i] { RunInstructionBaseAsync(i); });
     }
   }
 
@@ -1884,6 +2409,51 @@ void PirInterpreter::RunNextInstructions(InstructionBase* instr,
     return deps_[next_id]->CheckAndDecrease();
   };
 
+  if (!critical_path_.empty() && !FLAGS_new_executor_serial_run &&
+      instr->KernelType() != OpFuncType::kGpuAsync) {
+    // the ready cpu instruction with the longest critical path and the cheap
+    // ones stay on this thread, the others are dispatched
+    std::vector<size_t> ready_ids;
+    for (auto* next_instr_ids : {&instr->NextInstrsInDifferenceThread(),
+                                 &instr->NextInstrsInSameThread()}) {
+      for (size_t next_instr_id : *next_instr_ids) {
+        if (!IsReady(next_instr_id)) {
+          continue;
+        }
+        if (vec_instruction_base_[next_instr_id]->KernelType() ==
+            OpFuncType::kGpuAsync) {
+          async_work_queue_->AddTask(
+              OpFuncType::kGpuAsync, [this, next_instr_id]() {
+                RunInstructionBaseAsync(next_instr_id);
+              });
+        } else {
+          ready_ids.push_back(next_instr_id);
+        }
+      }
+    }
+    if (ready_ids.empty()) {
+      return;
+    }
+    size_t longest_id = *std::max_element(
+        ready_ids.begin(), ready_ids.end(), [this](size_t lhs, size_t rhs) {
+          return critical_path_[lhs] < critical_path_[rhs];
+        });
+    for (size_t next_instr_id : ready_ids) {
+      if (next_instr_id == longest_id ||
+          instruction_costs_[next_instr_id] <
+              FLAGS_pir_interpreter_inline_op_cost_us) {
+        reserved_next_ops->push(next_instr_id);
+      } else {
+        async_work_queue_->AddTask(
+            vec_instruction_base_[next_instr_id]->KernelType(),
+            [this, next_instr_id]() {
+              RunInstructionBaseAsync(next_instr_id);
+            });
+      }
+    }
+    return;
+  }
+
   for (size_t next_instr_id : instr->NextInstrsInDifferenceThread()) {
     if (IsReady(next_instr_id)) {
       async_work_queue_->AddTask(
@@ -1948,7 +2518,7 @@ void PirInterpreter::RunInstructionBase(InstructionBase* instr_node) {
       {
         phi::RecordEvent record(
             "InstrRun", phi::TracerEventType::UserDefined, 10);
-        instr_node->Run();
+        RunInstructionKernel(instr_node);
       }
 
       if (instr_node->IsSyncAfterLaunch()) {
@@ -1972,6 +2542,9 @@ void PirInterpreter::RunInstructionBase(InstructionBase* instr_node) {
               << " runs on " << phi::GetCurrentThreadName() << "\n"
               << "After: " << cur_place << " "
               << instr_node->DebugStringEx(scope_, value_exe_info_.get());
+      if (UNLIKELY(probe_static_memory_plan_)) {
+        ProbeStaticMemoryPlan(instr_node);
+      }
       CheckGC(instr_node);
       VLOG(4) << "done CheckGC";
       memory::LogDeviceMemoryStats(cur_place, instr_node->Name());
@@ -1995,6 +2568,34 @@ void PirInterpreter::RunInstructionBase(InstructionBase* instr_node) {
       }
     }
 #endif
+  } catch (...) {
+    HandleInstructionException(instr_node);
+  }
+}
+
+void PirInterpreter::RunInstructionKernel(InstructionBase* instr_node) {
+  if (LIKELY(!profile_instruction_costs_ && !log_dispatch_overhead_)) {
+    instr_node->Run();
+    return;
+  }
+  auto begin = std::chrono::steady_clock::now();
+  instr_node->Run();
+  double cost = std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - begin)
+                    .count();
+  if (profile_instruction_costs_) {
+    // written by the only thread running this instruction, read after the run
+    instruction_costs_[instr_node->Id()] = cost;
+  }
+  if (log_dispatch_overhead_) {
+    kernel_run_us_ += cost;
+  }
+}
+
+// Called in a catch block, records the exception of instr_node.
+void PirInterpreter::HandleInstructionException(InstructionBase* instr_node) {
+  try {
+    throw;
   } catch (platform::EnforceNotMet& ex) {
     auto* op = instr_node->Operation();
     const std::vector<std::string> op_callstack_attr =
@@ -2028,10 +2629,22 @@ void PirInterpreter::RunInstructionBase(InstructionBase* instr_node) {
 }
 
 void PirInterpreter::PreAnalysis() {
+  LoadBuildCache();
+  VLOG(4) << "Done LoadBuildCache";
+
   BuildInstructionDependences();
   VLOG(4) << "Done BuildInstructionDependences";
 
   ir_stream_analyzer_.SetForceEventsToWaitInfo(force_events_to_wait_);
+  if (build_cache_ != nullptr) {
+    std::map<const phi::DeviceContext*, std::map<size_t, std::set<size_t>>>
+        event_info;
+    for (auto& item : build_cache_->event_info) {
+      event_info[&vec_instruction_base_[item.first]->DeviceContext()] =
+          item.second;
+    }
+    ir_stream_analyzer_.LoadEventInfo(std::move(event_info));
+  }
   ir_stream_analyzer_.ConstructEvents(vec_instruction_base_);
   VLOG(4) << "Done ConstructEvents";
 
@@ -2040,8 +2653,13 @@ void PirInterpreter::PreAnalysis() {
   ConstructEventForJitInput();
   VLOG(4) << "AddEventToWait for JitInputVars";
 
-  CalculateLastLiveOps();
-  VLOG(4) << "Done CalculateLastLiveOps";
+  if (build_cache_ != nullptr) {
+    RestoreLastLiveOps();
+    VLOG(4) << "Done RestoreLastLiveOps";
+  } else {
+    CalculateLastLiveOps();
+    VLOG(4) << "Done CalculateLastLiveOps";
+  }
 
   if (VLOG_IS_ON(2)) {
     std::vector<std::string> instr_debug_info = DebugInfo();
@@ -2050,9 +2668,19 @@ void PirInterpreter::PreAnalysis() {
     }
   }
 
-  AnalyseExecuteOrderForTrace(ir_dependency_builder_.OpDownstreamMap(),
-                              ir_instruction_scheduling_priority_less);
-  VLOG(4) << "Done AnalyseExecuteOrderForTrace";
+  if (build_cache_ != nullptr) {
+    trace_execute_order_ = build_cache_->trace_execute_order;
+  } else {
+    AnalyseExecuteOrderForTrace(ir_dependency_builder_.OpDownstreamMap(),
+                                ir_instruction_scheduling_priority_less);
+    VLOG(4) << "Done AnalyseExecuteOrderForTrace";
+    if (!build_cache_path_.empty()) {
+      SaveBuildCache();
+    }
+  }
+  build_cache_loaded_ = build_cache_ != nullptr;
+  build_cache_ = nullptr;
+  build_cache_fingerprint_.clear();
 
   AnalyzeForceSyncOps();
   VLOG(4) << "Done AnalyzeForceSyncOps";
@@ -2065,6 +2693,15 @@ void PirInterpreter::PreAnalysis() {
 
   UpdateOneDNNOpNum();
   VLOG(4) << "Done UpdateOneDNNOpNum";
+
+  PrepareStaticMemoryPlan();
+  VLOG(4) << "Done PrepareStaticMemoryPlan";
+
+  PrepareCriticalPathSchedule();
+  VLOG(4) << "Done PrepareCriticalPathSchedule";
+
+  BuildTraceBatches();
+  VLOG(4) << "Done BuildTraceBatches";
 }
 
 ::pir::Value PirInterpreter::GetValueByName(const std::string& var_name) {
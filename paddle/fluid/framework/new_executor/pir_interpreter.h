@@ -15,6 +15,9 @@
 #pragma once
 #include <memory>
 #include "paddle/fluid/framework/new_executor/instruction/instruction_base.h"
+#include "paddle/fluid/framework/new_executor/interpreter/build_cache.h"
+#include "paddle/fluid/framework/new_executor/interpreter/critical_path.h"
+#include "paddle/fluid/framework/new_executor/interpreter/static_memory_plan.h"
 #include "paddle/fluid/framework/new_executor/interpreter_base_impl.h"
 #include "paddle/pir/include/core/value.h"
 
@@ -113,6 +116,23 @@ class PirInterpreter : public InterpreterBaseImpl {
   // Only for debug
   Variable* DebugVar(const std::string& name) const override;
 
+  // Only for test
+  const std::vector<double>& InstructionCosts() const {
+    return instruction_costs_;
+  }
+
+  const std::vector<double>& CriticalPath() const { return critical_path_; }
+
+  const interpreter::StaticMemoryPlan& GetStaticMemoryPlan() const {
+    return static_memory_plan_;
+  }
+
+  size_t LastDispatchNum() const { return last_dispatch_num_; }
+
+  const std::string& BuildCachePath() const { return build_cache_path_; }
+
+  bool BuildCacheLoaded() const { return build_cache_loaded_; }
+
   std::unordered_map<std::string, std::shared_ptr<EventInter>>*
   GetForceEventsToWaitInfo() {
     return force_events_to_wait_;
@@ -137,6 +157,31 @@ class PirInterpreter : public InterpreterBaseImpl {
   void ConstructEventForJitInput();
   void CalculateLastLiveOps();
 
+  // build cache
+  void LoadBuildCache();
+  std::string BuildCacheFingerprint() const;
+  void RestoreLastLiveOps();
+  void SaveBuildCache();
+
+  // static memory plan
+  void PrepareStaticMemoryPlan();
+  void ProbeStaticMemoryPlan(InstructionBase* instr);
+  void BuildStaticMemoryPlan();
+  void DropStaticMemoryPlan();
+
+  bool TraceRunEnabled() const;
+
+  // critical path schedule
+  void PrepareCriticalPathSchedule();
+  void UpdateCriticalPath();
+
+  // instruction batches
+  void BuildTraceBatches();
+  bool CanRunTraceBatches() const;
+  void RunInstructionBatch(size_t begin, size_t end);
+  void RunInstructionKernel(InstructionBase* instr_node);
+  void HandleInstructionException(InstructionBase* instr_node);
+
   // gc
   void ClearDenseTensorArrayInLocalScope();
 
@@ -206,6 +251,39 @@ class PirInterpreter : public InterpreterBaseImpl {
   int64_t onednn_op_num_{-1};
   std::vector<size_t> trace_execute_order_;
 
+  // the analysis results loaded from the build cache, set during PreAnalysis
+  // on a hit
+  std::unique_ptr<interpreter::InterpreterBuildCache> build_cache_;
+  std::string build_cache_path_;
+  std::string build_cache_fingerprint_;
+  // whether the last PreAnalysis restored its results from the cache
+  bool build_cache_loaded_{false};
+
+  // the DenseTensors placed in one arena in trace mode, sized by the first
+  // run while probe_static_memory_plan_ is set
+  interpreter::StaticMemoryPlan static_memory_plan_;
+  bool probe_static_memory_plan_{false};
+  // the instructions whose gc check of a planned var was removed
+  std::unordered_map<size_t, std::vector<InstructionBase*>>
+      static_memory_gc_instrs_;
+
+  // used for critical path scheduling in multi-thread mode, the costs are
+  // estimated in microseconds and replaced by the ones of the first run
+  // while profile_instruction_costs_ is set
+  std::vector<double> instruction_costs_;
+  std::vector<double> critical_path_;
+  bool profile_instruction_costs_{false};
+
+  // trace_batch_end_[i] is the end of the batch of trace_execute_order_
+  // starting at i, or 0 if no batch starts at i
+  std::vector<size_t> trace_batch_end_;
+  // the time spent in the kernels of the current run, accumulated while
+  // log_dispatch_overhead_ is set
+  bool log_dispatch_overhead_{false};
+  double kernel_run_us_{0};
+  // the instructions and batches run one by one by the last trace run
+  size_t last_dispatch_num_{0};
+
   std::vector<PirHookFunc> pir_output_hookfuncs_;
   std::vector<PirHookFunc> pir_input_hookfuncs_;
 
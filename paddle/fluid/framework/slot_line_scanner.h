@@ -0,0 +1,162 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "paddle/utils/string/parse_digits.h"
+
+namespace paddle {
+namespace framework {
+
+// Scans the space separated numbers of a slot line from left to right. The
+// parse functions return what strtol, strtoull and strtof would return at the
+// current position and advance past the number the same way, so the slot
+// feeds can use them in place of the libc calls.
+//
+// The common cases are handled on 8 bytes at a time: runs of digits are
+// found and converted with SWAR (SIMD within a register) arithmetic, tokens
+// are skipped by locating the next delimiter byte in a word, and decimals
+// that a float holds exactly take Clinger's fast path. Anything else (signs
+// of unsigned values, exponents, overflow, nan) goes to libc, which keeps
+// the results identical bit for bit.
+//
+// The line must be null terminated at str + len, like std::string::c_str()
+// and LineFileReader::get().
+class SlotLineScanner {
+ public:
+  SlotLineScanner(const char* str, size_t len) : pos_(str), end_(str + len) {}
+
+  const char* pos() const { return pos_; }
+  void set_pos(const char* pos) { pos_ = pos; }
+
+  int64_t ParseInt64() {
+    const char* start = pos_;
+    const char* p = SkipSpaces(pos_);
+    uint64_t value = 0;
+    const char* digits_end = ParseDigits(p, &value);
+    if (digits_end == p || value > INT64_MAX) {
+      char* endptr = nullptr;
+      int64_t result = strtoll(start, &endptr, 10);
+      pos_ = endptr;
+      return result;
+    }
+    pos_ = digits_end;
+    return static_cast<int64_t>(value);
+  }
+
+  uint64_t ParseUint64() {
+    const char* start = pos_;
+    const char* p = SkipSpaces(pos_);
+    uint64_t value = 0;
+    const char* digits_end = ParseDigits(p, &value);
+    if (digits_end == p) {
+      char* endptr = nullptr;
+      uint64_t result = strtoull(start, &endptr, 10);
+      pos_ = endptr;
+      return result;
+    }
+    pos_ = digits_end;
+    return value;
+  }
+
+  float ParseFloat() {
+    const char* start = pos_;
+    const char* p = SkipSpaces(pos_);
+    bool negative = *p == '-';
+    if (*p == '-' || *p == '+') ++p;
+    uint64_t mantissa = 0;
+    const char* int_end = ParseDigits(p, &mantissa);
+    const char* frac_end = int_end;
+    int frac_num = 0;
+    if (*int_end == '.') {
+      uint64_t frac = 0;
+      frac_end = ParseDigits(int_end + 1, &frac);
+      frac_num = static_cast<int>(frac_end - int_end - 1);
+      if (frac_num > 0 && frac_num <= kMaxExactPow10) {
+        mantissa = mantissa * string::kDecimalPow10[frac_num] + frac;
+      }
+    }
+    // exact when the mantissa and the power of ten are both exact floats,
+    // the single rounding of the division is then the correct one
+    if ((int_end != p || frac_num > 0) && frac_end - p <= 19 &&
+        frac_num <= kMaxExactPow10 && mantissa <= (1 << 24) &&
+        !IsFloatContinuation(*frac_end)) {
+      float value = static_cast<float>(mantissa);
+      if (frac_num > 0) {
+        value /= static_cast<float>(string::kDecimalPow10[frac_num]);
+      }
+      pos_ = frac_end;
+      return negative ? -value : value;
+    }
+    char* endptr = nullptr;
+    float result = strtof(start, &endptr);
+    pos_ = endptr;
+    return result;
+  }
+
+  // skips the spaces and the token after them
+  void SkipToken() {
+    const char* p = SkipSpaces(pos_);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (end_ - p >= 8) {
+      uint64_t chunk;
+      memcpy(&chunk, p, sizeof(chunk));
+      // bytes below 0x21 are spaces, control chars or the terminator, only
+      // the lowest flagged byte is exact but that is the one needed
+      uint64_t delim =
+          (chunk - 0x2121212121212121ULL) & ~chunk & 0x8080808080808080ULL;
+      if (delim != 0) {
+        pos_ = p + (__builtin_ctzll(delim) >> 3);
+        return;
+      }
+      p += 8;
+    }
+#endif
+    while (p < end_ && static_cast<unsigned char>(*p) > ' ') ++p;
+    pos_ = p;
+  }
+
+ private:
+  static constexpr int kMaxExactPow10 = 10;
+
+  static const char* SkipSpaces(const char* p) {
+    // isspace in the C locale
+    while (*p == ' ' || static_cast<unsigned char>(*p - '\t') < 5) ++p;
+    return p;
+  }
+
+  static bool IsFloatContinuation(char c) {
+    // exponents, hex floats, inf, nan and digits left by an overflow are
+    // left to strtof
+    return c == 'e' || c == 'E' || c == 'x' || c == 'X' || c == 'i' ||
+           c == 'I' || c == 'n' || c == 'N' || c == 'p' || c == 'P' ||
+           static_cast<unsigned char>(c - '0') < 10;
+  }
+
+  // Parses the digits at p into value and returns their end, p if there is
+  // none or the value overflows, for the caller to fall back to libc.
+  const char* ParseDigits(const char* p, uint64_t* value) const {
+    return string::ParseUint64Digits(p, end_, value);
+  }
+
+  const char* pos_;
+  const char* end_;
+};
+
+}  // namespace framework
+}  // namespace paddle
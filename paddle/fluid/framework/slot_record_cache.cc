@@ -0,0 +1,469 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/slot_record_cache.h"
+
+#ifdef _LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "paddle/common/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+constexpr char kCacheMagic[8] = {'P', 'D', 'S', 'L', 'O', 'T', 'R', 'C'};
+constexpr uint32_t kCacheVersion = 1;
+
+struct BlockHeader {
+  uint32_t ins_num;
+  uint32_t ins_id_bytes;
+  uint64_t uint64_value_num;
+  uint64_t float_value_num;
+};
+
+size_t AlignUp(size_t bytes) { return (bytes + 7) & ~static_cast<size_t>(7); }
+
+// hands out the 8 byte aligned columns of a block in order
+template <typename Char>
+class ColumnCursor {
+ public:
+  explicit ColumnCursor(Char* data) : data_(data) {}
+  Char* Next(size_t bytes) {
+    Char* column = data_;
+    data_ += AlignUp(bytes);
+    return column;
+  }
+
+ private:
+  Char* data_;
+};
+
+size_t BlockBytes(const BlockHeader& block,
+                  uint32_t uint64_slot_num,
+                  uint32_t float_slot_num) {
+  size_t num = block.ins_num;
+  return AlignUp(sizeof(BlockHeader)) +
+         AlignUp(num * (uint64_slot_num + 1) * sizeof(uint32_t)) +
+         AlignUp(num * (float_slot_num + 1) * sizeof(uint32_t)) +
+         AlignUp(block.uint64_value_num * sizeof(uint64_t)) +
+         AlignUp(block.float_value_num * sizeof(float)) +
+         AlignUp(num * sizeof(uint32_t)) + AlignUp(block.ins_id_bytes) +
+         AlignUp(num * sizeof(uint64_t)) + 2 * AlignUp(num * sizeof(uint32_t));
+}
+
+// returns the value num of one record, checking its slot num
+template <typename T>
+size_t CountSlotValues(const SlotValues<T>& values, uint32_t slot_num) {
+  PADDLE_ENFORCE_EQ(values.slot_offsets.size(),
+                    slot_num + 1,
+                    common::errors::InvalidArgument(
+                        "The record has %d slot offsets, but the block "
+                        "expects %d slots.",
+                        values.slot_offsets.size(),
+                        slot_num));
+  return values.slot_offsets.back() - values.slot_offsets.front();
+}
+
+// copies the values of one record and its slot offsets rebased to the first
+// value, returns the end of the copied values
+template <typename T>
+T* EncodeSlotValues(const SlotValues<T>& values, uint32_t* offsets, T* out) {
+  uint32_t begin = values.slot_offsets.front();
+  for (size_t i = 0; i < values.slot_offsets.size(); ++i) {
+    offsets[i] = values.slot_offsets[i] - begin;
+  }
+  size_t num = values.slot_offsets.back() - begin;
+  if (num > 0) {
+    memcpy(out, values.slot_values.data() + begin, num * sizeof(T));
+  }
+  return out + num;
+}
+
+// whether the slot offsets of one record start at 0, never decrease and
+// stay within value_num
+bool ValidSlotOffsets(const uint32_t* offsets,
+                      uint32_t slot_num,
+                      size_t value_num) {
+  if (offsets[0] != 0) {
+    return false;
+  }
+  for (uint32_t i = 0; i < slot_num; ++i) {
+    if (offsets[i + 1] < offsets[i]) {
+      return false;
+    }
+  }
+  return offsets[slot_num] <= value_num;
+}
+
+template <typename T>
+const T* FillSlotValues(const uint32_t* offsets,
+                        uint32_t slot_num,
+                        const T* values,
+                        SlotValues<T>* slot_values) {
+  slot_values->slot_offsets.assign(offsets, offsets + slot_num + 1);
+  slot_values->slot_values.assign(values, values + offsets[slot_num]);
+  return values + offsets[slot_num];
+}
+
+}  // namespace
+
+void EncodeSlotRecordBlock(const SlotRecord* records,
+                           size_t num,
+                           uint32_t uint64_slot_num,
+                           uint32_t float_slot_num,
+                           std::string* buffer) {
+  BlockHeader block;
+  block.ins_num = static_cast<uint32_t>(num);
+  block.ins_id_bytes = 0;
+  block.uint64_value_num = 0;
+  block.float_value_num = 0;
+  for (size_t i = 0; i < num; ++i) {
+    const SlotRecord& rec = records[i];
+    block.uint64_value_num +=
+        CountSlotValues(rec->slot_uint64_feasigns_, uint64_slot_num);
+    block.float_value_num +=
+        CountSlotValues(rec->slot_float_feasigns_, float_slot_num);
+    block.ins_id_bytes += static_cast<uint32_t>(rec->ins_id_.size());
+  }
+
+  size_t begin = buffer->size();
+  buffer->resize(begin + BlockBytes(block, uint64_slot_num, float_slot_num),
+                 '\0');
+  ColumnCursor<char> cursor(&(*buffer)[begin]);
+  memcpy(cursor.Next(sizeof(block)), &block, sizeof(block));
+  auto uint64_offsets = reinterpret_cast<uint32_t*>(
+      cursor.Next(num * (uint64_slot_num + 1) * sizeof(uint32_t)));
+  auto float_offsets = reinterpret_cast<uint32_t*>(
+      cursor.Next(num * (float_slot_num + 1) * sizeof(uint32_t)));
+  auto uint64_values = reinterpret_cast<uint64_t*>(
+      cursor.Next(block.uint64_value_num * sizeof(uint64_t)));
+  auto float_values = reinterpret_cast<float*>(
+      cursor.Next(block.float_value_num * sizeof(float)));
+  auto ins_id_lens =
+      reinterpret_cast<uint32_t*>(cursor.Next(num * sizeof(uint32_t)));
+  char* ins_ids = cursor.Next(block.ins_id_bytes);
+  auto search_ids =
+      reinterpret_cast<uint64_t*>(cursor.Next(num * sizeof(uint64_t)));
+  auto cmatches =
+      reinterpret_cast<uint32_t*>(cursor.Next(num * sizeof(uint32_t)));
+  auto ranks = reinterpret_cast<uint32_t*>(cursor.Next(num * sizeof(uint32_t)));
+  for (size_t i = 0; i < num; ++i) {
+    const SlotRecord& rec = records[i];
+    uint64_values = EncodeSlotValues(rec->slot_uint64_feasigns_,
+                                     uint64_offsets + i * (uint64_slot_num + 1),
+                                     uint64_values);
+    float_values = EncodeSlotValues(rec->slot_float_feasigns_,
+                                    float_offsets + i * (float_slot_num + 1),
+                                    float_values);
+    ins_id_lens[i] = static_cast<uint32_t>(rec->ins_id_.size());
+    if (!rec->ins_id_.empty()) {
+      memcpy(ins_ids, rec->ins_id_.data(), rec->ins_id_.size());
+      ins_ids += rec->ins_id_.size();
+    }
+    search_ids[i] = rec->search_id;
+    cmatches[i] = rec->cmatch;
+    ranks[i] = rec->rank;
+  }
+}
+
+size_t DecodeSlotRecordBlock(const char* data,
+                             size_t size,
+                             uint32_t uint64_slot_num,
+                             uint32_t float_slot_num,
+                             const std::string& name,
+                             std::vector<SlotRecord>* records) {
+  PADDLE_ENFORCE_LE(sizeof(BlockHeader),
+                    size,
+                    common::errors::InvalidArgument(
+                        "The slot record block of %s is truncated.", name));
+  BlockHeader block;
+  memcpy(&block, data, sizeof(block));
+  // every column fits in size, so BlockBytes can not overflow
+  size_t uint64_offset_bytes =
+      (static_cast<size_t>(uint64_slot_num) + 1) * sizeof(uint32_t);
+  size_t float_offset_bytes =
+      (static_cast<size_t>(float_slot_num) + 1) * sizeof(uint32_t);
+  PADDLE_ENFORCE_EQ(
+      block.ins_num <= size / uint64_offset_bytes &&
+          block.ins_num <= size / float_offset_bytes &&
+          block.uint64_value_num <= size / sizeof(uint64_t) &&
+          block.float_value_num <= size / sizeof(float),
+      true,
+      common::errors::InvalidArgument(
+          "The slot record block of %s is corrupted, it has %d records, "
+          "%d uint64 values and %d float values in %d bytes.",
+          name,
+          block.ins_num,
+          block.uint64_value_num,
+          block.float_value_num,
+          size));
+  size_t bytes = BlockBytes(block, uint64_slot_num, float_slot_num);
+  PADDLE_ENFORCE_LE(bytes,
+                    size,
+                    common::errors::InvalidArgument(
+                        "The slot record block of %s is truncated, it has "
+                        "%d bytes but needs %d.",
+                        name,
+                        size,
+                        bytes));
+  size_t num = block.ins_num;
+  ColumnCursor<const char> cursor(data);
+  cursor.Next(sizeof(block));
+  auto uint64_offsets = reinterpret_cast<const uint32_t*>(
+      cursor.Next(num * (uint64_slot_num + 1) * sizeof(uint32_t)));
+  auto float_offsets = reinterpret_cast<const uint32_t*>(
+      cursor.Next(num * (float_slot_num + 1) * sizeof(uint32_t)));
+  auto uint64_values = reinterpret_cast<const uint64_t*>(
+      cursor.Next(block.uint64_value_num * sizeof(uint64_t)));
+  auto float_values = reinterpret_cast<const float*>(
+      cursor.Next(block.float_value_num * sizeof(float)));
+  auto ins_id_lens =
+      reinterpret_cast<const uint32_t*>(cursor.Next(num * sizeof(uint32_t)));
+  const char* ins_ids = cursor.Next(block.ins_id_bytes);
+  auto search_ids =
+      reinterpret_cast<const uint64_t*>(cursor.Next(num * sizeof(uint64_t)));
+  auto cmatches =
+      reinterpret_cast<const uint32_t*>(cursor.Next(num * sizeof(uint32_t)));
+  auto ranks =
+      reinterpret_cast<const uint32_t*>(cursor.Next(num * sizeof(uint32_t)));
+
+  const uint64_t* uint64_end = uint64_values + block.uint64_value_num;
+  const float* float_end = float_values + block.float_value_num;
+  const char* ins_ids_end = ins_ids + block.ins_id_bytes;
+  size_t first = records->size();
+  records->resize(first + num);
+  if (num > 0) {
+    SlotRecordPool().get(records->data() + first, static_cast<int>(num));
+  }
+  for (size_t i = 0; i < num; ++i) {
+    SlotRecord rec = (*records)[first + i];
+    const uint32_t* uint64_rec_offsets =
+        uint64_offsets + i * (uint64_slot_num + 1);
+    const uint32_t* float_rec_offsets =
+        float_offsets + i * (float_slot_num + 1);
+    PADDLE_ENFORCE_EQ(
+        ValidSlotOffsets(uint64_rec_offsets,
+                         uint64_slot_num,
+                         static_cast<size_t>(uint64_end - uint64_values)) &&
+            ValidSlotOffsets(float_rec_offsets,
+                             float_slot_num,
+                             static_cast<size_t>(float_end - float_values)) &&
+            ins_id_lens[i] <= static_cast<size_t>(ins_ids_end - ins_ids),
+        true,
+        common::errors::InvalidArgument(
+            "The slot record block of %s is corrupted at record %d.",
+            name,
+            i));
+    uint64_values = FillSlotValues(uint64_rec_offsets,
+                                   uint64_slot_num,
+                                   uint64_values,
+                                   &rec->slot_uint64_feasigns_);
+    float_values = FillSlotValues(float_rec_offsets,
+                                  float_slot_num,
+                                  float_values,
+                                  &rec->slot_float_feasigns_);
+    rec->ins_id_.assign(ins_ids, ins_id_lens[i]);
+    ins_ids += ins_id_lens[i];
+    rec->search_id = search_ids[i];
+    rec->cmatch = cmatches[i];
+    rec->rank = ranks[i];
+  }
+  return bytes;
+}
+
+uint64_t SlotRecordCacheLayoutHash(const DataFeedDesc& desc) {
+  // FNV-1a, stable across builds unlike std::hash
+  uint64_t hash = 14695981039346656037ULL;
+  auto update = [&hash](const std::string& str) {
+    for (char c : str) {
+      hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+    }
+    hash = (hash ^ 0xFF) * 1099511628211ULL;
+  };
+  const auto& multi_slot_desc = desc.multi_slot_desc();
+  for (int i = 0; i < multi_slot_desc.slots_size(); ++i) {
+    const auto& slot = multi_slot_desc.slots(i);
+    if (!slot.is_used()) {
+      continue;
+    }
+    update(slot.name());
+    update(slot.type());
+    update(slot.is_dense() ? "dense" : "sparse");
+  }
+  return hash;
+}
+
+SlotRecordCacheWriter::SlotRecordCacheWriter(const std::string& path,
+                                             uint64_t layout_hash,
+                                             uint32_t uint64_slot_num,
+                                             uint32_t float_slot_num)
+    : path_(path),
+      uint64_slot_num_(uint64_slot_num),
+      float_slot_num_(float_slot_num) {
+  fp_ = fopen(path.c_str(), "wb");
+  PADDLE_ENFORCE_NOT_NULL(
+      fp_,
+      common::errors::Unavailable("Failed to open %s for writing the binary "
+                                  "cache.",
+                                  path));
+  SlotRecordCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kCacheMagic, sizeof(header.magic));
+  header.version = kCacheVersion;
+  header.uint64_slot_num = uint64_slot_num;
+  header.float_slot_num = float_slot_num;
+  header.layout_hash = layout_hash;
+  PADDLE_ENFORCE_EQ(
+      fwrite(&header, sizeof(header), 1, fp_),
+      1,
+      common::errors::Unavailable("Failed to write the header of %s.", path));
+  pending_.reserve(kBlockSize);
+}
+
+SlotRecordCacheWriter::~SlotRecordCacheWriter() {
+  if (fp_ != nullptr) {
+    fclose(fp_);
+  }
+}
+
+void SlotRecordCacheWriter::Write(const SlotRecord* records, size_t num) {
+  for (size_t i = 0; i < num; ++i) {
+    pending_.push_back(records[i]);
+    if (pending_.size() == kBlockSize) {
+      WriteBlock(pending_.data(), pending_.size());
+      pending_.clear();
+    }
+  }
+}
+
+void SlotRecordCacheWriter::Close() {
+  if (fp_ == nullptr) {
+    return;
+  }
+  if (!pending_.empty()) {
+    WriteBlock(pending_.data(), pending_.size());
+    pending_.clear();
+  }
+  int ret = fclose(fp_);
+  fp_ = nullptr;
+  PADDLE_ENFORCE_EQ(
+      ret,
+      0,
+      common::errors::Unavailable("Failed to close the binary cache %s.",
+                                  path_));
+}
+
+void SlotRecordCacheWriter::WriteBlock(const SlotRecord* records, size_t num) {
+  buffer_.clear();
+  EncodeSlotRecordBlock(
+      records, num, uint64_slot_num_, float_slot_num_, &buffer_);
+  PADDLE_ENFORCE_EQ(
+      fwrite(buffer_.data(), 1, buffer_.size(), fp_),
+      buffer_.size(),
+      common::errors::Unavailable("Failed to write the binary cache %s.",
+                                  path_));
+}
+
+SlotRecordCacheReader::SlotRecordCacheReader(const std::string& path)
+    : path_(path) {
+#ifdef _LINUX
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        madvise(addr, st.st_size, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(addr);
+        size_ = st.st_size;
+        mapped_ = true;
+      }
+    }
+    close(fd);
+  }
+#endif
+  if (!mapped_) {
+    std::ifstream file(path, std::ios::binary);
+    PADDLE_ENFORCE_EQ(
+        file.good(),
+        true,
+        common::errors::NotFound("Failed to open the binary cache %s.", path));
+    std::stringstream stream;
+    stream << file.rdbuf();
+    buffer_ = stream.str();
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+  }
+  memcpy(&header_, Column(sizeof(header_)), sizeof(header_));
+  PADDLE_ENFORCE_EQ(
+      memcmp(header_.magic, kCacheMagic, sizeof(kCacheMagic)),
+      0,
+      common::errors::InvalidArgument("%s is not a binary cache of slot "
+                                      "records.",
+                                      path));
+  PADDLE_ENFORCE_EQ(header_.version,
+                    kCacheVersion,
+                    common::errors::InvalidArgument(
+                        "The binary cache %s has version %d, but %d is "
+                        "expected, please dump it again.",
+                        path,
+                        header_.version,
+                        kCacheVersion));
+}
+
+SlotRecordCacheReader::~SlotRecordCacheReader() {
+#ifdef _LINUX
+  if (mapped_) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+#endif
+}
+
+const char* SlotRecordCacheReader::Column(size_t bytes) {
+  PADDLE_ENFORCE_LE(
+      AlignUp(bytes),
+      size_ - pos_,
+      common::errors::InvalidArgument(
+          "The binary cache %s is truncated at offset %d.", path_, pos_));
+  const char* column = data_ + pos_;
+  pos_ += AlignUp(bytes);
+  return column;
+}
+
+size_t SlotRecordCacheReader::ReadBlock(std::vector<SlotRecord>* records) {
+  if (pos_ == size_) {
+    return 0;
+  }
+  size_t first = records->size();
+  pos_ += DecodeSlotRecordBlock(data_ + pos_,
+                                size_ - pos_,
+                                header_.uint64_slot_num,
+                                header_.float_slot_num,
+                                path_,
+                                records);
+  return records->size() - first;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,127 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/data_feed.h"
+#include "paddle/fluid/framework/data_feed.pb.h"
+
+namespace paddle {
+namespace framework {
+
+// Binary cache of parsed SlotRecords, so that a dataset parsed once can be
+// loaded again without the pipe command and the text parser.
+//
+// A cache file is a header followed by blocks of up to kBlockSize records.
+// Each block stores its records column by column, every column padded to 8
+// bytes:
+//   block header   ins_num, the value counts and the ins_id bytes
+//   uint32         uint64 slot offsets, (uint64 slot num + 1) per record
+//   uint32         float slot offsets, (float slot num + 1) per record
+//   uint64         uint64 values
+//   float          float values
+//   uint32, char   ins_id lengths and their chars
+//   uint64         search_id
+//   uint32, uint32 cmatch and rank
+// The offsets and values are copied into the records as they are, the
+// format is native endian and meant for the local disk of the machine that
+// dumps it.
+struct SlotRecordCacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t uint64_slot_num;
+  uint32_t float_slot_num;
+  uint32_t reserved;
+  // hash of the used slots, a cache is only read with the same slots
+  uint64_t layout_hash;
+};
+
+// hash of the names, types and dense flags of the used slots in desc
+uint64_t SlotRecordCacheLayoutHash(const DataFeedDesc& desc);
+
+// Appends num records as one block to buffer. The block size is computed
+// first, so buffer grows once and every column is copied in place. Blocks
+// are also the unit SlotRecordDataset::GlobalShuffle sends between trainers.
+void EncodeSlotRecordBlock(const SlotRecord* records,
+                           size_t num,
+                           uint32_t uint64_slot_num,
+                           uint32_t float_slot_num,
+                           std::string* buffer);
+// Decodes the block at data into records taken from SlotRecordPool() and
+// appends them to records. Returns the bytes of the block, name is only used
+// in error messages.
+size_t DecodeSlotRecordBlock(const char* data,
+                             size_t size,
+                             uint32_t uint64_slot_num,
+                             uint32_t float_slot_num,
+                             const std::string& name,
+                             std::vector<SlotRecord>* records);
+
+class SlotRecordCacheWriter {
+ public:
+  static constexpr size_t kBlockSize = 4096;
+
+  SlotRecordCacheWriter(const std::string& path,
+                        uint64_t layout_hash,
+                        uint32_t uint64_slot_num,
+                        uint32_t float_slot_num);
+  ~SlotRecordCacheWriter();
+
+  void Write(const SlotRecord* records, size_t num);
+  // flushes the last block, the file is complete after it
+  void Close();
+
+ private:
+  void WriteBlock(const SlotRecord* records, size_t num);
+
+  std::string path_;
+  FILE* fp_ = nullptr;
+  uint32_t uint64_slot_num_;
+  uint32_t float_slot_num_;
+  std::vector<SlotRecord> pending_;
+  std::string buffer_;
+};
+
+class SlotRecordCacheReader {
+ public:
+  // maps the file at path and checks its header
+  explicit SlotRecordCacheReader(const std::string& path);
+  ~SlotRecordCacheReader();
+  SlotRecordCacheReader(const SlotRecordCacheReader&) = delete;
+  SlotRecordCacheReader& operator=(const SlotRecordCacheReader&) = delete;
+
+  const SlotRecordCacheHeader& header() const { return header_; }
+  // Appends the records of the next block to records, taking them from
+  // SlotRecordPool(). Returns their number, 0 at the end of the file.
+  size_t ReadBlock(std::vector<SlotRecord>* records);
+
+ private:
+  const char* Column(size_t bytes);
+
+  std::string path_;
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  size_t pos_ = 0;
+  bool mapped_ = false;
+  std::string buffer_;
+  SlotRecordCacheHeader header_;
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -269,6 +269,18 @@ void BindDataset(py::module *m) {
       .def("wait_preload_done",
            &framework::Dataset::WaitPreLoadDone,
            py::call_guard<py::gil_scoped_release>())
+      .def("dump_into_binary_cache",
+           &framework::Dataset::DumpIntoBinaryCache,
+           py::call_guard<py::gil_scoped_release>())
+      .def("set_binary_cache_dir",
+           &framework::Dataset::SetBinaryCacheDir,
+           py::call_guard<py::gil_scoped_release>())
+      .def("set_streaming_mode",
+           &framework::Dataset::SetStreamingMode,
+           py::call_guard<py::gil_scoped_release>())
+      .def("get_stream_data_size",
+           &framework::Dataset::GetStreamDataSize,
+           py::call_guard<py::gil_scoped_release>())
       .def("release_memory",
            &framework::Dataset::ReleaseMemory,
            py::call_guard<py::gil_scoped_release>())
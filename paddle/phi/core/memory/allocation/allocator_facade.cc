@@ -27,6 +27,7 @@
 #include "paddle/phi/core/memory/allocation/naive_best_fit_allocator.h"
 #include "paddle/phi/core/memory/allocation/retry_allocator.h"
 #include "paddle/phi/core/memory/allocation/stat_allocator.h"
+#include "paddle/phi/core/memory/allocation/thread_cache_allocator.h"
 #include "paddle/phi/core/platform/device_context.h"
 
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
@@ -113,6 +114,9 @@ PHI_DEFINE_EXPORTED_bool(
 
 COMMON_DECLARE_string(allocator_strategy);
 COMMON_DECLARE_uint64(auto_growth_chunk_size_in_mb);
+COMMON_DECLARE_uint64(thread_cache_allocator_max_size_in_kb);
+COMMON_DECLARE_uint64(thread_cache_allocator_cache_size_in_mb);
+COMMON_DECLARE_int64(thread_cache_allocator_trim_interval_ms);
 COMMON_DECLARE_bool(use_auto_growth_pinned_allocator);
 COMMON_DECLARE_bool(use_cuda_malloc_async_allocator);
 COMMON_DECLARE_bool(auto_free_cudagraph_allocations_on_launch);
@@ -177,6 +181,13 @@ static bool IsCUDAGraphCapturing() {
 #endif
 }
 
+// thread_cache builds the same device allocators as auto_growth and only
+// differs on CPU, so every device-side auto_growth feature applies to it.
+static bool UseAutoGrowthDeviceAllocator(AllocatorStrategy strategy) {
+  return strategy == AllocatorStrategy::kAutoGrowth ||
+         strategy == AllocatorStrategy::kThreadCache;
+}
+
 class AllocatorFacadePrivate {
  public:
   using AllocatorMap = std::map<phi::Place, std::shared_ptr<Allocator>>;
@@ -242,8 +253,15 @@ class AllocatorFacadePrivate {
         break;
       }
 
-      case AllocatorStrategy::kAutoGrowth: {
-        InitNaiveBestFitCPUAllocator();
+      case AllocatorStrategy::kAutoGrowth:
+      case AllocatorStrategy::kThreadCache: {
+        // thread_cache keeps every auto_growth device allocator and only
+        // swaps the CPU allocator for the per-thread cached one
+        if (strategy_ == AllocatorStrategy::kThreadCache) {
+          InitThreadCacheCPUAllocator();
+        } else {
+          InitNaiveBestFitCPUAllocator();
+        }
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
         allow_free_idle_chunk_ = allow_free_idle_chunk;
         for (int dev_id = 0; dev_id < platform::GetGPUDeviceCount(); ++dev_id) {
@@ -834,6 +852,18 @@ class AllocatorFacadePrivate {
 #endif
   }
 
+  void InitThreadCacheCPUAllocator() {
+#if defined(__APPLE__) && defined(__arm64__)
+    InitNaiveBestFitCPUAllocator();
+#else
+    allocators_[phi::CPUPlace()] = std::make_shared<ThreadCacheAllocator>(
+        std::make_shared<CPUAllocator>(),
+        FLAGS_thread_cache_allocator_max_size_in_kb << 10,
+        FLAGS_thread_cache_allocator_cache_size_in_mb << 20,
+        FLAGS_thread_cache_allocator_trim_interval_ms);
+#endif
+  }
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   void InitNaiveBestFitCUDAPinnedAllocator() {
     if (FLAGS_use_auto_growth_pinned_allocator) {
@@ -861,8 +891,8 @@ class AllocatorFacadePrivate {
   std::shared_ptr<Allocator> CreateCUDAAllocator(phi::GPUPlace p) {
     if (FLAGS_use_cuda_managed_memory) {
       PADDLE_ENFORCE_EQ(
-          strategy_,
-          AllocatorStrategy::kAutoGrowth,
+          UseAutoGrowthDeviceAllocator(strategy_),
+          true,
           common::errors::InvalidArgument(
               "CUDA managed memory is only implemented for auto_growth "
               "strategy, not support %s strategy.\n"
@@ -888,8 +918,8 @@ class AllocatorFacadePrivate {
 
   void InitCUDAAllocator(phi::GPUPlace p, gpuStream_t stream) {
     PADDLE_ENFORCE_EQ(
-        strategy_,
-        AllocatorStrategy::kAutoGrowth,
+        UseAutoGrowthDeviceAllocator(strategy_),
+        true,
         common::errors::Unimplemented(
             "Only support auto-growth strategy for StreamSafeCUDAAllocator, "
             "the allocator strategy %d is unsupported for multi-stream",
@@ -1269,8 +1299,8 @@ class AllocatorFacadePrivate {
 
   void InitStreamSafeXPUAllocator(phi::XPUPlace p, XPUStream stream) {
     PADDLE_ENFORCE_EQ(
-        strategy_,
-        AllocatorStrategy::kAutoGrowth,
+        UseAutoGrowthDeviceAllocator(strategy_),
+        true,
         common::errors::Unimplemented(
             "Only support auto-growth strategy for StreamSafeXPUAllocator, "
             "the allocator strategy %d is unsupported for multi-stream",
@@ -1378,8 +1408,8 @@ class AllocatorFacadePrivate {
   void InitStreamSafeCustomDeviceAllocator(phi::CustomPlace p,
                                            phi::stream::stream_t stream) {
     PADDLE_ENFORCE_EQ(
-        strategy_,
-        AllocatorStrategy::kAutoGrowth,
+        UseAutoGrowthDeviceAllocator(strategy_),
+        true,
         common::errors::Unimplemented(
             "Only support auto-growth strategy for "
             "StreamSafeCustomDeviceAllocator, "
@@ -1659,11 +1689,12 @@ const std::shared_ptr<Allocator>& AllocatorFacade::GetAutoGrowthAllocator(
 
 void* AllocatorFacade::GetBasePtr(
     const std::shared_ptr<phi::Allocation>& allocation) {
-  PADDLE_ENFORCE_EQ(GetAllocatorStrategy(),
-                    AllocatorStrategy::kAutoGrowth,
+  PADDLE_ENFORCE_EQ(UseAutoGrowthDeviceAllocator(GetAllocatorStrategy()),
+                    true,
                     common::errors::Unimplemented(
                         "GetBasePtr() is only implemented for auto_growth "
-                        "strategy, not support allocator strategy: %d",
+                        "and thread_cache strategy, not support allocator "
+                        "strategy: %d",
                         static_cast<int>(GetAllocatorStrategy())));
   PADDLE_ENFORCE_EQ(phi::is_gpu_place(allocation->place()),
                     true,
@@ -1838,11 +1869,12 @@ void AllocatorFacade::SetDefaultStream(const phi::GPUPlace& place,
 
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 void AllocatorFacade::PrepareMemoryPoolForCUDAGraph(int64_t id) {
-  PADDLE_ENFORCE_EQ(GetAllocatorStrategy(),
-                    AllocatorStrategy::kAutoGrowth,
+  PADDLE_ENFORCE_EQ(UseAutoGrowthDeviceAllocator(GetAllocatorStrategy()),
+                    true,
                     common::errors::InvalidArgument(
                         "CUDA Graph is only supported when the "
-                        "FLAGS_allocator_strategy=\"auto_growth\", but got "
+                        "FLAGS_allocator_strategy=\"auto_growth\" or "
+                        "\"thread_cache\", but got "
                         "FLAGS_allocator_strategy=\"%s\"",
                         FLAGS_allocator_strategy));
   auto& allocator = cuda_graph_map_[id];
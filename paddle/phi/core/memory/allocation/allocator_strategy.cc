@@ -36,9 +36,13 @@ static AllocatorStrategy GetStrategyFromFlag() {
     return AllocatorStrategy::kThreadLocal;
   }
 
+  if (FLAGS_allocator_strategy == "thread_cache") {
+    return AllocatorStrategy::kThreadCache;
+  }
+
   PADDLE_THROW(common::errors::InvalidArgument(
       "Unsupported allocator strategy: %s, candidates are naive_best_fit, "
-      "auto_growth or thread_local.",
+      "auto_growth, thread_local or thread_cache.",
       FLAGS_allocator_strategy));
 }
 
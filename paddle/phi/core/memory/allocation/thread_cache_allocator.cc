@@ -0,0 +1,387 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/core/memory/allocation/thread_cache_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/core/memory/allocation/spin_lock.h"
+
+namespace paddle::memory::allocation {
+
+static constexpr size_t kMinClassSize = 256;
+static constexpr size_t kMinClassExponent = 8;
+// the bytes moved between a thread cache and a central list at a time
+static constexpr size_t kBatchSize = 64 << 10;
+static constexpr size_t kMaxBatchNum = 32;
+
+static size_t batch_num(size_t size_class) {
+  size_t class_size = ThreadCacheAllocator::ClassSize(size_class);
+  return std::min(kMaxBatchNum, std::max<size_t>(1, kBatchSize / class_size));
+}
+
+// set once the thread caches of this thread were handed over at its exit,
+// later frees of the thread, e.g. from static destructors of the main
+// thread, go to the central lists
+static thread_local bool thread_caches_destructed = false;
+
+static int64_t steady_now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+size_t ThreadCacheAllocator::SizeClass(size_t size) {
+  if (size <= kMinClassSize) {
+    return 0;
+  }
+  // 2^exponent < size <= 2^(exponent + 1), split in 4 classes
+  size_t exponent = kMinClassExponent;
+  while (((size - 1) >> (exponent + 1)) != 0) {
+    ++exponent;
+  }
+  size_t step = static_cast<size_t>(1) << (exponent - 2);
+  size_t k = (size - (static_cast<size_t>(1) << exponent) + step - 1) / step;
+  return 1 + (exponent - kMinClassExponent) * 4 + (k - 1);
+}
+
+size_t ThreadCacheAllocator::ClassSize(size_t size_class) {
+  if (size_class == 0) {
+    return kMinClassSize;
+  }
+  size_t exponent = kMinClassExponent + (size_class - 1) / 4;
+  size_t k = (size_class - 1) % 4 + 1;
+  return (static_cast<size_t>(1) << exponent) +
+         k * (static_cast<size_t>(1) << (exponent - 2));
+}
+
+struct ThreadCacheAllocator::ThreadCache {
+  explicit ThreadCache(size_t class_num) : lists(class_num) {}
+
+  // only contended by Release and the thread exit of the owner
+  SpinLock lock;
+  std::vector<std::vector<phi::Allocation*>> lists;
+  size_t size = 0;
+};
+
+struct ThreadCacheAllocator::CentralCache {
+  struct FreeList {
+    SpinLock lock;
+    std::vector<phi::Allocation*> allocations;
+    // the least number of allocations in the list since the last trim, the
+    // ones below it were not used since then
+    size_t low_water = 0;
+  };
+
+  CentralCache(std::shared_ptr<Allocator> allocator,
+               size_t max_size,
+               size_t cache_size,
+               int64_t trim_interval_ms)
+      : underlying_allocator(std::move(allocator)),
+        class_num(SizeClass(max_size) + 1),
+        max_class_size(ClassSize(SizeClass(max_size))),
+        thread_cache_size(cache_size),
+        trim_interval_ns(trim_interval_ms * 1000000),
+        lists(new FreeList[class_num]),
+        next_trim_ns(steady_now_ns() + trim_interval_ns) {
+    static std::atomic<uint64_t> next_id{0};
+    id = next_id.fetch_add(1);
+  }
+
+  ~CentralCache() { Release(); }
+
+  void FreeAllocations(const std::vector<phi::Allocation*>& allocations) {
+    for (phi::Allocation* allocation : allocations) {
+      underlying_allocator->Free(allocation);
+    }
+  }
+
+  // moves up to a batch of allocations of size_class into list
+  void PopBatch(size_t size_class, std::vector<phi::Allocation*>* list) {
+    FreeList& free_list = lists[size_class];
+    {
+      std::lock_guard<SpinLock> guard(free_list.lock);
+      size_t num = std::min(batch_num(size_class),
+                            free_list.allocations.size());
+      list->insert(list->end(),
+                   free_list.allocations.end() - num,
+                   free_list.allocations.end());
+      free_list.allocations.resize(free_list.allocations.size() - num);
+      free_list.low_water =
+          std::min(free_list.low_water, free_list.allocations.size());
+      cached_size -= num * ClassSize(size_class);
+    }
+    MaybeTrim();
+  }
+
+  // moves the first num allocations of list to the central list
+  void PushBatch(size_t size_class,
+                 size_t num,
+                 std::vector<phi::Allocation*>* list) {
+    FreeList& free_list = lists[size_class];
+    {
+      std::lock_guard<SpinLock> guard(free_list.lock);
+      free_list.allocations.insert(
+          free_list.allocations.end(), list->begin(), list->begin() + num);
+      cached_size += num * ClassSize(size_class);
+    }
+    list->erase(list->begin(), list->begin() + num);
+    MaybeTrim();
+  }
+
+  void MaybeTrim() {
+    int64_t next = next_trim_ns.load(std::memory_order_relaxed);
+    int64_t now = steady_now_ns();
+    if (now < next || !next_trim_ns.compare_exchange_strong(
+                          next, now + trim_interval_ns)) {
+      return;
+    }
+    std::vector<phi::Allocation*> idle;
+    for (size_t i = 0; i < class_num; ++i) {
+      FreeList& free_list = lists[i];
+      std::lock_guard<SpinLock> guard(free_list.lock);
+      size_t num = free_list.low_water;
+      idle.insert(idle.end(),
+                  free_list.allocations.begin(),
+                  free_list.allocations.begin() + num);
+      free_list.allocations.erase(free_list.allocations.begin(),
+                                  free_list.allocations.begin() + num);
+      free_list.low_water = free_list.allocations.size();
+      cached_size -= num * ClassSize(i);
+    }
+    VLOG(10) << "Trim " << idle.size() << " idle allocations of the "
+             << "ThreadCacheAllocator";
+    FreeAllocations(idle);
+  }
+
+  void RemoveThreadCache(const std::shared_ptr<ThreadCache>& cache) {
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+      thread_caches.erase(
+          std::find(thread_caches.begin(), thread_caches.end(), cache));
+    }
+    std::lock_guard<SpinLock> guard(cache->lock);
+    for (size_t i = 0; i < class_num; ++i) {
+      if (!cache->lists[i].empty()) {
+        PushBatch(i, cache->lists[i].size(), &cache->lists[i]);
+      }
+    }
+    cache->size = 0;
+  }
+
+  uint64_t Release() {
+    std::vector<phi::Allocation*> released;
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+      for (auto& cache : thread_caches) {
+        std::lock_guard<SpinLock> cache_guard(cache->lock);
+        for (auto& list : cache->lists) {
+          released.insert(released.end(), list.begin(), list.end());
+          list.clear();
+        }
+        cache->size = 0;
+      }
+    }
+    for (size_t i = 0; i < class_num; ++i) {
+      FreeList& free_list = lists[i];
+      std::lock_guard<SpinLock> guard(free_list.lock);
+      released.insert(released.end(),
+                      free_list.allocations.begin(),
+                      free_list.allocations.end());
+      cached_size -= free_list.allocations.size() * ClassSize(i);
+      free_list.allocations.clear();
+      free_list.low_water = 0;
+    }
+    uint64_t released_size = 0;
+    for (phi::Allocation* allocation : released) {
+      released_size += allocation->size();
+    }
+    FreeAllocations(released);
+    return released_size;
+  }
+
+  uint64_t id;
+  std::shared_ptr<Allocator> underlying_allocator;
+  const size_t class_num;
+  const size_t max_class_size;
+  const size_t thread_cache_size;
+  const int64_t trim_interval_ns;
+  std::unique_ptr<FreeList[]> lists;
+  std::atomic<size_t> cached_size{0};
+  std::atomic<int64_t> next_trim_ns;
+
+  // guards thread_caches
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ThreadCache>> thread_caches;
+};
+
+// The thread caches of a thread, handed over to the central lists of their
+// allocators when the thread exits.
+struct ThreadCacheAllocator::ThreadCacheRegistry {
+  struct Entry {
+    uint64_t id;
+    std::weak_ptr<CentralCache> central;
+    std::shared_ptr<ThreadCache> cache;
+  };
+
+  ~ThreadCacheRegistry() {
+    thread_caches_destructed = true;
+    for (auto& entry : entries) {
+      auto central = entry.central.lock();
+      if (central != nullptr) {
+        central->RemoveThreadCache(entry.cache);
+      }
+    }
+  }
+
+  std::vector<Entry> entries;
+};
+
+ThreadCacheAllocator::ThreadCacheAllocator(
+    std::shared_ptr<Allocator> underlying_allocator,
+    size_t max_class_size,
+    size_t thread_cache_size,
+    int64_t trim_interval_ms) {
+  PADDLE_ENFORCE_NOT_NULL(
+      underlying_allocator,
+      common::errors::InvalidArgument(
+          "Underlying allocator of ThreadCacheAllocator is NULL"));
+  PADDLE_ENFORCE_EQ(
+      underlying_allocator->IsAllocThreadSafe(),
+      true,
+      common::errors::InvalidArgument(
+          "Underlying allocator of ThreadCacheAllocator must be thread safe"));
+  central_ = std::make_shared<CentralCache>(std::move(underlying_allocator),
+                                            max_class_size,
+                                            thread_cache_size,
+                                            trim_interval_ms);
+}
+
+ThreadCacheAllocator::~ThreadCacheAllocator() = default;
+
+ThreadCacheAllocator::ThreadCache* ThreadCacheAllocator::GetThreadCache() {
+  if (UNLIKELY(thread_caches_destructed)) {
+    return nullptr;
+  }
+  static thread_local ThreadCacheRegistry registry;
+  for (auto& entry : registry.entries) {
+    if (entry.id == central_->id) {
+      return entry.cache.get();
+    }
+  }
+  // drop the caches of the allocators destructed since
+  registry.entries.erase(
+      std::remove_if(registry.entries.begin(),
+                     registry.entries.end(),
+                     [](const ThreadCacheRegistry::Entry& entry) {
+                       return entry.central.expired();
+                     }),
+      registry.entries.end());
+  auto cache = std::make_shared<ThreadCache>(central_->class_num);
+  {
+    std::lock_guard<std::mutex> guard(central_->mutex);
+    central_->thread_caches.push_back(cache);
+  }
+  registry.entries.push_back(
+      ThreadCacheRegistry::Entry{central_->id, central_, cache});
+  return cache.get();
+}
+
+phi::Allocation* ThreadCacheAllocator::AllocateImpl(size_t size) {
+  if (size > central_->max_class_size) {
+    return central_->underlying_allocator->Allocate(size).release();
+  }
+  size_t size_class = SizeClass(size);
+  ThreadCache* cache = GetThreadCache();
+  if (LIKELY(cache != nullptr)) {
+    std::lock_guard<SpinLock> guard(cache->lock);
+    auto& list = cache->lists[size_class];
+    if (list.empty()) {
+      central_->PopBatch(size_class, &list);
+      cache->size += list.size() * ClassSize(size_class);
+    }
+    if (!list.empty()) {
+      phi::Allocation* allocation = list.back();
+      list.pop_back();
+      cache->size -= allocation->size();
+      return allocation;
+    }
+  }
+
+  size_t class_size = ClassSize(size_class);
+  auto allocation =
+      central_->underlying_allocator->Allocate(class_size).release();
+  PADDLE_ENFORCE_EQ(
+      allocation->size(),
+      class_size,
+      common::errors::PreconditionNotMet(
+          "The underlying allocator of ThreadCacheAllocator should allocate "
+          "%d bytes, but got %d.",
+          class_size,
+          allocation->size()));
+  return allocation;
+}
+
+void ThreadCacheAllocator::FreeImpl(phi::Allocation* allocation) {
+  size_t size = allocation->size();
+  if (size > central_->max_class_size) {
+    central_->underlying_allocator->Free(allocation);
+    return;
+  }
+  size_t size_class = SizeClass(size);
+  ThreadCache* cache = GetThreadCache();
+  if (UNLIKELY(cache == nullptr)) {
+    std::vector<phi::Allocation*> list{allocation};
+    central_->PushBatch(size_class, 1, &list);
+    return;
+  }
+  std::lock_guard<SpinLock> guard(cache->lock);
+  auto& list = cache->lists[size_class];
+  list.push_back(allocation);
+  cache->size += size;
+  // keep a batch for the next allocations, move the older ones
+  size_t batch = batch_num(size_class);
+  size_t num = 0;
+  if (list.size() > 2 * batch) {
+    num = list.size() - batch;
+  } else if (cache->size > central_->thread_cache_size) {
+    num = list.size();
+  }
+  if (num > 0) {
+    central_->PushBatch(size_class, num, &list);
+    cache->size -= num * size;
+  }
+}
+
+uint64_t ThreadCacheAllocator::ReleaseImpl(const phi::Place& place) {
+  return central_->Release();
+}
+
+size_t ThreadCacheAllocator::CachedSize() const {
+  size_t size = central_->cached_size;
+  std::lock_guard<std::mutex> guard(central_->mutex);
+  for (auto& cache : central_->thread_caches) {
+    std::lock_guard<SpinLock> cache_guard(cache->lock);
+    size += cache->size;
+  }
+  return size;
+}
+
+}  // namespace paddle::memory::allocation
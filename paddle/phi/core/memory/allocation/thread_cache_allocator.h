@@ -0,0 +1,75 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+
+#include "paddle/phi/core/memory/allocation/allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+// ThreadCacheAllocator caches the allocations of an underlying host
+// allocator by size class, 4 classes per power of two from 256 bytes up to
+// max_class_size. Each thread allocates from and frees into a cache of its
+// own, whose lock is only contended by Release, and moves batches of
+// allocations to and from a central free list per class when its list of a
+// class runs empty or grows past its limit. A thread that exits hands its
+// cache over to the central lists.
+//
+// The central lists are trimmed every trim_interval_ms: the allocations of
+// a class that stayed in its list since the last trim are freed. Release
+// frees every cached allocation, including the ones of the thread caches.
+// Larger allocations go to the underlying allocator directly.
+//
+// The underlying allocator must be thread safe and return allocations of
+// the requested size, as CPUAllocator does, since the class of a freed
+// allocation is found from its size.
+class ThreadCacheAllocator : public Allocator {
+ public:
+  ThreadCacheAllocator(std::shared_ptr<Allocator> underlying_allocator,
+                       size_t max_class_size,
+                       size_t thread_cache_size,
+                       int64_t trim_interval_ms);
+  ~ThreadCacheAllocator() override;
+
+  bool IsAllocThreadSafe() const override { return true; }
+
+  static size_t SizeClass(size_t size);
+  static size_t ClassSize(size_t size_class);
+
+  // the bytes of the allocations cached in the central lists and the
+  // thread caches
+  size_t CachedSize() const;
+
+ protected:
+  phi::Allocation* AllocateImpl(size_t size) override;
+  void FreeImpl(phi::Allocation* allocation) override;
+  uint64_t ReleaseImpl(const phi::Place& place) override;
+
+ private:
+  struct ThreadCache;
+  struct CentralCache;
+  struct ThreadCacheRegistry;
+
+  ThreadCache* GetThreadCache();
+
+  std::shared_ptr<CentralCache> central_;
+};
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
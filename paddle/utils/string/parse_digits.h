@@ -0,0 +1,107 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace paddle {
+namespace string {
+
+inline constexpr uint64_t kDecimalPow10[20] = {1ULL,
+                                               10ULL,
+                                               100ULL,
+                                               1000ULL,
+                                               10000ULL,
+                                               100000ULL,
+                                               1000000ULL,
+                                               10000000ULL,
+                                               100000000ULL,
+                                               1000000000ULL,
+                                               10000000000ULL,
+                                               100000000000ULL,
+                                               1000000000000ULL,
+                                               10000000000000ULL,
+                                               100000000000000ULL,
+                                               1000000000000000ULL,
+                                               10000000000000000ULL,
+                                               100000000000000000ULL,
+                                               1000000000000000000ULL,
+                                               10000000000000000000ULL};
+
+// value of 8 ascii digits, the first one in the lowest byte
+inline uint64_t Swar8Digits(uint64_t chunk) {
+  chunk -= 0x3030303030303030ULL;
+  chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FFULL;
+  chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFFULL;
+  return (chunk * 10000 + (chunk >> 32)) & 0xFFFFFFFFULL;
+}
+
+// Parses the decimal digits in [p, end) into value, eight digits at a time
+// with SWAR (SIMD within a register) arithmetic where the buffer allows it.
+// Returns the end of the digits, or p if there is no digit or the value does
+// not fit in 64 bits. value is left untouched when p is returned, so callers
+// can fall back to strtoull or reject the field.
+inline const char* ParseUint64Digits(const char* p,
+                                     const char* end,
+                                     uint64_t* value) {
+  const char* start = p;
+  uint64_t result = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  while (end - p >= 8) {
+    uint64_t chunk;
+    memcpy(&chunk, p, sizeof(chunk));
+    // a byte is a digit iff its high nibble is 3 and adding 6 does not
+    // carry into it, carries only go up so the lowest flag is exact
+    uint64_t non_digit =
+        ((chunk & 0xF0F0F0F0F0F0F0F0ULL) ^ 0x3030303030303030ULL) |
+        ((chunk + 0x0606060606060606ULL) & 0xC0C0C0C0C0C0C0C0ULL);
+    int num = non_digit == 0 ? 8 : __builtin_ctzll(non_digit) >> 3;
+    if (num == 0) {
+      break;
+    }
+    if (num < 8) {
+      // move the digits to the high bytes behind leading zeros
+      chunk =
+          (chunk << (8 * (8 - num))) | (0x3030303030303030ULL >> (8 * num));
+    }
+    uint64_t digits = Swar8Digits(chunk);
+    if (p - start + num > 19 &&
+        result > (UINT64_MAX - digits) / kDecimalPow10[num]) {
+      return start;
+    }
+    result = result * kDecimalPow10[num] + digits;
+    p += num;
+    if (num < 8) {
+      *value = result;
+      return p;
+    }
+  }
+#endif
+  for (; p < end && static_cast<unsigned char>(*p - '0') < 10; ++p) {
+    uint64_t digit = *p - '0';
+    if (p - start >= 19 && result > (UINT64_MAX - digit) / 10) {
+      return start;
+    }
+    result = result * 10 + digit;
+  }
+  if (p != start) {
+    *value = result;
+  }
+  return p;
+}
+
+}  // namespace string
+}  // namespace paddle
@@ -1068,6 +1068,139 @@ class InMemoryDataset(DatasetBase):
         self.dataset.wait_preload_done()
         self.dataset.destroy_preload_readers()
 
+    def dump_binary_cache(self, cache_dir: str) -> None:
+        """
+        :api_attr: Static Graph
+
+        Dump the parsed data in memory into binary cache files under the
+        local directory cache_dir, replacing the cache files already there.
+        After set_binary_cache_dir(cache_dir), load_into_memory and
+        preload_into_memory map these files and load them without running
+        the pipe command and parsing the text again. Only supported with
+        data_feed_type SlotRecordInMemoryDataFeed.
+
+        Args:
+            cache_dir(str): local directory of the binary cache files
+
+        Examples:
+            .. code-block:: python
+
+                >>> # doctest: +SKIP('No files to read')
+                >>> import paddle
+                >>> paddle.enable_static()
+
+                >>> dataset = paddle.distributed.InMemoryDataset()
+                >>> slots = ["slot1", "slot2", "slot3", "slot4"]
+                >>> slots_vars = []
+                >>> for slot in slots:
+                ...     var = paddle.static.data(
+                ...         name=slot, shape=[None, 1], dtype="int64", lod_level=1)
+                ...     slots_vars.append(var)
+                >>> dataset.init(
+                ...     batch_size=1,
+                ...     thread_num=2,
+                ...     pipe_command="cat",
+                ...     data_feed_type="SlotRecordInMemoryDataFeed",
+                ...     use_var=slots_vars)
+                >>> filelist = ["a.txt", "b.txt"]
+                >>> dataset.set_filelist(filelist)
+                >>> dataset.load_into_memory()
+                >>> dataset.dump_binary_cache("./dataset_cache")
+
+        """
+        self.dataset.dump_into_binary_cache(cache_dir)
+
+    def set_binary_cache_dir(self, cache_dir: str) -> None:
+        """
+        :api_attr: Static Graph
+
+        Load the binary cache files under cache_dir, dumped by
+        dump_binary_cache with the same used slots, instead of the filelist
+        in the following load_into_memory or preload_into_memory. Call it
+        again before every load, like set_filelist. An empty cache_dir
+        loads the filelist again.
+
+        Args:
+            cache_dir(str): local directory of the binary cache files
+
+        Examples:
+            .. code-block:: python
+
+                >>> # doctest: +SKIP('No files to read')
+                >>> import paddle
+                >>> paddle.enable_static()
+
+                >>> dataset = paddle.distributed.InMemoryDataset()
+                >>> slots = ["slot1", "slot2", "slot3", "slot4"]
+                >>> slots_vars = []
+                >>> for slot in slots:
+                ...     var = paddle.static.data(
+                ...         name=slot, shape=[None, 1], dtype="int64", lod_level=1)
+                ...     slots_vars.append(var)
+                >>> dataset.init(
+                ...     batch_size=1,
+                ...     thread_num=2,
+                ...     pipe_command="cat",
+                ...     data_feed_type="SlotRecordInMemoryDataFeed",
+                ...     use_var=slots_vars)
+                >>> dataset.set_binary_cache_dir("./dataset_cache")
+                >>> dataset.load_into_memory()
+
+        """
+        # the cache files are checked against the used slots of the desc
+        self.dataset.set_data_feed_desc(self._desc())
+        self.dataset.set_binary_cache_dir(cache_dir)
+
+    def set_streaming_mode(self, window_size: int, spill_dir: str = "") -> None:
+        """
+        :api_attr: Static Graph
+
+        Stream the data to training instead of holding the whole pass in
+        memory. preload_into_memory starts loading and train_from_dataset
+        can run right away, taking the records shuffled within a window of
+        window_size records. The loading channel, the window and the
+        training channel each hold up to window_size records. When spill_dir
+        is set and training falls behind, the records are spilled there and
+        read back later instead of stalling the loading. Call
+        wait_preload_done after train_from_dataset to finish the pass. Only
+        supported with data_feed_type SlotRecordInMemoryDataFeed.
+
+        Args:
+            window_size(int): records to shuffle within, 0 turns streaming off
+            spill_dir(str): local directory for the spilled records, empty to
+                never spill. Default is "".
+
+        Examples:
+            .. code-block:: python
+
+                >>> # doctest: +SKIP('No files to read')
+                >>> import paddle
+                >>> paddle.enable_static()
+
+                >>> dataset = paddle.distributed.InMemoryDataset()
+                >>> slots = ["slot1", "slot2", "slot3", "slot4"]
+                >>> slots_vars = []
+                >>> for slot in slots:
+                ...     var = paddle.static.data(
+                ...         name=slot, shape=[None, 1], dtype="int64", lod_level=1)
+                ...     slots_vars.append(var)
+                >>> dataset.init(
+                ...     batch_size=1,
+                ...     thread_num=2,
+                ...     pipe_command="cat",
+                ...     data_feed_type="SlotRecordInMemoryDataFeed",
+                ...     use_var=slots_vars)
+                >>> dataset.set_filelist(["a.txt", "b.txt"])
+                >>> dataset.set_streaming_mode(100000, "./stream_spill")
+                >>> dataset.preload_into_memory()
+                >>> exe = paddle.static.Executor(paddle.CPUPlace())
+                >>> main_program = paddle.static.default_main_program()
+                >>> exe.train_from_dataset(main_program, dataset)
+                >>> dataset.wait_preload_done()
+
+        """
+        self.dataset.set_streaming_mode(window_size, spill_dir)
+
     def local_shuffle(self) -> None:
         """
         :api_attr: Static Graph
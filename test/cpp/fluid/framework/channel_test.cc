@@ -0,0 +1,144 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/channel.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+// Runs producers writing blocks of 1..block_size values and consumers
+// reading blocks through ChannelReader, checks that every value arrives
+// once and returns the seconds it took.
+static double RunProducersConsumers(Channel<uint64_t> chan,
+                                    int producer_num,
+                                    int consumer_num,
+                                    uint64_t per_producer,
+                                    size_t block_size) {
+  chan->SetBlockSize(block_size);
+  std::atomic<uint64_t> sum(0);
+  std::atomic<uint64_t> count(0);
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> producers;
+  for (int i = 0; i < producer_num; ++i) {
+    producers.emplace_back([&, i]() {
+      std::vector<uint64_t> block;
+      uint64_t value = i * per_producer;
+      uint64_t end = value + per_producer;
+      while (value < end) {
+        size_t num = 1 + value % block_size;
+        for (size_t j = 0; j < num && value < end; ++j) {
+          block.push_back(value++);
+        }
+        size_t size = block.size();
+        ASSERT_EQ(chan->Write(std::move(block)), size);
+        block.clear();
+      }
+    });
+  }
+  std::vector<std::thread> consumers;
+  for (int i = 0; i < consumer_num; ++i) {
+    consumers.emplace_back([&]() {
+      ChannelReader<uint64_t> reader(chan.get());
+      uint64_t value = 0;
+      uint64_t local_sum = 0;
+      uint64_t local_count = 0;
+      while (reader >> value) {
+        local_sum += value;
+        ++local_count;
+      }
+      sum += local_sum;
+      count += local_count;
+    });
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+  chan->Close();
+  for (auto& t : consumers) {
+    t.join();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  uint64_t total = producer_num * per_producer;
+  EXPECT_EQ(count.load(), total);
+  EXPECT_EQ(sum.load(), total * (total - 1) / 2);
+  EXPECT_TRUE(chan->Empty());
+  return seconds;
+}
+
+TEST(Channel, LockFreeReadWrite) {
+  auto chan = MakeLockFreeChannel<std::string>(5);
+  ASSERT_TRUE(chan->LockFree());
+  ASSERT_EQ(chan->Capacity(), 8UL);
+  std::vector<std::string> in = {"a", "b", "c"};
+  ASSERT_EQ(chan->Write(in), 3UL);
+  ASSERT_TRUE(chan->Put("d"));
+  ASSERT_EQ(chan->Size(), 4UL);
+  std::vector<std::string> out;
+  ASSERT_EQ(chan->ReadOnce(out, 8), 4UL);
+  ASSERT_EQ(out, std::vector<std::string>({"a", "b", "c", "d"}));
+  ASSERT_TRUE(chan->Empty());
+
+  // a full channel blocks the writer until a reader makes room
+  std::vector<std::string> many(20, "x");
+  std::thread writer([&]() { ASSERT_EQ(chan->Write(many), 20UL); });
+  std::string val;
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_TRUE(chan->Get(val));
+    ASSERT_EQ(val, "x");
+  }
+  writer.join();
+
+  // closing wakes the readers, the remaining data can still be read
+  std::thread reader([&]() {
+    std::vector<std::string> all;
+    chan->ReadAll(all);
+    ASSERT_EQ(all, std::vector<std::string>({"y"}));
+  });
+  ASSERT_TRUE(chan->Put("y"));
+  chan->Close();
+  reader.join();
+  ASSERT_FALSE(chan->Put("z"));
+  ASSERT_ANY_THROW(chan->SetCapacity(16));
+}
+
+TEST(Channel, LockFreeManyThreads) {
+  RunProducersConsumers(MakeLockFreeChannel<uint64_t>(256), 32, 32, 2000, 64);
+  RunProducersConsumers(MakeLockFreeChannel<uint64_t>(1), 8, 8, 2000, 1);
+}
+
+// 32 producers and 32 consumers moving blocks through a mutex channel and a
+// lock-free channel of the same capacity.
+TEST(Channel, BENCHMARK_ProducersConsumers) {
+  for (size_t block_size : {1, 64}) {
+    double mutex_seconds = RunProducersConsumers(
+        MakeChannel<uint64_t>(4096), 32, 32, 50000, block_size);
+    double lock_free_seconds = RunProducersConsumers(
+        MakeLockFreeChannel<uint64_t>(4096), 32, 32, 50000, block_size);
+    LOG(INFO) << "block size " << block_size << ": mutex " << mutex_seconds
+              << "s, lock-free " << lock_free_seconds << "s";
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
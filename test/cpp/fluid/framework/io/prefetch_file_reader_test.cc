@@ -0,0 +1,227 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/io/prefetch_file_reader.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+// Picks the files of a list in order, as DataFeed::PickOneFile does.
+class FileListPicker {
+ public:
+  explicit FileListPicker(std::vector<std::string> files)
+      : files_(std::move(files)) {}
+
+  bool Pick(std::string* filename) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_ == files_.size()) {
+      return false;
+    }
+    *filename = files_[index_++];
+    return true;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::string> files_;
+  size_t index_ = 0;
+};
+
+// Opens local files, slowly when delay_ms is set, the way a remote file
+// system starts a shell pipe. Files named in fail_read end with a non-zero
+// err_no when closed, the ones in fail_open cannot be opened.
+static PrefetchFileReader::OpenFunc LocalOpen(
+    int delay_ms,
+    const std::string& fail_read = "",
+    const std::string& fail_open = "") {
+  return [=](const std::string& path, int* err_no) -> std::shared_ptr<FILE> {
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    if (path == fail_open) {
+      return nullptr;
+    }
+    FILE* fp = fopen(path.c_str(), "r");
+    bool fail = path == fail_read;
+    return std::shared_ptr<FILE>(fp, [err_no, fail](FILE* fp) {
+      fclose(fp);
+      if (fail) {
+        *err_no = -1;
+      }
+    });
+  };
+}
+
+// Writes num files of 10 * i lines into a directory of their own under the
+// system temp directory, which is removed with them when it goes away.
+class TestFiles {
+ public:
+  TestFiles(const std::string& name, int num) {
+    dir_ = std::filesystem::temp_directory_path() /
+           ("prefetch_file_reader_test_" + name + "_" +
+            std::to_string(
+                std::chrono::steady_clock::now().time_since_epoch().count()));
+    std::filesystem::create_directories(dir_);
+    for (int i = 0; i < num; ++i) {
+      files_.push_back((dir_ / ("file_" + std::to_string(i))).string());
+      std::ofstream out(files_.back());
+      for (int j = 0; j < i * 10; ++j) {
+        out << "file " << i << " line " << j << "\n";
+      }
+    }
+  }
+  ~TestFiles() {
+    std::error_code ec;
+    std::filesystem::remove_all(dir_, ec);
+  }
+
+  const std::vector<std::string>& files() const { return files_; }
+
+ private:
+  std::filesystem::path dir_;
+  std::vector<std::string> files_;
+};
+
+static std::string ReadAll(PrefetchFileReader* reader) {
+  std::string content;
+  char buf[5];
+  int len = 0;
+  while ((len = reader->Read(buf, sizeof(buf))) > 0) {
+    content.append(buf, len);
+  }
+  return content;
+}
+
+static std::string ReadLocal(const std::string& path) {
+  std::ifstream in(path);
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+TEST(PrefetchFileReader, ReadFiles) {
+  TestFiles test_files("ReadFiles", 20);
+  const auto& files = test_files.files();
+  FileListPicker picker(files);
+  // small blocks so that the reading threads wait for room
+  PrefetchFileReader reader(
+      [&picker](std::string* f) { return picker.Pick(f); },
+      LocalOpen(0),
+      3,
+      16,
+      2);
+  std::map<std::string, std::string> contents;
+  std::string filename;
+  uint64_t bytes = 0;
+  while (reader.NextFile(&filename)) {
+    ASSERT_EQ(contents.count(filename), 0UL);
+    contents[filename] = ReadAll(&reader);
+    ASSERT_FALSE(reader.Failed());
+    bytes += contents[filename].size();
+  }
+  ASSERT_EQ(contents.size(), files.size());
+  for (auto& file : files) {
+    ASSERT_EQ(contents[file], ReadLocal(file));
+  }
+  auto stats = reader.GetStats();
+  ASSERT_EQ(stats.files, files.size());
+  ASSERT_EQ(stats.bytes, bytes);
+  ASSERT_FALSE(reader.NextFile(&filename));
+}
+
+TEST(PrefetchFileReader, OverlapSlowOpens) {
+  TestFiles test_files("OverlapSlowOpens", 8);
+  const auto& files = test_files.files();
+  FileListPicker picker(files);
+  // counts the opens in flight rather than timing them, which is flaky on
+  // a loaded machine
+  std::atomic<int> opening(0);
+  std::atomic<int> max_opening(0);
+  auto local_open = LocalOpen(50);
+  auto open = [&](const std::string& path, int* err_no) {
+    int num = ++opening;
+    int max_num = max_opening.load();
+    while (num > max_num &&
+           !max_opening.compare_exchange_weak(max_num, num)) {
+    }
+    auto fp = local_open(path, err_no);
+    --opening;
+    return fp;
+  };
+  PrefetchFileReader reader(
+      [&picker](std::string* f) { return picker.Pick(f); }, open, 4, 1 << 20);
+  std::string filename;
+  int num = 0;
+  while (reader.NextFile(&filename)) {
+    ReadAll(&reader);
+    ++num;
+  }
+  ASSERT_EQ(num, 8);
+  // the files are opened by up to four threads at a time
+  ASSERT_GT(max_opening.load(), 1);
+  ASSERT_LE(max_opening.load(), 4);
+  auto stats = reader.GetStats();
+  ASSERT_GE(stats.open_seconds, 0.4);
+  ASSERT_GT(stats.stalls, 0UL);
+}
+
+TEST(PrefetchFileReader, Errors) {
+  TestFiles test_files("Errors", 6);
+  const auto& files = test_files.files();
+  {
+    FileListPicker picker(files);
+    PrefetchFileReader reader(
+        [&picker](std::string* f) { return picker.Pick(f); },
+        LocalOpen(0, files[2]),
+        1,
+        8);
+    std::string filename;
+    int failed = 0;
+    while (reader.NextFile(&filename)) {
+      // the files can be left before their end
+      char buf[8];
+      reader.Read(buf, sizeof(buf));
+      if (filename == files[2]) {
+        ReadAll(&reader);
+        ASSERT_TRUE(reader.Failed());
+        ++failed;
+      } else {
+        ASSERT_FALSE(reader.Failed());
+      }
+    }
+    ASSERT_EQ(failed, 1);
+  }
+  {
+    FileListPicker picker(files);
+    PrefetchFileReader reader(
+        [&picker](std::string* f) { return picker.Pick(f); },
+        LocalOpen(0, "", files[0]),
+        2,
+        8);
+    std::string filename;
+    ASSERT_ANY_THROW(while (reader.NextFile(&filename)) ReadAll(&reader));
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
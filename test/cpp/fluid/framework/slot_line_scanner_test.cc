@@ -0,0 +1,177 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/slot_line_scanner.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace paddle {
+namespace framework {
+
+// Random slot lines in the feed format: "num v1 v2 ..." per slot, with
+// feasigns of all lengths, short decimals and some values that only libc
+// parses (exponents, signs, overflow, nan).
+static std::string MakeSlotLine(std::mt19937_64* engine, int slot_num) {
+  std::string line;
+  for (int i = 0; i < slot_num; ++i) {
+    int num = 1 + (*engine)() % 6;
+    line += std::to_string(num);
+    for (int j = 0; j < num; ++j) {
+      line += (*engine)() % 4 == 0 ? "  " : " ";
+      switch ((*engine)() % 8) {
+        case 0:
+          line += std::to_string((*engine)() >> ((*engine)() % 64));
+          break;
+        case 1:
+          line += std::to_string((*engine)() % 1000) + "." +
+                  std::to_string((*engine)() % 100000);
+          break;
+        case 2:
+          line += "-0." + std::to_string((*engine)() % 1000000000000ULL);
+          break;
+        case 3:
+          line += std::to_string((*engine)() % 100) + "e-" +
+                  std::to_string((*engine)() % 40);
+          break;
+        case 4:
+          line += "+" + std::to_string((*engine)() % 100000);
+          break;
+        case 5:
+          line += "184467440737095516150";
+          break;
+        case 6:
+          line += (*engine)() % 2 == 0 ? "nan" : "-inf";
+          break;
+        default:
+          line += std::to_string((*engine)() % 1000000000);
+          break;
+      }
+    }
+    line += " ";
+  }
+  return line;
+}
+
+TEST(SlotLineScanner, MatchesLibc) {
+  std::mt19937_64 engine(0);
+  for (int i = 0; i < 20000; ++i) {
+    std::string line = MakeSlotLine(&engine, 8);
+    const char* str = line.c_str();
+    int type = i % 3;
+    SlotLineScanner scanner(str, line.size());
+    char* endptr = const_cast<char*>(str);
+    while (*endptr != '\0') {
+      ASSERT_EQ(scanner.pos(), endptr) << line;
+      const char* start = endptr;
+      if (type == 0) {
+        uint64_t expect = strtoull(endptr, &endptr, 10);
+        ASSERT_EQ(scanner.ParseUint64(), expect) << line;
+      } else if (type == 1) {
+        int64_t expect = strtoll(endptr, &endptr, 10);
+        ASSERT_EQ(scanner.ParseInt64(), expect) << line;
+      } else {
+        float expect = strtof(endptr, &endptr);
+        float value = scanner.ParseFloat();
+        ASSERT_EQ(memcmp(&value, &expect, sizeof(float)), 0)
+            << line << " at " << endptr - str;
+      }
+      ASSERT_EQ(scanner.pos(), endptr) << line;
+      if (endptr == start || (*endptr != '\0' && *endptr != ' ')) {
+        // libc stopped on a char it does not parse, step over it
+        ++endptr;
+        scanner.set_pos(endptr);
+      }
+    }
+    ASSERT_EQ(scanner.pos(), endptr) << line;
+  }
+}
+
+TEST(SlotLineScanner, SkipToken) {
+  std::string line = "3 1234567890123456789 a\tb  x\n";
+  SlotLineScanner scanner(line.c_str(), line.size());
+  ASSERT_EQ(scanner.ParseInt64(), 3);
+  scanner.SkipToken();
+  ASSERT_EQ(scanner.pos(), line.c_str() + 21);
+  scanner.SkipToken();
+  ASSERT_EQ(scanner.pos(), line.c_str() + 23);
+  scanner.SkipToken();
+  ASSERT_EQ(scanner.pos(), line.c_str() + 25);
+  scanner.SkipToken();
+  ASSERT_EQ(scanner.pos(), line.c_str() + 28);
+  scanner.SkipToken();
+  ASSERT_EQ(scanner.pos(), line.c_str() + line.size());
+}
+
+// Parses CTR-like lines of 100 slots with strtoull/strtof and the scanner.
+TEST(SlotLineScanner, BENCHMARK_ParseLines) {
+  std::mt19937_64 engine(0);
+  std::vector<std::string> lines;
+  size_t bytes = 0;
+  for (int i = 0; i < 20000; ++i) {
+    std::string line;
+    for (int slot = 0; slot < 100; ++slot) {
+      int num = 1 + engine() % 4;
+      line += std::to_string(num);
+      for (int j = 0; j < num; ++j) {
+        line += " ";
+        line += slot < 10 ? std::to_string(engine() % 1000 / 1000.0).substr(
+                                0, 5)
+                          : std::to_string(engine() >> 4);
+      }
+      line += " ";
+    }
+    bytes += line.size();
+    lines.push_back(std::move(line));
+  }
+
+  uint64_t sum = 0;
+  for (bool with_scanner : {false, true}) {
+    auto start = std::chrono::steady_clock::now();
+    for (auto& line : lines) {
+      const char* str = line.c_str();
+      char* endptr = const_cast<char*>(str);
+      SlotLineScanner scanner(str, line.size());
+      for (int slot = 0; slot < 100; ++slot) {
+        int num = with_scanner ? static_cast<int>(scanner.ParseInt64())
+                               : static_cast<int>(strtol(endptr, &endptr, 10));
+        for (int j = 0; j < num; ++j) {
+          if (slot < 10) {
+            sum += with_scanner ? scanner.ParseFloat() > 0.5f
+                                : strtof(endptr, &endptr) > 0.5f;
+          } else {
+            sum += with_scanner ? scanner.ParseUint64()
+                                : strtoull(endptr, &endptr, 10);
+          }
+        }
+      }
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    LOG(INFO) << (with_scanner ? "scanner" : "libc") << ": "
+              << bytes / seconds / (1 << 20) << " MB/s";
+  }
+  LOG(INFO) << "checksum " << sum;
+}
+
+}  // namespace framework
+}  // namespace paddle
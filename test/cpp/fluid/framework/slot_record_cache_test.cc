@@ -0,0 +1,109 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/slot_record_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+template <typename T>
+static void FillSlots(std::mt19937_64* engine,
+                      int slot_num,
+                      SlotValues<T>* values) {
+  values->slot_values.clear();
+  values->slot_offsets.clear();
+  // a value before the first slot, the blocks store rebased offsets
+  values->slot_values.push_back(T(7));
+  values->slot_offsets.push_back(1);
+  for (int i = 0; i < slot_num; ++i) {
+    int num = (*engine)() % 4;
+    for (int j = 0; j < num; ++j) {
+      values->slot_values.push_back(static_cast<T>((*engine)() % 100000));
+    }
+    values->slot_offsets.push_back(values->slot_values.size());
+  }
+}
+
+template <typename T>
+static void ExpectSameSlots(const SlotValues<T>& expect,
+                            const SlotValues<T>& actual) {
+  uint32_t begin = expect.slot_offsets.front();
+  ASSERT_EQ(expect.slot_offsets.size(), actual.slot_offsets.size());
+  for (size_t i = 0; i < expect.slot_offsets.size(); ++i) {
+    ASSERT_EQ(expect.slot_offsets[i] - begin, actual.slot_offsets[i]);
+  }
+  ASSERT_EQ(std::vector<T>(expect.slot_values.begin() + begin,
+                           expect.slot_values.end()),
+            actual.slot_values);
+}
+
+TEST(SlotRecordCache, EncodeDecodeBlocks) {
+  std::mt19937_64 engine(0);
+  std::vector<SlotRecord> records;
+  SlotRecordPool().get(&records, 100);
+  for (size_t i = 0; i < records.size(); ++i) {
+    SlotRecord rec = records[i];
+    FillSlots(&engine, 5, &rec->slot_uint64_feasigns_);
+    FillSlots(&engine, 2, &rec->slot_float_feasigns_);
+    rec->ins_id_ = i % 3 == 0 ? "" : "ins_" + std::to_string(i);
+    rec->search_id = engine();
+    rec->cmatch = i;
+    rec->rank = i * 2;
+  }
+
+  // two blocks in one message, as GlobalShuffle may send them
+  std::string msg;
+  EncodeSlotRecordBlock(records.data(), 30, 5, 2, &msg);
+  size_t first_bytes = msg.size();
+  ASSERT_EQ(first_bytes % 8, 0UL);
+  EncodeSlotRecordBlock(records.data() + 30, 70, 5, 2, &msg);
+
+  std::vector<SlotRecord> decoded;
+  size_t pos =
+      DecodeSlotRecordBlock(msg.data(), msg.size(), 5, 2, "msg", &decoded);
+  ASSERT_EQ(pos, first_bytes);
+  ASSERT_EQ(decoded.size(), 30UL);
+  pos += DecodeSlotRecordBlock(
+      msg.data() + pos, msg.size() - pos, 5, 2, "msg", &decoded);
+  ASSERT_EQ(pos, msg.size());
+  ASSERT_EQ(decoded.size(), records.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    ExpectSameSlots(records[i]->slot_uint64_feasigns_,
+                    decoded[i]->slot_uint64_feasigns_);
+    ExpectSameSlots(records[i]->slot_float_feasigns_,
+                    decoded[i]->slot_float_feasigns_);
+    ASSERT_EQ(records[i]->ins_id_, decoded[i]->ins_id_);
+    ASSERT_EQ(records[i]->search_id, decoded[i]->search_id);
+    ASSERT_EQ(records[i]->cmatch, decoded[i]->cmatch);
+    ASSERT_EQ(records[i]->rank, decoded[i]->rank);
+  }
+
+  std::vector<SlotRecord> truncated;
+  ASSERT_ANY_THROW(DecodeSlotRecordBlock(
+      msg.data(), first_bytes - 8, 5, 2, "msg", &truncated));
+  // the records have 5 uint64 slots
+  ASSERT_ANY_THROW(EncodeSlotRecordBlock(records.data(), 1, 4, 2, &msg));
+
+  SlotRecordPool().put(&records);
+  SlotRecordPool().put(&decoded);
+}
+
+}  // namespace framework
+}  // namespace paddle
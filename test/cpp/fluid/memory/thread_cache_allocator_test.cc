@@ -0,0 +1,171 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/core/memory/allocation/thread_cache_allocator.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/common/flags.h"
+#include "paddle/phi/core/memory/allocation/allocator_facade.h"
+#include "paddle/phi/core/memory/allocation/cpu_allocator.h"
+#include "paddle/phi/core/memory/stats.h"
+
+COMMON_DECLARE_string(allocator_strategy);
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+class RecordedAllocator : public Allocator {
+ public:
+  bool IsAllocThreadSafe() const override { return true; }
+  int64_t AllocatedSize() const { return allocated_size_; }
+
+ protected:
+  phi::Allocation *AllocateImpl(size_t size) override {
+    allocated_size_ += static_cast<int64_t>(size);
+    return new Allocation(malloc(size), size, phi::CPUPlace());  // NOLINT
+  }
+
+  void FreeImpl(phi::Allocation *allocation) override {
+    allocated_size_ -= static_cast<int64_t>(allocation->size());
+    free(allocation->ptr());  // NOLINT
+    delete allocation;
+  }
+
+ private:
+  std::atomic<int64_t> allocated_size_{0};
+};
+
+TEST(ThreadCacheAllocator, size_class) {
+  for (size_t size = 1; size <= (1 << 20); ++size) {
+    size_t size_class = ThreadCacheAllocator::SizeClass(size);
+    ASSERT_GE(ThreadCacheAllocator::ClassSize(size_class), size);
+    if (size_class > 0) {
+      ASSERT_LT(ThreadCacheAllocator::ClassSize(size_class - 1), size);
+    }
+  }
+  ASSERT_EQ(ThreadCacheAllocator::ClassSize(0), 256UL);
+  ASSERT_EQ(ThreadCacheAllocator::ClassSize(1), 320UL);
+  ASSERT_EQ(ThreadCacheAllocator::ClassSize(4), 512UL);
+  ASSERT_EQ(ThreadCacheAllocator::ClassSize(5), 640UL);
+}
+
+TEST(ThreadCacheAllocator, reuse_and_release) {
+  auto recorded_allocator = std::make_shared<RecordedAllocator>();
+  ThreadCacheAllocator allocator(recorded_allocator, 256 << 10, 4 << 20, 1000);
+
+  void *ptr = nullptr;
+  {
+    auto allocation = allocator.Allocate(1000);
+    ASSERT_EQ(allocation->size(), 1024UL);
+    ptr = allocation->ptr();
+  }
+  {
+    auto allocation = allocator.Allocate(1000);
+    ASSERT_EQ(allocation->ptr(), ptr);
+  }
+  {
+    auto allocation = allocator.Allocate(1 << 20);
+    ASSERT_EQ(allocation->size(), 1UL << 20);
+  }
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), 1024);
+
+  // freed in another thread, cached by that thread until it exits
+  auto allocation = allocator.Allocate(3000);
+  std::thread([&allocation]() { allocation.reset(); }).join();
+  ASSERT_EQ(allocator.CachedSize(), 1024UL + 3072UL);
+
+  ASSERT_EQ(allocator.Release(phi::CPUPlace()), 1024UL + 3072UL);
+  ASSERT_EQ(allocator.CachedSize(), 0UL);
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), 0);
+}
+
+TEST(ThreadCacheAllocator, trim) {
+  auto recorded_allocator = std::make_shared<RecordedAllocator>();
+  ThreadCacheAllocator allocator(recorded_allocator, 256 << 10, 0, 10);
+
+  // with no room in the thread caches every free goes to the central lists
+  allocator.Allocate(1000);
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), 1024);
+  // the first trim marks the allocation idle, the second one frees it
+  for (int i = 0; i < 2; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    allocator.Allocate(5000);
+  }
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), 5120);
+}
+
+TEST(ThreadCacheAllocator, allocator_facade) {
+  FLAGS_allocator_strategy = "thread_cache";
+  int64_t allocated = HOST_MEMORY_STAT_CURRENT_VALUE(Allocated, 0);
+  {
+    auto allocation =
+        AllocatorFacade::Instance().Alloc(phi::CPUPlace(), 1000);
+    ASSERT_NE(allocation->ptr(), nullptr);
+    ASSERT_EQ(HOST_MEMORY_STAT_CURRENT_VALUE(Allocated, 0), allocated + 1024);
+    ASSERT_GE(HOST_MEMORY_STAT_CURRENT_VALUE(Reserved, 0),
+              HOST_MEMORY_STAT_CURRENT_VALUE(Allocated, 0));
+  }
+  ASSERT_EQ(HOST_MEMORY_STAT_CURRENT_VALUE(Allocated, 0), allocated);
+  AllocatorFacade::Instance().Release(phi::CPUPlace());
+}
+
+// Allocates and frees in several threads, each keeping a window of live
+// allocations, through CPUAllocator and a ThreadCacheAllocator over it.
+static double RunAllocFreeBenchmark(Allocator *allocator, int thread_num) {
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_num; ++i) {
+    threads.emplace_back([allocator, i]() {
+      std::vector<AllocationPtr> window(16);
+      uint32_t seed = i;
+      for (int j = 0; j < 100000; ++j) {
+        seed = seed * 1103515245 + 12345;
+        window[seed % window.size()] =
+            allocator->Allocate(64 + (seed >> 8) % (16 << 10));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       begin)
+      .count();
+}
+
+TEST(ThreadCacheAllocator, multithread_benchmark) {
+  auto cpu_allocator = std::make_shared<CPUAllocator>();
+  ThreadCacheAllocator thread_cache_allocator(
+      cpu_allocator, 256 << 10, 4 << 20, 1000);
+  for (int thread_num : {1, 4, 8}) {
+    double cpu_seconds = RunAllocFreeBenchmark(cpu_allocator.get(), thread_num);
+    double thread_cache_seconds =
+        RunAllocFreeBenchmark(&thread_cache_allocator, thread_num);
+    LOG(INFO) << thread_num << " threads, CPUAllocator: " << cpu_seconds
+              << "s, ThreadCacheAllocator: " << thread_cache_seconds << "s";
+  }
+  thread_cache_allocator.Release(phi::CPUPlace());
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
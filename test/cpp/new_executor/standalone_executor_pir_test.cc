@@ -17,12 +17,20 @@
 #include <gtest/gtest.h>
 
 #include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <string>
 
 #include "paddle/phi/core/kernel_registry.h"
 
+#include "paddle/common/flags.h"
+#include "paddle/fluid/framework/new_executor/interpreter/build_cache.h"
+#include "paddle/fluid/framework/new_executor/interpreter/critical_path.h"
+#include "paddle/fluid/framework/new_executor/interpreter/static_memory_plan.h"
 #include "paddle/fluid/framework/new_executor/pir_interpreter.h"
+#include "paddle/fluid/pir/dialect/kernel/ir/kernel_op.h"
 #include "paddle/fluid/pir/dialect/operator/ir/control_flow_op.h"
 #include "paddle/fluid/pir/dialect/operator/ir/op_dialect.h"
 #include "paddle/fluid/pir/dialect/operator/ir/pd_op.h"
@@ -46,6 +54,13 @@ PD_DECLARE_KERNEL(add, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(sqrt, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(less_than, CPU, ALL_LAYOUT);
 
+COMMON_DECLARE_bool(enable_pir_in_executor_trace_run);
+COMMON_DECLARE_bool(pir_interpreter_static_memory_plan);
+COMMON_DECLARE_bool(pir_interpreter_critical_path_schedule);
+COMMON_DECLARE_bool(pir_interpreter_batch_cpu_instructions);
+COMMON_DECLARE_bool(pir_interpreter_log_dispatch_overhead);
+COMMON_DECLARE_string(pir_interpreter_build_cache_dir);
+
 bool simple_cmp(float a, float b) { return std::abs((a - b) / a) < 1e-5; }
 
 namespace paddle {
@@ -260,6 +275,544 @@ TEST(StandaloneExecutor, run_inplace_sqrt) {
   EXPECT_EQ(res3, true);
 }
 
+TEST(StandaloneExecutor, plan_memory_offsets) {
+  std::vector<interpreter::MemoryLiveRange> ranges = {
+      {1000, 0, 1}, {500, 1, 2}, {1000, 2, 3}, {200, 3, 4}};
+  size_t arena_size = 0;
+  std::vector<size_t> offsets =
+      interpreter::PlanMemoryOffsets(ranges, 256, &arena_size);
+
+  EXPECT_EQ(offsets, (std::vector<size_t>{0, 1024, 0, 1024}));
+  EXPECT_EQ(arena_size, 1536u);
+}
+
+TEST(StandaloneExecutor, run_static_memory_plan) {
+  bool trace_run = FLAGS_enable_pir_in_executor_trace_run;
+  bool static_memory_plan = FLAGS_pir_interpreter_static_memory_plan;
+  FLAGS_enable_pir_in_executor_trace_run = true;
+  FLAGS_pir_interpreter_static_memory_plan = true;
+
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  pir::Program program((ctx));
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  pir::Builder builder = pir::Builder(ctx, program.block());
+
+  paddle::dialect::FullOp op1 = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{2, 2}, 4.0, phi::DataType::FLOAT32, phi::CPUPlace());
+  auto sqrt_op = builder.Build<paddle::dialect::SqrtOp>(op1->result(0));
+  paddle::dialect::FullOp op2 = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{2, 2}, 1.0, phi::DataType::FLOAT32, phi::CPUPlace());
+  auto add_op1 =
+      builder.Build<paddle::dialect::AddOp>(sqrt_op->result(0), op2->result(0));
+  auto add_op2 =
+      builder.Build<paddle::dialect::AddOp>(add_op1->result(0), op2->result(0));
+
+  std::string out_name = "add_out";
+  builder.Build<pir::ShadowOutputOp>(add_op2->result(0), out_name);
+
+  auto kernel_program = paddle::dialect::PdOpLowerToKernelPass(&program);
+
+  auto place = phi::CPUPlace();
+  Scope scope;
+  PirInterpreter test_core(place, {}, kernel_program->block(), &scope);
+
+  test_core.SetSkipGcVars({out_name});
+
+  // the first run sizes the plan, the others run in the arena
+  const interpreter::StaticMemoryPlan& plan = test_core.GetStaticMemoryPlan();
+  for (int i = 0; i < 3; ++i) {
+    test_core.Run({});
+
+    auto out_tensor =
+        test_core.local_scope() == nullptr
+            ? scope.FindVar(out_name)->Get<phi::DenseTensor>()
+            : test_core.local_scope()
+                  ->FindVar(out_name)
+                  ->Get<phi::DenseTensor>();
+    for (int j = 0; j < 4; ++j) {
+      EXPECT_TRUE(simple_cmp(out_tensor.data<float>()[j], 4.0));
+    }
+
+    // the two full outputs, the sqrt output and the first add output, at
+    // most three of them live at a time in 256 bytes aligned slices
+    EXPECT_TRUE(plan.IsBuilt());
+    EXPECT_EQ(plan.VarIds().size(), 4u);
+    EXPECT_GT(plan.ArenaSize(), 0u);
+    EXPECT_LE(plan.ArenaSize(), 3 * 256u);
+    if (i > 0) {
+      // every planned tensor ran in its slice of the arena
+      EXPECT_TRUE(plan.Check());
+    }
+  }
+
+  FLAGS_enable_pir_in_executor_trace_run = trace_run;
+  FLAGS_pir_interpreter_static_memory_plan = static_memory_plan;
+}
+
+TEST(StandaloneExecutor, run_static_memory_plan_shape_change) {
+  bool trace_run = FLAGS_enable_pir_in_executor_trace_run;
+  bool static_memory_plan = FLAGS_pir_interpreter_static_memory_plan;
+  FLAGS_enable_pir_in_executor_trace_run = true;
+  FLAGS_pir_interpreter_static_memory_plan = true;
+
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  pir::Program program(ctx);
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  pir::Builder builder = pir::Builder(ctx, program.block());
+
+  pir::OpInfo feed_op_info =
+      ctx->GetRegisteredOpInfo(paddle::dialect::FeedOp::name());
+
+  pir::Type fp32_dtype = pir::Float32Type::get(ctx);
+  phi::DDim dims = {2, 2};
+  phi::DataLayout data_layout = phi::DataLayout::NCHW;
+  phi::LegacyLoD lod = {{0}};
+  size_t offset = 0;
+  pir::Type dense_tensor_dtype = paddle::dialect::DenseTensorType::get(
+      ctx, fp32_dtype, dims, data_layout, lod, offset);
+
+  pir::AttributeMap attr_map;
+  attr_map.insert(std::pair<std::string, pir::Attribute>(
+      "name", pir::StrAttribute::get(ctx, "x")));
+  attr_map.insert(std::pair<std::string, pir::Attribute>(
+      "col", pir::Int32Attribute::get(ctx, 0)));
+  pir::Operation* feed_op =
+      pir::Operation::Create({}, attr_map, {dense_tensor_dtype}, feed_op_info);
+  program.block()->push_back(feed_op);
+
+  auto sqrt_op1 = builder.Build<paddle::dialect::SqrtOp>(feed_op->result(0));
+  auto sqrt_op2 = builder.Build<paddle::dialect::SqrtOp>(sqrt_op1->result(0));
+  std::string out_name = "sqrt_out";
+  builder.Build<pir::ShadowOutputOp>(sqrt_op2->result(0), out_name);
+
+  auto kernel_program = paddle::dialect::PdOpLowerToKernelPass(&program);
+
+  auto place = phi::CPUPlace();
+  Scope scope;
+  PirInterpreter test_core(place, {}, kernel_program->block(), &scope);
+
+  test_core.SetSkipGcVars({out_name});
+
+  // the output of the first sqrt is the only planned tensor
+  std::string mid_name;
+  for (auto& op : *kernel_program->block()) {
+    auto kernel_op = op.dyn_cast<paddle::dialect::PhiKernelOp>();
+    if (kernel_op && kernel_op.op_name() == "pd_op.sqrt") {
+      mid_name = test_core.GetNameByValue(op.result(0));
+      break;
+    }
+  }
+  ASSERT_FALSE(mid_name.empty());
+
+  // the plan is sized for 2x2 by the first run, the 16x16 feed of the third
+  // run does not fit in the slice, reallocates the planned tensor and drops
+  // the plan
+  const interpreter::StaticMemoryPlan& plan = test_core.GetStaticMemoryPlan();
+  std::vector<int64_t> feed_sizes = {2, 2, 16, 16};
+  phi::DeviceContext* dev_ctx = phi::DeviceContextPool::Instance().Get(place);
+  for (size_t i = 0; i < feed_sizes.size(); ++i) {
+    phi::DenseTensor tensor_x;
+    tensor_x.set_meta(
+        phi::DenseTensorMeta(phi::DataType::FLOAT32,
+                             phi::make_ddim({feed_sizes[i], feed_sizes[i]})));
+    dev_ctx->Alloc(&tensor_x, phi::DataType::FLOAT32);
+    for (int64_t j = 0; j < tensor_x.numel(); ++j) {
+      tensor_x.data<float>()[j] = 16.0;
+    }
+
+    test_core.Run({"x"}, {tensor_x});
+
+    auto out_tensor =
+        test_core.InnerScope()->FindVar(out_name)->Get<phi::DenseTensor>();
+    ASSERT_EQ(out_tensor.numel(), tensor_x.numel());
+    for (int64_t j = 0; j < out_tensor.numel(); ++j) {
+      EXPECT_TRUE(simple_cmp(out_tensor.data<float>()[j], 2.0));
+    }
+
+    const phi::DenseTensor& mid_tensor =
+        test_core.InnerScope()->FindVar(mid_name)->Get<phi::DenseTensor>();
+    if (i < 2) {
+      EXPECT_TRUE(plan.IsBuilt());
+      EXPECT_EQ(plan.VarIds().size(), 1u);
+      // the planned tensor keeps its slice instead of being collected
+      EXPECT_TRUE(mid_tensor.initialized());
+    } else {
+      EXPECT_FALSE(plan.IsBuilt());
+      EXPECT_EQ(plan.ArenaSize(), 0u);
+    }
+    if (i == 3) {
+      // the gc check restored by the drop collects it again
+      EXPECT_FALSE(mid_tensor.initialized());
+    }
+  }
+
+  FLAGS_enable_pir_in_executor_trace_run = trace_run;
+  FLAGS_pir_interpreter_static_memory_plan = static_memory_plan;
+}
+
+TEST(StandaloneExecutor, critical_path_lengths) {
+  // 0 -> 1 -> 3, 0 -> 2 -> 3, 4
+  std::map<size_t, std::set<size_t>> downstream_map = {
+      {0, {1, 2}}, {1, {3}}, {2, {3}}};
+  std::vector<double> costs = {1, 5, 2, 1, 3};
+  std::vector<double> lengths =
+      interpreter::ComputeCriticalPathLengths(downstream_map, costs);
+
+  EXPECT_EQ(lengths, (std::vector<double>{7, 6, 3, 1, 3}));
+}
+
+TEST(StandaloneExecutor, run_critical_path_schedule) {
+  bool critical_path_schedule = FLAGS_pir_interpreter_critical_path_schedule;
+  FLAGS_pir_interpreter_critical_path_schedule = true;
+
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  pir::Program program((ctx));
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  pir::Builder builder = pir::Builder(ctx, program.block());
+
+  paddle::dialect::FullOp op1 = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{2, 2}, 4.0, phi::DataType::FLOAT32, phi::CPUPlace());
+  paddle::dialect::FullOp op2 = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{2, 2}, 1.0, phi::DataType::FLOAT32, phi::CPUPlace());
+  auto sqrt_op = builder.Build<paddle::dialect::SqrtOp>(op1->result(0));
+  auto add_op1 =
+      builder.Build<paddle::dialect::AddOp>(op1->result(0), op2->result(0));
+  auto add_op2 = builder.Build<paddle::dialect::AddOp>(sqrt_op->result(0),
+                                                       add_op1->result(0));
+
+  std::string out_name = "add_out";
+  builder.Build<pir::ShadowOutputOp>(add_op2->result(0), out_name);
+
+  auto kernel_program = paddle::dialect::PdOpLowerToKernelPass(&program);
+
+  auto place = phi::CPUPlace();
+  Scope scope;
+  // inference runs in trace mode unless the schedule opts it out
+  interpreter::ExecutionConfig execution_config;
+  execution_config.used_for_inference = true;
+  PirInterpreter test_core(
+      place, {}, kernel_program->block(), &scope, execution_config);
+
+  test_core.SetSkipGcVars({out_name});
+
+  // the first run profiles the instructions, the others are scheduled by
+  // the profiled critical path
+  std::vector<double> profiled_costs;
+  for (int i = 0; i < 3; ++i) {
+    test_core.Run({});
+
+    auto out_tensor =
+        test_core.local_scope() == nullptr
+            ? scope.FindVar(out_name)->Get<phi::DenseTensor>()
+            : test_core.local_scope()
+                  ->FindVar(out_name)
+                  ->Get<phi::DenseTensor>();
+    for (int j = 0; j < 4; ++j) {
+      EXPECT_TRUE(simple_cmp(out_tensor.data<float>()[j], 7.0));
+    }
+
+    // full, full, sqrt, add, add, each estimated at 1us + 4ns before the
+    // first run
+    const std::vector<double>& costs = test_core.InstructionCosts();
+    ASSERT_EQ(costs.size(), 5u);
+    if (i == 0) {
+      profiled_costs = costs;
+      for (double cost : profiled_costs) {
+        EXPECT_NE(cost, 1.004);
+      }
+    }
+    // the later runs are not profiled again
+    EXPECT_EQ(costs, profiled_costs);
+
+    // 0 -> 2 -> 4, 0 -> 3 -> 4, 1 -> 3
+    std::map<size_t, std::set<size_t>> downstream_map = {
+        {0, {2, 3}}, {1, {3}}, {2, {4}}, {3, {4}}};
+    EXPECT_EQ(test_core.CriticalPath(),
+              interpreter::ComputeCriticalPathLengths(downstream_map,
+                                                      profiled_costs));
+  }
+
+  // the hooks are called in the execution order, so inference keeps to
+  // trace mode when they are registered
+  Scope hook_scope;
+  PirInterpreter hook_core(
+      place, {}, kernel_program->block(), &hook_scope, execution_config);
+  hook_core.SetSkipGcVars({out_name});
+  size_t hook_calls = 0;
+  hook_core.SetInputHooks(
+      {[&hook_calls](InstructionBase*, ValueExecutionInfo*, Scope*) {
+        ++hook_calls;
+      }});
+  hook_core.Run({});
+  EXPECT_EQ(hook_calls, 5u);
+  EXPECT_TRUE(hook_core.InstructionCosts().empty());
+
+  FLAGS_pir_interpreter_critical_path_schedule = critical_path_schedule;
+}
+
+TEST(StandaloneExecutor, run_instruction_batches) {
+  bool trace_run = FLAGS_enable_pir_in_executor_trace_run;
+  bool batch_cpu_instructions = FLAGS_pir_interpreter_batch_cpu_instructions;
+  bool log_dispatch_overhead = FLAGS_pir_interpreter_log_dispatch_overhead;
+  FLAGS_enable_pir_in_executor_trace_run = true;
+  FLAGS_pir_interpreter_log_dispatch_overhead = true;
+
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  pir::Program program((ctx));
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  pir::Builder builder = pir::Builder(ctx, program.block());
+
+  paddle::dialect::FullOp op1 = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{2, 2}, 4.0, phi::DataType::FLOAT32, phi::CPUPlace());
+  auto sqrt_op = builder.Build<paddle::dialect::SqrtOp>(op1->result(0));
+  paddle::dialect::FullOp op2 = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{2, 2}, 1.0, phi::DataType::FLOAT32, phi::CPUPlace());
+  auto add_op1 =
+      builder.Build<paddle::dialect::AddOp>(sqrt_op->result(0), op2->result(0));
+  auto add_op2 =
+      builder.Build<paddle::dialect::AddOp>(add_op1->result(0), op2->result(0));
+
+  std::string out_name = "add_out";
+  builder.Build<pir::ShadowOutputOp>(add_op2->result(0), out_name);
+
+  auto kernel_program = paddle::dialect::PdOpLowerToKernelPass(&program);
+
+  auto place = phi::CPUPlace();
+  // the five cpu kernels are dispatched one by one, or as one batch
+  for (bool batch : {false, true}) {
+    FLAGS_pir_interpreter_batch_cpu_instructions = batch;
+    Scope scope;
+    PirInterpreter test_core(place, {}, kernel_program->block(), &scope);
+
+    test_core.SetSkipGcVars({out_name});
+
+    for (int i = 0; i < 2; ++i) {
+      test_core.Run({});
+
+      auto out_tensor =
+          test_core.local_scope() == nullptr
+              ? scope.FindVar(out_name)->Get<phi::DenseTensor>()
+              : test_core.local_scope()
+                    ->FindVar(out_name)
+                    ->Get<phi::DenseTensor>();
+      for (int j = 0; j < 4; ++j) {
+        EXPECT_TRUE(simple_cmp(out_tensor.data<float>()[j], 4.0));
+      }
+      EXPECT_EQ(test_core.LastDispatchNum(), batch ? 1u : 5u);
+    }
+  }
+
+  FLAGS_enable_pir_in_executor_trace_run = trace_run;
+  FLAGS_pir_interpreter_batch_cpu_instructions = batch_cpu_instructions;
+  FLAGS_pir_interpreter_log_dispatch_overhead = log_dispatch_overhead;
+}
+
+TEST(StandaloneExecutor, run_instruction_batches_error) {
+  bool trace_run = FLAGS_enable_pir_in_executor_trace_run;
+  bool batch_cpu_instructions = FLAGS_pir_interpreter_batch_cpu_instructions;
+  FLAGS_enable_pir_in_executor_trace_run = true;
+  FLAGS_pir_interpreter_batch_cpu_instructions = true;
+
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  pir::Program program((ctx));
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  pir::Builder builder = pir::Builder(ctx, program.block());
+
+  paddle::dialect::FullOp op1 = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{2, 2}, 1.0, phi::DataType::FLOAT32, phi::CPUPlace());
+  paddle::dialect::FullOp op2 = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{2, 2}, 1.0, phi::DataType::FLOAT64, phi::CPUPlace());
+  auto add_op =
+      builder.Build<paddle::dialect::AddOp>(op1->result(0), op2->result(0));
+
+  std::string out_name = "add_out";
+  builder.Build<pir::ShadowOutputOp>(add_op->result(0), out_name);
+
+  auto kernel_program = paddle::dialect::PdOpLowerToKernelPass(&program);
+
+  auto place = phi::CPUPlace();
+  Scope scope;
+  PirInterpreter test_core(place, {}, kernel_program->block(), &scope);
+
+  test_core.SetSkipGcVars({out_name});
+
+  // the add raises inside the batch, the exception is recorded and
+  // rethrown by the run
+  bool is_catch = false;
+  try {
+    test_core.Run({});
+  } catch (std::exception& e) {
+    is_catch =
+        std::string(e.what()).find("InvalidArgumentError") != std::string::npos;
+  }
+  EXPECT_TRUE(is_catch);
+  EXPECT_EQ(test_core.LastDispatchNum(), 1u);
+
+  FLAGS_enable_pir_in_executor_trace_run = trace_run;
+  FLAGS_pir_interpreter_batch_cpu_instructions = batch_cpu_instructions;
+}
+
+// A directory of its own under the gtest temp dir, so that tests running in
+// parallel do not share their build caches.
+static std::filesystem::path MakeTestDir(const std::string& name) {
+  std::filesystem::path path =
+      std::filesystem::path(::testing::TempDir()) /
+      (name + "_" +
+       std::to_string(
+           std::chrono::steady_clock::now().time_since_epoch().count()));
+  std::filesystem::create_directories(path);
+  return path;
+}
+
+TEST(StandaloneExecutor, run_build_cache) {
+  std::filesystem::path cache_dir = MakeTestDir("pir_build_cache");
+  std::string build_cache_dir = FLAGS_pir_interpreter_build_cache_dir;
+  FLAGS_pir_interpreter_build_cache_dir = cache_dir.string();
+
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  pir::Program program((ctx));
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  pir::Builder builder = pir::Builder(ctx, program.block());
+
+  paddle::dialect::FullOp op1 = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{2, 2}, 4.0, phi::DataType::FLOAT32, phi::CPUPlace());
+  auto sqrt_op = builder.Build<paddle::dialect::SqrtOp>(op1->result(0));
+  paddle::dialect::FullOp op2 = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{2, 2}, 1.0, phi::DataType::FLOAT32, phi::CPUPlace());
+  auto add_op =
+      builder.Build<paddle::dialect::AddOp>(sqrt_op->result(0), op2->result(0));
+
+  std::string out_name = "add_out";
+  builder.Build<pir::ShadowOutputOp>(add_op->result(0), out_name);
+
+  auto kernel_program = paddle::dialect::PdOpLowerToKernelPass(&program);
+
+  auto place = phi::CPUPlace();
+  // the first interpreter saves the cache, the second one loads it
+  std::string cache_path;
+  for (int i = 0; i < 2; ++i) {
+    Scope scope;
+    PirInterpreter test_core(place, {}, kernel_program->block(), &scope);
+    test_core.SetSkipGcVars({out_name});
+    test_core.Run({});
+
+    auto out_tensor =
+        test_core.local_scope() == nullptr
+            ? scope.FindVar(out_name)->Get<phi::DenseTensor>()
+            : test_core.local_scope()
+                  ->FindVar(out_name)
+                  ->Get<phi::DenseTensor>();
+    for (int j = 0; j < 4; ++j) {
+      EXPECT_TRUE(simple_cmp(out_tensor.data<float>()[j], 3.0));
+    }
+
+    EXPECT_EQ(test_core.BuildCacheLoaded(), i == 1);
+    if (i == 0) {
+      cache_path = test_core.BuildCachePath();
+      EXPECT_EQ(std::filesystem::path(cache_path).parent_path(), cache_dir);
+      EXPECT_TRUE(std::filesystem::exists(cache_path));
+    } else {
+      EXPECT_EQ(test_core.BuildCachePath(), cache_path);
+    }
+  }
+  // only the renamed cache is left, no temporary file
+  EXPECT_EQ(std::distance(std::filesystem::directory_iterator(cache_dir),
+                          std::filesystem::directory_iterator()),
+            1);
+
+  FLAGS_pir_interpreter_build_cache_dir = build_cache_dir;
+  std::filesystem::remove_all(cache_dir);
+}
+
+static std::string ReadFile(const std::string& path) {
+  std::ifstream is(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(is),
+                     std::istreambuf_iterator<char>());
+}
+
+static void WriteFile(const std::string& path, const std::string& content) {
+  std::ofstream os(path, std::ios::binary | std::ios::trunc);
+  os.write(content.data(), static_cast<std::streamsize>(content.size()));
+}
+
+TEST(StandaloneExecutor, load_build_cache) {
+  std::filesystem::path cache_dir = MakeTestDir("pir_build_cache_load");
+  std::string path = (cache_dir / "test.cache").string();
+  std::string fingerprint = "full\nsqrt\nadd";
+
+  interpreter::InterpreterBuildCache cache;
+  cache.instr_num = 3;
+  cache.op_downstream_map = {{0, {2}}, {1, {2}}};
+  cache.op_happens_before = {
+      {false, false, true}, {false, false, true}, {false, false, false}};
+  cache.event_info = {{0, {{0, {2}}}}};
+  cache.last_live_ops = {{0, {2}}, {1, {2}}, {3, {2}}};
+  cache.trace_execute_order = {0, 1, 2};
+  interpreter::SaveInterpreterBuildCache(path, fingerprint, cache);
+
+  interpreter::InterpreterBuildCache loaded;
+  ASSERT_TRUE(interpreter::LoadInterpreterBuildCache(
+      path, fingerprint, 3, 4, &loaded));
+  EXPECT_EQ(loaded.instr_num, cache.instr_num);
+  EXPECT_EQ(loaded.op_downstream_map, cache.op_downstream_map);
+  EXPECT_EQ(loaded.op_happens_before, cache.op_happens_before);
+  EXPECT_EQ(loaded.event_info, cache.event_info);
+  EXPECT_EQ(loaded.last_live_ops, cache.last_live_ops);
+  EXPECT_EQ(loaded.trace_execute_order, cache.trace_execute_order);
+
+  // another program, whether its fingerprint has the same size or not
+  EXPECT_FALSE(interpreter::LoadInterpreterBuildCache(
+      path, "full\nsqrt\nsub", 3, 4, &loaded));
+  EXPECT_FALSE(
+      interpreter::LoadInterpreterBuildCache(path, "full", 3, 4, &loaded));
+  // the same program with other instructions or vars
+  EXPECT_FALSE(interpreter::LoadInterpreterBuildCache(
+      path, fingerprint, 4, 4, &loaded));
+  EXPECT_FALSE(interpreter::LoadInterpreterBuildCache(
+      path, fingerprint, 3, 3, &loaded));
+  EXPECT_FALSE(interpreter::LoadInterpreterBuildCache(
+      (cache_dir / "missing.cache").string(), fingerprint, 3, 4, &loaded));
+
+  std::string content = ReadFile(path);
+  std::string bad_path = (cache_dir / "bad.cache").string();
+  // every truncation is rejected
+  for (size_t size = 0; size < content.size(); ++size) {
+    WriteFile(bad_path, content.substr(0, size));
+    EXPECT_FALSE(interpreter::LoadInterpreterBuildCache(
+        bad_path, fingerprint, 3, 4, &loaded))
+        << "truncated to " << size << " bytes";
+  }
+
+  // a wrong magic, and an out of range id in the last execute order entry
+  std::string corrupted = content;
+  corrupted[0] = 'X';
+  WriteFile(bad_path, corrupted);
+  EXPECT_FALSE(interpreter::LoadInterpreterBuildCache(
+      bad_path, fingerprint, 3, 4, &loaded));
+  corrupted = content;
+  corrupted.replace(corrupted.size() - sizeof(uint64_t),
+                    sizeof(uint64_t),
+                    sizeof(uint64_t),
+                    '\xff');
+  WriteFile(bad_path, corrupted);
+  EXPECT_FALSE(interpreter::LoadInterpreterBuildCache(
+      bad_path, fingerprint, 3, 4, &loaded));
+  // a count larger than the instructions, instead of an allocation
+  corrupted = content;
+  corrupted.replace(corrupted.size() - 4 * sizeof(uint64_t),
+                    sizeof(uint64_t),
+                    sizeof(uint64_t),
+                    '\x7f');
+  WriteFile(bad_path, corrupted);
+  EXPECT_FALSE(interpreter::LoadInterpreterBuildCache(
+      bad_path, fingerprint, 3, 4, &loaded));
+
+  // the failed loads left the last loaded cache untouched
+  EXPECT_EQ(loaded.trace_execute_order, cache.trace_execute_order);
+
+  std::filesystem::remove_all(cache_dir);
+}
+
 TEST(StandaloneExecutor, if_op) {
   pir::IrContext* ctx = pir::IrContext::Instance();
   ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
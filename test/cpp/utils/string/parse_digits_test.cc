@@ -0,0 +1,67 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/utils/string/parse_digits.h"
+
+#include <random>
+#include <string>
+
+#include "gtest/gtest.h"
+
+TEST(ParseDigits, ParseUint64Digits) {
+  std::mt19937_64 engine(0);
+  for (int i = 0; i < 10000; ++i) {
+    uint64_t value = engine() >> (engine() % 64);
+    std::string str = std::to_string(value);
+    size_t len = str.size();
+    str += i % 2 == 0 ? "\t1" : ":";
+    uint64_t parsed = 0;
+    const char* end = str.data() + str.size();
+    ASSERT_EQ(paddle::string::ParseUint64Digits(str.data(), end, &parsed),
+              str.data() + len);
+    ASSERT_EQ(parsed, value);
+  }
+  std::string str = "1234567/89";
+  const char* end = str.data() + str.size();
+  uint64_t parsed = 0;
+  ASSERT_EQ(paddle::string::ParseUint64Digits(str.data(), end, &parsed),
+            str.data() + 7);
+  ASSERT_EQ(parsed, 1234567u);
+  ASSERT_EQ(paddle::string::ParseUint64Digits(str.data() + 7, end, &parsed),
+            str.data() + 7);
+  ASSERT_EQ(parsed, 1234567u);
+}
+
+TEST(ParseDigits, Overflow) {
+  // the largest value and leading zeros still parse
+  for (std::string str : {"18446744073709551615",
+                          "000000000018446744073709551615",
+                          "0000000000000000000000000000001"}) {
+    uint64_t parsed = 0;
+    const char* end = str.data() + str.size();
+    ASSERT_EQ(paddle::string::ParseUint64Digits(str.data(), end, &parsed),
+              end);
+    ASSERT_EQ(parsed, std::stoull(str));
+  }
+  // past it nothing is parsed and the value is untouched
+  for (std::string str : {"18446744073709551616",
+                          "99999999999999999999",
+                          "123456789012345678901234567890 1"}) {
+    uint64_t parsed = 7;
+    const char* end = str.data() + str.size();
+    ASSERT_EQ(paddle::string::ParseUint64Digits(str.data(), end, &parsed),
+              str.data());
+    ASSERT_EQ(parsed, 7u);
+  }
+}
@@ -17,7 +17,9 @@ including create, config, run, etc.
 """
 
 import os
+import struct
 import tempfile
+import time
 import unittest
 
 import paddle
@@ -25,6 +27,84 @@ from paddle import base
 from paddle.base import core
 
 
+def _read_slot_record_cache(cache_dir):
+    """
+    Decodes the binary cache files under cache_dir into sorted
+    (ins_id, uint64 values per slot, float values per slot) tuples.
+    """
+
+    def align(size):
+        return (size + 7) & ~7
+
+    records = []
+    for name in sorted(os.listdir(cache_dir)):
+        with open(os.path.join(cache_dir, name), "rb") as f:
+            data = f.read()
+        _, _, uint64_slot_num, float_slot_num, _, _ = struct.unpack_from(
+            "<8sIIIIQ", data
+        )
+        pos = struct.calcsize("<8sIIIIQ")
+        while pos < len(data):
+            ins_num, ins_id_bytes, uint64_num, float_num = struct.unpack_from(
+                "<IIQQ", data, pos
+            )
+            pos += align(struct.calcsize("<IIQQ"))
+            columns = []
+            for fmt, count in [
+                ("I", ins_num * (uint64_slot_num + 1)),
+                ("I", ins_num * (float_slot_num + 1)),
+                ("Q", uint64_num),
+                ("f", float_num),
+                ("I", ins_num),
+            ]:
+                columns.append(struct.unpack_from(f"<{count}{fmt}", data, pos))
+                pos += align(count * struct.calcsize(fmt))
+            ins_ids = data[pos : pos + ins_id_bytes].decode()
+            # search ids, cmatches and ranks are not checked
+            pos += (
+                align(ins_id_bytes)
+                + align(ins_num * 8)
+                + 2 * align(ins_num * 4)
+            )
+            uint64_offsets, float_offsets, uint64_values, float_values = (
+                columns[:4]
+            )
+            ins_id_lens = columns[4]
+
+            def split(offsets, slot_num, values, i, begin):
+                rec = offsets[i * (slot_num + 1) : (i + 1) * (slot_num + 1)]
+                return (
+                    tuple(
+                        tuple(values[begin + rec[j] : begin + rec[j + 1]])
+                        for j in range(slot_num)
+                    ),
+                    begin + rec[slot_num],
+                )
+
+            uint64_begin = float_begin = ins_id_begin = 0
+            for i in range(ins_num):
+                uint64_slots, uint64_begin = split(
+                    uint64_offsets,
+                    uint64_slot_num,
+                    uint64_values,
+                    i,
+                    uint64_begin,
+                )
+                float_slots, float_begin = split(
+                    float_offsets, float_slot_num, float_values, i, float_begin
+                )
+                ins_id_end = ins_id_begin + ins_id_lens[i]
+                records.append(
+                    (
+                        ins_ids[ins_id_begin:ins_id_end],
+                        uint64_slots,
+                        float_slots,
+                    )
+                )
+                ins_id_begin = ins_id_end
+    return sorted(records)
+
+
 class TestDataset(unittest.TestCase):
     """TestCases for Dataset."""
 
@@ -898,6 +978,169 @@ class TestDataset(unittest.TestCase):
 
             temp_dir.cleanup()
 
+    def test_slot_record_dataset_binary_cache(self):
+        """
+        Testcase for SlotRecordDataset dumped into a binary cache and loaded
+        from it.
+        """
+        with paddle.pir_utils.OldIrGuard():
+            temp_dir = tempfile.TemporaryDirectory()
+            filename = os.path.join(
+                temp_dir.name, "test_slot_record_binary_cache.txt"
+            )
+            cache_dir = os.path.join(temp_dir.name, "binary_cache")
+
+            with open(filename, "w") as f:
+                data = ""
+                for i in range(100):
+                    data += f"1 ins{i} 2 {i} {i + 1} 1 {i * 0.5} 1 {i * 7}\n"
+                f.write(data)
+
+            slots_vars = [
+                paddle.static.data(name="slot1", shape=[-1, 1], dtype="int64"),
+                paddle.static.data(
+                    name="slot2", shape=[-1, 1], dtype="float32"
+                ),
+                paddle.static.data(name="slot3", shape=[-1, 1], dtype="int64"),
+            ]
+
+            def create_dataset():
+                dataset = paddle.distributed.InMemoryDataset()
+                dataset.init(
+                    batch_size=32,
+                    thread_num=2,
+                    pipe_command="cat",
+                    data_feed_type="SlotRecordInMemoryDataFeed",
+                    use_var=slots_vars,
+                )
+                dataset._init_distributed_settings(parse_ins_id=True)
+                return dataset
+
+            dataset = create_dataset()
+            dataset.set_filelist([filename])
+            dataset.load_into_memory()
+            self.assertEqual(dataset.get_memory_data_size(), 100)
+            dataset.dump_binary_cache(cache_dir)
+            self.assertEqual(len(os.listdir(cache_dir)), 2)
+            self.assertEqual(dataset.get_memory_data_size(), 100)
+            dataset.release_memory()
+            # zero floats of sparse slots are dropped while parsing
+            expected = sorted(
+                (
+                    f"ins{i}",
+                    ((i, i + 1), (i * 7,)),
+                    ((i * 0.5,) if i > 0 else (),),
+                )
+                for i in range(100)
+            )
+            self.assertEqual(_read_slot_record_cache(cache_dir), expected)
+
+            dataset = create_dataset()
+            dataset.set_binary_cache_dir(cache_dir)
+            dataset.load_into_memory()
+            self.assertEqual(dataset.get_memory_data_size(), 100)
+            # the loaded records are dumped again with the same values
+            reload_dir = os.path.join(temp_dir.name, "binary_cache_reload")
+            dataset.dump_binary_cache(reload_dir)
+            self.assertEqual(_read_slot_record_cache(reload_dir), expected)
+
+            paddle.enable_static()
+            exe = paddle.static.Executor(paddle.CPUPlace())
+            startup_program = paddle.static.Program()
+            main_program = paddle.static.Program()
+            exe.run(startup_program)
+            try:
+                exe.train_from_dataset(main_program, dataset)
+            except ImportError as e:
+                pass
+            except Exception as e:
+                self.assertTrue(False)
+            dataset.release_memory()
+
+            # a cache of other used slots is rejected
+            slots_vars.pop()
+            dataset = create_dataset()
+            with self.assertRaises(Exception):
+                dataset.set_binary_cache_dir(cache_dir)
+
+            temp_dir.cleanup()
+
+    def test_slot_record_dataset_streaming(self):
+        """
+        Testcase for SlotRecordDataset trained while it is being loaded.
+        """
+        with paddle.pir_utils.OldIrGuard():
+            temp_dir = tempfile.TemporaryDirectory()
+            filename = os.path.join(
+                temp_dir.name, "test_slot_record_stream.txt"
+            )
+            spill_dir = os.path.join(temp_dir.name, "spill")
+
+            with open(filename, "w") as f:
+                data = ""
+                for i in range(200):
+                    data += f"1 ins{i} 2 {i} {i + 1} 1 {i * 0.5} 1 {i * 7}\n"
+                f.write(data)
+
+            slots_vars = [
+                paddle.static.data(name="slot1", shape=[-1, 1], dtype="int64"),
+                paddle.static.data(
+                    name="slot2", shape=[-1, 1], dtype="float32"
+                ),
+                paddle.static.data(name="slot3", shape=[-1, 1], dtype="int64"),
+            ]
+
+            dataset = paddle.distributed.InMemoryDataset()
+            dataset.init(
+                batch_size=8,
+                thread_num=2,
+                pipe_command="cat",
+                data_feed_type="SlotRecordInMemoryDataFeed",
+                use_var=slots_vars,
+            )
+            dataset._init_distributed_settings(parse_ins_id=True)
+            dataset.set_filelist([filename])
+            with self.assertRaises(Exception):
+                dataset.set_streaming_mode(-1)
+            dataset.set_streaming_mode(16, spill_dir)
+
+            paddle.enable_static()
+            exe = paddle.static.Executor(paddle.CPUPlace())
+            startup_program = paddle.static.Program()
+            main_program = paddle.static.Program()
+            exe.run(startup_program)
+
+            def train():
+                try:
+                    exe.train_from_dataset(main_program, dataset)
+                except ImportError as e:
+                    pass
+                except Exception as e:
+                    self.assertTrue(False)
+
+            dataset.preload_into_memory()
+            train()
+            dataset.wait_preload_done()
+            self.assertEqual(dataset.dataset.get_stream_data_size(), 200)
+            self.assertEqual(os.listdir(spill_dir), [])
+
+            # the stream loads while nothing reads it, the records past the
+            # window and the training channel are spilled and read back
+            dataset.preload_into_memory()
+            time.sleep(1)
+            train()
+            dataset.wait_preload_done()
+            self.assertEqual(dataset.dataset.get_stream_data_size(), 200)
+            self.assertEqual(os.listdir(spill_dir), [])
+
+            # a stream nobody trains on is finished without blocking
+            dataset.preload_into_memory()
+            dataset.wait_preload_done()
+            self.assertEqual(dataset.dataset.get_stream_data_size(), 0)
+            self.assertEqual(os.listdir(spill_dir), [])
+
+            temp_dir.cleanup()
+
     def test_cuda_in_memory_dataset_run(self):
         """
         Testcase for cuda inmemory dataset hogwild_worker train to run(barrier).